@@ -0,0 +1,151 @@
+#include"stdafx.hpp"
+#include"Benchmark.hpp"
+#include"Clock.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+void BenchmarkRunner::add(const std::string& name, BenchmarkSetup setup)
+{
+	benchmarks.push_back(std::make_pair(name, setup));
+}
+
+std::vector<BenchmarkResult> BenchmarkRunner::run(const BenchmarkSettings& settings)
+{
+	std::vector<BenchmarkResult> results;
+	const int64_t minNanoseconds = Clock::fromSeconds(settings.minMilliseconds / 1000.0);
+
+	for(const std::pair<std::string, BenchmarkSetup>& benchmark: benchmarks)
+	{
+		if(benchmark.first.find(settings.filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		BenchmarkBody body = benchmark.second();
+
+		// One untimed iteration warms caches and lets lazy initialization happen
+		body(1);
+
+		uint64_t iterations = 1;
+		while(true)
+		{
+			int64_t start = Clock::nanoseconds();
+			body(iterations);
+			int64_t elapsed = Clock::nanoseconds() - start;
+
+			if(elapsed >= minNanoseconds || iterations >= (1ULL << 40))
+			{
+				break;
+			}
+
+			// Jump close to target instead of doubling many times when body is very short
+			uint64_t estimate = elapsed > 0 ? static_cast<uint64_t>(iterations * 1.2 * minNanoseconds / elapsed) : iterations * 100;
+			iterations = std::max(iterations * 2, std::min(estimate, iterations * 100));
+		}
+
+		std::vector<double> samples;
+		for(uint32_t i=0; i<std::max(settings.repetitions, 1U); i++)
+		{
+			int64_t start = Clock::nanoseconds();
+			body(iterations);
+			samples.push_back(static_cast<double>(Clock::nanoseconds() - start) / iterations);
+		}
+		std::sort(samples.begin(), samples.end());
+
+		BenchmarkResult result;
+		result.name = benchmark.first;
+		result.iterations = iterations;
+		result.repetitions = static_cast<uint32_t>(samples.size());
+		result.medianNanoseconds = samples[samples.size() / 2];
+		result.minNanoseconds = samples.front();
+		result.maxNanoseconds = samples.back();
+		results.push_back(result);
+
+		std::cerr << result.name << ": " << result.medianNanoseconds << " ns (min " << result.minNanoseconds << " max " << result.maxNanoseconds << ", " << iterations << " iterations)" << std::endl;
+	}
+
+	return results;
+}
+
+void BenchmarkRunner::writeJson(const std::vector<BenchmarkResult>& results, std::ostream& output)
+{
+	output.setf(std::ios::fixed);
+	output.precision(3);
+	output << "{\n\t\"benchmarks\": [";
+
+	for(size_t i=0; i<results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		output << (i == 0 ? "\n" : ",\n");
+		output << "\t\t{\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations << ", \"repetitions\": " << result.repetitions
+			<< ", \"median_ns\": " << result.medianNanoseconds << ", \"min_ns\": " << result.minNanoseconds << ", \"max_ns\": " << result.maxNanoseconds << "}";
+	}
+	output << "\n\t]\n}\n";
+}
+
+// Only files written by writeJson are read: one benchmark object per line, keys in fixed order
+std::vector<BenchmarkResult> BenchmarkRunner::readJson(const std::string& fileName)
+{
+	std::ifstream file(fileName);
+
+	if(!file.is_open())
+	{
+		throw std::runtime_error("Failed to open baseline " + fileName);
+	}
+
+	std::vector<BenchmarkResult> results;
+	std::string line;
+
+	while(std::getline(file, line))
+	{
+		size_t nameStart = line.find("\"name\": \"");
+		size_t medianStart = line.find("\"median_ns\": ");
+
+		if(nameStart == std::string::npos || medianStart == std::string::npos)
+		{
+			continue;
+		}
+
+		nameStart += 9;
+		BenchmarkResult result = {};
+		result.name = line.substr(nameStart, line.find('"', nameStart) - nameStart);
+		result.medianNanoseconds = std::strtod(line.c_str() + medianStart + 13, nullptr);
+		results.push_back(result);
+	}
+	return results;
+}
+
+uint32_t BenchmarkRunner::compare(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline, double thresholdPercent)
+{
+	uint32_t regressions = 0;
+
+	for(const BenchmarkResult& result: results)
+	{
+		std::vector<BenchmarkResult>::const_iterator base = std::find_if(baseline.begin(), baseline.end(), [&result](const BenchmarkResult& candidate)
+		{
+			return candidate.name == result.name;
+		});
+
+		if(base == baseline.end() || base->medianNanoseconds <= 0.0)
+		{
+			std::cout << "NEW        " << result.name << std::endl;
+			continue;
+		}
+
+		double changePercent = (result.medianNanoseconds / base->medianNanoseconds - 1.0) * 100.0;
+		const char* verdict = "ok        ";
+
+		if(changePercent > thresholdPercent)
+		{
+			verdict = "REGRESSION";
+			++regressions;
+		}
+		else if(changePercent < -thresholdPercent)
+		{
+			verdict = "improved  ";
+		}
+
+		std::cout << verdict << " " << result.name << ": " << base->medianNanoseconds << " -> " << result.medianNanoseconds << " ns (" << (changePercent >= 0.0 ? "+" : "") << changePercent << "%)" << std::endl;
+	}
+	return regressions;
+}
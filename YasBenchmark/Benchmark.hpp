@@ -0,0 +1,70 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+const uint32_t BENCHMARK_DEFAULT_REPETITIONS		= 5;
+const double BENCHMARK_DEFAULT_MIN_MILLISECONDS		= 100.0;
+const double BENCHMARK_DEFAULT_THRESHOLD_PERCENT	= 10.0;
+
+// Body of benchmark runs given number of iterations of measured operation
+typedef std::function<void(uint64_t)> BenchmarkBody;
+// Prepares input data and returns body. Called only for benchmarks which pass filter, setup is not measured.
+typedef std::function<BenchmarkBody()> BenchmarkSetup;
+
+struct BenchmarkResult
+{
+	std::string						name;
+	uint64_t						iterations;
+	uint32_t						repetitions;
+	// Time of one iteration. Median is compared against baseline, minimum and maximum show noise.
+	double							medianNanoseconds;
+	double							minNanoseconds;
+	double							maxNanoseconds;
+};
+
+struct BenchmarkSettings
+{
+	std::string						filter;
+	std::string						outputPath;
+	std::string						baselinePath;
+	double							thresholdPercent = BENCHMARK_DEFAULT_THRESHOLD_PERCENT;
+	uint32_t						repetitions = BENCHMARK_DEFAULT_REPETITIONS;
+	double							minMilliseconds = BENCHMARK_DEFAULT_MIN_MILLISECONDS;
+};
+
+// Keeps value computed by benchmark from being optimized away
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#ifdef _MSC_VER
+	static volatile const void* sink;
+	sink = &value;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+class BenchmarkRunner
+{
+	public:
+
+		// Names are grouped as "area/case", filter is substring of name
+		void							add(const std::string& name, BenchmarkSetup setup);
+		// Number of iterations is doubled until one repetition takes at least minimum time
+		std::vector<BenchmarkResult>	run(const BenchmarkSettings& settings);
+
+		static void						writeJson(const std::vector<BenchmarkResult>& results, std::ostream& output);
+		// Reads file written by writeJson, throws when it can not be read
+		static std::vector<BenchmarkResult> readJson(const std::string& fileName);
+		// Prints change of every benchmark found in baseline. Returns number of benchmarks slower by more than threshold.
+		static uint32_t					compare(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline, double thresholdPercent);
+
+	private:
+
+		std::vector<std::pair<std::string, BenchmarkSetup>> benchmarks;
+};
+
+#endif
@@ -0,0 +1,2186 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include"stdafx.hpp"
+#include"Benchmark.hpp"
+#include"ModelLoader.hpp"
+#include"JobSystem.hpp"
+#include"Arena.hpp"
+#include"RenderQueue.hpp"
+#include"OcclusionCulling.hpp"
+#include"Simulation.hpp"
+#include"TripleBuffer.hpp"
+#include"TransformBatch.hpp"
+#include"Skinning.hpp"
+#include"YasLog.hpp"
+#include"ResidencyCache.hpp"
+#include"AssetArchive.hpp"
+#include"DeviceSelection.hpp"
+#include<filesystem>
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Generated inputs are used when engine assets are not found, so suite runs from any directory.
+// Their names differ from asset names so results of different inputs are never compared.
+const char* const GENERATED_MODEL_PATH			= "benchmark_model.obj";
+const uint32_t GENERATED_MODEL_SEGMENTS			= 256;
+const uint32_t GENERATED_TEXTURE_SIZE			= 1024;
+const uint32_t BENCHMARK_OBJECTS_NUMBER			= 1024;
+const uint32_t BENCHMARK_PACKETS_NUMBER			= 4096;
+const uint32_t BENCHMARK_SORT_KEYS_NUMBER		= 65536;
+// Power of two
+const uint32_t BENCHMARK_MATRICES_NUMBER		= 256;
+const uint32_t BENCHMARK_TRANSFORMS_NUMBER		= 65536;
+const uint32_t BENCHMARK_CHARACTERS_NUMBER		= 100;
+// Streaming trace: level of assets from 4 KB to 256 KB, camera sees window of them and one more far away every frame.
+// Far asset is mostly one of landmarks seen from whole level, so larger budget keeps more of them resident.
+const uint32_t RESIDENCY_TRACE_ASSETS			= 4096;
+const uint32_t RESIDENCY_TRACE_LANDMARKS		= 128;
+const uint32_t RESIDENCY_TRACE_FRAMES			= 10000;
+const uint32_t RESIDENCY_TRACE_VISIBLE_ASSETS	= 16;
+const uint32_t RESIDENCY_TRACE_DELAY_FRAMES		= 2;
+// Small assets from 256 B to 4 KB, read one by one from loose files and from archive packed of the same files
+const char* const GENERATED_ASSETS_DIRECTORY	= "benchmark_assets";
+const char* const GENERATED_ARCHIVE_PATH		= "benchmark_assets.yar";
+const uint32_t GENERATED_ASSETS_NUMBER			= 10000;
+
+static JobSystem jobSystem;
+
+// UV sphere with seam, corners on seam and poles share positions but not texture coordinates, like real models
+static void writeGeneratedModel(const std::string& fileName)
+{
+	std::ofstream file(fileName, std::ios::trunc);
+
+	if(!file.is_open())
+	{
+		throw std::runtime_error("Failed to create generated model");
+	}
+
+	const uint32_t segments = GENERATED_MODEL_SEGMENTS;
+
+	for(uint32_t y=0; y<=segments; y++)
+	{
+		for(uint32_t x=0; x<=segments; x++)
+		{
+			float u = static_cast<float>(x) / segments;
+			float v = static_cast<float>(y) / segments;
+			float theta = u * 6.2831853F;
+			float phi = v * 3.1415926F;
+			file << "v " << std::sin(phi) * std::cos(theta) << " " << std::sin(phi) * std::sin(theta) << " " << std::cos(phi) << "\n";
+			file << "vt " << u << " " << v << "\n";
+		}
+	}
+
+	for(uint32_t y=0; y<segments; y++)
+	{
+		for(uint32_t x=0; x<segments; x++)
+		{
+			// OBJ indices start at 1
+			uint32_t a = y * (segments + 1) + x + 1;
+			uint32_t b = a + 1;
+			uint32_t c = a + segments + 1;
+			uint32_t d = c + 1;
+			file << "f " << a << "/" << a << " " << c << "/" << c << " " << b << "/" << b << "\n";
+			file << "f " << b << "/" << b << " " << c << "/" << c << " " << d << "/" << d << "\n";
+		}
+	}
+}
+
+static bool readWholeFile(const std::string& fileName, std::vector<unsigned char>& bytes)
+{
+	std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+
+	if(!file.is_open())
+	{
+		return false;
+	}
+	bytes.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+	return true;
+}
+
+static void appendBytes(void* context, void* data, int size)
+{
+	std::vector<unsigned char>* bytes = static_cast<std::vector<unsigned char>*>(context);
+	bytes->insert(bytes->end(), static_cast<unsigned char*>(data), static_cast<unsigned char*>(data) + size);
+}
+
+static std::vector<unsigned char> generateTextureJpeg()
+{
+	const int size = GENERATED_TEXTURE_SIZE;
+	std::vector<unsigned char> pixels(size * size * 3);
+
+	for(int y=0; y<size; y++)
+	{
+		for(int x=0; x<size; x++)
+		{
+			unsigned char* pixel = &pixels[(y * size + x) * 3];
+			pixel[0] = static_cast<unsigned char>(x ^ y);
+			pixel[1] = static_cast<unsigned char>((x * 7 + y * 3) >> 2);
+			pixel[2] = static_cast<unsigned char>(128 + 127 * std::sin(x * 0.05F) * std::cos(y * 0.03F));
+		}
+	}
+
+	std::vector<unsigned char> jpeg;
+	stbi_write_jpg_to_func(appendBytes, &jpeg, size, size, 3, pixels.data(), 90);
+	return jpeg;
+}
+
+static void addModelBenchmarks(BenchmarkRunner& runner, const std::string& assetsPath)
+{
+	std::string modelPath = assetsPath + "/Models/chalet.obj";
+	std::string modelName = "chalet";
+
+	if(!std::ifstream(modelPath).is_open())
+	{
+		modelPath = GENERATED_MODEL_PATH;
+		modelName = "generated_sphere";
+	}
+
+	runner.add("model/obj_load_weld/" + modelName, [modelPath]
+	{
+		if(modelPath == GENERATED_MODEL_PATH)
+		{
+			writeGeneratedModel(modelPath);
+		}
+
+		return [modelPath](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				std::vector<Vertex> vertices;
+				std::vector<uint32_t> indices;
+				ModelLoader::loadObj(modelPath, jobSystem, vertices, indices);
+				doNotOptimize(indices.back());
+			}
+		};
+	});
+
+	runner.add("model/weld/" + modelName, [modelPath]
+	{
+		if(modelPath == GENERATED_MODEL_PATH)
+		{
+			writeGeneratedModel(modelPath);
+		}
+
+		std::shared_ptr<tinyobj::attrib_t> attrib(new tinyobj::attrib_t());
+		std::shared_ptr<std::vector<tinyobj::shape_t>> shapes(new std::vector<tinyobj::shape_t>());
+		std::vector<tinyobj::material_t> materials;
+		std::string warnings;
+		std::string error;
+
+		if(!tinyobj::LoadObj(attrib.get(), shapes.get(), &materials, &warnings, &error, modelPath.c_str()))
+		{
+			throw std::runtime_error(error);
+		}
+
+		return [attrib, shapes](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				std::vector<Vertex> vertices;
+				std::vector<uint32_t> indices;
+				ModelLoader::weldCorners(*attrib, *shapes, jobSystem, vertices, indices);
+				doNotOptimize(indices.back());
+			}
+		};
+	});
+
+	runner.add("model/mesh_decode/" + modelName, [modelPath]
+	{
+		if(modelPath == GENERATED_MODEL_PATH)
+		{
+			writeGeneratedModel(modelPath);
+		}
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		ModelLoader::loadObj(modelPath, jobSystem, vertices, indices);
+		std::shared_ptr<std::vector<char>> data(new std::vector<char>());
+		MeshCodec::encode(vertices, indices, ModelLoader::getFileSize(modelPath), ModelLoader::getFileModificationTime(modelPath), *data);
+
+		// Decode speed is decoded size divided by median time of iteration. Stderr keeps JSON output clean.
+		size_t decodedSize = sizeof(Vertex) * vertices.size() + sizeof(uint32_t) * indices.size();
+		std::cerr << "mesh_decode: " << data->size() << " bytes compressed, " << decodedSize << " bytes decoded, ratio "
+			<< static_cast<double>(decodedSize) / data->size() << " to binary " << static_cast<double>(ModelLoader::getFileSize(modelPath)) / data->size() << " to OBJ" << std::endl;
+
+		std::shared_ptr<std::vector<Vertex>> decodedVertices(new std::vector<Vertex>(vertices.size()));
+		std::shared_ptr<std::vector<uint32_t>> decodedIndices(new std::vector<uint32_t>(indices.size()));
+
+		return [data, decodedVertices, decodedIndices](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				MeshCodec::decode(data->data(), data->size(), jobSystem, decodedVertices->data(), decodedIndices->data());
+				doNotOptimize(decodedIndices->back());
+			}
+		};
+	});
+}
+
+static void addTextureBenchmarks(BenchmarkRunner& runner, const std::string& assetsPath)
+{
+	std::shared_ptr<std::vector<unsigned char>> jpeg(new std::vector<unsigned char>());
+	std::string textureName = "chalet";
+
+	if(!readWholeFile(assetsPath + "/Textures/chalet.jpg", *jpeg))
+	{
+		textureName = "generated_1024";
+	}
+
+	// Same call as YasEngine::decodeTexture, file is read in advance so only decoding is measured
+	runner.add("texture/decode/" + textureName, [jpeg]
+	{
+		if(jpeg->empty())
+		{
+			*jpeg = generateTextureJpeg();
+		}
+
+		return [jpeg](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				int width;
+				int height;
+				int channels;
+				stbi_uc* pixels = stbi_load_from_memory(jpeg->data(), static_cast<int>(jpeg->size()), &width, &height, &channels, STBI_rgb_alpha);
+
+				if(pixels == nullptr)
+				{
+					throw std::runtime_error("Failed to decode benchmark texture");
+				}
+				doNotOptimize(pixels[0]);
+				stbi_image_free(pixels);
+			}
+		};
+	});
+}
+
+// Rotations with translation, last row is changed so general inverse is needed
+static std::vector<glm::mat4> generateMatrices()
+{
+	std::vector<glm::mat4> matrices(BENCHMARK_MATRICES_NUMBER);
+
+	for(uint32_t i=0; i<BENCHMARK_MATRICES_NUMBER; i++)
+	{
+		matrices[i] = glm::translate(glm::rotate(glm::mat4(1.0F), 0.1F * i, glm::vec3(0.3F, 1.0F, 0.2F)), glm::vec3(0.5F * i, -0.25F * i, 1.0F));
+		matrices[i][0][3] = 0.001F * i;
+	}
+	return matrices;
+}
+
+// Benchmark would compare different things if results did not match
+static void checkAgainstGlm(const std::string& operation, const glm::mat4& expected, const YasMathLib::mat4& result)
+{
+	for(int i=0; i<4; i++)
+	{
+		for(int j=0; j<4; j++)
+		{
+			if(std::fabs(expected[i][j] - result[i][j]) > 1.0e-4F * std::max(1.0F, std::fabs(expected[i][j])))
+			{
+				throw std::runtime_error("YasMathLib " + operation + " differs from glm");
+			}
+		}
+	}
+}
+
+static std::shared_ptr<std::vector<YasMathLib::mat4>> generateCheckedMatrices()
+{
+	std::vector<glm::mat4> glmMatrices = generateMatrices();
+	std::shared_ptr<std::vector<YasMathLib::mat4>> matrices(new std::vector<YasMathLib::mat4>());
+
+	for(const glm::mat4& matrix: glmMatrices)
+	{
+		matrices->push_back(YasMathLib::fromGlm(matrix));
+	}
+
+	for(uint32_t i=0; i<BENCHMARK_MATRICES_NUMBER; i++)
+	{
+		uint32_t next = (i + 1) & (BENCHMARK_MATRICES_NUMBER - 1);
+		checkAgainstGlm("multiply", glmMatrices[i] * glmMatrices[next], (*matrices)[i] * (*matrices)[next]);
+		checkAgainstGlm("inverse", glm::inverse(glmMatrices[i]), YasMathLib::inverse((*matrices)[i]));
+	}
+	checkAgainstGlm("view projection", glm::perspective(glm::radians(45.0F), 1.5F, 0.1F, 10.0F) * glm::lookAt(glm::vec3(2.0F), glm::vec3(0.0F), glm::vec3(0.0F, 0.0F, 1.0F)),
+		YasMathLib::perspective(YasMathLib::radians(45.0F), 1.5F, 0.1F, 10.0F) * YasMathLib::lookAt(YasMathLib::vec3(2.0F), YasMathLib::vec3(0.0F), YasMathLib::vec3(0.0F, 0.0F, 1.0F)));
+	return matrices;
+}
+
+// Same ticks have to be computed whatever frame rate drives simulation, so final states must be equal bit for bit
+static void checkSimulationDeterminism()
+{
+	const uint32_t objectsNumber = 64;
+	// Ten minutes, end is tick time so every run interpolates to exactly the newest tick
+	const int64_t endNanoseconds = Simulation::getTickTime(36000);
+	// 30 Hz, 60 Hz, 144 Hz and 0 for irregular frames from 1 ms to 50 ms
+	const int64_t framesNanoseconds[4] = {NANOSECONDS_PER_SECOND / 30, NANOSECONDS_PER_SECOND / 60, NANOSECONDS_PER_SECOND / 144, 0};
+
+	std::vector<SimulatedObject> simulatedObjects(objectsNumber);
+	for(uint32_t i=0; i<objectsNumber; i++)
+	{
+		simulatedObjects[i].position = glm::vec3(0.1F * i, -0.05F * i, 0.0F);
+		simulatedObjects[i].angle = 0.01F * i;
+		// Negative, slow and fast rotations, some wrap around many times
+		simulatedObjects[i].angularVelocity = (static_cast<float>(i) - 20.0F) * 0.37F;
+	}
+
+	std::vector<float> expectedComponents;
+
+	for(int64_t frameNanoseconds: framesNanoseconds)
+	{
+		// xorshift, same irregular frames on every run
+		uint32_t state = 2463534242U;
+		auto random = [&state]
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		};
+
+		Simulation simulation;
+		simulation.initialize(simulatedObjects);
+		int64_t now = 0;
+
+		while(now < endNanoseconds)
+		{
+			now += frameNanoseconds > 0 ? frameNanoseconds : 1000000LL + static_cast<int64_t>(random() % 49000000U);
+			simulation.advanceTo(std::min(now, endNanoseconds));
+		}
+
+		TransformBatch transformBatch;
+		transformBatch.resize(objectsNumber);
+		simulation.interpolate(endNanoseconds, transformBatch);
+
+		std::vector<float> components;
+		for(uint32_t component=TRANSFORM_POSITION_X; component<=TRANSFORM_ROTATION_W; component++)
+		{
+			const float* values = transformBatch.getComponent(static_cast<TransformComponent>(component));
+			components.insert(components.end(), values, values + objectsNumber);
+		}
+
+		if(expectedComponents.empty())
+		{
+			expectedComponents = components;
+		}
+		else if(std::memcmp(components.data(), expectedComponents.data(), sizeof(float) * components.size()) != 0)
+		{
+			throw std::runtime_error("Simulation state differs when driven by frames of " + std::to_string(frameNanoseconds) + " ns");
+		}
+	}
+}
+
+static void addMathBenchmarks(BenchmarkRunner& runner)
+{
+	const uint32_t mask = BENCHMARK_MATRICES_NUMBER - 1;
+
+	runner.add("math/mat4_multiply/glm", [mask]
+	{
+		std::shared_ptr<std::vector<glm::mat4>> matrices(new std::vector<glm::mat4>(generateMatrices()));
+
+		return [matrices, mask](uint64_t iterations)
+		{
+			const std::vector<glm::mat4>& m = *matrices;
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				glm::mat4 product = m[i & mask] * m[(i + 1) & mask];
+				doNotOptimize(product);
+			}
+		};
+	});
+
+	runner.add("math/mat4_multiply/yas", [mask]
+	{
+		std::shared_ptr<std::vector<YasMathLib::mat4>> matrices = generateCheckedMatrices();
+
+		return [matrices, mask](uint64_t iterations)
+		{
+			const std::vector<YasMathLib::mat4>& m = *matrices;
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				YasMathLib::mat4 product = m[i & mask] * m[(i + 1) & mask];
+				doNotOptimize(product);
+			}
+		};
+	});
+
+	runner.add("math/mat4_inverse/glm", [mask]
+	{
+		std::shared_ptr<std::vector<glm::mat4>> matrices(new std::vector<glm::mat4>(generateMatrices()));
+
+		return [matrices, mask](uint64_t iterations)
+		{
+			const std::vector<glm::mat4>& m = *matrices;
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				glm::mat4 inverse = glm::inverse(m[i & mask]);
+				doNotOptimize(inverse);
+			}
+		};
+	});
+
+	runner.add("math/mat4_inverse/yas", [mask]
+	{
+		std::shared_ptr<std::vector<YasMathLib::mat4>> matrices = generateCheckedMatrices();
+
+		return [matrices, mask](uint64_t iterations)
+		{
+			const std::vector<YasMathLib::mat4>& m = *matrices;
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				YasMathLib::mat4 inverse = YasMathLib::inverse(m[i & mask]);
+				doNotOptimize(inverse);
+			}
+		};
+	});
+
+	// Camera part of YasEngine::updateUniformBuffer
+	runner.add("math/view_projection", []
+	{
+		return [](uint64_t iterations)
+		{
+			float aspectRatio = 16.0F / 9.0F;
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				YasMathLib::mat4 viewProjection = computeViewProjection(aspectRatio);
+				doNotOptimize(viewProjection);
+				aspectRatio += 1.0e-7F;
+			}
+		};
+	});
+
+	// One fixed tick of all objects, the same ticks are computed at any frame rate
+	runner.add("math/simulation_advance_1024", []
+	{
+		checkSimulationDeterminism();
+
+		std::shared_ptr<Simulation> simulation(new Simulation());
+		std::vector<SimulatedObject> simulatedObjects(BENCHMARK_OBJECTS_NUMBER);
+
+		for(uint32_t i=0; i<BENCHMARK_OBJECTS_NUMBER; i++)
+		{
+			simulatedObjects[i].position = glm::vec3(static_cast<float>(i % 32), static_cast<float>(i / 32), 0.0F);
+			simulatedObjects[i].angle = 0.0F;
+			simulatedObjects[i].angularVelocity = 0.001F * i;
+		}
+		simulation->initialize(simulatedObjects);
+		// Time keeps growing over repetitions, every iteration computes one new tick
+		std::shared_ptr<uint64_t> tick(new uint64_t(0));
+
+		return [simulation, tick](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				simulation->advanceTo(Simulation::getTickTime(++*tick));
+			}
+		};
+	});
+
+	// Model matrices written by Simulation::interpolate every frame
+	runner.add("math/simulation_interpolate_1024", []
+	{
+		std::shared_ptr<Simulation> simulation(new Simulation());
+		std::shared_ptr<TransformBatch> transformBatch(new TransformBatch());
+		std::vector<SimulatedObject> simulatedObjects(BENCHMARK_OBJECTS_NUMBER);
+
+		for(uint32_t i=0; i<BENCHMARK_OBJECTS_NUMBER; i++)
+		{
+			simulatedObjects[i].position = glm::vec3(static_cast<float>(i % 32), static_cast<float>(i / 32), 0.0F);
+			simulatedObjects[i].angle = 0.0F;
+			simulatedObjects[i].angularVelocity = 0.001F * i;
+		}
+		simulation->initialize(simulatedObjects);
+		simulation->advanceTo(SIMULATION_TICK_NANOSECONDS * 2);
+		transformBatch->resize(BENCHMARK_OBJECTS_NUMBER);
+
+		return [simulation, transformBatch](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				simulation->interpolate(SIMULATION_TICK_NANOSECONDS + static_cast<int64_t>(i % SIMULATION_TICK_NANOSECONDS), *transformBatch);
+				doNotOptimize(*transformBatch);
+			}
+		};
+	});
+}
+
+// Frame timer driven through 72 hours of frames must measure deltas and simulation time exactly, the same as right after start
+static void checkLongUptime()
+{
+	const int64_t uptimeNanoseconds = 72LL * 3600LL * NANOSECONDS_PER_SECOND;
+	// Monotonic clock does not start at zero, machine can run for weeks before engine starts
+	const int64_t clockStart = 30LL * 24LL * 3600LL * NANOSECONDS_PER_SECOND + 123456789LL;
+
+	// xorshift, same frame times on every run
+	uint64_t state = 0x2545F4914F6CDD1DULL;
+	auto random = [&state]
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	};
+
+	FrameTimer frameTimer;
+	frameTimer.reset(clockStart);
+	int64_t now = clockStart;
+	// What accumulator of float seconds would give, printed to show error avoided by integer nanoseconds
+	float floatSimulationSeconds = 0.0F;
+	double maxAlphaError = 0.0;
+
+	while(now - clockStart < uptimeNanoseconds)
+	{
+		// Frames from 5 ms to 40 ms, not multiples of simulation tick
+		const int64_t frameNanoseconds = 5000000LL + static_cast<int64_t>(random() % 35000000ULL);
+		now += frameNanoseconds;
+		double deltaSeconds = frameTimer.tick(now);
+		floatSimulationSeconds += static_cast<float>(deltaSeconds);
+
+		if(frameTimer.getDeltaNanoseconds() != frameNanoseconds || deltaSeconds != static_cast<double>(frameNanoseconds) / NANOSECONDS_PER_SECOND)
+		{
+			throw std::runtime_error("Frame timer delta lost precision after " + std::to_string(frameTimer.getFramesNumber()) + " frames");
+		}
+
+		if(frameTimer.getSimulationNanoseconds() != now - clockStart)
+		{
+			throw std::runtime_error("Frame timer simulation time drifted after " + std::to_string(frameTimer.getFramesNumber()) + " frames");
+		}
+
+		// Interpolation factor of simulation is computed from integer time since newest tick, the same way as Simulation::interpolate
+		const int64_t simulationNanoseconds = frameTimer.getSimulationNanoseconds();
+		const uint64_t previousTick = static_cast<uint64_t>(simulationNanoseconds / SIMULATION_TICK_NANOSECONDS);
+		double alpha = Clock::toSeconds(simulationNanoseconds - Simulation::getTickTime(previousTick)) / Clock::toSeconds(SIMULATION_TICK_NANOSECONDS);
+		double expectedAlpha = static_cast<double>(simulationNanoseconds % SIMULATION_TICK_NANOSECONDS) / SIMULATION_TICK_NANOSECONDS;
+		maxAlphaError = std::max(maxAlphaError, std::abs(alpha - expectedAlpha));
+	}
+
+	// Double seconds of 72 hours still resolve well under a nanosecond
+	double simulationSecondsError = std::abs(frameTimer.getSimulationSeconds() - static_cast<double>(now - clockStart) / NANOSECONDS_PER_SECOND);
+	if(simulationSecondsError > 1.0e-9 || maxAlphaError > 1.0e-9)
+	{
+		throw std::runtime_error("Frame timer seconds lost precision after 72 hours");
+	}
+
+	std::cerr << "clock/frame_timer_tick: " << frameTimer.getFramesNumber() << " frames in 72 hours exact, float seconds accumulator would be off by "
+		<< std::abs(static_cast<double>(floatSimulationSeconds) - frameTimer.getSimulationSeconds()) << " s" << std::endl;
+}
+
+static void addClockBenchmarks(BenchmarkRunner& runner)
+{
+	runner.add("clock/frame_timer_tick", []
+	{
+		checkLongUptime();
+
+		return [](uint64_t iterations)
+		{
+			FrameTimer frameTimer;
+			frameTimer.reset(0);
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				doNotOptimize(frameTimer.tick(static_cast<int64_t>(i) * SIMULATION_TICK_NANOSECONDS));
+			}
+		};
+	});
+}
+
+// Capabilities of device made up by hand, UUID bytes count up from first one
+static PhysicalDeviceCapabilities createDeviceCapabilities(const char* name, VkPhysicalDeviceType deviceType, VkDeviceSize deviceLocalMemory, uint8_t firstUUIDByte)
+{
+	PhysicalDeviceCapabilities capabilities = {};
+	std::strncpy(capabilities.properties.deviceName, name, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+	capabilities.properties.deviceType = deviceType;
+	capabilities.deviceLocalMemory = deviceLocalMemory;
+	for(uint32_t i=0; i<VK_UUID_SIZE; i++)
+	{
+		capabilities.deviceUUID[i] = static_cast<uint8_t>(firstUUIDByte + i * 0x11);
+	}
+	return capabilities;
+}
+
+static std::vector<PhysicalDeviceCapabilities> createDeviceSelectionCandidates()
+{
+	const VkDeviceSize gigabyte = 1024ULL * 1024 * 1024;
+	std::vector<PhysicalDeviceCapabilities> candidates;
+	// Software rasterizer reports all system memory as device local
+	candidates.push_back(createDeviceCapabilities("llvmpipe (LLVM 15.0.7, 256 bits)", VK_PHYSICAL_DEVICE_TYPE_CPU, 64 * gigabyte, 0x00));
+	// Shared heap larger than memory of discrete GPU, with every feature
+	candidates.push_back(createDeviceCapabilities("Intel(R) UHD Graphics 770", VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU, 32 * gigabyte, 0x10));
+	candidates.back().dedicatedTransferQueue = true;
+	candidates.back().dedicatedComputeQueue = true;
+	candidates.back().descriptorIndexing = true;
+	candidates.back().timelineSemaphore = true;
+	candidates.push_back(createDeviceCapabilities("NVIDIA GeForce GTX 1050", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 2 * gigabyte, 0x20));
+	candidates.push_back(createDeviceCapabilities("AMD Radeon RX 6800", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 16 * gigabyte, 0x30));
+	return candidates;
+}
+
+// Index of candidate with highest score, first one on tie like selectPhysicalDevice
+static size_t selectBestDevice(const std::vector<PhysicalDeviceCapabilities>& candidates)
+{
+	size_t best = 0;
+	uint64_t bestScore = 0;
+	for(size_t i=0; i<candidates.size(); i++)
+	{
+		uint64_t score = DeviceSelection::scorePhysicalDevice(candidates[i]);
+		if(score > bestScore)
+		{
+			best = i;
+			bestScore = score;
+		}
+	}
+	return best;
+}
+
+// Scoring and matching of preferred device checked on devices made up by hand, no Vulkan device is needed
+static void checkDeviceSelection()
+{
+	const VkDeviceSize gigabyte = 1024ULL * 1024 * 1024;
+	std::vector<PhysicalDeviceCapabilities> candidates = createDeviceSelectionCandidates();
+
+	if(selectBestDevice(candidates) != 3)
+	{
+		throw std::runtime_error("Discrete GPU with most memory was not selected");
+	}
+
+	// Device type dominates memory and features
+	if(DeviceSelection::scorePhysicalDevice(candidates[2]) <= DeviceSelection::scorePhysicalDevice(candidates[1])
+		|| DeviceSelection::scorePhysicalDevice(candidates[1]) <= DeviceSelection::scorePhysicalDevice(candidates[0]))
+	{
+		throw std::runtime_error("Device type does not dominate device score");
+	}
+
+	// Memory contribution is capped below next device type even for absurd heap
+	PhysicalDeviceCapabilities hugeIntegrated = createDeviceCapabilities("Integrated", VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU, 1ULL << 62, 0x40);
+	hugeIntegrated.dedicatedTransferQueue = true;
+	hugeIntegrated.dedicatedComputeQueue = true;
+	hugeIntegrated.descriptorIndexing = true;
+	hugeIntegrated.timelineSemaphore = true;
+	PhysicalDeviceCapabilities smallDiscrete = createDeviceCapabilities("Discrete", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 0, 0x50);
+	if(DeviceSelection::scorePhysicalDevice(smallDiscrete) <= DeviceSelection::scorePhysicalDevice(hugeIntegrated))
+	{
+		throw std::runtime_error("Memory of integrated GPU outweighs discrete GPU");
+	}
+
+	// Between devices of the same type queues and features break tie of equal memory
+	PhysicalDeviceCapabilities plain = createDeviceCapabilities("Plain", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 8 * gigabyte, 0x60);
+	PhysicalDeviceCapabilities withQueue = plain;
+	withQueue.dedicatedComputeQueue = true;
+	PhysicalDeviceCapabilities withFeature = plain;
+	withFeature.timelineSemaphore = true;
+	PhysicalDeviceCapabilities moreMemory = plain;
+	moreMemory.deviceLocalMemory = 9 * gigabyte;
+	if(DeviceSelection::scorePhysicalDevice(withQueue) <= DeviceSelection::scorePhysicalDevice(withFeature)
+		|| DeviceSelection::scorePhysicalDevice(withFeature) <= DeviceSelection::scorePhysicalDevice(plain)
+		|| DeviceSelection::scorePhysicalDevice(moreMemory) <= DeviceSelection::scorePhysicalDevice(plain))
+	{
+		throw std::runtime_error("Queues, features or memory do not break tie of devices");
+	}
+
+	// Preferred device by UUID in any case with or without dashes, or by name substring
+	struct PreferredDeviceCase
+	{
+		std::string preferredDevice;
+		size_t candidate;
+		bool matches;
+	};
+	const std::string uuid = DeviceSelection::formatUUID(candidates[2].deviceUUID);
+	std::string upperUUIDWithDashes = uuid.substr(0, 8) + "-" + uuid.substr(8, 4) + "-" + uuid.substr(12, 4) + "-" + uuid.substr(16, 4) + "-" + uuid.substr(20);
+	std::transform(upperUUIDWithDashes.begin(), upperUUIDWithDashes.end(), upperUUIDWithDashes.begin(), [](char character) { return static_cast<char>(std::toupper(static_cast<unsigned char>(character))); });
+	const std::vector<PreferredDeviceCase> preferredDeviceCases =
+	{
+		{uuid, 2, true},
+		{upperUUIDWithDashes, 2, true},
+		{uuid, 3, false},
+		{"llvmpipe", 0, true},
+		{"LLVMPIPE", 0, true},
+		{"geforce gtx", 2, true},
+		{"GeForce", 3, false},
+		{"uhd graphics 770", 1, true},
+		{"", 1, false},
+		{"------", 1, false},
+	};
+
+	for(const PreferredDeviceCase& preferredDeviceCase: preferredDeviceCases)
+	{
+		if(DeviceSelection::matchesPreferredDevice(candidates[preferredDeviceCase.candidate], preferredDeviceCase.preferredDevice) != preferredDeviceCase.matches)
+		{
+			throw std::runtime_error("Preferred device \"" + preferredDeviceCase.preferredDevice + "\" matched " + candidates[preferredDeviceCase.candidate].properties.deviceName + " wrongly");
+		}
+	}
+}
+
+static void addDeviceBenchmarks(BenchmarkRunner& runner)
+{
+	runner.add("device/select_of_4", []
+	{
+		checkDeviceSelection();
+		std::shared_ptr<std::vector<PhysicalDeviceCapabilities>> candidates(new std::vector<PhysicalDeviceCapabilities>(createDeviceSelectionCandidates()));
+
+		return [candidates](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				doNotOptimize(selectBestDevice(*candidates));
+				doNotOptimize(DeviceSelection::matchesPreferredDevice((*candidates)[i & 3], "radeon"));
+			}
+		};
+	});
+}
+
+struct TransformScene
+{
+	TransformBatch transformBatch;
+	// Same transforms in array of structures for per object version
+	std::vector<YasMathLib::vec3> positions;
+	std::vector<YasMathLib::quat> rotations;
+	std::vector<YasMathLib::vec3> scales;
+	YasMathLib::mat4 viewProjection;
+	std::vector<YasMathLib::mat4> world;
+	std::vector<YasMathLib::mat4> modelViewProjections;
+};
+
+static std::shared_ptr<TransformScene> createTransformScene()
+{
+	std::shared_ptr<TransformScene> scene(new TransformScene());
+	scene->transformBatch.resize(BENCHMARK_TRANSFORMS_NUMBER);
+	scene->viewProjection = computeViewProjection(16.0F / 9.0F);
+	scene->world.resize(BENCHMARK_TRANSFORMS_NUMBER);
+	scene->modelViewProjections.resize(BENCHMARK_TRANSFORMS_NUMBER);
+
+	for(uint32_t i=0; i<BENCHMARK_TRANSFORMS_NUMBER; i++)
+	{
+		YasMathLib::vec3 position(0.01F * (i % 256), 0.01F * (i / 256), -0.5F);
+		YasMathLib::quat rotation = YasMathLib::angleAxis(0.001F * i, YasMathLib::normalize(YasMathLib::vec3(0.3F, 1.0F, 0.2F)));
+		YasMathLib::vec3 scale(1.0F + 0.0001F * i);
+		scene->positions.push_back(position);
+		scene->rotations.push_back(rotation);
+		scene->scales.push_back(scale);
+		scene->transformBatch.setPosition(i, position);
+		scene->transformBatch.setRotation(i, rotation);
+		scene->transformBatch.setScale(i, scale);
+	}
+	return scene;
+}
+
+static void computeTransformsPerObject(TransformScene& scene)
+{
+	for(uint32_t i=0; i<BENCHMARK_TRANSFORMS_NUMBER; i++)
+	{
+		YasMathLib::mat4 world = YasMathLib::scale(YasMathLib::translate(YasMathLib::mat4(1.0F), scene.positions[i]) * YasMathLib::toMat4(scene.rotations[i]), scene.scales[i]);
+		scene.world[i] = world;
+		scene.modelViewProjections[i] = scene.viewProjection * world;
+	}
+}
+
+static void checkTransforms(const TransformScene& scene, const std::vector<YasMathLib::mat4>& expectedWorld, const std::vector<YasMathLib::mat4>& expectedModelViewProjections)
+{
+	for(uint32_t i=0; i<BENCHMARK_TRANSFORMS_NUMBER; i++)
+	{
+		for(int column=0; column<4; column++)
+		{
+			if(!(scene.world[i][column] == expectedWorld[i][column]) || !(scene.modelViewProjections[i][column] == expectedModelViewProjections[i][column]))
+			{
+				throw std::runtime_error("Batched transforms differ from per object transforms");
+			}
+		}
+	}
+}
+
+// Matrices per second are BENCHMARK_TRANSFORMS_NUMBER divided by time of one iteration
+static void addTransformBenchmarks(BenchmarkRunner& runner)
+{
+	runner.add("transform/per_object_65536", []
+	{
+		std::shared_ptr<TransformScene> scene = createTransformScene();
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				computeTransformsPerObject(*scene);
+				doNotOptimize(scene->modelViewProjections.back());
+			}
+		};
+	});
+
+	runner.add("transform/batch_65536", []
+	{
+		std::shared_ptr<TransformScene> scene = createTransformScene();
+		computeTransformsPerObject(*scene);
+		std::vector<YasMathLib::mat4> expectedWorld = scene->world;
+		std::vector<YasMathLib::mat4> expectedModelViewProjections = scene->modelViewProjections;
+		scene->transformBatch.computeMatrices(scene->viewProjection, 0, BENCHMARK_TRANSFORMS_NUMBER, &scene->world[0][0].x, sizeof(YasMathLib::mat4), &scene->modelViewProjections[0][0].x, sizeof(YasMathLib::mat4));
+		checkTransforms(*scene, expectedWorld, expectedModelViewProjections);
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				scene->transformBatch.computeMatrices(scene->viewProjection, 0, BENCHMARK_TRANSFORMS_NUMBER, &scene->world[0][0].x, sizeof(YasMathLib::mat4), &scene->modelViewProjections[0][0].x, sizeof(YasMathLib::mat4));
+				doNotOptimize(scene->modelViewProjections.back());
+			}
+		};
+	});
+
+	runner.add("transform/batch_parallel_for_65536", []
+	{
+		std::shared_ptr<TransformScene> scene = createTransformScene();
+		computeTransformsPerObject(*scene);
+		std::vector<YasMathLib::mat4> expectedWorld = scene->world;
+		std::vector<YasMathLib::mat4> expectedModelViewProjections = scene->modelViewProjections;
+		scene->transformBatch.computeMatrices(jobSystem, scene->viewProjection, &scene->world[0][0].x, sizeof(YasMathLib::mat4), &scene->modelViewProjections[0][0].x, sizeof(YasMathLib::mat4));
+		checkTransforms(*scene, expectedWorld, expectedModelViewProjections);
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				scene->transformBatch.computeMatrices(jobSystem, scene->viewProjection, &scene->world[0][0].x, sizeof(YasMathLib::mat4), &scene->modelViewProjections[0][0].x, sizeof(YasMathLib::mat4));
+				doNotOptimize(scene->modelViewProjections.back());
+			}
+		};
+	});
+}
+
+// Vertex stage of vertShader.vert run on CPU, as lavapipe runs it, over every vertex of model. Matrices are read again for
+// every vertex so products of uniforms are not hoisted out of loop, shader invocations do not share them either.
+struct VertexStageScene
+{
+	std::vector<YasMathLib::vec4> positions;
+	std::vector<YasMathLib::vec4> clipPositions;
+	YasMathLib::mat4 model;
+	YasMathLib::mat4 view;
+	YasMathLib::mat4 projection;
+	YasMathLib::mat4 viewProjection;
+};
+
+static std::shared_ptr<VertexStageScene> createVertexStageScene(const std::string& modelPath)
+{
+	if(modelPath == GENERATED_MODEL_PATH)
+	{
+		writeGeneratedModel(modelPath);
+	}
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	ModelLoader::loadObj(modelPath, jobSystem, vertices, indices);
+
+	std::shared_ptr<VertexStageScene> scene(new VertexStageScene());
+	for(const Vertex& vertex: vertices)
+	{
+		scene->positions.push_back(YasMathLib::vec4(vertex.pos.x, vertex.pos.y, vertex.pos.z, 1.0F));
+	}
+	scene->clipPositions.resize(vertices.size());
+	scene->model = YasMathLib::translate(YasMathLib::mat4(1.0F), YasMathLib::vec3(0.1F, -0.2F, 0.05F));
+	scene->view = YasMathLib::lookAt(YasMathLib::vec3(2.0F, 2.0F, 2.0F), YasMathLib::vec3(0.0F, 0.0F, 0.0F), YasMathLib::vec3(0.0F, 0.0F, 1.0F));
+	scene->projection = YasMathLib::perspective(YasMathLib::radians(45.0F), 16.0F / 9.0F, 0.1F, 10.0F);
+	scene->projection[1][1] *= -1;
+	scene->viewProjection = scene->projection * scene->view;
+	return scene;
+}
+
+// Three matrices in uniform buffer, gl_Position = ubo.proj * ubo.view * ubo.model * position: two matrix products and one matrix times vector
+static void transformVerticesUniformChain(VertexStageScene& scene)
+{
+	for(size_t i=0; i<scene.positions.size(); i++)
+	{
+		doNotOptimize(scene.model);
+		scene.clipPositions[i] = scene.projection * scene.view * scene.model * scene.positions[i];
+	}
+}
+
+// View-projection in uniform buffer and model in push constants, gl_Position = ubo.viewProjection * (push.model * position): two matrix times vector
+static void transformVerticesPushConstant(VertexStageScene& scene)
+{
+	for(size_t i=0; i<scene.positions.size(); i++)
+	{
+		doNotOptimize(scene.model);
+		scene.clipPositions[i] = scene.viewProjection * (scene.model * scene.positions[i]);
+	}
+}
+
+// Vertices per second are vertices of model divided by time of one iteration. On GPU the same change is measured by
+// profiler region "Render pass" of headless run, compared between builds before and after change.
+static void addVertexStageBenchmarks(BenchmarkRunner& runner, const std::string& assetsPath)
+{
+	std::string modelPath = assetsPath + "/Models/chalet.obj";
+	std::string modelName = "chalet";
+
+	if(!std::ifstream(modelPath).is_open())
+	{
+		modelPath = GENERATED_MODEL_PATH;
+		modelName = "generated_sphere";
+	}
+
+	runner.add("vertex_stage/uniform_chain/" + modelName, [modelPath]
+	{
+		std::shared_ptr<VertexStageScene> scene = createVertexStageScene(modelPath);
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				transformVerticesUniformChain(*scene);
+				doNotOptimize(scene->clipPositions.back());
+			}
+		};
+	});
+
+	runner.add("vertex_stage/push_constant/" + modelName, [modelPath]
+	{
+		std::shared_ptr<VertexStageScene> scene = createVertexStageScene(modelPath);
+
+		// Both paths have to put vertices at the same place, only order of multiplication differs
+		transformVerticesUniformChain(*scene);
+		std::vector<YasMathLib::vec4> expected = scene->clipPositions;
+		transformVerticesPushConstant(*scene);
+
+		for(size_t i=0; i<expected.size(); i++)
+		{
+			for(int axis=0; axis<4; axis++)
+			{
+				if(std::fabs(expected[i][axis] - scene->clipPositions[i][axis]) > 1.0e-4F * std::max(1.0F, std::fabs(expected[i][axis])))
+				{
+					throw std::runtime_error("Push constant vertex path differs from uniform chain");
+				}
+			}
+		}
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				transformVerticesPushConstant(*scene);
+				doNotOptimize(scene->clipPositions.back());
+			}
+		};
+	});
+}
+
+// Characters set up like in engine, one after another in skinning matrices and skinned vertices
+struct SkinningScene
+{
+	SkinnedMesh mesh;
+	std::vector<SkinnedCharacter> characters;
+	std::vector<YasMathLib::mat4> skinningMatrices;
+	std::vector<Vertex> skinnedVertices;
+};
+
+static void animateAndSkin(SkinningScene& scene, float time, uint32_t begin, uint32_t end)
+{
+	const uint32_t jointsNumber = scene.mesh.skeleton.getJointsNumber();
+	const uint32_t verticesNumber = static_cast<uint32_t>(scene.mesh.vertices.size());
+
+	for(uint32_t i=begin; i<end; i++)
+	{
+		YasMathLib::mat4* characterMatrices = &scene.skinningMatrices[i * jointsNumber];
+		scene.characters[i].computeSkinningMatrices(time, characterMatrices);
+		SkinningPass::skinVertices(scene.mesh.vertices.data(), scene.mesh.skinWeights.data(), verticesNumber, characterMatrices, &scene.skinnedVertices[i * verticesNumber]);
+	}
+}
+
+// First character does not blend. At time of key its pose is that key, so joint chain and skinning are computed again
+// per joint and per vertex with YasMathLib and compared. All other characters have to stay inside bounds of mesh.
+static void checkSkinning(SkinningScene& scene)
+{
+	const uint32_t key = 7;
+	const uint32_t jointsNumber = scene.mesh.skeleton.getJointsNumber();
+	const uint32_t verticesNumber = static_cast<uint32_t>(scene.mesh.vertices.size());
+	animateAndSkin(scene, key / 30.0F, 0, BENCHMARK_CHARACTERS_NUMBER);
+
+	TransformBatch& pose = scene.mesh.clips[0].getKey(key);
+	std::vector<YasMathLib::mat4> modelMatrices(jointsNumber);
+	for(uint32_t joint=0; joint<jointsNumber; joint++)
+	{
+		YasMathLib::vec3 position(pose.getComponent(TRANSFORM_POSITION_X)[joint], pose.getComponent(TRANSFORM_POSITION_Y)[joint], pose.getComponent(TRANSFORM_POSITION_Z)[joint]);
+		YasMathLib::quat rotation(pose.getComponent(TRANSFORM_ROTATION_W)[joint], pose.getComponent(TRANSFORM_ROTATION_X)[joint], pose.getComponent(TRANSFORM_ROTATION_Y)[joint], pose.getComponent(TRANSFORM_ROTATION_Z)[joint]);
+		YasMathLib::mat4 local = YasMathLib::translate(YasMathLib::mat4(1.0F), position) * YasMathLib::toMat4(rotation);
+		int32_t parent = scene.mesh.skeleton.getParent(joint);
+		modelMatrices[joint] = parent < 0 ? local : modelMatrices[parent] * local;
+	}
+
+	std::vector<YasMathLib::mat4> skinningMatrices(jointsNumber);
+	scene.mesh.skeleton.computeSkinningMatrices(modelMatrices.data(), skinningMatrices.data());
+
+	for(uint32_t i=0; i<verticesNumber; i++)
+	{
+		const SkinWeights& skin = scene.mesh.skinWeights[i];
+		YasMathLib::mat4 blended;
+		for(int column=0; column<4; column++)
+		{
+			blended[column] = YasMathLib::vec4(0.0F);
+			for(uint32_t influence=0; influence<SKIN_JOINTS_PER_VERTEX; influence++)
+			{
+				blended[column] = blended[column] + skinningMatrices[skin.jointIndices[influence]][column] * skin.weights[influence];
+			}
+		}
+
+		const glm::vec3& bindPosition = scene.mesh.vertices[i].pos;
+		YasMathLib::vec4 expected = blended * YasMathLib::vec4(bindPosition.x, bindPosition.y, bindPosition.z, 1.0F);
+		const glm::vec3& skinned = scene.skinnedVertices[i].pos;
+
+		if(std::fabs(skinned.x - expected.x) > 1.0e-4F || std::fabs(skinned.y - expected.y) > 1.0e-4F || std::fabs(skinned.z - expected.z) > 1.0e-4F)
+		{
+			throw std::runtime_error("Skinned vertex differs from per vertex reference");
+		}
+	}
+
+	for(const Vertex& vertex: scene.skinnedVertices)
+	{
+		for(int axis=0; axis<3; axis++)
+		{
+			if(!(vertex.pos[axis] >= scene.mesh.boundsMin[axis] && vertex.pos[axis] <= scene.mesh.boundsMax[axis]))
+			{
+				throw std::runtime_error("Skinned vertex is outside of mesh bounds");
+			}
+		}
+	}
+}
+
+static std::shared_ptr<SkinningScene> createSkinningScene()
+{
+	std::shared_ptr<SkinningScene> scene(new SkinningScene());
+	SkinningPass::createTestMesh(TEST_CHARACTER_JOINTS, TEST_CHARACTER_RINGS_PER_JOINT, TEST_CHARACTER_SEGMENTS, scene->mesh);
+	scene->characters.resize(BENCHMARK_CHARACTERS_NUMBER);
+
+	for(uint32_t i=0; i<BENCHMARK_CHARACTERS_NUMBER; i++)
+	{
+		// First character is checked against reference, so it has no time offset and does not blend
+		scene->characters[i].initialize(&scene->mesh, 0.37F * i, (i % 5) / 4.0F);
+	}
+
+	scene->skinningMatrices.resize(BENCHMARK_CHARACTERS_NUMBER * scene->mesh.skeleton.getJointsNumber());
+	scene->skinnedVertices.resize(BENCHMARK_CHARACTERS_NUMBER * scene->mesh.vertices.size());
+	checkSkinning(*scene);
+	return scene;
+}
+
+// Skinned vertices per millisecond are 100 * 2080 divided by time of one iteration.
+// Compute shader path is measured by GPU profiler region "Skinning" of headless run with --characters.
+static void addSkinningBenchmarks(BenchmarkRunner& runner)
+{
+	runner.add("skinning/animate_100", []
+	{
+		std::shared_ptr<SkinningScene> scene = createSkinningScene();
+
+		return [scene](uint64_t iterations)
+		{
+			const uint32_t jointsNumber = scene->mesh.skeleton.getJointsNumber();
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				for(uint32_t character=0; character<BENCHMARK_CHARACTERS_NUMBER; character++)
+				{
+					scene->characters[character].computeSkinningMatrices(0.001F * (i % 1000), &scene->skinningMatrices[character * jointsNumber]);
+				}
+				doNotOptimize(scene->skinningMatrices.back());
+			}
+		};
+	});
+
+	runner.add("skinning/cpu_skin_100", []
+	{
+		std::shared_ptr<SkinningScene> scene = createSkinningScene();
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				animateAndSkin(*scene, 0.001F * (i % 1000), 0, BENCHMARK_CHARACTERS_NUMBER);
+				doNotOptimize(scene->skinnedVertices.back());
+			}
+		};
+	});
+
+	runner.add("skinning/cpu_skin_100_parallel_for", []
+	{
+		std::shared_ptr<SkinningScene> scene = createSkinningScene();
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				SkinningScene* sceneData = scene.get();
+				float time = 0.001F * (i % 1000);
+				jobSystem.parallelFor(0, BENCHMARK_CHARACTERS_NUMBER, 1, [sceneData, time](uint32_t begin, uint32_t end)
+				{
+					animateAndSkin(*sceneData, time, begin, end);
+				});
+				doNotOptimize(scene->skinnedVertices.back());
+			}
+		};
+	});
+}
+
+// Chase-Lev deque with one owner and several thieves. Owner pops after some pushes and whenever queue is full,
+// so last job is often raced for by pop and steal.
+static void checkJobQueueStress()
+{
+	const uint32_t jobsNumber = 200000;
+	const uint32_t thievesNumber = std::min(std::max(std::thread::hardware_concurrency(), 2U) - 1, 4U);
+
+	std::unique_ptr<JobQueue> queue(new JobQueue());
+	std::vector<Job> jobs(jobsNumber);
+	std::unique_ptr<std::atomic<uint32_t>[]> takenTimes(new std::atomic<uint32_t>[jobsNumber]);
+	for(uint32_t i=0; i<jobsNumber; i++)
+	{
+		takenTimes[i].store(0, std::memory_order_relaxed);
+	}
+	std::atomic<uint32_t> takenNumber(0);
+
+	auto take = [&](Job* job)
+	{
+		takenTimes[job - jobs.data()].fetch_add(1, std::memory_order_relaxed);
+		takenNumber.fetch_add(1, std::memory_order_relaxed);
+	};
+
+	std::vector<std::thread> thieves;
+	std::vector<uint32_t> stolenNumbers(thievesNumber, 0);
+	for(uint32_t i=0; i<thievesNumber; i++)
+	{
+		thieves.emplace_back([&, i]
+		{
+			while(takenNumber.load(std::memory_order_relaxed) < jobsNumber)
+			{
+				Job* job = queue->steal();
+				if(job != nullptr)
+				{
+					take(job);
+					++stolenNumbers[i];
+				}
+			}
+		});
+	}
+
+	// xorshift, same pattern of pushes and pops on every run
+	uint32_t state = 2463534242U;
+	for(uint32_t i=0; i<jobsNumber; i++)
+	{
+		while(!queue->push(&jobs[i]))
+		{
+			Job* job = queue->pop();
+			if(job != nullptr)
+			{
+				take(job);
+			}
+		}
+
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		if(state % 3 == 0)
+		{
+			Job* job = queue->pop();
+			if(job != nullptr)
+			{
+				take(job);
+			}
+		}
+	}
+
+	// Empty pop means thieves took the rest
+	while(Job* job = queue->pop())
+	{
+		take(job);
+	}
+
+	for(std::thread& thief: thieves)
+	{
+		thief.join();
+	}
+
+	uint32_t stolenNumber = 0;
+	for(uint32_t stolen: stolenNumbers)
+	{
+		stolenNumber += stolen;
+	}
+
+	for(uint32_t i=0; i<jobsNumber; i++)
+	{
+		if(takenTimes[i].load() != 1)
+		{
+			throw std::runtime_error("Job queue returned job " + std::to_string(i) + " " + std::to_string(takenTimes[i].load()) + " times");
+		}
+	}
+	std::cerr << "jobs/queue_push_pop: " << jobsNumber << " jobs taken once, " << stolenNumber << " by " << thievesNumber << " thieves" << std::endl;
+}
+
+// Several threads log while ring wraps and fills, then logger is stopped while they still write. Every message has to be
+// written exactly once, either by logger into file or directly to standard output, which is captured here.
+static void checkLogNoMessagesLost()
+{
+	const uint32_t threadsNumber = 4;
+	const char* const logPath = "benchmark_log_stress.txt";
+
+	std::ostringstream directOutput;
+	std::streambuf* standardOutput = std::cout.rdbuf(directOutput.rdbuf());
+	YasLog::start(logPath);
+
+	std::atomic<bool> stopping(false);
+	std::atomic<uint32_t> writtenTotal(0);
+	std::vector<uint32_t> writtenNumbers(threadsNumber, 0);
+	std::vector<std::thread> threads;
+
+	for(uint32_t i=0; i<threadsNumber; i++)
+	{
+		threads.emplace_back([&, i]
+		{
+			while(!stopping.load(std::memory_order_relaxed))
+			{
+				YasLog::write(YAS_LOG_LEVEL_INFO, "stress {} {}", i, writtenNumbers[i]);
+				++writtenNumbers[i];
+				writtenTotal.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+	}
+
+	// Several rounds of ring, so it is full for part of the time
+	while(writtenTotal.load(std::memory_order_relaxed) < 4 * LOG_RING_SIZE)
+	{
+		std::this_thread::yield();
+	}
+	stopping.store(true);
+	YasLog::stop();
+
+	for(std::thread& thread: threads)
+	{
+		thread.join();
+	}
+	std::cout.rdbuf(standardOutput);
+
+	std::vector<std::vector<uint32_t>> receivedTimes(threadsNumber);
+	for(uint32_t i=0; i<threadsNumber; i++)
+	{
+		receivedTimes[i].resize(writtenNumbers[i], 0);
+	}
+
+	std::ifstream logFile(logPath);
+	std::istringstream directLines(directOutput.str());
+	std::istream* inputs[2] = {&logFile, &directLines};
+	std::string line;
+
+	for(std::istream* input: inputs)
+	{
+		while(std::getline(*input, line))
+		{
+			size_t messageStart = line.find("INFO: stress ");
+			if(messageStart == std::string::npos)
+			{
+				continue;
+			}
+
+			uint32_t thread = 0;
+			uint32_t message = 0;
+			std::istringstream(line.substr(messageStart + 13)) >> thread >> message;
+			if(thread >= threadsNumber || message >= writtenNumbers[thread])
+			{
+				throw std::runtime_error("Logger wrote message which was not logged: " + line);
+			}
+			++receivedTimes[thread][message];
+		}
+	}
+	logFile.close();
+	std::remove(logPath);
+
+	for(uint32_t i=0; i<threadsNumber; i++)
+	{
+		for(uint32_t j=0; j<writtenNumbers[i]; j++)
+		{
+			if(receivedTimes[i][j] != 1)
+			{
+				throw std::runtime_error("Message " + std::to_string(j) + " of thread " + std::to_string(i) + " was written " + std::to_string(receivedTimes[i][j]) + " times");
+			}
+		}
+	}
+	std::cerr << "log/write_and_flush_5_arguments: " << writtenTotal.load() << " messages of " << threadsNumber << " threads written once" << std::endl;
+}
+
+// Inner scope which starts after allocation of outer scope overflowed to heap must free only its own blocks
+static void checkNestedArenaScopes()
+{
+	LinearArena arena(1024);
+
+	{
+		ArenaScope outerScope(arena);
+		char* outer = static_cast<char*>(arena.allocate(4096, 16));
+		std::memset(outer, 0x5A, 4096);
+
+		{
+			ArenaScope innerScope(arena);
+			arena.allocate(512, 16);
+			arena.allocate(8192, 16);
+		}
+
+		// Reset would grow arena by reallocating its memory and free block of outer scope
+		if(arena.getCapacity() != 1024)
+		{
+			throw std::runtime_error("Rewinding inner arena scope reset arena used by outer scope");
+		}
+
+		for(uint32_t i=0; i<4096; i++)
+		{
+			if(outer[i] != 0x5A)
+			{
+				throw std::runtime_error("Rewinding inner arena scope freed allocation of outer scope");
+			}
+		}
+	}
+
+	// Outermost scope ended, arena is empty and grows by everything which overflowed
+	if(arena.getCapacity() <= 1024 + 4096 + 8192)
+	{
+		throw std::runtime_error("Arena did not grow after overflow");
+	}
+}
+
+static void addContainerBenchmarks(BenchmarkRunner& runner)
+{
+	runner.add("arena/linear_arena_allocate_64", []
+	{
+		std::shared_ptr<LinearArena> arena(new LinearArena(FRAME_ARENA_SIZE));
+
+		return [arena](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				// Arena is reset like at start of frame before it fills up
+				if((i & 4095) == 0)
+				{
+					arena->reset();
+				}
+				doNotOptimize(arena->allocate(64, 16));
+			}
+		};
+	});
+
+	// Scratch arena used by temporary containers of one function
+	runner.add("arena/scope_allocate_64", []
+	{
+		checkNestedArenaScopes();
+		std::shared_ptr<LinearArena> arena(new LinearArena(SCRATCH_ARENA_SIZE));
+
+		return [arena](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				ArenaScope scope(*arena);
+				doNotOptimize(arena->allocate(64, 16));
+			}
+		};
+	});
+
+	runner.add("arena/heap_new_delete_64", []
+	{
+		return [](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				char* memory = new char[64];
+				doNotOptimize(memory);
+				delete[] memory;
+			}
+		};
+	});
+
+	runner.add("arena/arena_vector_push_back_1024", []
+	{
+		return [](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				ArenaScope arenaScope;
+				ArenaVector<uint32_t> values;
+				for(uint32_t j=0; j<1024; j++)
+				{
+					values.push_back(j);
+				}
+				doNotOptimize(values.back());
+			}
+		};
+	});
+
+	runner.add("arena/std_vector_push_back_1024", []
+	{
+		return [](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				std::vector<uint32_t> values;
+				for(uint32_t j=0; j<1024; j++)
+				{
+					values.push_back(j);
+				}
+				doNotOptimize(values.back());
+			}
+		};
+	});
+
+	// Work of recordCommandBuffer before any Vulkan call
+	runner.add("render_queue/submit_sort_4096", []
+	{
+		std::shared_ptr<FrameArena> frameArena(new FrameArena());
+		std::shared_ptr<RenderQueue> renderQueue(new RenderQueue());
+		frameArena->initialize(2, FRAME_ARENA_SIZE);
+
+		return [frameArena, renderQueue](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				frameArena->beginFrame(static_cast<uint32_t>(i & 1));
+				renderQueue->clear(frameArena->current(), BENCHMARK_PACKETS_NUMBER);
+
+				for(uint32_t j=0; j<BENCHMARK_PACKETS_NUMBER; j++)
+				{
+					DrawPacket drawPacket = {};
+					drawPacket.sortKey = makeSortKey(0, (j * 7) % 5, (j * 13) % 64, j % 256, (j * 2654435761U) >> 16);
+					drawPacket.indexCount = j;
+					renderQueue->submit(drawPacket);
+				}
+				renderQueue->sort();
+				doNotOptimize(renderQueue->size());
+			}
+		};
+	});
+
+	runner.add("render_queue/radix_sort_65536", []
+	{
+		std::shared_ptr<std::vector<uint64_t>> randomKeys(new std::vector<uint64_t>(BENCHMARK_SORT_KEYS_NUMBER));
+		uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+		for(uint64_t& key: *randomKeys)
+		{
+			// xorshift, same keys on every run
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			key = state;
+		}
+
+		return [randomKeys](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				ArenaScope arenaScope;
+				ArenaVector<uint64_t> keys(randomKeys->begin(), randomKeys->end());
+				ArenaVector<uint32_t> values(keys.size());
+				ArenaVector<uint64_t> keysTemp;
+				ArenaVector<uint32_t> valuesTemp;
+				RenderQueue::radixSort(keys, values, keysTemp, valuesTemp);
+				doNotOptimize(keys[0]);
+			}
+		};
+	});
+
+	runner.add("triple_buffer/publish_update", []
+	{
+		std::shared_ptr<TripleBuffer<uint64_t>> tripleBuffer(new TripleBuffer<uint64_t>());
+
+		return [tripleBuffer](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				tripleBuffer->getWriteBuffer() = i;
+				tripleBuffer->publish();
+				tripleBuffer->update();
+				doNotOptimize(tripleBuffer->getReadBuffer());
+			}
+		};
+	});
+
+	runner.add("jobs/run_wait", []
+	{
+		return [](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				JobCounter counter;
+				jobSystem.run([]
+				{
+				}, &counter);
+				jobSystem.wait(counter);
+			}
+		};
+	});
+
+	runner.add("jobs/parallel_for_1024", []
+	{
+		std::shared_ptr<std::vector<uint32_t>> values(new std::vector<uint32_t>(1024));
+
+		return [values](uint64_t iterations)
+		{
+			uint32_t* data = values->data();
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				jobSystem.parallelFor(0, 1024, 1, [data](uint32_t begin, uint32_t end)
+				{
+					for(uint32_t j=begin; j<end; j++)
+					{
+						++data[j];
+					}
+				});
+			}
+			doNotOptimize(data[0]);
+		};
+	});
+
+	// Owner pushes and pops while thieves steal, every job has to be taken exactly once.
+	// Queue uses only atomics, so this runs clean in build with SANITIZE=thread.
+	runner.add("jobs/queue_push_pop", []
+	{
+		checkJobQueueStress();
+		std::shared_ptr<JobQueue> queue(new JobQueue());
+		std::shared_ptr<Job> job(new Job());
+
+		return [queue, job](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				queue->push(job.get());
+				doNotOptimize(queue->pop());
+			}
+		};
+	});
+
+	// The same parallel transform work on job systems of 1 to all cores. Main thread is worker of global job system,
+	// so in these it is external thread which runs jobs while it waits, in place of worker 0.
+	const uint32_t coresNumber = std::max(std::thread::hardware_concurrency(), 1U);
+	std::vector<uint32_t> workersNumbers;
+	for(uint32_t workersNumber=1; workersNumber<coresNumber; workersNumber*=2)
+	{
+		workersNumbers.push_back(workersNumber);
+	}
+	workersNumbers.push_back(coresNumber);
+
+	for(uint32_t workersNumber: workersNumbers)
+	{
+		runner.add("jobs/scaling_transform_65536/workers_" + std::to_string(workersNumber), [workersNumber]
+		{
+			std::shared_ptr<TransformScene> scene = createTransformScene();
+
+			return [scene, workersNumber](uint64_t iterations)
+			{
+				JobSystem scalingJobSystem;
+				scalingJobSystem.initialize(workersNumber);
+				for(uint64_t i=0; i<iterations; i++)
+				{
+					scene->transformBatch.computeMatrices(scalingJobSystem, scene->viewProjection, &scene->world[0][0].x, sizeof(YasMathLib::mat4), &scene->modelViewProjections[0][0].x, sizeof(YasMathLib::mat4));
+					doNotOptimize(scene->modelViewProjections.back());
+				}
+				scalingJobSystem.shutdown();
+			};
+		});
+	}
+
+	// Whole path of message: copy into ring on caller and formatting and writing on logger thread
+	runner.add("log/write_and_flush_5_arguments", []
+	{
+		checkLogNoMessagesLost();
+		YasLog::start("benchmark_log.txt");
+
+		return [](uint64_t iterations)
+		{
+			std::string regionName = "Render pass";
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				YasLog::write(YAS_LOG_LEVEL_INFO, "FPS: {} culled {}/{} GPU {}: {} ms", 60.0 + i, i, 1024U, regionName, 0.25);
+			}
+			YasLog::flush();
+		};
+	});
+}
+
+struct ResidencyTrace
+{
+	std::vector<uint64_t> sizes;
+	// RESIDENCY_TRACE_VISIBLE_ASSETS + 1 requests per frame
+	std::vector<uint32_t> requests;
+};
+
+static void generateResidencyTrace(ResidencyTrace& trace)
+{
+	// xorshift, same trace on every run
+	uint64_t state = 0x9E3779B97F4A7C15ULL;
+	auto random = [&state]
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	};
+	trace.sizes.resize(RESIDENCY_TRACE_ASSETS);
+
+	for(uint64_t& size: trace.sizes)
+	{
+		size = 4096ULL << (random() % 7);
+	}
+
+	// Camera moves forward at varying speed, sometimes it stops and looks back over assets it passed
+	float position = 0.0F;
+
+	for(uint32_t frame=0; frame<RESIDENCY_TRACE_FRAMES; frame++)
+	{
+		position += static_cast<float>(random() % 100) / 200.0F;
+		uint32_t first = static_cast<uint32_t>(position);
+
+		if(random() % 64 == 0)
+		{
+			first = first > RESIDENCY_TRACE_VISIBLE_ASSETS * 4 ? first - RESIDENCY_TRACE_VISIBLE_ASSETS * 4 : 0;
+		}
+
+		for(uint32_t i=0; i<RESIDENCY_TRACE_VISIBLE_ASSETS; i++)
+		{
+			trace.requests.push_back((first + i) % RESIDENCY_TRACE_ASSETS);
+		}
+		trace.requests.push_back(random() % 4 == 0 ? random() % RESIDENCY_TRACE_ASSETS : random() % RESIDENCY_TRACE_LANDMARKS * (RESIDENCY_TRACE_ASSETS / RESIDENCY_TRACE_LANDMARKS));
+	}
+}
+
+// Returns hit rate of whole trace
+static double replayResidencyTrace(const ResidencyTrace& trace, uint64_t budget, ResidencyCache& cache, std::vector<uint32_t>& destroyedResources)
+{
+	cache.initialize(budget, RESIDENCY_TRACE_DELAY_FRAMES);
+
+	for(uint64_t size: trace.sizes)
+	{
+		cache.addResource(size);
+	}
+
+	for(size_t i=0; i<trace.requests.size(); i++)
+	{
+		cache.request(trace.requests[i]);
+
+		if(i % (RESIDENCY_TRACE_VISIBLE_ASSETS + 1) == RESIDENCY_TRACE_VISIBLE_ASSETS)
+		{
+			destroyedResources.clear();
+			cache.advanceFrame(destroyedResources);
+		}
+	}
+	return cache.getHitRate();
+}
+
+// Replays trace like replayResidencyTrace, but after every request checks that resident resources fit into budget,
+// unless cache counted current frame as over budget because resources used by frame alone do not fit
+static double checkResidencyReplay(const ResidencyTrace& trace, uint64_t budget, ResidencyCache& cache, std::vector<uint32_t>& destroyedResources)
+{
+	cache.initialize(budget, RESIDENCY_TRACE_DELAY_FRAMES);
+
+	for(uint64_t size: trace.sizes)
+	{
+		cache.addResource(size);
+	}
+
+	uint32_t overBudgetFrames = 0;
+
+	for(size_t i=0; i<trace.requests.size(); i++)
+	{
+		cache.request(trace.requests[i]);
+		ResidencyStatistics statistics = cache.getStatistics();
+
+		if(statistics.residentSize > budget && statistics.overBudgetFrames == overBudgetFrames)
+		{
+			throw std::runtime_error("Residency cache exceeded budget of " + std::to_string(budget) + " bytes in frame which fits into it");
+		}
+
+		if(i % (RESIDENCY_TRACE_VISIBLE_ASSETS + 1) == RESIDENCY_TRACE_VISIBLE_ASSETS)
+		{
+			destroyedResources.clear();
+			cache.advanceFrame(destroyedResources);
+			overBudgetFrames = statistics.overBudgetFrames;
+		}
+	}
+	return cache.getHitRate();
+}
+
+// Small trace written by hand with known eviction order. Budget 100 bytes, destruction is delayed by one frame.
+static void checkScriptedResidency()
+{
+	struct ScriptedFrame
+	{
+		std::vector<uint32_t> requests;
+		// Returned by advanceFrame after requests of frame, in order of eviction
+		std::vector<uint32_t> destroyedResources;
+	};
+
+	const uint32_t A = 0, B = 1, C = 2, D = 3, E = 4;
+	const std::vector<ScriptedFrame> frames =
+	{
+		// A, B and C fill budget exactly
+		{{A, B, C}, {}},
+		// A is used again, so D evicts B, least recently used
+		{{A, D}, {B}},
+		// E evicts C and A. C is requested again before it is destroyed, so it is hit and A is the only one destroyed.
+		{{E, C}, {A}},
+		// B evicts D and E, A is loaded again into space left
+		{{B, A}, {D, E}},
+		// C and B are used, D evicts A
+		{{C, B, D}, {A}},
+		{{D, B, C}, {}},
+	};
+
+	ResidencyCache cache;
+	cache.initialize(100, 1);
+
+	for(uint64_t size: {40, 30, 30, 20, 50})
+	{
+		cache.addResource(size);
+	}
+
+	std::vector<uint32_t> destroyedResources;
+
+	for(size_t frame=0; frame<frames.size(); frame++)
+	{
+		for(uint32_t resource: frames[frame].requests)
+		{
+			cache.request(resource);
+
+			if(cache.getStatistics().residentSize > 100)
+			{
+				throw std::runtime_error("Scripted residency trace exceeded budget in frame " + std::to_string(frame));
+			}
+		}
+
+		destroyedResources.clear();
+		cache.advanceFrame(destroyedResources);
+
+		if(destroyedResources != frames[frame].destroyedResources)
+		{
+			throw std::runtime_error("Scripted residency trace destroyed unexpected resources after frame " + std::to_string(frame));
+		}
+	}
+
+	// 7 hits of 15 requests
+	ResidencyStatistics statistics = cache.getStatistics();
+	if(statistics.hits != 7 || statistics.misses != 8 || statistics.evictions != 6 || statistics.destructions != 5
+		|| statistics.peakResidentSize != 100 || statistics.overBudgetFrames != 0 || cache.getHitRate() != 7.0 / 15.0)
+	{
+		throw std::runtime_error("Scripted residency trace has unexpected statistics, hit rate " + std::to_string(cache.getHitRate()));
+	}
+
+	if(cache.getState(A) != RESIDENCY_NOT_RESIDENT || cache.getState(E) != RESIDENCY_NOT_RESIDENT
+		|| cache.getState(B) != RESIDENCY_RESIDENT || cache.getState(C) != RESIDENCY_RESIDENT || cache.getState(D) != RESIDENCY_RESIDENT)
+	{
+		throw std::runtime_error("Scripted residency trace ended with unexpected resident resources");
+	}
+}
+
+static void addResidencyBenchmarks(BenchmarkRunner& runner)
+{
+	runner.add("residency/lru_trace", []
+	{
+		std::shared_ptr<ResidencyTrace> trace(new ResidencyTrace());
+		generateResidencyTrace(*trace);
+		std::shared_ptr<ResidencyCache> cache(new ResidencyCache());
+		std::shared_ptr<std::vector<uint32_t>> destroyedResources(new std::vector<uint32_t>());
+
+		checkScriptedResidency();
+		double previousHitRate = 0.0;
+
+		// Policy quality does not change with speed of machine, it is reported once. Stderr keeps JSON output clean.
+		for(uint64_t budgetMegabytes: {1, 2, 4, 8, 16})
+		{
+			double hitRate = checkResidencyReplay(*trace, budgetMegabytes * 1024 * 1024, *cache, *destroyedResources);
+			ResidencyStatistics statistics = cache->getStatistics();
+
+			// Larger budget keeps more landmarks and assets camera looks back at
+			if(hitRate < previousHitRate)
+			{
+				throw std::runtime_error("Residency hit rate dropped with larger budget of " + std::to_string(budgetMegabytes) + " MB");
+			}
+			previousHitRate = hitRate;
+			std::cerr << "residency/lru_trace: budget " << budgetMegabytes << " MB hit rate " << hitRate << " misses " << statistics.misses
+				<< " evictions " << statistics.evictions << " peak " << statistics.peakResidentSize / (1024.0 * 1024.0) << " MB over budget frames "
+				<< statistics.overBudgetFrames << std::endl;
+		}
+
+		return [trace, cache, destroyedResources](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				doNotOptimize(replayResidencyTrace(*trace, 4 * 1024 * 1024, *cache, *destroyedResources));
+			}
+		};
+	});
+}
+
+static std::string getGeneratedAssetName(uint32_t asset)
+{
+	std::string number = std::to_string(asset);
+	return std::string(GENERATED_ASSETS_DIRECTORY) + "/asset_" + std::string(5 - std::min<size_t>(number.size(), 5), '0') + number + ".bin";
+}
+
+// Returns names of written assets. Content is short runs of few symbols, so it compresses about as well as typical small asset.
+static std::shared_ptr<std::vector<std::string>> writeGeneratedAssets()
+{
+	std::filesystem::create_directories(GENERATED_ASSETS_DIRECTORY);
+	std::shared_ptr<std::vector<std::string>> names(new std::vector<std::string>());
+	// xorshift, same assets on every run
+	uint64_t state = 0x2545F4914F6CDD1DULL;
+	auto random = [&state]
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	};
+	std::vector<char> bytes;
+
+	for(uint32_t asset=0; asset<GENERATED_ASSETS_NUMBER; asset++)
+	{
+		bytes.resize(256 + random() % (4096 - 256));
+
+		for(size_t i=0; i<bytes.size(); )
+		{
+			char symbol = static_cast<char>('a' + random() % 8);
+			size_t run = std::min<size_t>(1 + random() % 6, bytes.size() - i);
+			std::fill(bytes.begin() + i, bytes.begin() + i + run, symbol);
+			i += run;
+		}
+
+		names->push_back(getGeneratedAssetName(asset));
+		std::ofstream file(names->back(), std::ios::binary | std::ios::trunc);
+
+		if(!file.is_open())
+		{
+			throw std::runtime_error("Failed to create " + names->back());
+		}
+		file.write(bytes.data(), bytes.size());
+	}
+	return names;
+}
+
+// Every byte is touched so mapped pages are really read, sum is cheap enough not to hide cost of opening
+static uint64_t sumBytes(const char* data, size_t size)
+{
+	uint64_t sum = 0;
+
+	for(size_t i=0; i<size; i++)
+	{
+		sum += static_cast<unsigned char>(data[i]);
+	}
+	return sum;
+}
+
+// Every asset is opened and read whole, time of one iteration is time of reading all GENERATED_ASSETS_NUMBER of them
+static void addAssetBenchmarks(BenchmarkRunner& runner)
+{
+	runner.add("assets/loose_open_read_10k", []
+	{
+		std::shared_ptr<std::vector<std::string>> names = writeGeneratedAssets();
+		std::shared_ptr<std::vector<unsigned char>> bytes(new std::vector<unsigned char>());
+
+		return [names, bytes](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				uint64_t sum = 0;
+
+				for(const std::string& name: *names)
+				{
+					if(!readWholeFile(name, *bytes))
+					{
+						throw std::runtime_error("Failed to read " + name);
+					}
+					sum += sumBytes(reinterpret_cast<const char*>(bytes->data()), bytes->size());
+				}
+				doNotOptimize(sum);
+			}
+		};
+	});
+
+	runner.add("assets/archive_open_read_10k", []
+	{
+		std::shared_ptr<std::vector<std::string>> names = writeGeneratedAssets();
+		AssetArchive::write(GENERATED_ARCHIVE_PATH, *names, false);
+
+		// Compression is not measured, only ratio it reaches on these assets is reported. Stderr keeps JSON output clean.
+		const std::string compressedArchivePath = std::string(GENERATED_ARCHIVE_PATH) + ".lz";
+		AssetArchive::write(compressedArchivePath, *names, true);
+		std::cerr << "assets/archive_open_read_10k: archive " << std::filesystem::file_size(GENERATED_ARCHIVE_PATH) / 1024 << " KB, compressed "
+			<< std::filesystem::file_size(compressedArchivePath) / 1024 << " KB" << std::endl;
+		std::remove(compressedArchivePath.c_str());
+
+		std::shared_ptr<std::vector<char>> buffer(new std::vector<char>());
+
+		return [names, buffer](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				AssetArchive assetArchive;
+
+				if(!assetArchive.open(GENERATED_ARCHIVE_PATH))
+				{
+					throw std::runtime_error(std::string("Failed to open ") + GENERATED_ARCHIVE_PATH);
+				}
+				uint64_t sum = 0;
+
+				for(const std::string& name: *names)
+				{
+					AssetSpan span = {};
+
+					if(!assetArchive.read(name, span, *buffer))
+					{
+						throw std::runtime_error("Asset " + name + " is not in archive");
+					}
+					sum += sumBytes(span.data, span.size);
+				}
+				doNotOptimize(sum);
+			}
+		};
+	});
+}
+
+static void addOcclusionBenchmarks(BenchmarkRunner& runner)
+{
+	// Generated sphere in front of grid of small boxes, seen by engine camera
+	runner.add("occlusion/cull_1024", []
+	{
+		writeGeneratedModel(GENERATED_MODEL_PATH);
+
+		struct Scene
+		{
+			OcclusionCuller occlusionCuller;
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+			std::vector<RenderObject> renderObjects;
+			std::vector<uint32_t> visibleObjects;
+			std::vector<glm::mat4> modelViewProjections;
+		};
+		std::shared_ptr<Scene> scene(new Scene());
+		scene->occlusionCuller.initialize(&jobSystem);
+		ModelLoader::loadObj(GENERATED_MODEL_PATH, jobSystem, scene->vertices, scene->indices);
+
+		RenderObject occluder = {};
+		occluder.model = glm::scale(glm::mat4(1.0F), glm::vec3(0.6F));
+		occluder.boundsMin = glm::vec3(-1.0F);
+		occluder.boundsMax = glm::vec3(1.0F);
+		occluder.indexCount = static_cast<uint32_t>(scene->indices.size());
+		occluder.isOccluder = true;
+		scene->renderObjects.push_back(occluder);
+
+		for(uint32_t i=0; i<BENCHMARK_OBJECTS_NUMBER; i++)
+		{
+			RenderObject box = {};
+			box.model = glm::translate(glm::mat4(1.0F), glm::vec3(-1.5F + 0.1F * (i % 32), -1.5F + 0.1F * (i / 32), -0.5F));
+			box.boundsMin = glm::vec3(-0.03F);
+			box.boundsMax = glm::vec3(0.03F);
+			scene->renderObjects.push_back(box);
+		}
+
+		glm::mat4 viewProjection = YasMathLib::toGlm(computeViewProjection(16.0F / 9.0F));
+		for(const RenderObject& renderObject: scene->renderObjects)
+		{
+			scene->modelViewProjections.push_back(viewProjection * renderObject.model);
+		}
+
+		// Benchmark of culling which culls nothing would measure only rasterization
+		scene->occlusionCuller.cull(scene->modelViewProjections, scene->renderObjects, scene->vertices, scene->indices, scene->visibleObjects);
+		if(scene->occlusionCuller.statistics.culledObjects == 0)
+		{
+			throw std::runtime_error("Occlusion culling did not cull any of benchmark objects");
+		}
+		std::cerr << "occlusion/cull_1024: culled " << scene->occlusionCuller.statistics.culledObjects << " of " << scene->occlusionCuller.statistics.testedObjects << " objects" << std::endl;
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				scene->occlusionCuller.cull(scene->modelViewProjections, scene->renderObjects, scene->vertices, scene->indices, scene->visibleObjects);
+				doNotOptimize(scene->visibleObjects.size());
+			}
+		};
+	});
+
+	// Same wall and boxes as occluder scene of engine, every box behind the wall has to be culled
+	runner.add("occlusion/wall_scene", []
+	{
+		struct Scene
+		{
+			OcclusionCuller occlusionCuller;
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+			std::vector<RenderObject> renderObjects;
+			std::vector<uint32_t> visibleObjects;
+			std::vector<glm::mat4> modelViewProjections;
+		};
+		std::shared_ptr<Scene> scene(new Scene());
+		scene->occlusionCuller.initialize(&jobSystem);
+
+		std::vector<Vertex> boxVertices;
+		std::vector<uint32_t> boxIndices;
+		createBoxMesh(OCCLUDER_WALL_HALF_SIZE, scene->vertices, scene->indices);
+		createBoxMesh(OCCLUDED_BOX_HALF_SIZE, boxVertices, boxIndices);
+
+		RenderObject wall = {};
+		wall.model = glm::translate(glm::mat4(1.0F), computeOccluderWallPosition());
+		wall.boundsMin = glm::vec3(-OCCLUDER_WALL_HALF_SIZE);
+		wall.boundsMax = glm::vec3(OCCLUDER_WALL_HALF_SIZE);
+		wall.indexCount = static_cast<uint32_t>(scene->indices.size());
+		wall.isOccluder = true;
+		scene->renderObjects.push_back(wall);
+
+		RenderObject box = {};
+		box.boundsMin = glm::vec3(-OCCLUDED_BOX_HALF_SIZE);
+		box.boundsMax = glm::vec3(OCCLUDED_BOX_HALF_SIZE);
+		box.firstIndex = static_cast<uint32_t>(scene->indices.size());
+		box.indexCount = static_cast<uint32_t>(boxIndices.size());
+		box.vertexOffset = static_cast<int32_t>(scene->vertices.size());
+		scene->vertices.insert(scene->vertices.end(), boxVertices.begin(), boxVertices.end());
+		scene->indices.insert(scene->indices.end(), boxIndices.begin(), boxIndices.end());
+
+		for(uint32_t i=0; i<DEFAULT_OCCLUDED_BOXES_NUMBER; i++)
+		{
+			box.model = glm::translate(glm::mat4(1.0F), computeOccludedBoxPosition(i));
+			scene->renderObjects.push_back(box);
+		}
+
+		// Engine window and headless images are 4:3, benchmark scenes use 16:9
+		const float aspectRatios[2] = {4.0F / 3.0F, 16.0F / 9.0F};
+		for(float aspectRatio: aspectRatios)
+		{
+			glm::mat4 viewProjection = YasMathLib::toGlm(computeViewProjection(aspectRatio));
+			scene->modelViewProjections.clear();
+			for(const RenderObject& renderObject: scene->renderObjects)
+			{
+				scene->modelViewProjections.push_back(viewProjection * renderObject.model);
+			}
+
+			scene->occlusionCuller.cull(scene->modelViewProjections, scene->renderObjects, scene->vertices, scene->indices, scene->visibleObjects);
+			if(scene->occlusionCuller.statistics.culledObjects != DEFAULT_OCCLUDED_BOXES_NUMBER || scene->visibleObjects.size() != 1 || scene->visibleObjects[0] != 0)
+			{
+				throw std::runtime_error("Occlusion culling did not cull boxes behind wall, culled " + std::to_string(scene->occlusionCuller.statistics.culledObjects) + " of " + std::to_string(DEFAULT_OCCLUDED_BOXES_NUMBER));
+			}
+		}
+
+		return [scene](uint64_t iterations)
+		{
+			for(uint64_t i=0; i<iterations; i++)
+			{
+				scene->occlusionCuller.cull(scene->modelViewProjections, scene->renderObjects, scene->vertices, scene->indices, scene->visibleObjects);
+				doNotOptimize(scene->visibleObjects.size());
+			}
+		};
+	});
+}
+
+static bool parseSettings(int argc, char* argv[], BenchmarkSettings& settings, std::string& assetsPath)
+{
+	for(int i=1; i<argc; i++)
+	{
+		std::string option = argv[i];
+
+		if(i + 1 >= argc)
+		{
+			std::cerr << "Missing value of option " << option << std::endl;
+			return false;
+		}
+
+		const char* value = argv[++i];
+
+		if(option == "--filter")
+		{
+			settings.filter = value;
+		}
+		else if(option == "--output")
+		{
+			settings.outputPath = value;
+		}
+		else if(option == "--compare")
+		{
+			settings.baselinePath = value;
+		}
+		else if(option == "--threshold")
+		{
+			settings.thresholdPercent = std::strtod(value, nullptr);
+		}
+		else if(option == "--repetitions")
+		{
+			settings.repetitions = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--min-time")
+		{
+			settings.minMilliseconds = std::strtod(value, nullptr);
+		}
+		else if(option == "--assets")
+		{
+			assetsPath = value;
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// Returns 0 when all benchmarks ran and none regressed, 1 on error, 2 when comparison found regression
+int main(int argc, char* argv[])
+{
+	BenchmarkSettings settings;
+	// Default is layout of repository when started from YasBenchmark directory
+	std::string assetsPath = "../YasEngine";
+
+	if(!parseSettings(argc, argv, settings, assetsPath))
+	{
+		std::cerr << "Usage: YasBenchmark [--filter text] [--output results.json] [--compare baseline.json] [--threshold percent] [--repetitions N] [--min-time ms] [--assets directory]" << std::endl;
+		return 1;
+	}
+
+	try
+	{
+		jobSystem.initialize(std::max(std::thread::hardware_concurrency(), 1U));
+
+		BenchmarkRunner runner;
+		addModelBenchmarks(runner, assetsPath);
+		addTextureBenchmarks(runner, assetsPath);
+		addMathBenchmarks(runner);
+		addClockBenchmarks(runner);
+		addDeviceBenchmarks(runner);
+		addTransformBenchmarks(runner);
+		addVertexStageBenchmarks(runner, assetsPath);
+		addSkinningBenchmarks(runner);
+		addContainerBenchmarks(runner);
+		addOcclusionBenchmarks(runner);
+		addResidencyBenchmarks(runner);
+		addAssetBenchmarks(runner);
+
+		std::vector<BenchmarkResult> results = runner.run(settings);
+
+		YasLog::stop();
+		jobSystem.shutdown();
+		std::remove(GENERATED_MODEL_PATH);
+		std::remove(GENERATED_ARCHIVE_PATH);
+		std::filesystem::remove_all(GENERATED_ASSETS_DIRECTORY);
+		std::remove("benchmark_log.txt");
+
+		if(settings.outputPath.empty())
+		{
+			BenchmarkRunner::writeJson(results, std::cout);
+		}
+		else
+		{
+			std::ofstream output(settings.outputPath, std::ios::trunc);
+
+			if(!output.is_open())
+			{
+				throw std::runtime_error("Failed to create " + settings.outputPath);
+			}
+			BenchmarkRunner::writeJson(results, output);
+		}
+
+		if(!settings.baselinePath.empty())
+		{
+			uint32_t regressions = BenchmarkRunner::compare(results, BenchmarkRunner::readJson(settings.baselinePath), settings.thresholdPercent);
+
+			if(regressions > 0)
+			{
+				std::cout << regressions << " benchmarks slower than baseline by more than " << settings.thresholdPercent << "%" << std::endl;
+				return 2;
+			}
+		}
+	}
+	catch(const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
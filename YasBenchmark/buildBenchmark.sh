@@ -0,0 +1,27 @@
+#!/bin/sh
+# Builds benchmark suite on Linux, no GPU is needed to run it.
+# Header only libraries are taken from directories given in GLM, STB and TINYOBJLOADER.
+CXX=${CXX:-g++}
+GLM=${GLM:-/usr/include}
+STB=${STB:-/usr/include/stb}
+TINYOBJLOADER=${TINYOBJLOADER:-/usr/include}
+cd "$(dirname "$0")" || exit 1
+
+# SANITIZE=thread builds with ThreadSanitizer, for example to run ./YasBenchmark --filter jobs/queue_push_pop
+OPTIMIZATION="-O2 -DNDEBUG"
+if [ -n "$SANITIZE" ]; then
+	OPTIMIZATION="-O1 -g -fsanitize=$SANITIZE"
+fi
+
+ENGINE=../YasEngine
+# Vulkan loader resolves command recording calls of render queue, descriptors and skinning. Engine files which create
+# instance or device are not linked, so nothing is called without device.
+$CXX -std=c++17 $OPTIMIZATION -mavx2 \
+	-I$ENGINE -I"$GLM" -I"$STB" -I"$TINYOBJLOADER" \
+	Benchmark.cpp EngineBenchmarks.cpp \
+	$ENGINE/AllocationCounter.cpp $ENGINE/Animation.cpp $ENGINE/Arena.cpp $ENGINE/AssetArchive.cpp $ENGINE/Clock.cpp $ENGINE/CpuProfiler.cpp $ENGINE/Descriptors.cpp $ENGINE/DeviceSelection.cpp \
+	$ENGINE/JobSystem.cpp $ENGINE/MappedFile.cpp $ENGINE/MeshCodec.cpp $ENGINE/ModelLoader.cpp $ENGINE/OcclusionCulling.cpp $ENGINE/RenderQueue.cpp $ENGINE/ResidencyCache.cpp $ENGINE/Simulation.cpp \
+	$ENGINE/Skinning.cpp $ENGINE/TransformBatch.cpp $ENGINE/YasLog.cpp \
+	-o YasBenchmark -lvulkan -lpthread || exit 1
+
+# Usage: ./YasBenchmark --output baseline.json, after change ./YasBenchmark --compare baseline.json
@@ -0,0 +1,107 @@
+#include"stdafx.hpp"
+#include"AllocationCounter.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+#ifdef YAS_COUNT_HEAP_ALLOCATIONS
+
+// Plain integers, they are zero initialized before any constructor can allocate
+static thread_local uint64_t threadAllocations;
+static std::atomic<uint64_t> allAllocations;
+
+// Array and nothrow forms of new and delete call these by default
+void* operator new(size_t size)
+{
+	++threadAllocations;
+	allAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* pointer = std::malloc(size > 0 ? size : 1);
+
+	if(pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t size) noexcept
+{
+	std::free(pointer);
+}
+
+// Types aligned above __STDCPP_DEFAULT_NEW_ALIGNMENT__, like job queues aligned to cache lines. Memory of these
+// can not be freed by plain free on Windows, so they have own pair of functions.
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	++threadAllocations;
+	allAllocations.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef _WIN32
+	void* pointer = _aligned_malloc(size > 0 ? size : 1, static_cast<size_t>(alignment));
+#else
+	void* pointer = nullptr;
+	if(posix_memalign(&pointer, std::max(static_cast<size_t>(alignment), sizeof(void*)), size > 0 ? size : 1) != 0)
+	{
+		pointer = nullptr;
+	}
+#endif
+
+	if(pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept
+{
+#ifdef _WIN32
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+void operator delete(void* pointer, size_t size, std::align_val_t alignment) noexcept
+{
+	operator delete(pointer, alignment);
+}
+
+bool AllocationCounter::isEnabled()
+{
+	return true;
+}
+
+uint64_t AllocationCounter::getThreadAllocations()
+{
+	return threadAllocations;
+}
+
+uint64_t AllocationCounter::getAllAllocations()
+{
+	return allAllocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::isEnabled()
+{
+	return false;
+}
+
+uint64_t AllocationCounter::getThreadAllocations()
+{
+	return 0;
+}
+
+uint64_t AllocationCounter::getAllAllocations()
+{
+	return 0;
+}
+
+#endif
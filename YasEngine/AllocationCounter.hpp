@@ -0,0 +1,22 @@
+#ifndef ALLOCATIONCOUNTER_HPP
+#define ALLOCATIONCOUNTER_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Global operator new is replaced to count heap allocations in the same builds which have CPU profiling
+#if !defined(NDEBUG) || defined(YAS_ENABLE_CPU_PROFILING)
+	#define YAS_COUNT_HEAP_ALLOCATIONS
+#endif
+
+class AllocationCounter
+{
+	public:
+
+		static bool						isEnabled();
+		// Number of operator new calls since program start
+		static uint64_t					getThreadAllocations();
+		static uint64_t					getAllAllocations();
+};
+
+#endif
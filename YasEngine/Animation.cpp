@@ -0,0 +1,165 @@
+#include"stdafx.hpp"
+#include"Animation.hpp"
+#include"SimdLanes.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+Skeleton::Skeleton()
+{
+
+}
+
+void Skeleton::addJoint(int32_t parent, const YasMathLib::mat4& inverseBindMatrix)
+{
+	if(parent >= static_cast<int32_t>(parents.size()))
+	{
+		throw std::runtime_error("Parent of joint has to be added before it");
+	}
+
+	parents.push_back(parent);
+	inverseBindMatrices.push_back(inverseBindMatrix);
+}
+
+uint32_t Skeleton::getJointsNumber() const
+{
+	return static_cast<uint32_t>(parents.size());
+}
+
+int32_t Skeleton::getParent(uint32_t joint) const
+{
+	return parents[joint];
+}
+
+void Skeleton::computeModelMatrices(const TransformBatch& localPose, YasMathLib::mat4* modelMatrices) const
+{
+	// Local matrices of all joints come from SIMD kernel, then each one is multiplied in place by already finished parent
+	localPose.computeMatrices(YasMathLib::mat4(1.0F), 0, getJointsNumber(), &modelMatrices[0][0].x, sizeof(YasMathLib::mat4), nullptr, 0);
+
+	for(uint32_t joint=0; joint<parents.size(); joint++)
+	{
+		if(parents[joint] >= 0)
+		{
+			modelMatrices[joint] = modelMatrices[parents[joint]] * modelMatrices[joint];
+		}
+	}
+}
+
+void Skeleton::computeSkinningMatrices(const YasMathLib::mat4* modelMatrices, YasMathLib::mat4* skinningMatrices) const
+{
+	for(uint32_t joint=0; joint<parents.size(); joint++)
+	{
+		skinningMatrices[joint] = modelMatrices[joint] * inverseBindMatrices[joint];
+	}
+}
+
+AnimationClip::AnimationClip()
+{
+	keysPerSecond = 1.0F;
+}
+
+void AnimationClip::initialize(uint32_t jointsNumber, uint32_t keysNumber, float keysPerSecond)
+{
+	if(keysNumber < 2 || keysPerSecond <= 0.0F)
+	{
+		throw std::runtime_error("Animation clip needs at least two keys and positive rate");
+	}
+
+	this->keysPerSecond = keysPerSecond;
+	keys.resize(keysNumber);
+
+	for(TransformBatch& key: keys)
+	{
+		key.resize(jointsNumber);
+	}
+}
+
+TransformBatch& AnimationClip::getKey(uint32_t key)
+{
+	return keys[key];
+}
+
+uint32_t AnimationClip::getKeysNumber() const
+{
+	return static_cast<uint32_t>(keys.size());
+}
+
+float AnimationClip::getDuration() const
+{
+	return (keys.size() - 1) / keysPerSecond;
+}
+
+void AnimationClip::sample(float time, TransformBatch& pose) const
+{
+	const float duration = getDuration();
+	float clipTime = std::fmod(time, duration);
+
+	if(clipTime < 0.0F)
+	{
+		clipTime += duration;
+	}
+
+	float keyPosition = clipTime * keysPerSecond;
+	uint32_t key = std::min(static_cast<uint32_t>(keyPosition), static_cast<uint32_t>(keys.size()) - 2);
+	blendPoses(keys[key], keys[key + 1], keyPosition - key, pose);
+}
+
+template<typename Lanes>
+void AnimationClip::blendGroup(const TransformBatch& first, const TransformBatch& second, float weight, TransformBatch& result, uint32_t index)
+{
+	const Lanes firstWeight = Lanes::broadcast(1.0F - weight);
+	const Lanes secondWeight = Lanes::broadcast(weight);
+
+	const TransformComponent linearComponents[] = {TRANSFORM_POSITION_X, TRANSFORM_POSITION_Y, TRANSFORM_POSITION_Z, TRANSFORM_SCALE_X, TRANSFORM_SCALE_Y, TRANSFORM_SCALE_Z};
+	for(TransformComponent component: linearComponents)
+	{
+		Lanes blended = Lanes::load(first.getComponent(component) + index) * firstWeight + Lanes::load(second.getComponent(component) + index) * secondWeight;
+		blended.store(result.getComponent(component) + index);
+	}
+
+	Lanes firstRotation[4];
+	Lanes secondRotation[4];
+	for(int i=0; i<4; i++)
+	{
+		firstRotation[i] = Lanes::load(first.getComponent(static_cast<TransformComponent>(TRANSFORM_ROTATION_X + i)) + index);
+		secondRotation[i] = Lanes::load(second.getComponent(static_cast<TransformComponent>(TRANSFORM_ROTATION_X + i)) + index);
+	}
+
+	// q and -q are the same rotation, second one is flipped when it points away so blend takes shorter arc
+	Lanes cosine = firstRotation[0] * secondRotation[0] + firstRotation[1] * secondRotation[1] + firstRotation[2] * secondRotation[2] + firstRotation[3] * secondRotation[3];
+	Lanes signedWeight = copySign(secondWeight, cosine);
+
+	Lanes blended[4];
+	for(int i=0; i<4; i++)
+	{
+		blended[i] = firstRotation[i] * firstWeight + secondRotation[i] * signedWeight;
+	}
+
+	Lanes length = squareRoot(blended[0] * blended[0] + blended[1] * blended[1] + blended[2] * blended[2] + blended[3] * blended[3]);
+	for(int i=0; i<4; i++)
+	{
+		(blended[i] / length).store(result.getComponent(static_cast<TransformComponent>(TRANSFORM_ROTATION_X + i)) + index);
+	}
+}
+
+void AnimationClip::blendPoses(const TransformBatch& first, const TransformBatch& second, float weight, TransformBatch& result)
+{
+	const uint32_t jointsNumber = first.size();
+	uint32_t index = 0;
+
+#if defined(YAS_MATH_AVX)
+	for(; index + 8 <= jointsNumber; index += 8)
+	{
+		blendGroup<AvxLanes>(first, second, weight, result, index);
+	}
+#endif
+#if defined(YAS_MATH_SSE)
+	for(; index + 4 <= jointsNumber; index += 4)
+	{
+		blendGroup<SseLanes>(first, second, weight, result, index);
+	}
+#endif
+	for(; index < jointsNumber; index++)
+	{
+		blendGroup<ScalarLanes>(first, second, weight, result, index);
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef ANIMATION_HPP
+#define ANIMATION_HPP
+#include"stdafx.hpp"
+#include"YasMathLib.hpp"
+#include"TransformBatch.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Joint hierarchy of skinned mesh. Joints are ordered so parent always comes before its children,
+// then model matrices are computed in one pass over joints.
+class Skeleton
+{
+	public:
+
+										Skeleton();
+		// Parent is -1 for root. Throws when parent is not added yet.
+		void							addJoint(int32_t parent, const YasMathLib::mat4& inverseBindMatrix);
+		uint32_t						getJointsNumber() const;
+		int32_t							getParent(uint32_t joint) const;
+
+		// Local pose has one object per joint, model matrices are relative to root of skeleton
+		void							computeModelMatrices(const TransformBatch& localPose, YasMathLib::mat4* modelMatrices) const;
+		// Model matrix times inverse bind matrix, moves bind pose vertices into current pose
+		void							computeSkinningMatrices(const YasMathLib::mat4* modelMatrices, YasMathLib::mat4* skinningMatrices) const;
+
+	private:
+
+		std::vector<int32_t>			parents;
+		std::vector<YasMathLib::mat4>	inverseBindMatrices;
+};
+
+// Looping clip with keys sampled at fixed rate, so sampling does not search for keys.
+// Every key is local pose of all joints, last key has to be equal to first one.
+class AnimationClip
+{
+	public:
+
+										AnimationClip();
+		// Keys start as identity transforms
+		void							initialize(uint32_t jointsNumber, uint32_t keysNumber, float keysPerSecond);
+		TransformBatch&					getKey(uint32_t key);
+		uint32_t						getKeysNumber() const;
+		float							getDuration() const;
+
+		// Pose must have one object per joint. Any time is wrapped into clip.
+		void							sample(float time, TransformBatch& pose) const;
+
+		// Weight 0 gives first pose, 1 gives second. Translation and scale are interpolated linearly,
+		// rotation with normalized lerp along shorter arc. Result can be one of inputs.
+		static void						blendPoses(const TransformBatch& first, const TransformBatch& second, float weight, TransformBatch& result);
+
+	private:
+
+		template<typename Lanes>
+		static void						blendGroup(const TransformBatch& first, const TransformBatch& second, float weight, TransformBatch& result, uint32_t index);
+
+		std::vector<TransformBatch>		keys;
+		float							keysPerSecond;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include"stdafx.hpp"
+#include"Arena.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+LinearArena::LinearArena()
+{
+	memory = nullptr;
+	capacity = 0;
+	offset = 0;
+	highWaterMark = 0;
+	overflowBytes = 0;
+	overflowsNumber = 0;
+}
+
+LinearArena::LinearArena(size_t capacity) : LinearArena()
+{
+	initialize(capacity);
+}
+
+LinearArena::~LinearArena()
+{
+	reset();
+	::operator delete(memory);
+}
+
+void LinearArena::initialize(size_t capacity)
+{
+	reset();
+	::operator delete(memory);
+	memory = static_cast<char*>(::operator new(capacity));
+	this->capacity = capacity;
+}
+
+void* LinearArena::allocate(size_t size, size_t alignment)
+{
+	size_t alignedOffset = (reinterpret_cast<uintptr_t>(memory) + offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+	alignedOffset -= reinterpret_cast<uintptr_t>(memory);
+
+	if(alignedOffset + size <= capacity)
+	{
+		offset = alignedOffset + size;
+		highWaterMark = std::max(highWaterMark, offset);
+		return memory + alignedOffset;
+	}
+
+	// Block from heap is aligned by hand, original pointer is kept for delete
+	char* block = static_cast<char*>(::operator new(size + alignment));
+	overflowBlocks.push_back(block);
+	overflowBytes += size + alignment;
+	++overflowsNumber;
+	return reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(block) + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+}
+
+void LinearArena::deallocate(void* pointer, size_t size)
+{
+	if(static_cast<char*>(pointer) + size == memory + offset)
+	{
+		offset -= size;
+	}
+}
+
+void LinearArena::reset()
+{
+	offset = 0;
+
+	// Blocks can be already freed by rewind, arena still grows by what overflowed
+	if(overflowBytes == 0)
+	{
+		return;
+	}
+
+	for(void* block: overflowBlocks)
+	{
+		::operator delete(block);
+	}
+	overflowBlocks.clear();
+
+	// Next time the same amount of work fits without heap
+	size_t newCapacity = capacity + overflowBytes;
+	overflowBytes = 0;
+	::operator delete(memory);
+	memory = static_cast<char*>(::operator new(newCapacity));
+	capacity = newCapacity;
+}
+
+ArenaMarker LinearArena::getMarker() const
+{
+	ArenaMarker marker = {};
+	marker.offset = offset;
+	marker.overflowBlocksNumber = overflowBlocks.size();
+	return marker;
+}
+
+void LinearArena::rewind(const ArenaMarker& marker)
+{
+	// Nothing was allocated before marker, so memory can be reallocated to grow
+	if(marker.offset == 0 && marker.overflowBlocksNumber == 0)
+	{
+		reset();
+		return;
+	}
+
+	for(size_t i=marker.overflowBlocksNumber; i<overflowBlocks.size(); i++)
+	{
+		::operator delete(overflowBlocks[i]);
+	}
+	overflowBlocks.resize(marker.overflowBlocksNumber);
+	offset = marker.offset;
+}
+
+size_t LinearArena::getCapacity() const
+{
+	return capacity;
+}
+
+size_t LinearArena::getHighWaterMark() const
+{
+	return highWaterMark;
+}
+
+uint32_t LinearArena::getOverflowsNumber() const
+{
+	return overflowsNumber;
+}
+
+LinearArena& getScratchArena()
+{
+	thread_local LinearArena scratchArena(SCRATCH_ARENA_SIZE);
+	return scratchArena;
+}
+
+FrameArena::FrameArena()
+{
+	currentIndex = 0;
+}
+
+void FrameArena::initialize(uint32_t framesNumber, size_t bytesPerFrame)
+{
+	arenas.clear();
+	for(uint32_t i=0; i<framesNumber; i++)
+	{
+		arenas.push_back(std::unique_ptr<LinearArena>(new LinearArena(bytesPerFrame)));
+	}
+	currentIndex = 0;
+}
+
+void FrameArena::beginFrame(uint32_t frameIndex)
+{
+	currentIndex = frameIndex;
+	arenas[currentIndex]->reset();
+}
+
+LinearArena& FrameArena::current()
+{
+	return *arenas[currentIndex];
+}
@@ -0,0 +1,149 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+const size_t FRAME_ARENA_SIZE				= 1 << 20;
+const size_t SCRATCH_ARENA_SIZE				= 256 * 1024;
+
+// Position in arena. Rewinding frees only overflow blocks allocated after it, blocks of outer scopes stay alive.
+struct ArenaMarker
+{
+	size_t							offset;
+	size_t							overflowBlocksNumber;
+};
+
+// Bump allocator. Memory is given back all at once by reset or by rewinding to marker taken earlier.
+// Allocation which does not fit goes to heap and arena grows by that much at next reset, so it never fails.
+class LinearArena
+{
+	public:
+
+										LinearArena();
+		explicit						LinearArena(size_t capacity);
+										~LinearArena();
+										LinearArena(const LinearArena&) = delete;
+		LinearArena&					operator=(const LinearArena&) = delete;
+
+		void							initialize(size_t capacity);
+		void*							allocate(size_t size, size_t alignment);
+		// Only last allocation can be given back, vector which grows gets its old buffer back this way
+		void							deallocate(void* pointer, size_t size);
+		// O(1) unless something overflowed since last reset
+		void							reset();
+		ArenaMarker						getMarker() const;
+		// Rewinding to marker of empty arena is reset
+		void							rewind(const ArenaMarker& marker);
+
+		size_t							getCapacity() const;
+		size_t							getHighWaterMark() const;
+		uint32_t						getOverflowsNumber() const;
+
+	private:
+
+		char*							memory;
+		size_t							capacity;
+		size_t							offset;
+		size_t							highWaterMark;
+		std::vector<void*>				overflowBlocks;
+		size_t							overflowBytes;
+		uint32_t						overflowsNumber;
+};
+
+// Temporary arena of calling thread. Use inside ArenaScope, everything allocated in scope is freed when it ends.
+LinearArena&							getScratchArena();
+
+class ArenaScope
+{
+	public:
+
+		explicit						ArenaScope(LinearArena& arena = getScratchArena()) : arena(arena), marker(arena.getMarker())
+		{
+		}
+
+										~ArenaScope()
+		{
+			arena.rewind(marker);
+		}
+
+										ArenaScope(const ArenaScope&) = delete;
+		ArenaScope&						operator=(const ArenaScope&) = delete;
+
+	private:
+
+		LinearArena&					arena;
+		ArenaMarker						marker;
+};
+
+// STL allocator which takes memory from LinearArena. Default constructed allocator uses scratch arena of calling thread.
+template<typename T>
+class ArenaAllocator
+{
+	public:
+
+		typedef T						value_type;
+		// Assigning vector which was built in other arena moves it there instead of copying elements
+		typedef std::true_type			propagate_on_container_copy_assignment;
+		typedef std::true_type			propagate_on_container_move_assignment;
+		typedef std::true_type			propagate_on_container_swap;
+
+										ArenaAllocator() : arena(&getScratchArena())
+		{
+		}
+
+		explicit						ArenaAllocator(LinearArena& arena) : arena(&arena)
+		{
+		}
+
+		template<typename U>
+										ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena)
+		{
+		}
+
+		T*								allocate(size_t count)
+		{
+			return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void							deallocate(T* pointer, size_t count)
+		{
+			arena->deallocate(pointer, count * sizeof(T));
+		}
+
+		template<typename U>
+		bool							operator==(const ArenaAllocator<U>& other) const
+		{
+			return arena == other.arena;
+		}
+
+		template<typename U>
+		bool							operator!=(const ArenaAllocator<U>& other) const
+		{
+			return arena != other.arena;
+		}
+
+		LinearArena*					arena;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// One arena per frame in flight. Arena of frame is reset after fence of that frame was waited for,
+// so memory allocated while recording can be referenced until frame is done on GPU.
+class FrameArena
+{
+	public:
+
+										FrameArena();
+		void							initialize(uint32_t framesNumber, size_t bytesPerFrame);
+		void							beginFrame(uint32_t frameIndex);
+		LinearArena&					current();
+
+	private:
+
+		std::vector<std::unique_ptr<LinearArena>> arenas;
+		uint32_t						currentIndex;
+};
+
+#endif
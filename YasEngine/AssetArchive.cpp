@@ -0,0 +1,431 @@
+#include"stdafx.hpp"
+#include"AssetArchive.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Matches are found through table of positions indexed by hash of their first four bytes
+const uint32_t LZ_HASH_BITS					= 14;
+const uint32_t LZ_MIN_MATCH					= 4;
+const uint32_t LZ_MAX_OFFSET				= 65535;
+// Last bytes are always literals, so decoder never reads match past end of data
+const uint32_t LZ_END_LITERALS				= 5;
+// Length of literals or match which does not fit into its 4 bits of token continues in following bytes
+const uint32_t LZ_TOKEN_LENGTH_MAX			= 15;
+// Compressed entry is kept when it is at most this part of original size, otherwise it is stored as it is
+const float ASSET_COMPRESSION_MAX_RATIO		= 0.9F;
+
+AssetArchive::AssetArchive()
+{
+	entries = nullptr;
+	entriesNumber = 0;
+}
+
+bool AssetArchive::open(const std::string& fileName)
+{
+	close();
+
+	if(!file.open(fileName))
+	{
+		return false;
+	}
+
+	const char* data = file.data();
+	const size_t size = file.size();
+
+	if(size < sizeof(AssetArchiveHeader))
+	{
+		throw std::runtime_error("Asset archive " + fileName + " is too small");
+	}
+
+	const AssetArchiveHeader* header = reinterpret_cast<const AssetArchiveHeader*>(data);
+
+	if(header->magic != ASSET_ARCHIVE_MAGIC || header->version != ASSET_ARCHIVE_VERSION)
+	{
+		throw std::runtime_error("Asset archive " + fileName + " has wrong format, pack it again");
+	}
+
+	if(size < sizeof(AssetArchiveHeader) + static_cast<size_t>(header->entriesNumber) * sizeof(AssetArchiveEntry))
+	{
+		throw std::runtime_error("Asset archive " + fileName + " entries table is truncated");
+	}
+
+	const AssetArchiveEntry* archiveEntries = reinterpret_cast<const AssetArchiveEntry*>(data + sizeof(AssetArchiveHeader));
+
+	// Lookups trust table after this, so it is checked once here
+	for(uint32_t i=0; i<header->entriesNumber; i++)
+	{
+		if(archiveEntries[i].offset > size || archiveEntries[i].storedSize > size - archiveEntries[i].offset)
+		{
+			throw std::runtime_error("Asset archive " + fileName + " entry points outside of file");
+		}
+
+		if(archiveEntries[i].compression == ASSET_COMPRESSION_NONE && archiveEntries[i].storedSize != archiveEntries[i].size)
+		{
+			throw std::runtime_error("Asset archive " + fileName + " entry has wrong size");
+		}
+
+		if(i > 0 && archiveEntries[i - 1].nameHash >= archiveEntries[i].nameHash)
+		{
+			throw std::runtime_error("Asset archive " + fileName + " entries table is not sorted");
+		}
+	}
+
+	entries = archiveEntries;
+	entriesNumber = header->entriesNumber;
+	return true;
+}
+
+void AssetArchive::close()
+{
+	file.close();
+	entries = nullptr;
+	entriesNumber = 0;
+}
+
+bool AssetArchive::isOpen() const
+{
+	return file.isOpen();
+}
+
+uint32_t AssetArchive::getEntriesNumber() const
+{
+	return entriesNumber;
+}
+
+bool AssetArchive::contains(const std::string& name) const
+{
+	return findEntry(name) != nullptr;
+}
+
+bool AssetArchive::read(const std::string& name, AssetSpan& span, std::vector<char>& buffer) const
+{
+	const AssetArchiveEntry* entry = findEntry(name);
+
+	if(entry == nullptr)
+	{
+		return false;
+	}
+
+	const char* storedData = file.data() + entry->offset;
+
+	if(entry->compression == ASSET_COMPRESSION_NONE)
+	{
+		span.data = storedData;
+		span.size = entry->storedSize;
+		return true;
+	}
+
+	if(entry->compression != ASSET_COMPRESSION_LZ)
+	{
+		throw std::runtime_error("Asset " + name + " has unknown compression, pack archive again");
+	}
+
+	buffer.resize(entry->size);
+
+	if(!decompressLz(storedData, entry->storedSize, buffer.data(), buffer.size()))
+	{
+		throw std::runtime_error("Asset " + name + " is corrupted, pack archive again");
+	}
+
+	span.data = buffer.data();
+	span.size = buffer.size();
+	return true;
+}
+
+void AssetArchive::write(const std::string& archiveFileName, const std::vector<std::string>& fileNames, bool compress)
+{
+	std::vector<AssetArchiveEntry> archiveEntries;
+	std::vector<std::vector<char>> storedData;
+
+	for(const std::string& fileName: fileNames)
+	{
+		std::ifstream assetFile(fileName, std::ios::binary | std::ios::ate);
+
+		if(!assetFile.is_open())
+		{
+			throw std::runtime_error("Failed to open asset " + fileName);
+		}
+
+		// Entry sizes are 32 bit, larger asset is rejected before it is read instead of being truncated
+		const uint64_t assetSize = static_cast<uint64_t>(assetFile.tellg());
+
+		if(assetSize > std::numeric_limits<uint32_t>::max())
+		{
+			throw std::runtime_error("Asset " + fileName + " has " + std::to_string(assetSize) + " bytes, archive entries have to be smaller than 4 GiB");
+		}
+
+		std::vector<char> data(static_cast<size_t>(assetSize));
+		assetFile.seekg(0);
+		assetFile.read(data.data(), data.size());
+
+		AssetArchiveEntry entry = {};
+		entry.nameHash = hashName(fileName);
+		entry.size = static_cast<uint32_t>(data.size());
+		entry.compression = ASSET_COMPRESSION_NONE;
+
+		if(compress)
+		{
+			std::vector<char> compressed;
+			compressLz(data.data(), data.size(), compressed);
+
+			if(compressed.size() <= data.size() * ASSET_COMPRESSION_MAX_RATIO)
+			{
+				data.swap(compressed);
+				entry.compression = ASSET_COMPRESSION_LZ;
+			}
+		}
+
+		entry.storedSize = static_cast<uint32_t>(data.size());
+		archiveEntries.push_back(entry);
+		storedData.push_back(std::move(data));
+	}
+
+	// Sorted by hash for binary search, data keeps order of files
+	std::vector<uint32_t> order(archiveEntries.size());
+	for(uint32_t i=0; i<order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&archiveEntries](uint32_t a, uint32_t b) { return archiveEntries[a].nameHash < archiveEntries[b].nameHash; });
+
+	for(size_t i=1; i<order.size(); i++)
+	{
+		if(archiveEntries[order[i - 1]].nameHash == archiveEntries[order[i]].nameHash)
+		{
+			throw std::runtime_error("Assets " + fileNames[order[i - 1]] + " and " + fileNames[order[i]] + " have the same name hash, rename one of them");
+		}
+	}
+
+	uint64_t offset = sizeof(AssetArchiveHeader) + archiveEntries.size() * sizeof(AssetArchiveEntry);
+	for(AssetArchiveEntry& entry: archiveEntries)
+	{
+		offset = (offset + ASSET_ARCHIVE_ALIGNMENT - 1) & ~static_cast<uint64_t>(ASSET_ARCHIVE_ALIGNMENT - 1);
+		entry.offset = offset;
+		offset += entry.storedSize;
+	}
+
+	std::vector<AssetArchiveEntry> sortedEntries;
+	for(uint32_t index: order)
+	{
+		sortedEntries.push_back(archiveEntries[index]);
+	}
+
+	AssetArchiveHeader header = {};
+	header.magic = ASSET_ARCHIVE_MAGIC;
+	header.version = ASSET_ARCHIVE_VERSION;
+	header.entriesNumber = static_cast<uint32_t>(sortedEntries.size());
+
+	std::ofstream archiveFile(archiveFileName, std::ios::binary | std::ios::trunc);
+
+	if(!archiveFile.is_open())
+	{
+		throw std::runtime_error("Failed to create asset archive " + archiveFileName);
+	}
+
+	archiveFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	archiveFile.write(reinterpret_cast<const char*>(sortedEntries.data()), sortedEntries.size() * sizeof(AssetArchiveEntry));
+	uint64_t written = sizeof(AssetArchiveHeader) + sortedEntries.size() * sizeof(AssetArchiveEntry);
+
+	const char padding[ASSET_ARCHIVE_ALIGNMENT] = {};
+	for(size_t i=0; i<archiveEntries.size(); i++)
+	{
+		archiveFile.write(padding, archiveEntries[i].offset - written);
+		archiveFile.write(storedData[i].data(), storedData[i].size());
+		written = archiveEntries[i].offset + storedData[i].size();
+	}
+
+	if(!archiveFile.good())
+	{
+		throw std::runtime_error("Failed to write asset archive " + archiveFileName);
+	}
+}
+
+// 64 bit FNV-1a of normalized name
+uint64_t AssetArchive::hashName(const std::string& name)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for(char character: name)
+	{
+		character = character == '\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+		hash ^= static_cast<uint8_t>(character);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static void writeLzLength(uint32_t length, std::vector<char>& compressed)
+{
+	for(; length >= 255; length -= 255)
+	{
+		compressed.push_back(static_cast<char>(255));
+	}
+	compressed.push_back(static_cast<char>(length));
+}
+
+static void writeLzSequence(const char* literals, uint32_t literalsLength, uint32_t offset, uint32_t matchLength, std::vector<char>& compressed)
+{
+	// Token has length of literals in high 4 bits and match length without LZ_MIN_MATCH in low 4 bits
+	uint32_t matchCode = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+	compressed.push_back(static_cast<char>((std::min(literalsLength, LZ_TOKEN_LENGTH_MAX) << 4) | std::min(matchCode, LZ_TOKEN_LENGTH_MAX)));
+
+	if(literalsLength >= LZ_TOKEN_LENGTH_MAX)
+	{
+		writeLzLength(literalsLength - LZ_TOKEN_LENGTH_MAX, compressed);
+	}
+	compressed.insert(compressed.end(), literals, literals + literalsLength);
+
+	// Last sequence has only literals
+	if(matchLength == 0)
+	{
+		return;
+	}
+
+	compressed.push_back(static_cast<char>(offset & 0xFF));
+	compressed.push_back(static_cast<char>(offset >> 8));
+
+	if(matchCode >= LZ_TOKEN_LENGTH_MAX)
+	{
+		writeLzLength(matchCode - LZ_TOKEN_LENGTH_MAX, compressed);
+	}
+}
+
+void AssetArchive::compressLz(const char* data, size_t size, std::vector<char>& compressed)
+{
+	compressed.clear();
+	compressed.reserve(size + size / 255 + 16);
+
+	// Position plus one, zero is empty slot
+	std::vector<uint32_t> positions(static_cast<size_t>(1) << LZ_HASH_BITS, 0);
+	size_t anchor = 0;
+	size_t position = 0;
+
+	while(size >= LZ_MIN_MATCH + LZ_END_LITERALS && position <= size - LZ_MIN_MATCH - LZ_END_LITERALS)
+	{
+		uint32_t sequence;
+		std::memcpy(&sequence, data + position, sizeof(sequence));
+		uint32_t hash = (sequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+		size_t candidate = positions[hash];
+		positions[hash] = static_cast<uint32_t>(position + 1);
+
+		if(candidate == 0 || position - (candidate - 1) > LZ_MAX_OFFSET || std::memcmp(data + candidate - 1, data + position, LZ_MIN_MATCH) != 0)
+		{
+			++position;
+			continue;
+		}
+
+		const size_t match = candidate - 1;
+		size_t length = LZ_MIN_MATCH;
+		while(position + length < size - LZ_END_LITERALS && data[match + length] == data[position + length])
+		{
+			++length;
+		}
+
+		writeLzSequence(data + anchor, static_cast<uint32_t>(position - anchor), static_cast<uint32_t>(position - match), static_cast<uint32_t>(length), compressed);
+		position += length;
+		anchor = position;
+	}
+
+	writeLzSequence(data + anchor, static_cast<uint32_t>(size - anchor), 0, 0, compressed);
+}
+
+// Returns false when length continues past end of data
+static bool readLzLength(const uint8_t*& input, const uint8_t* end, size_t& length)
+{
+	uint8_t byte;
+	do
+	{
+		if(input == end)
+		{
+			return false;
+		}
+		byte = *input++;
+		length += byte;
+	}
+	while(byte == 255);
+	return true;
+}
+
+bool AssetArchive::decompressLz(const char* compressed, size_t compressedSize, char* data, size_t size)
+{
+	const uint8_t* input = reinterpret_cast<const uint8_t*>(compressed);
+	const uint8_t* inputEnd = input + compressedSize;
+	char* output = data;
+	char* outputEnd = data + size;
+
+	while(input < inputEnd)
+	{
+		const uint32_t token = *input++;
+		size_t literalsLength = token >> 4;
+
+		if(literalsLength == LZ_TOKEN_LENGTH_MAX && !readLzLength(input, inputEnd, literalsLength))
+		{
+			return false;
+		}
+
+		if(literalsLength > static_cast<size_t>(inputEnd - input) || literalsLength > static_cast<size_t>(outputEnd - output))
+		{
+			return false;
+		}
+
+		std::copy(input, input + literalsLength, output);
+		input += literalsLength;
+		output += literalsLength;
+
+		// Sequence which fills output is the last one
+		if(output == outputEnd)
+		{
+			return input == inputEnd;
+		}
+
+		if(inputEnd - input < 2)
+		{
+			return false;
+		}
+
+		const size_t offset = input[0] | (input[1] << 8);
+		input += 2;
+		size_t matchLength = token & LZ_TOKEN_LENGTH_MAX;
+
+		if(matchLength == LZ_TOKEN_LENGTH_MAX && !readLzLength(input, inputEnd, matchLength))
+		{
+			return false;
+		}
+		matchLength += LZ_MIN_MATCH;
+
+		if(offset == 0 || offset > static_cast<size_t>(output - data) || matchLength > static_cast<size_t>(outputEnd - output))
+		{
+			return false;
+		}
+
+		// Match can overlap bytes it produces, then it repeats last offset bytes
+		const char* match = output - offset;
+		if(offset >= matchLength)
+		{
+			std::memcpy(output, match, matchLength);
+			output += matchLength;
+		}
+		else
+		{
+			for(size_t i=0; i<matchLength; i++)
+			{
+				*output++ = match[i];
+			}
+		}
+	}
+	return false;
+}
+
+const AssetArchiveEntry* AssetArchive::findEntry(const std::string& name) const
+{
+	const uint64_t nameHash = hashName(name);
+	const AssetArchiveEntry* entry = std::lower_bound(entries, entries + entriesNumber, nameHash, [](const AssetArchiveEntry& entry, uint64_t nameHash)
+	{
+		return entry.nameHash < nameHash;
+	});
+
+	if(entry == entries + entriesNumber || entry->nameHash != nameHash)
+	{
+		return nullptr;
+	}
+	return entry;
+}
@@ -0,0 +1,88 @@
+#ifndef ASSETARCHIVE_HPP
+#define ASSETARCHIVE_HPP
+#include"stdafx.hpp"
+#include"MappedFile.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Assets packed into one file by YasEngine --pack-assets. When it exists its entries are used instead of loose files.
+const char* const ASSET_ARCHIVE_PATH		= "assets.yar";
+const uint32_t ASSET_ARCHIVE_MAGIC			= 0x52415359; // "YSAR"
+const uint32_t ASSET_ARCHIVE_VERSION		= 1;
+// Entry data starts at multiple of this, mapped view starts at page boundary
+const uint32_t ASSET_ARCHIVE_ALIGNMENT		= 64;
+
+enum AssetCompression
+{
+	ASSET_COMPRESSION_NONE				= 0,
+	// Byte oriented LZ77, sequences of literals and matches as in LZ4 block format
+	ASSET_COMPRESSION_LZ				= 1
+};
+
+// Archive layout: header, entries table sorted by name hash, then data of every entry aligned to ASSET_ARCHIVE_ALIGNMENT
+struct AssetArchiveHeader
+{
+	uint32_t						magic;
+	uint32_t						version;
+	uint32_t						entriesNumber;
+	uint32_t						reserved;
+};
+
+struct AssetArchiveEntry
+{
+	// Hash of normalized name, see AssetArchive::hashName
+	uint64_t						nameHash;
+	// From start of archive
+	uint64_t						offset;
+	uint32_t						size;
+	// Size in archive, the same as size when entry is not compressed
+	uint32_t						storedSize;
+	uint32_t						compression;
+	uint32_t						reserved;
+};
+
+// Bytes of asset, not owned
+struct AssetSpan
+{
+	const char*						data;
+	size_t							size;
+};
+
+// Read only archive mapped once. Looking up entry is binary search in mapped table, nothing is allocated.
+class AssetArchive
+{
+	public:
+
+										AssetArchive();
+										AssetArchive(const AssetArchive&) = delete;
+		AssetArchive&					operator=(const AssetArchive&) = delete;
+
+		// Returns false when archive does not exist. Throws when it is corrupted.
+		bool							open(const std::string& fileName);
+		void							close();
+		bool							isOpen() const;
+		uint32_t						getEntriesNumber() const;
+		bool							contains(const std::string& name) const;
+		// Span of uncompressed entry points straight into mapping and stays valid until archive is closed.
+		// Compressed entry is decompressed into buffer and span points into it. Returns false when archive has no such entry.
+		bool							read(const std::string& name, AssetSpan& span, std::vector<char>& buffer) const;
+
+		// Packs files under their names. Compressed entries are kept only when compression saves enough.
+		static void						write(const std::string& archiveFileName, const std::vector<std::string>& fileNames, bool compress);
+		// Case insensitive, backslashes match slashes, so "Models\\chalet.obj" is the same entry as "models/chalet.obj"
+		static uint64_t					hashName(const std::string& name);
+
+		static void						compressLz(const char* data, size_t size, std::vector<char>& compressed);
+		// Returns false when compressed data is corrupted or does not decompress into exactly size bytes
+		static bool						decompressLz(const char* compressed, size_t compressedSize, char* data, size_t size);
+
+	private:
+
+		const AssetArchiveEntry*		findEntry(const std::string& name) const;
+
+		MappedFile						file;
+		const AssetArchiveEntry*		entries;
+		uint32_t						entriesNumber;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include"stdafx.hpp"
+#include"Clock.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+int64_t Clock::nanoseconds()
+{
+	// steady_clock is QueryPerformanceCounter on Windows and CLOCK_MONOTONIC on Linux
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double Clock::toSeconds(int64_t nanoseconds)
+{
+	// Whole seconds and remainder are converted separately so result is exact to nanosecond up to 2^53 seconds
+	return static_cast<double>(nanoseconds / NANOSECONDS_PER_SECOND) + static_cast<double>(nanoseconds % NANOSECONDS_PER_SECOND) / NANOSECONDS_PER_SECOND;
+}
+
+int64_t Clock::fromSeconds(double seconds)
+{
+	return static_cast<int64_t>(std::llround(seconds * NANOSECONDS_PER_SECOND));
+}
+
+void Clock::sleepUntil(int64_t nanoseconds)
+{
+	std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(nanoseconds))));
+}
+
+FrameTimer::FrameTimer()
+{
+	started = false;
+	lastTickNanoseconds = 0;
+	deltaNanoseconds = 0;
+	simulationNanoseconds = 0;
+	framesNumber = 0;
+}
+
+void FrameTimer::reset(int64_t nowNanoseconds)
+{
+	started = true;
+	lastTickNanoseconds = nowNanoseconds;
+	deltaNanoseconds = 0;
+	simulationNanoseconds = 0;
+	framesNumber = 0;
+}
+
+double FrameTimer::tick(int64_t nowNanoseconds)
+{
+	if(!started)
+	{
+		reset(nowNanoseconds);
+		return 0.0;
+	}
+
+	deltaNanoseconds = nowNanoseconds - lastTickNanoseconds;
+	lastTickNanoseconds = nowNanoseconds;
+	simulationNanoseconds += deltaNanoseconds;
+	++framesNumber;
+	return getDeltaSeconds();
+}
+
+int64_t FrameTimer::getDeltaNanoseconds() const
+{
+	return deltaNanoseconds;
+}
+
+double FrameTimer::getDeltaSeconds() const
+{
+	return Clock::toSeconds(deltaNanoseconds);
+}
+
+int64_t FrameTimer::getSimulationNanoseconds() const
+{
+	return simulationNanoseconds;
+}
+
+double FrameTimer::getSimulationSeconds() const
+{
+	return Clock::toSeconds(simulationNanoseconds);
+}
+
+int64_t FrameTimer::getLastTickNanoseconds() const
+{
+	return lastTickNanoseconds;
+}
+
+uint64_t FrameTimer::getFramesNumber() const
+{
+	return framesNumber;
+}
@@ -0,0 +1,49 @@
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+const int64_t NANOSECONDS_PER_SECOND			= 1000000000LL;
+
+// Monotonic time as integer nanoseconds. Time points are never stored as floating point,
+// only differences between them are converted, so precision does not depend on uptime.
+class Clock
+{
+	public:
+
+		static int64_t					nanoseconds();
+		static double					toSeconds(int64_t nanoseconds);
+		static int64_t					fromSeconds(double seconds);
+		static void						sleepUntil(int64_t nanoseconds);
+};
+
+// Measures frames. Real time is passed in so it can be driven by fixed step or by test instead of Clock.
+// Simulation time is sum of integer deltas, it always equals time since reset and does not drift.
+class FrameTimer
+{
+	public:
+
+										FrameTimer();
+		// Next tick measures from given time
+		void							reset(int64_t nowNanoseconds);
+		// Returns seconds since previous tick. First tick after construction starts timer and returns 0.
+		double							tick(int64_t nowNanoseconds);
+
+		int64_t							getDeltaNanoseconds() const;
+		double							getDeltaSeconds() const;
+		int64_t							getSimulationNanoseconds() const;
+		double							getSimulationSeconds() const;
+		int64_t							getLastTickNanoseconds() const;
+		uint64_t						getFramesNumber() const;
+
+	private:
+
+		bool							started;
+		int64_t							lastTickNanoseconds;
+		int64_t							deltaNanoseconds;
+		int64_t							simulationNanoseconds;
+		uint64_t						framesNumber;
+};
+
+#endif
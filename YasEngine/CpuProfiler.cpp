@@ -0,0 +1,158 @@
+#include"stdafx.hpp"
+#include"CpuProfiler.hpp"
+#include"YasLog.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+thread_local CpuProfileThreadBuffer* CpuProfiler::threadBuffer = nullptr;
+std::atomic<bool> CpuProfiler::running(false);
+std::vector<std::unique_ptr<CpuProfileThreadBuffer>> CpuProfiler::threadBuffers;
+std::mutex CpuProfiler::threadBuffersMutex;
+std::ofstream CpuProfiler::traceFile;
+bool CpuProfiler::firstTraceEvent = true;
+uint64_t CpuProfiler::startTicks = 0;
+std::chrono::steady_clock::time_point CpuProfiler::startTime;
+std::thread CpuProfiler::flushThread;
+std::mutex CpuProfiler::flushMutex;
+std::condition_variable CpuProfiler::flushCondition;
+
+void CpuProfiler::start(const std::string& traceFileName)
+{
+	if(running.load())
+	{
+		return;
+	}
+
+	traceFile.open(traceFileName, std::ios::trunc);
+
+	if(!traceFile.is_open())
+	{
+		throw std::runtime_error("Failed to create CPU trace file");
+	}
+
+	// Timestamps are in microseconds, default precision would switch to exponent after 1 second
+	traceFile.setf(std::ios::fixed);
+	traceFile.precision(3);
+	traceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	firstTraceEvent = true;
+	startTime = std::chrono::steady_clock::now();
+	startTicks = ticks();
+
+	running.store(true);
+	flushThread = std::thread(flushLoop);
+}
+
+void CpuProfiler::stop()
+{
+	if(!running.load())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(flushMutex);
+		running.store(false);
+	}
+	flushCondition.notify_one();
+	flushThread.join();
+
+	// Scopes which were open during stop may still finish writing, what is in rings now is written
+	flush();
+	traceFile << "\n]}\n";
+	traceFile.close();
+
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+	for(const std::unique_ptr<CpuProfileThreadBuffer>& buffer: threadBuffers)
+	{
+		if(buffer->droppedEvents > 0)
+		{
+			YAS_LOG_WARNING("CPU profiler dropped {} events of thread {}, flush thread could not keep up", buffer->droppedEvents, buffer->threadIndex);
+		}
+	}
+}
+
+CpuProfileThreadBuffer* CpuProfiler::registerThread()
+{
+	std::unique_ptr<CpuProfileThreadBuffer> buffer(new CpuProfileThreadBuffer());
+	buffer->head.store(0);
+	buffer->tail.store(0);
+	buffer->droppedEvents = 0;
+	buffer->threadNameWritten = false;
+
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+	buffer->threadIndex = static_cast<uint32_t>(threadBuffers.size());
+	threadBuffer = buffer.get();
+	threadBuffers.push_back(std::move(buffer));
+	return threadBuffer;
+}
+
+void CpuProfiler::setThreadName(const char* name)
+{
+	CpuProfileThreadBuffer* buffer = threadBuffer;
+	if(buffer == nullptr)
+	{
+		buffer = registerThread();
+	}
+
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+	buffer->threadName = name;
+	buffer->threadNameWritten = false;
+}
+
+void CpuProfiler::flushLoop()
+{
+	std::unique_lock<std::mutex> lock(flushMutex);
+
+	while(running.load())
+	{
+		flushCondition.wait_for(lock, std::chrono::milliseconds(CPU_PROFILER_FLUSH_MILLISECONDS));
+		flush();
+	}
+}
+
+void CpuProfiler::flush()
+{
+	// Tick frequency is measured over whole recording, so it gets more precise with every flush
+	double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	uint64_t elapsedTicks = ticks() - startTicks;
+
+	if(elapsedSeconds <= 0.0 || elapsedTicks == 0)
+	{
+		return;
+	}
+
+	const double microsecondsPerTick = elapsedSeconds * 1000000.0 / elapsedTicks;
+
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+
+	for(const std::unique_ptr<CpuProfileThreadBuffer>& buffer: threadBuffers)
+	{
+		if(!buffer->threadNameWritten && !buffer->threadName.empty())
+		{
+			traceFile << (firstTraceEvent ? "\n" : ",\n");
+			traceFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadIndex << ",\"args\":{\"name\":\"" << buffer->threadName << "\"}}";
+			buffer->threadNameWritten = true;
+			firstTraceEvent = false;
+		}
+
+		uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+		for(uint64_t i=tail; i<head; i++)
+		{
+			const CpuProfileEvent& event = buffer->events[i & (CPU_PROFILER_RING_SIZE - 1)];
+			// Scope can start before profiler was started
+			double timestamp = (static_cast<int64_t>(event.beginTicks - startTicks)) * microsecondsPerTick;
+			double duration = (event.endTicks - event.beginTicks) * microsecondsPerTick;
+
+			traceFile << (firstTraceEvent ? "\n" : ",\n");
+			traceFile << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadIndex << ",\"ts\":" << timestamp << ",\"dur\":" << duration << "}";
+			firstTraceEvent = false;
+		}
+
+		// Slots are given back to writer only after they were read
+		buffer->tail.store(head, std::memory_order_release);
+	}
+
+	traceFile.flush();
+}
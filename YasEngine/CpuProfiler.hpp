@@ -0,0 +1,144 @@
+#ifndef CPUPROFILER_HPP
+#define CPUPROFILER_HPP
+#include"stdafx.hpp"
+#ifdef _MSC_VER
+	#include<intrin.h>
+#else
+	#include<x86intrin.h>
+#endif
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Profiling is on in debug builds. Release builds need YAS_ENABLE_CPU_PROFILING defined.
+#if !defined(NDEBUG) || defined(YAS_ENABLE_CPU_PROFILING)
+	#define YAS_CPU_PROFILING
+#endif
+
+// Must be power of two
+const uint32_t CPU_PROFILER_RING_SIZE			= 1 << 16;
+const uint32_t CPU_PROFILER_FLUSH_MILLISECONDS	= 100;
+
+struct CpuProfileEvent
+{
+	const char*						name;
+	uint64_t						beginTicks;
+	uint64_t						endTicks;
+};
+
+// Ring with one writer (thread which owns it) and one reader (flush thread). Counters only grow, index is counter & mask.
+struct CpuProfileThreadBuffer
+{
+	std::array<CpuProfileEvent, CPU_PROFILER_RING_SIZE> events;
+	// Counters are on separate cache lines so writer and reader do not invalidate each other
+	alignas(64) std::atomic<uint64_t> head;
+	alignas(64) std::atomic<uint64_t> tail;
+	uint64_t						droppedEvents;
+	uint32_t						threadIndex;
+	std::string						threadName;
+	bool							threadNameWritten;
+};
+
+// Scoped CPU instrumentation written to Chrome Trace Event JSON (opens in chrome://tracing and Perfetto).
+// Recording thread only writes to own ring, JSON is written by background thread.
+class CpuProfiler
+{
+	public:
+
+		static void						start(const std::string& traceFileName);
+		// Writes remaining events and closes trace file
+		static void						stop();
+		static void						setThreadName(const char* name);
+
+		// Time stamp counter is invariant on all x64 CPUs engine runs on. It is converted to time when trace is written.
+		static inline uint64_t			ticks()
+		{
+			return __rdtsc();
+		}
+
+		// Name must stay valid until trace is written, string literals are expected
+		static inline void				record(const char* name, uint64_t beginTicks, uint64_t endTicks)
+		{
+			if(!running.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			CpuProfileThreadBuffer* buffer = threadBuffer;
+			if(buffer == nullptr)
+			{
+				buffer = registerThread();
+			}
+
+			uint64_t head = buffer->head.load(std::memory_order_relaxed);
+
+			// Event is dropped instead of waiting for flush thread
+			if(head - buffer->tail.load(std::memory_order_acquire) >= CPU_PROFILER_RING_SIZE)
+			{
+				++buffer->droppedEvents;
+				return;
+			}
+
+			CpuProfileEvent& event = buffer->events[head & (CPU_PROFILER_RING_SIZE - 1)];
+			event.name = name;
+			event.beginTicks = beginTicks;
+			event.endTicks = endTicks;
+			buffer->head.store(head + 1, std::memory_order_release);
+		}
+
+	private:
+
+		static CpuProfileThreadBuffer*	registerThread();
+		static void						flushLoop();
+		static void						flush();
+
+		static thread_local CpuProfileThreadBuffer* threadBuffer;
+		static std::atomic<bool>		running;
+		// Buffers live until program ends because threads keep pointers to them
+		static std::vector<std::unique_ptr<CpuProfileThreadBuffer>> threadBuffers;
+		static std::mutex				threadBuffersMutex;
+
+		static std::ofstream			traceFile;
+		static bool						firstTraceEvent;
+		static uint64_t					startTicks;
+		static std::chrono::steady_clock::time_point startTime;
+		static std::thread				flushThread;
+		static std::mutex				flushMutex;
+		static std::condition_variable	flushCondition;
+};
+
+class CpuProfileScope
+{
+	public:
+
+		explicit						CpuProfileScope(const char* name) : name(name), beginTicks(CpuProfiler::ticks())
+		{
+		}
+
+										~CpuProfileScope()
+		{
+			CpuProfiler::record(name, beginTicks, CpuProfiler::ticks());
+		}
+
+	private:
+
+		const char*						name;
+		uint64_t						beginTicks;
+};
+
+#ifdef YAS_CPU_PROFILING
+	#define YAS_PROFILE_CONCATENATE_INNER(a, b)	a##b
+	#define YAS_PROFILE_CONCATENATE(a, b)		YAS_PROFILE_CONCATENATE_INNER(a, b)
+	#define YAS_PROFILE_SCOPE(name)				CpuProfileScope YAS_PROFILE_CONCATENATE(cpuProfileScope, __LINE__)(name)
+	#define YAS_PROFILE_FUNCTION()				YAS_PROFILE_SCOPE(__FUNCTION__)
+	#define YAS_PROFILE_THREAD_NAME(name)		CpuProfiler::setThreadName(name)
+	#define YAS_PROFILE_START(traceFileName)	CpuProfiler::start(traceFileName)
+	#define YAS_PROFILE_STOP()					CpuProfiler::stop()
+#else
+	#define YAS_PROFILE_SCOPE(name)				((void)0)
+	#define YAS_PROFILE_FUNCTION()				((void)0)
+	#define YAS_PROFILE_THREAD_NAME(name)		((void)0)
+	#define YAS_PROFILE_START(traceFileName)	((void)0)
+	#define YAS_PROFILE_STOP()					((void)0)
+#endif
+
+#endif
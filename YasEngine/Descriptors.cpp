@@ -0,0 +1,319 @@
+#include"stdafx.hpp"
+#include"Descriptors.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+DescriptorLayoutCache::DescriptorLayoutCache()
+{
+	device = VK_NULL_HANDLE;
+}
+
+void DescriptorLayoutCache::initialize(VkDevice device)
+{
+	this->device = device;
+}
+
+void DescriptorLayoutCache::destroy()
+{
+	std::lock_guard<std::mutex> lock(entriesMutex);
+
+	for(const std::pair<const uint64_t, Entry>& entry: entries)
+	{
+		vkDestroyDescriptorUpdateTemplate(device, entry.second.layout.updateTemplate, nullptr);
+		vkDestroyDescriptorSetLayout(device, entry.second.layout.layout, nullptr);
+	}
+	entries.clear();
+}
+
+DescriptorLayout DescriptorLayoutCache::getLayout(const VkDescriptorSetLayoutBinding* bindings, uint32_t bindingsNumber)
+{
+	std::vector<VkDescriptorSetLayoutBinding> sortedBindings(bindings, bindings + bindingsNumber);
+	std::sort(sortedBindings.begin(), sortedBindings.end(), [](const VkDescriptorSetLayoutBinding& first, const VkDescriptorSetLayoutBinding& second)
+	{
+		return first.binding < second.binding;
+	});
+
+	for(const VkDescriptorSetLayoutBinding& binding: sortedBindings)
+	{
+		if(binding.pImmutableSamplers != nullptr)
+		{
+			throw std::runtime_error("Descriptor layout cache does not support immutable samplers");
+		}
+	}
+
+	const uint64_t hash = hashBindings(sortedBindings.data(), bindingsNumber);
+	std::lock_guard<std::mutex> lock(entriesMutex);
+	std::pair<std::unordered_multimap<uint64_t, Entry>::iterator, std::unordered_multimap<uint64_t, Entry>::iterator> range = entries.equal_range(hash);
+
+	for(std::unordered_multimap<uint64_t, Entry>::iterator entry = range.first; entry != range.second; ++entry)
+	{
+		const std::vector<VkDescriptorSetLayoutBinding>& cached = entry->second.bindings;
+		bool equal = cached.size() == sortedBindings.size();
+
+		for(size_t i=0; equal && i<cached.size(); i++)
+		{
+			equal = cached[i].binding == sortedBindings[i].binding && cached[i].descriptorType == sortedBindings[i].descriptorType
+				&& cached[i].descriptorCount == sortedBindings[i].descriptorCount && cached[i].stageFlags == sortedBindings[i].stageFlags;
+		}
+
+		if(equal)
+		{
+			return entry->second.layout;
+		}
+	}
+
+	Entry entry;
+	entry.layout = createLayout(sortedBindings);
+	entry.bindings = std::move(sortedBindings);
+	DescriptorLayout layout = entry.layout;
+	entries.emplace(hash, std::move(entry));
+	return layout;
+}
+
+DescriptorLayout DescriptorLayoutCache::createLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+	DescriptorLayout layout = {};
+
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
+	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+
+	if(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo, nullptr, &layout.layout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor set layout");
+	}
+
+	// One template entry per binding, reading consecutive DescriptorInfo elements
+	std::vector<VkDescriptorUpdateTemplateEntry> templateEntries(bindings.size());
+	for(size_t i=0; i<bindings.size(); i++)
+	{
+		templateEntries[i].dstBinding = bindings[i].binding;
+		templateEntries[i].dstArrayElement = 0;
+		templateEntries[i].descriptorCount = bindings[i].descriptorCount;
+		templateEntries[i].descriptorType = bindings[i].descriptorType;
+		templateEntries[i].offset = sizeof(DescriptorInfo) * layout.descriptorsNumber;
+		templateEntries[i].stride = sizeof(DescriptorInfo);
+		layout.descriptorsNumber += bindings[i].descriptorCount;
+	}
+
+	VkDescriptorUpdateTemplateCreateInfo updateTemplateCreateInfo = {};
+	updateTemplateCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+	updateTemplateCreateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(templateEntries.size());
+	updateTemplateCreateInfo.pDescriptorUpdateEntries = templateEntries.data();
+	updateTemplateCreateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	updateTemplateCreateInfo.descriptorSetLayout = layout.layout;
+
+	if(vkCreateDescriptorUpdateTemplate(device, &updateTemplateCreateInfo, nullptr, &layout.updateTemplate) != VK_SUCCESS)
+	{
+		vkDestroyDescriptorSetLayout(device, layout.layout, nullptr);
+		throw std::runtime_error("Failed to create descriptor update template");
+	}
+
+	return layout;
+}
+
+void DescriptorLayoutCache::writeDescriptorSet(VkDescriptorSet descriptorSet, const DescriptorLayout& layout, const DescriptorInfo* descriptors)
+{
+	vkUpdateDescriptorSetWithTemplate(device, descriptorSet, layout.updateTemplate, descriptors);
+}
+
+uint32_t DescriptorLayoutCache::getLayoutsNumber()
+{
+	std::lock_guard<std::mutex> lock(entriesMutex);
+	return static_cast<uint32_t>(entries.size());
+}
+
+//static function
+uint64_t DescriptorLayoutCache::hashBindings(const VkDescriptorSetLayoutBinding* bindings, uint32_t bindingsNumber)
+{
+	// FNV-1a over fields which make layouts different, padding and sampler pointers are skipped
+	uint64_t hash = 14695981039346656037ULL;
+	for(uint32_t i=0; i<bindingsNumber; i++)
+	{
+		const uint32_t fields[] = {bindings[i].binding, static_cast<uint32_t>(bindings[i].descriptorType), bindings[i].descriptorCount, bindings[i].stageFlags};
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(fields);
+
+		for(size_t j=0; j<sizeof(fields); j++)
+		{
+			hash ^= bytes[j];
+			hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+DescriptorAllocator::DescriptorAllocator()
+{
+	device = VK_NULL_HANDLE;
+	currentPool = 0;
+	nextPoolSets = DESCRIPTOR_POOL_FIRST_SETS;
+	allocationsNumber = 0;
+}
+
+void DescriptorAllocator::initialize(VkDevice device, const std::vector<DescriptorPoolRatio>& ratios)
+{
+	this->device = device;
+	this->ratios = ratios;
+	currentPool = 0;
+	nextPoolSets = DESCRIPTOR_POOL_FIRST_SETS;
+	allocationsNumber = 0;
+}
+
+void DescriptorAllocator::destroy()
+{
+	for(VkDescriptorPool pool: pools)
+	{
+		vkDestroyDescriptorPool(device, pool, nullptr);
+	}
+	pools.clear();
+	currentPool = 0;
+	nextPoolSets = DESCRIPTOR_POOL_FIRST_SETS;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+{
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	descriptorSetAllocateInfo.pSetLayouts = &layout;
+
+	if(pools.empty())
+	{
+		pools.push_back(createPool(nextPoolSets));
+	}
+
+	bool emptyPool = false;
+
+	while(true)
+	{
+		descriptorSetAllocateInfo.descriptorPool = pools[currentPool];
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		VkResult result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorSet);
+
+		if(result == VK_SUCCESS)
+		{
+			++allocationsNumber;
+			return descriptorSet;
+		}
+
+		if(result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+		{
+			throw std::runtime_error("Failed to allocate descriptor set");
+		}
+
+		// Set which does not fit into empty pool would not fit into next one either
+		if(emptyPool)
+		{
+			throw std::runtime_error("Descriptor set does not fit into empty pool, ratios of allocator miss its descriptor types");
+		}
+
+		++currentPool;
+		if(currentPool == pools.size())
+		{
+			pools.push_back(createPool(nextPoolSets));
+		}
+		emptyPool = true;
+	}
+}
+
+void DescriptorAllocator::reset()
+{
+	// Pools after current one were not used since last reset
+	for(uint32_t i=0; i<pools.size() && i<=currentPool; i++)
+	{
+		vkResetDescriptorPool(device, pools[i], 0);
+	}
+	currentPool = 0;
+}
+
+uint64_t DescriptorAllocator::getAllocationsNumber() const
+{
+	return allocationsNumber;
+}
+
+uint32_t DescriptorAllocator::getPoolsNumber() const
+{
+	return static_cast<uint32_t>(pools.size());
+}
+
+VkDescriptorPool DescriptorAllocator::createPool(uint32_t setsNumber)
+{
+	std::vector<VkDescriptorPoolSize> poolSizes(ratios.size());
+	for(size_t i=0; i<ratios.size(); i++)
+	{
+		poolSizes[i].type = ratios[i].type;
+		poolSizes[i].descriptorCount = std::max(static_cast<uint32_t>(std::ceil(ratios[i].descriptorsPerSet * setsNumber)), 1U);
+	}
+
+	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
+	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
+	descriptorPoolCreateInfo.maxSets = setsNumber;
+
+	VkDescriptorPool pool;
+	if(vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, nullptr, &pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool.");
+	}
+
+	nextPoolSets = std::min(nextPoolSets * 2, DESCRIPTOR_POOL_MAX_SETS);
+	return pool;
+}
+
+FrameDescriptorAllocator::FrameDescriptorAllocator()
+{
+	currentIndex = 0;
+}
+
+void FrameDescriptorAllocator::initialize(VkDevice device, uint32_t framesNumber, const std::vector<DescriptorPoolRatio>& ratios)
+{
+	allocators.clear();
+	for(uint32_t i=0; i<framesNumber; i++)
+	{
+		allocators.push_back(std::unique_ptr<DescriptorAllocator>(new DescriptorAllocator()));
+		allocators.back()->initialize(device, ratios);
+	}
+	currentIndex = 0;
+}
+
+void FrameDescriptorAllocator::destroy()
+{
+	for(std::unique_ptr<DescriptorAllocator>& allocator: allocators)
+	{
+		allocator->destroy();
+	}
+	allocators.clear();
+}
+
+void FrameDescriptorAllocator::beginFrame(uint32_t frameIndex)
+{
+	currentIndex = frameIndex;
+	allocators[currentIndex]->reset();
+}
+
+DescriptorAllocator& FrameDescriptorAllocator::current()
+{
+	return *allocators[currentIndex];
+}
+
+uint64_t FrameDescriptorAllocator::getAllocationsNumber() const
+{
+	uint64_t allocationsNumber = 0;
+	for(const std::unique_ptr<DescriptorAllocator>& allocator: allocators)
+	{
+		allocationsNumber += allocator->getAllocationsNumber();
+	}
+	return allocationsNumber;
+}
+
+uint32_t FrameDescriptorAllocator::getPoolsNumber() const
+{
+	uint32_t poolsNumber = 0;
+	for(const std::unique_ptr<DescriptorAllocator>& allocator: allocators)
+	{
+		poolsNumber += allocator->getPoolsNumber();
+	}
+	return poolsNumber;
+}
@@ -0,0 +1,118 @@
+#ifndef DESCRIPTORS_HPP
+#define DESCRIPTORS_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Sets of first pool of allocator, every next pool is twice as big up to maximum
+const uint32_t DESCRIPTOR_POOL_FIRST_SETS		= 64;
+const uint32_t DESCRIPTOR_POOL_MAX_SETS			= 4096;
+
+// Element of data written by update template. Descriptors of all bindings follow one another in binding order,
+// array binding takes descriptorCount elements.
+union DescriptorInfo
+{
+	VkDescriptorBufferInfo			buffer;
+	VkDescriptorImageInfo			image;
+	VkBufferView					texelBufferView;
+};
+
+// Layout with template which writes all its bindings in one call
+struct DescriptorLayout
+{
+	VkDescriptorSetLayout			layout;
+	VkDescriptorUpdateTemplate		updateTemplate;
+	uint32_t						descriptorsNumber;
+};
+
+// Pool of allocator holds descriptorsPerSet descriptors of type for each of its sets
+struct DescriptorPoolRatio
+{
+	VkDescriptorType				type;
+	float							descriptorsPerSet;
+};
+
+// Layouts are created once per distinct list of bindings and live as long as device. All methods are thread safe.
+class DescriptorLayoutCache
+{
+	public:
+
+										DescriptorLayoutCache();
+		void							initialize(VkDevice device);
+		void							destroy();
+		// Bindings can be in any order. Immutable samplers are not part of key, so they are not accepted.
+		DescriptorLayout				getLayout(const VkDescriptorSetLayoutBinding* bindings, uint32_t bindingsNumber);
+		// Descriptors are laid out as described at DescriptorInfo
+		void							writeDescriptorSet(VkDescriptorSet descriptorSet, const DescriptorLayout& layout, const DescriptorInfo* descriptors);
+		uint32_t						getLayoutsNumber();
+
+		// Bindings must be sorted by binding number
+		static uint64_t					hashBindings(const VkDescriptorSetLayoutBinding* bindings, uint32_t bindingsNumber);
+
+	private:
+
+		struct Entry
+		{
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			DescriptorLayout			layout;
+		};
+
+		DescriptorLayout				createLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+		VkDevice						device;
+		// Entries with equal hash are compared binding by binding
+		std::unordered_multimap<uint64_t, Entry> entries;
+		std::mutex						entriesMutex;
+};
+
+// Allocates sets from chain of pools. When current pool is out of memory the next one is used, created when it does not exist yet.
+// Reset gives back all sets at once and keeps pools for reuse. Not thread safe, each thread or frame needs its own allocator.
+class DescriptorAllocator
+{
+	public:
+
+										DescriptorAllocator();
+		// Ratios must cover every descriptor type of layouts which are allocated
+		void							initialize(VkDevice device, const std::vector<DescriptorPoolRatio>& ratios);
+		void							destroy();
+		VkDescriptorSet					allocate(VkDescriptorSetLayout layout);
+		void							reset();
+
+		uint64_t						getAllocationsNumber() const;
+		uint32_t						getPoolsNumber() const;
+
+	private:
+
+		VkDescriptorPool				createPool(uint32_t setsNumber);
+
+		VkDevice						device;
+		std::vector<DescriptorPoolRatio> ratios;
+		// Pools after current one are empty
+		std::vector<VkDescriptorPool>	pools;
+		uint32_t						currentPool;
+		uint32_t						nextPoolSets;
+		uint64_t						allocationsNumber;
+};
+
+// Allocator per frame in flight, reset in bulk when frame begins like FrameArena.
+// Sets stay valid until the same frame index begins again, after its fence was waited for.
+class FrameDescriptorAllocator
+{
+	public:
+
+										FrameDescriptorAllocator();
+		void							initialize(VkDevice device, uint32_t framesNumber, const std::vector<DescriptorPoolRatio>& ratios);
+		void							destroy();
+		void							beginFrame(uint32_t frameIndex);
+		DescriptorAllocator&			current();
+
+		uint64_t						getAllocationsNumber() const;
+		uint32_t						getPoolsNumber() const;
+
+	private:
+
+		std::vector<std::unique_ptr<DescriptorAllocator>> allocators;
+		uint32_t						currentIndex;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include"stdafx.hpp"
+#include"DeviceSelection.hpp"
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Score weights. Any discrete GPU beats any integrated one, memory counts in 256 MiB steps.
+const uint64_t DEVICE_SCORE_DISCRETE				= 100000;
+const uint64_t DEVICE_SCORE_INTEGRATED				= 10000;
+const uint64_t DEVICE_SCORE_VIRTUAL					= 1000;
+const uint64_t DEVICE_SCORE_CPU						= 100;
+const VkDeviceSize DEVICE_SCORE_MEMORY_STEP			= 256ULL * 1024 * 1024;
+const uint64_t DEVICE_SCORE_DEDICATED_QUEUE			= 50;
+const uint64_t DEVICE_SCORE_FEATURE					= 25;
+
+//static function
+uint64_t DeviceSelection::scorePhysicalDevice(const PhysicalDeviceCapabilities& capabilities)
+{
+	uint64_t score = 0;
+
+	switch(capabilities.properties.deviceType)
+	{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			score += DEVICE_SCORE_DISCRETE;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			score += DEVICE_SCORE_INTEGRATED;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			score += DEVICE_SCORE_VIRTUAL;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:
+			score += DEVICE_SCORE_CPU;
+			break;
+		default:
+			break;
+	}
+
+	// Capped so huge shared heap of integrated GPU can not outweigh device type
+	score += std::min<uint64_t>(capabilities.deviceLocalMemory / DEVICE_SCORE_MEMORY_STEP, DEVICE_SCORE_INTEGRATED - 1);
+
+	if(capabilities.dedicatedTransferQueue)
+	{
+		score += DEVICE_SCORE_DEDICATED_QUEUE;
+	}
+	if(capabilities.dedicatedComputeQueue)
+	{
+		score += DEVICE_SCORE_DEDICATED_QUEUE;
+	}
+	if(capabilities.descriptorIndexing)
+	{
+		score += DEVICE_SCORE_FEATURE;
+	}
+	if(capabilities.timelineSemaphore)
+	{
+		score += DEVICE_SCORE_FEATURE;
+	}
+
+	return score;
+}
+
+//static function
+bool DeviceSelection::matchesPreferredDevice(const PhysicalDeviceCapabilities& capabilities, const std::string& preferredDevice)
+{
+	std::string preferred;
+	std::string preferredHex;
+	for(char character: preferredDevice)
+	{
+		char lower = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+		preferred.push_back(lower);
+		if(lower != '-')
+		{
+			preferredHex.push_back(lower);
+		}
+	}
+
+	if(preferredHex == formatUUID(capabilities.deviceUUID))
+	{
+		return true;
+	}
+
+	std::string name = capabilities.properties.deviceName;
+	std::transform(name.begin(), name.end(), name.begin(), [](char character) { return static_cast<char>(std::tolower(static_cast<unsigned char>(character))); });
+	return !preferred.empty() && name.find(preferred) != std::string::npos;
+}
+
+//static function
+const char* DeviceSelection::getVendorName(uint32_t vendorID)
+{
+	switch(vendorID)
+	{
+		case VENDOR_ID_AMD:
+			return "AMD";
+		case VENDOR_ID_NVIDIA:
+			return "NVIDIA";
+		case VENDOR_ID_INTEL:
+			return "INTEL";
+		default:
+			return "Other vendor";
+	}
+}
+
+//static function
+const char* DeviceSelection::getDeviceTypeName(VkPhysicalDeviceType deviceType)
+{
+	switch(deviceType)
+	{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			return "discrete";
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			return "integrated";
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			return "virtual";
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:
+			return "cpu";
+		default:
+			return "other";
+	}
+}
+
+//static function
+std::string DeviceSelection::formatUUID(const uint8_t* uuid)
+{
+	const char* digits = "0123456789abcdef";
+	std::string text;
+	for(uint32_t i=0; i<VK_UUID_SIZE; i++)
+	{
+		text.push_back(digits[uuid[i] >> 4]);
+		text.push_back(digits[uuid[i] & 0xF]);
+	}
+	return text;
+}
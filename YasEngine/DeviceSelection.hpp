@@ -0,0 +1,42 @@
+#ifndef DEVICESELECTION_HPP
+#define DEVICESELECTION_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+const uint32_t VENDOR_ID_AMD						= 0x1002;
+const uint32_t VENDOR_ID_NVIDIA						= 0x10DE;
+const uint32_t VENDOR_ID_INTEL						= 0x8086;
+
+// What device selection knows about one physical device. Filled from Vulkan queries,
+// or by hand so scoring can be checked without a device.
+struct PhysicalDeviceCapabilities
+{
+	VkPhysicalDeviceProperties		properties;
+	uint8_t							deviceUUID[VK_UUID_SIZE];
+	// Largest heap with VK_MEMORY_HEAP_DEVICE_LOCAL_BIT
+	VkDeviceSize					deviceLocalMemory;
+	// Transfer family without graphics and compute, compute family without graphics
+	bool							dedicatedTransferQueue;
+	bool							dedicatedComputeQueue;
+	bool							descriptorIndexing;
+	bool							timelineSemaphore;
+	// VK_EXT_memory_budget reports how much of heaps process may use while other applications use them too
+	bool							memoryBudget;
+};
+
+// Pure functions of capabilities. They use only Vulkan types, not Vulkan calls, so they link without Vulkan loader.
+class DeviceSelection
+{
+	public:
+
+		// Device type dominates, then memory, queues and features break ties
+		static uint64_t					scorePhysicalDevice(const PhysicalDeviceCapabilities& capabilities);
+		// Case insensitive, UUID is 32 hex digits with optional dashes
+		static bool						matchesPreferredDevice(const PhysicalDeviceCapabilities& capabilities, const std::string& preferredDevice);
+		static const char*				getVendorName(uint32_t vendorID);
+		static const char*				getDeviceTypeName(VkPhysicalDeviceType deviceType);
+		static std::string				formatUUID(const uint8_t* uuid);
+};
+
+#endif
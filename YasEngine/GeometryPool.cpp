@@ -0,0 +1,376 @@
+#include"stdafx.hpp"
+#include"GeometryPool.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+RangeAllocator::RangeAllocator()
+{
+	capacity = 0;
+	freeSize = 0;
+}
+
+void RangeAllocator::initialize(uint32_t capacity)
+{
+	this->capacity = capacity;
+	reset(0);
+}
+
+bool RangeAllocator::allocate(uint32_t size, uint32_t& offset)
+{
+	if(size == 0)
+	{
+		offset = 0;
+		return true;
+	}
+
+	// Smallest range which fits leaves large ranges for large meshes
+	size_t best = freeRanges.size();
+	for(size_t i=0; i<freeRanges.size(); i++)
+	{
+		if(freeRanges[i].size >= size && (best == freeRanges.size() || freeRanges[i].size < freeRanges[best].size))
+		{
+			best = i;
+			if(freeRanges[i].size == size)
+			{
+				break;
+			}
+		}
+	}
+
+	if(best == freeRanges.size())
+	{
+		return false;
+	}
+
+	offset = freeRanges[best].offset;
+	if(freeRanges[best].size == size)
+	{
+		freeRanges.erase(freeRanges.begin() + best);
+	}
+	else
+	{
+		freeRanges[best].offset += size;
+		freeRanges[best].size -= size;
+	}
+	freeSize -= size;
+	return true;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t size)
+{
+	if(size == 0)
+	{
+		return;
+	}
+
+	std::vector<GeometryRange>::iterator next = std::lower_bound(freeRanges.begin(), freeRanges.end(), offset, [](const GeometryRange& range, uint32_t offset)
+	{
+		return range.offset < offset;
+	});
+	freeSize += size;
+
+	bool mergesPrevious = next != freeRanges.begin() && (next - 1)->offset + (next - 1)->size == offset;
+	bool mergesNext = next != freeRanges.end() && offset + size == next->offset;
+
+	if(mergesPrevious && mergesNext)
+	{
+		(next - 1)->size += size + next->size;
+		freeRanges.erase(next);
+	}
+	else if(mergesPrevious)
+	{
+		(next - 1)->size += size;
+	}
+	else if(mergesNext)
+	{
+		next->offset = offset;
+		next->size += size;
+	}
+	else
+	{
+		freeRanges.insert(next, {offset, size});
+	}
+}
+
+void RangeAllocator::reset(uint32_t usedSize)
+{
+	freeRanges.clear();
+	freeSize = capacity - usedSize;
+
+	if(freeSize > 0)
+	{
+		freeRanges.push_back({usedSize, freeSize});
+	}
+}
+
+uint32_t RangeAllocator::getCapacity() const
+{
+	return capacity;
+}
+
+uint32_t RangeAllocator::getFreeSize() const
+{
+	return freeSize;
+}
+
+uint32_t RangeAllocator::getLargestFreeRange() const
+{
+	uint32_t largest = 0;
+	for(const GeometryRange& range: freeRanges)
+	{
+		largest = std::max(largest, range.size);
+	}
+	return largest;
+}
+
+uint32_t RangeAllocator::getFreeRangesNumber() const
+{
+	return static_cast<uint32_t>(freeRanges.size());
+}
+
+float RangeAllocator::getFragmentation() const
+{
+	if(freeSize == 0)
+	{
+		return 0.0F;
+	}
+	return 1.0F - static_cast<float>(getLargestFreeRange()) / freeSize;
+}
+
+GeometryPool::GeometryPool()
+{
+	frame = 0;
+	freeDelayFrames = 0;
+	statistics = {};
+}
+
+void GeometryPool::initialize(uint32_t verticesCapacity, uint32_t indicesCapacity, uint32_t freeDelayFrames)
+{
+	vertexAllocator.initialize(verticesCapacity);
+	indexAllocator.initialize(indicesCapacity);
+	meshes.clear();
+	freeMeshIds.clear();
+	pendingFrees.clear();
+	vertices.clear();
+	indices.clear();
+	frame = 0;
+	this->freeDelayFrames = freeDelayFrames;
+	statistics = {};
+}
+
+uint32_t GeometryPool::addMesh(const Vertex* vertices, uint32_t verticesNumber, const uint32_t* indices, uint32_t indicesNumber)
+{
+	uint32_t mesh = allocateMesh(verticesNumber, indicesNumber);
+
+	if(mesh != NO_GEOMETRY_MESH)
+	{
+		std::copy(vertices, vertices + verticesNumber, getMeshVertices(mesh));
+		std::copy(indices, indices + indicesNumber, getMeshIndices(mesh));
+	}
+	return mesh;
+}
+
+uint32_t GeometryPool::allocateMesh(uint32_t verticesNumber, uint32_t indicesNumber)
+{
+	GeometryMesh mesh = {};
+	mesh.verticesNumber = verticesNumber;
+	mesh.indicesNumber = indicesNumber;
+
+	if(!vertexAllocator.allocate(verticesNumber, mesh.firstVertex))
+	{
+		return NO_GEOMETRY_MESH;
+	}
+
+	if(!indexAllocator.allocate(indicesNumber, mesh.firstIndex))
+	{
+		vertexAllocator.free(mesh.firstVertex, verticesNumber);
+		return NO_GEOMETRY_MESH;
+	}
+
+	if(mesh.firstVertex + verticesNumber > vertices.size())
+	{
+		vertices.resize(mesh.firstVertex + verticesNumber);
+	}
+	if(mesh.firstIndex + indicesNumber > indices.size())
+	{
+		indices.resize(mesh.firstIndex + indicesNumber);
+	}
+
+	uint32_t id;
+	if(freeMeshIds.empty())
+	{
+		id = static_cast<uint32_t>(meshes.size());
+		meshes.push_back({});
+	}
+	else
+	{
+		id = freeMeshIds.back();
+		freeMeshIds.pop_back();
+	}
+
+	meshes[id].mesh = mesh;
+	meshes[id].isLive = true;
+	++statistics.meshesAdded;
+	return id;
+}
+
+void GeometryPool::removeMesh(uint32_t mesh)
+{
+	if(mesh >= meshes.size() || !meshes[mesh].isLive)
+	{
+		throw std::runtime_error("Geometry pool does not contain removed mesh");
+	}
+
+	// Id can be reused at once, ranges only when frames which drew from them are done
+	pendingFrees.push_back({meshes[mesh].mesh, frame});
+	meshes[mesh].isLive = false;
+	freeMeshIds.push_back(mesh);
+	++statistics.meshesRemoved;
+}
+
+void GeometryPool::advanceFrame()
+{
+	++frame;
+
+	while(!pendingFrees.empty() && pendingFrees.front().frame + freeDelayFrames <= frame)
+	{
+		const GeometryMesh& mesh = pendingFrees.front().mesh;
+		vertexAllocator.free(mesh.firstVertex, mesh.verticesNumber);
+		indexAllocator.free(mesh.firstIndex, mesh.indicesNumber);
+		pendingFrees.pop_front();
+	}
+}
+
+const GeometryMesh& GeometryPool::getMesh(uint32_t mesh) const
+{
+	return meshes[mesh].mesh;
+}
+
+Vertex* GeometryPool::getMeshVertices(uint32_t mesh)
+{
+	return vertices.data() + meshes[mesh].mesh.firstVertex;
+}
+
+uint32_t* GeometryPool::getMeshIndices(uint32_t mesh)
+{
+	return indices.data() + meshes[mesh].mesh.firstIndex;
+}
+
+bool GeometryPool::needsCompaction() const
+{
+	return (vertexAllocator.getFreeRangesNumber() > 1 && vertexAllocator.getFragmentation() > GEOMETRY_COMPACTION_FRAGMENTATION) ||
+		(indexAllocator.getFreeRangesNumber() > 1 && indexAllocator.getFragmentation() > GEOMETRY_COMPACTION_FRAGMENTATION);
+}
+
+void GeometryPool::compact(std::vector<VkBufferCopy>& vertexCopies, std::vector<VkBufferCopy>& indexCopies)
+{
+	vertexCopies.clear();
+	indexCopies.clear();
+	pendingFrees.clear();
+
+	std::vector<MeshSlot*> liveMeshes;
+	for(MeshSlot& slot: meshes)
+	{
+		if(slot.isLive)
+		{
+			liveMeshes.push_back(&slot);
+		}
+	}
+
+	// Meshes only move towards beginning, so CPU copy is moved in place when they are processed in order of offsets.
+	// Neighbours in old buffer stay neighbours, their copies are merged into one region.
+	std::sort(liveMeshes.begin(), liveMeshes.end(), [](const MeshSlot* a, const MeshSlot* b) { return a->mesh.firstVertex < b->mesh.firstVertex; });
+	uint32_t verticesUsed = 0;
+
+	for(MeshSlot* slot: liveMeshes)
+	{
+		GeometryMesh& mesh = slot->mesh;
+		if(mesh.verticesNumber == 0)
+		{
+			continue;
+		}
+
+		// Source and destination overlap when mesh moves by less than its size. Mesh already in place is not moved on CPU,
+		// its GPU region is still needed because new buffer starts empty.
+		if(mesh.firstVertex != verticesUsed)
+		{
+			std::memmove(&vertices[verticesUsed], &vertices[mesh.firstVertex], sizeof(Vertex) * mesh.verticesNumber);
+		}
+
+		VkDeviceSize sourceOffset = sizeof(Vertex) * mesh.firstVertex;
+		if(!vertexCopies.empty() && vertexCopies.back().srcOffset + vertexCopies.back().size == sourceOffset)
+		{
+			vertexCopies.back().size += sizeof(Vertex) * mesh.verticesNumber;
+		}
+		else
+		{
+			vertexCopies.push_back({sourceOffset, sizeof(Vertex) * verticesUsed, sizeof(Vertex) * mesh.verticesNumber});
+		}
+
+		mesh.firstVertex = verticesUsed;
+		verticesUsed += mesh.verticesNumber;
+	}
+
+	std::sort(liveMeshes.begin(), liveMeshes.end(), [](const MeshSlot* a, const MeshSlot* b) { return a->mesh.firstIndex < b->mesh.firstIndex; });
+	uint32_t indicesUsed = 0;
+
+	for(MeshSlot* slot: liveMeshes)
+	{
+		GeometryMesh& mesh = slot->mesh;
+		if(mesh.indicesNumber == 0)
+		{
+			continue;
+		}
+
+		if(mesh.firstIndex != indicesUsed)
+		{
+			std::memmove(&indices[indicesUsed], &indices[mesh.firstIndex], sizeof(uint32_t) * mesh.indicesNumber);
+		}
+
+		VkDeviceSize sourceOffset = sizeof(uint32_t) * mesh.firstIndex;
+		if(!indexCopies.empty() && indexCopies.back().srcOffset + indexCopies.back().size == sourceOffset)
+		{
+			indexCopies.back().size += sizeof(uint32_t) * mesh.indicesNumber;
+		}
+		else
+		{
+			indexCopies.push_back({sourceOffset, sizeof(uint32_t) * indicesUsed, sizeof(uint32_t) * mesh.indicesNumber});
+		}
+
+		mesh.firstIndex = indicesUsed;
+		indicesUsed += mesh.indicesNumber;
+	}
+
+	vertices.resize(verticesUsed);
+	indices.resize(indicesUsed);
+	vertexAllocator.reset(verticesUsed);
+	indexAllocator.reset(indicesUsed);
+	++statistics.compactions;
+}
+
+const std::vector<Vertex>& GeometryPool::getVertices() const
+{
+	return vertices;
+}
+
+const std::vector<uint32_t>& GeometryPool::getIndices() const
+{
+	return indices;
+}
+
+GeometryPoolStatistics GeometryPool::getStatistics() const
+{
+	GeometryPoolStatistics result = statistics;
+	result.meshesNumber = static_cast<uint32_t>(meshes.size() - freeMeshIds.size());
+	result.verticesCapacity = vertexAllocator.getCapacity();
+	result.verticesUsed = vertexAllocator.getCapacity() - vertexAllocator.getFreeSize();
+	result.vertexFreeRanges = vertexAllocator.getFreeRangesNumber();
+	result.largestVertexFreeRange = vertexAllocator.getLargestFreeRange();
+	result.vertexFragmentation = vertexAllocator.getFragmentation();
+	result.indicesCapacity = indexAllocator.getCapacity();
+	result.indicesUsed = indexAllocator.getCapacity() - indexAllocator.getFreeSize();
+	result.indexFreeRanges = indexAllocator.getFreeRangesNumber();
+	result.largestIndexFreeRange = indexAllocator.getLargestFreeRange();
+	result.indexFragmentation = indexAllocator.getFragmentation();
+	return result;
+}
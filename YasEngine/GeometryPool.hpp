@@ -0,0 +1,134 @@
+#ifndef GEOMETRYPOOL_HPP
+#define GEOMETRYPOOL_HPP
+#include"stdafx.hpp"
+#include"VariousTools.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+const uint32_t NO_GEOMETRY_MESH				= 0xFFFFFFFF;
+// Room left in pool buffers for meshes loaded after startup
+const uint32_t GEOMETRY_POOL_SPARE_VERTICES	= 1 << 20;
+const uint32_t GEOMETRY_POOL_SPARE_INDICES	= 1 << 22;
+// Compaction is worth copying live meshes only when free space is split this much
+const float GEOMETRY_COMPACTION_FRAGMENTATION	= 0.5F;
+
+// Elements, not bytes
+struct GeometryRange
+{
+	uint32_t						offset;
+	uint32_t						size;
+};
+
+// Best fit allocator of ranges in buffer of fixed capacity.
+// Free ranges are kept sorted by offset so freed range is merged with its neighbours.
+class RangeAllocator
+{
+	public:
+
+										RangeAllocator();
+		void							initialize(uint32_t capacity);
+		// Returns false when no free range is large enough. Empty range is always allocated at offset 0.
+		bool							allocate(uint32_t size, uint32_t& offset);
+		void							free(uint32_t offset, uint32_t size);
+		// Everything below usedSize becomes allocated and the rest one free range
+		void							reset(uint32_t usedSize);
+
+		uint32_t						getCapacity() const;
+		uint32_t						getFreeSize() const;
+		uint32_t						getLargestFreeRange() const;
+		uint32_t						getFreeRangesNumber() const;
+		// 0 when all free space is one range, approaches 1 as it splits into many small ranges
+		float							getFragmentation() const;
+
+	private:
+
+		std::vector<GeometryRange>		freeRanges;
+		uint32_t						capacity;
+		uint32_t						freeSize;
+};
+
+// Ranges of one mesh in pool buffers. Indices are relative to firstVertex, draws pass it as vertexOffset.
+struct GeometryMesh
+{
+	uint32_t						firstVertex;
+	uint32_t						verticesNumber;
+	uint32_t						firstIndex;
+	uint32_t						indicesNumber;
+};
+
+struct GeometryPoolStatistics
+{
+	uint32_t						meshesNumber;
+	uint32_t						verticesCapacity;
+	uint32_t						verticesUsed;
+	uint32_t						vertexFreeRanges;
+	uint32_t						largestVertexFreeRange;
+	float							vertexFragmentation;
+	uint32_t						indicesCapacity;
+	uint32_t						indicesUsed;
+	uint32_t						indexFreeRanges;
+	uint32_t						largestIndexFreeRange;
+	float							indexFragmentation;
+	// Counters since initialize
+	uint32_t						meshesAdded;
+	uint32_t						meshesRemoved;
+	uint32_t						compactions;
+};
+
+// Sub-allocates meshes from one vertex and one index buffer, so every mesh is drawn without binding its own buffers.
+// Pool keeps CPU copy of both buffers laid out the same way, owner of GPU buffers uploads ranges of added meshes from it.
+class GeometryPool
+{
+	public:
+
+										GeometryPool();
+		// Freed ranges are reused only after freeDelayFrames calls of advanceFrame, when no frame in flight reads them anymore
+		void							initialize(uint32_t verticesCapacity, uint32_t indicesCapacity, uint32_t freeDelayFrames);
+
+		// Returns id of mesh, which stays the same until it is removed, or NO_GEOMETRY_MESH when pool has no free range large enough
+		uint32_t						addMesh(const Vertex* vertices, uint32_t verticesNumber, const uint32_t* indices, uint32_t indicesNumber);
+		// The same as addMesh, but caller writes mesh into CPU copy itself before it is uploaded
+		uint32_t						allocateMesh(uint32_t verticesNumber, uint32_t indicesNumber);
+		Vertex*							getMeshVertices(uint32_t mesh);
+		uint32_t*						getMeshIndices(uint32_t mesh);
+		void							removeMesh(uint32_t mesh);
+		void							advanceFrame();
+		const GeometryMesh&				getMesh(uint32_t mesh) const;
+
+		bool							needsCompaction() const;
+		// Moves live meshes to beginning of pool keeping their order. Regions copy them from old GPU buffers into new ones, in bytes.
+		// Ranges waiting for frames in flight are dropped, frames in flight read old buffers.
+		void							compact(std::vector<VkBufferCopy>& vertexCopies, std::vector<VkBufferCopy>& indexCopies);
+
+		// CPU copies end with last allocated element
+		const std::vector<Vertex>&		getVertices() const;
+		const std::vector<uint32_t>&	getIndices() const;
+		GeometryPoolStatistics			getStatistics() const;
+
+	private:
+
+		struct MeshSlot
+		{
+			GeometryMesh				mesh;
+			bool						isLive;
+		};
+
+		struct PendingFree
+		{
+			GeometryMesh				mesh;
+			uint64_t					frame;
+		};
+
+		RangeAllocator					vertexAllocator;
+		RangeAllocator					indexAllocator;
+		std::vector<MeshSlot>			meshes;
+		std::vector<uint32_t>			freeMeshIds;
+		std::deque<PendingFree>			pendingFrees;
+		uint64_t						frame;
+		uint32_t						freeDelayFrames;
+		std::vector<Vertex>				vertices;
+		std::vector<uint32_t>			indices;
+		GeometryPoolStatistics			statistics;
+};
+
+#endif
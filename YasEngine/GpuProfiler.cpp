@@ -0,0 +1,254 @@
+#include"stdafx.hpp"
+#include"GpuProfiler.hpp"
+#include"YasLog.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+GpuProfiler::GpuProfiler()
+{
+	device = VK_NULL_HANDLE;
+	supported = false;
+	timestampPeriod = 1.0;
+	timestampMask = 0;
+	currentSlot = 0;
+	immediateRegion = GPU_PROFILER_NO_REGION;
+}
+
+void GpuProfiler::initialize(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex, uint32_t framesNumber)
+{
+	this->device = device;
+
+	VkPhysicalDeviceProperties physicalDeviceProperties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+	// Zero valid bits means queue can not write timestamps at all. Software drivers like lavapipe report 64.
+	uint32_t validBits = queueFamilyIndex < queueFamilyCount ? queueFamilies[queueFamilyIndex].timestampValidBits : 0;
+	supported = validBits > 0 && physicalDeviceProperties.limits.timestampPeriod > 0.0F;
+	timestampPeriod = physicalDeviceProperties.limits.timestampPeriod;
+	timestampMask = validBits >= 64 ? ~0ULL : ((1ULL << validBits) - 1);
+
+	if(!supported)
+	{
+		YAS_LOG_WARNING("GPU profiler disabled: queue does not support timestamps");
+		return;
+	}
+
+	createSlots(framesNumber);
+}
+
+void GpuProfiler::destroy()
+{
+	destroySlots();
+	histories.clear();
+}
+
+void GpuProfiler::setFramesNumber(uint32_t framesNumber)
+{
+	if(!supported)
+	{
+		return;
+	}
+	destroySlots();
+	createSlots(framesNumber);
+}
+
+bool GpuProfiler::isSupported() const
+{
+	return supported;
+}
+
+void GpuProfiler::createSlots(uint32_t framesNumber)
+{
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = GPU_PROFILER_MAX_REGIONS * 2;
+
+	slots.resize(framesNumber + 1);
+
+	for(FrameSlot& slot: slots)
+	{
+		if(vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &slot.queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create timestamp query pool");
+		}
+		slot.regionNames.clear();
+	}
+
+	currentSlot = 0;
+	queryResults.resize(GPU_PROFILER_MAX_REGIONS * 2);
+}
+
+void GpuProfiler::destroySlots()
+{
+	for(FrameSlot& slot: slots)
+	{
+		vkDestroyQueryPool(device, slot.queryPool, nullptr);
+	}
+	slots.clear();
+}
+
+void GpuProfiler::resetSlot(VkCommandBuffer commandBuffer, uint32_t slotIndex)
+{
+	FrameSlot& slot = slots[slotIndex];
+	vkCmdResetQueryPool(commandBuffer, slot.queryPool, 0, GPU_PROFILER_MAX_REGIONS * 2);
+	slot.regionNames.clear();
+	currentSlot = slotIndex;
+}
+
+void GpuProfiler::collectSlot(uint32_t slotIndex)
+{
+	FrameSlot& slot = slots[slotIndex];
+	uint32_t queriesNumber = static_cast<uint32_t>(slot.regionNames.size()) * 2;
+
+	if(queriesNumber == 0)
+	{
+		return;
+	}
+
+	// No WAIT flag. Fence of this slot was waited for already so results are normally available,
+	// if driver is not done yet this sample is dropped instead of blocking frame.
+	VkResult result = vkGetQueryPoolResults(device, slot.queryPool, 0, queriesNumber, queriesNumber * sizeof(uint64_t), queryResults.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if(result == VK_SUCCESS)
+	{
+		for(size_t i=0; i<slot.regionNames.size(); i++)
+		{
+			uint64_t ticks = (queryResults[2 * i + 1] - queryResults[2 * i]) & timestampMask;
+			RegionHistory& history = histories[slot.regionNames[i]];
+			history.samples[history.nextSample] = ticks * timestampPeriod / 1000000.0;
+			history.nextSample = (history.nextSample + 1) % GPU_PROFILER_HISTORY_SIZE;
+			history.samplesNumber = std::min(history.samplesNumber + 1, GPU_PROFILER_HISTORY_SIZE);
+		}
+	}
+
+	slot.regionNames.clear();
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if(!supported)
+	{
+		return;
+	}
+	collectSlot(frameIndex);
+	resetSlot(commandBuffer, frameIndex);
+}
+
+uint32_t GpuProfiler::beginRegion(VkCommandBuffer commandBuffer, const char* name)
+{
+	if(!supported)
+	{
+		return GPU_PROFILER_NO_REGION;
+	}
+
+	FrameSlot& slot = slots[currentSlot];
+
+	if(slot.regionNames.size() >= GPU_PROFILER_MAX_REGIONS)
+	{
+		return GPU_PROFILER_NO_REGION;
+	}
+
+	uint32_t region = static_cast<uint32_t>(slot.regionNames.size());
+	slot.regionNames.push_back(name);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.queryPool, region * 2);
+	return region;
+}
+
+void GpuProfiler::endRegion(VkCommandBuffer commandBuffer, uint32_t region)
+{
+	if(region == GPU_PROFILER_NO_REGION)
+	{
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slots[currentSlot].queryPool, region * 2 + 1);
+}
+
+void GpuProfiler::beginImmediate(VkCommandBuffer commandBuffer, const char* name)
+{
+	if(!supported)
+	{
+		return;
+	}
+	resetSlot(commandBuffer, static_cast<uint32_t>(slots.size()) - 1);
+	immediateRegion = beginRegion(commandBuffer, name);
+}
+
+void GpuProfiler::endImmediate(VkCommandBuffer commandBuffer)
+{
+	endRegion(commandBuffer, immediateRegion);
+	immediateRegion = GPU_PROFILER_NO_REGION;
+}
+
+void GpuProfiler::collectImmediate()
+{
+	if(!supported)
+	{
+		return;
+	}
+	collectSlot(static_cast<uint32_t>(slots.size()) - 1);
+}
+
+GpuRegionStatistics GpuProfiler::computeStatistics(const std::string& name, const RegionHistory& history)
+{
+	GpuRegionStatistics statistics = {};
+	statistics.name = name;
+	statistics.samples = history.samplesNumber;
+
+	if(history.samplesNumber == 0)
+	{
+		return statistics;
+	}
+
+	std::vector<double> sorted(history.samples.begin(), history.samples.begin() + history.samplesNumber);
+	std::sort(sorted.begin(), sorted.end());
+
+	double sum = 0.0;
+	for(double sample: sorted)
+	{
+		sum += sample;
+	}
+
+	// Nearest rank percentiles
+	const size_t last = sorted.size() - 1;
+	statistics.averageMilliseconds = sum / sorted.size();
+	statistics.medianMilliseconds = sorted[last / 2];
+	statistics.percentile95Milliseconds = sorted[(last * 95 + 50) / 100];
+	statistics.percentile99Milliseconds = sorted[(last * 99 + 50) / 100];
+	statistics.maxMilliseconds = sorted[last];
+	return statistics;
+}
+
+GpuRegionStatistics GpuProfiler::getStatistics(const std::string& name) const
+{
+	std::unordered_map<std::string, RegionHistory>::const_iterator history = histories.find(name);
+
+	if(history == histories.end())
+	{
+		GpuRegionStatistics statistics = {};
+		statistics.name = name;
+		return statistics;
+	}
+	return computeStatistics(name, history->second);
+}
+
+std::vector<GpuRegionStatistics> GpuProfiler::getAllStatistics() const
+{
+	std::vector<GpuRegionStatistics> allStatistics;
+
+	for(const std::pair<const std::string, RegionHistory>& history: histories)
+	{
+		allStatistics.push_back(computeStatistics(history.first, history.second));
+	}
+
+	std::sort(allStatistics.begin(), allStatistics.end(), [](const GpuRegionStatistics& a, const GpuRegionStatistics& b)
+	{
+		return a.name < b.name;
+	});
+	return allStatistics;
+}
@@ -0,0 +1,87 @@
+#ifndef GPUPROFILER_HPP
+#define GPUPROFILER_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Each region uses two timestamp queries
+const uint32_t GPU_PROFILER_MAX_REGIONS		= 32;
+const uint32_t GPU_PROFILER_HISTORY_SIZE	= 256;
+const uint32_t GPU_PROFILER_NO_REGION		= 0xFFFFFFFF;
+
+struct GpuRegionStatistics
+{
+	std::string						name;
+	// Number of samples in rolling window
+	uint32_t						samples;
+	double							averageMilliseconds;
+	double							medianMilliseconds;
+	double							percentile95Milliseconds;
+	double							percentile99Milliseconds;
+	double							maxMilliseconds;
+};
+
+// Measures GPU time of named regions with timestamp queries. Every frame in flight has own query pool so results
+// are read when fence of that frame was already waited for and reading never stalls.
+// When queue does not support timestamps all calls do nothing.
+class GpuProfiler
+{
+	public:
+
+										GpuProfiler();
+		void							initialize(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex, uint32_t framesNumber);
+		void							destroy();
+		// Number of swapchain images can change with swapchain. Device must be idle, unread results are dropped.
+		void							setFramesNumber(uint32_t framesNumber);
+		bool							isSupported() const;
+
+		// Collects results written when frame slot was used last time and resets its queries
+		void							beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		// Region name must stay valid until results are collected, string literals are expected
+		uint32_t						beginRegion(VkCommandBuffer commandBuffer, const char* name);
+		void							endRegion(VkCommandBuffer commandBuffer, uint32_t region);
+
+		// Single time commands have own slot. It is collected right after queue waited idle.
+		void							beginImmediate(VkCommandBuffer commandBuffer, const char* name);
+		void							endImmediate(VkCommandBuffer commandBuffer);
+		void							collectImmediate();
+
+		GpuRegionStatistics				getStatistics(const std::string& name) const;
+		std::vector<GpuRegionStatistics> getAllStatistics() const;
+
+	private:
+
+		struct FrameSlot
+		{
+			VkQueryPool					queryPool;
+			// Region i uses queries 2*i and 2*i+1
+			std::vector<const char*>	regionNames;
+		};
+
+		struct RegionHistory
+		{
+			std::array<double, GPU_PROFILER_HISTORY_SIZE> samples;
+			uint32_t					nextSample;
+			uint32_t					samplesNumber;
+		};
+
+		void							createSlots(uint32_t framesNumber);
+		void							destroySlots();
+		void							resetSlot(VkCommandBuffer commandBuffer, uint32_t slotIndex);
+		void							collectSlot(uint32_t slotIndex);
+		static GpuRegionStatistics		computeStatistics(const std::string& name, const RegionHistory& history);
+
+		VkDevice						device;
+		bool							supported;
+		// Nanoseconds per timestamp tick
+		double							timestampPeriod;
+		uint64_t						timestampMask;
+		// Last slot is used by single time commands
+		std::vector<FrameSlot>			slots;
+		uint32_t						currentSlot;
+		uint32_t						immediateRegion;
+		std::unordered_map<std::string, RegionHistory> histories;
+		std::vector<uint64_t>			queryResults;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include"stdafx.hpp"
+#include"InitGraph.hpp"
+#include"Clock.hpp"
+#include"CpuProfiler.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+InitGraph::InitGraph()
+{
+	jobSystem = nullptr;
+	beginNanoseconds = 0;
+	endNanoseconds = 0;
+}
+
+uint32_t InitGraph::addStep(const char* name, std::function<void()> function, std::initializer_list<uint32_t> dependencies)
+{
+	const uint32_t index = static_cast<uint32_t>(steps.size());
+	std::unique_ptr<Step> step(new Step());
+	step->function = std::move(function);
+	step->dependenciesNumber = static_cast<uint32_t>(dependencies.size());
+	step->skipped.store(false);
+
+	for(uint32_t dependency: dependencies)
+	{
+		if(dependency >= index)
+		{
+			throw std::runtime_error("Init step can only depend on steps added before it");
+		}
+		steps[dependency]->dependents.push_back(index);
+	}
+
+	steps.push_back(std::move(step));
+
+	InitStepTiming timing = {};
+	timing.name = name;
+	timing.worker = NO_WORKER;
+	timeline.push_back(timing);
+	return index;
+}
+
+void InitGraph::run(JobSystem& jobSystem)
+{
+	this->jobSystem = &jobSystem;
+	exception = nullptr;
+	beginNanoseconds = Clock::nanoseconds();
+
+	for(std::unique_ptr<Step>& step: steps)
+	{
+		step->pendingDependencies.store(step->dependenciesNumber, std::memory_order_relaxed);
+		step->skipped.store(false, std::memory_order_relaxed);
+	}
+
+	// Roots are collected first, steps started below could otherwise already release dependents while loop still reads counts
+	std::vector<uint32_t> roots;
+	for(uint32_t i=0; i<steps.size(); i++)
+	{
+		if(steps[i]->dependenciesNumber == 0)
+		{
+			roots.push_back(i);
+		}
+	}
+
+	for(uint32_t root: roots)
+	{
+		jobSystem.run([this, root]
+		{
+			executeStep(root);
+		}, &counter);
+	}
+
+	jobSystem.wait(counter);
+	endNanoseconds = Clock::nanoseconds();
+
+	if(exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
+void InitGraph::executeStep(uint32_t index)
+{
+	Step& step = *steps[index];
+	InitStepTiming& timing = timeline[index];
+	timing.worker = jobSystem->getCurrentWorkerIndex();
+	timing.beginNanoseconds = Clock::nanoseconds();
+
+	if(!step.skipped.load(std::memory_order_acquire))
+	{
+		try
+		{
+			YAS_PROFILE_SCOPE(timing.name);
+			step.function();
+		}
+		catch(...)
+		{
+			step.skipped.store(true, std::memory_order_release);
+			std::lock_guard<std::mutex> lock(exceptionMutex);
+			if(!exception)
+			{
+				exception = std::current_exception();
+			}
+		}
+	}
+
+	timing.endNanoseconds = Clock::nanoseconds();
+
+	// Dependents are released even after failure so counter reaches zero, they only inherit skip
+	for(uint32_t dependent: step.dependents)
+	{
+		Step& dependentStep = *steps[dependent];
+
+		if(step.skipped.load(std::memory_order_acquire))
+		{
+			dependentStep.skipped.store(true, std::memory_order_release);
+		}
+
+		if(dependentStep.pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			jobSystem->run([this, dependent]
+			{
+				executeStep(dependent);
+			}, &counter);
+		}
+	}
+}
+
+const std::vector<InitStepTiming>& InitGraph::getTimeline() const
+{
+	return timeline;
+}
+
+int64_t InitGraph::getDurationNanoseconds() const
+{
+	return endNanoseconds - beginNanoseconds;
+}
+
+void InitGraph::writeTimeline(const std::string& fileName) const
+{
+	std::ofstream file(fileName, std::ios::trunc);
+
+	if(!file.is_open())
+	{
+		throw std::runtime_error("Failed to create startup timeline file");
+	}
+
+	file << "{\"traceEvents\":[";
+	bool first = true;
+
+	for(const InitStepTiming& timing: timeline)
+	{
+		// Microseconds from start of graph, the unit of trace format
+		double timestamp = (timing.beginNanoseconds - beginNanoseconds) / 1000.0;
+		double duration = (timing.endNanoseconds - timing.beginNanoseconds) / 1000.0;
+
+		file << (first ? "\n" : ",\n");
+		file << "{\"name\":\"" << timing.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << timing.worker << ",\"ts\":" << timestamp << ",\"dur\":" << duration << "}";
+		first = false;
+	}
+
+	file << "\n]}\n";
+}
@@ -0,0 +1,59 @@
+#ifndef INITGRAPH_HPP
+#define INITGRAPH_HPP
+#include"stdafx.hpp"
+#include"JobSystem.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Begin and end are Clock nanoseconds, worker is JobSystem worker which ran the step
+struct InitStepTiming
+{
+	const char*						name;
+	int64_t							beginNanoseconds;
+	int64_t							endNanoseconds;
+	uint32_t						worker;
+};
+
+// Startup steps with explicit dependencies, executed on job system as soon as everything they need is done.
+// Steps can only depend on steps added before them, so graph has no cycles and order of adding is a valid sequential order.
+class InitGraph
+{
+	public:
+
+										InitGraph();
+		// Name must stay valid until timeline is written, string literals are expected. Returns index used as dependency.
+		uint32_t						addStep(const char* name, std::function<void()> function, std::initializer_list<uint32_t> dependencies);
+		// Returns when all steps are done. When step throws, steps which depend on it are skipped
+		// and first exception is rethrown after everything already started has finished.
+		void							run(JobSystem& jobSystem);
+
+		// One entry per step in order of adding, skipped steps have zero duration
+		const std::vector<InitStepTiming>&	getTimeline() const;
+		int64_t							getDurationNanoseconds() const;
+		// Chrome Trace Event JSON like CPU profiler output, one row per worker
+		void							writeTimeline(const std::string& fileName) const;
+
+	private:
+
+		struct Step
+		{
+			std::function<void()>		function;
+			std::vector<uint32_t>		dependents;
+			uint32_t					dependenciesNumber;
+			std::atomic<uint32_t>		pendingDependencies;
+			std::atomic<bool>			skipped;
+		};
+
+		void							executeStep(uint32_t index);
+
+		std::vector<std::unique_ptr<Step>> steps;
+		std::vector<InitStepTiming>		timeline;
+		JobSystem*						jobSystem;
+		JobCounter						counter;
+		int64_t							beginNanoseconds;
+		int64_t							endNanoseconds;
+		std::mutex						exceptionMutex;
+		std::exception_ptr				exception;
+};
+
+#endif
@@ -0,0 +1,444 @@
+#include"stdafx.hpp"
+#include"JobSystem.hpp"
+#include"CpuProfiler.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Worker spins this many times before it goes to sleep
+const uint32_t JOB_IDLE_SPINS				= 64;
+
+thread_local JobSystem* JobSystem::currentJobSystem = nullptr;
+thread_local uint32_t JobSystem::currentWorkerIndex = NO_WORKER;
+
+JobCounter::JobCounter()
+{
+	pending.store(0);
+}
+
+bool JobCounter::isDone() const
+{
+	return pending.load(std::memory_order_acquire) == 0;
+}
+
+JobQueue::JobQueue()
+{
+	top.store(0);
+	bottom.store(0);
+	for(std::atomic<Job*>& job: jobs)
+	{
+		job.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+bool JobQueue::push(Job* job)
+{
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+
+	if(b - t >= static_cast<int64_t>(JOB_QUEUE_CAPACITY))
+	{
+		return false;
+	}
+
+	jobs[b & (JOB_QUEUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+	bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+Job* JobQueue::pop()
+{
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	// Thieves must see smaller bottom before owner reads top, otherwise both could take last job
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+
+	if(t > b)
+	{
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = jobs[b & (JOB_QUEUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+
+	if(t == b)
+	{
+		// Last job, thief may be taking it right now
+		if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobQueue::steal()
+{
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+
+	if(t >= b)
+	{
+		return nullptr;
+	}
+
+	Job* job = jobs[t & (JOB_QUEUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+
+	if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+	return job;
+}
+
+JobSystem::JobSystem()
+{
+	running.store(false);
+	externalJobsNumber.store(0);
+	sleepingWorkers.store(0);
+}
+
+JobSystem::~JobSystem()
+{
+	shutdown();
+}
+
+void JobSystem::initialize(uint32_t workersNumber)
+{
+	workersNumber = std::max(workersNumber, 1U);
+
+	for(uint32_t i=0; i<workersNumber; i++)
+	{
+		std::unique_ptr<Worker> worker(new Worker());
+		for(Job& job: worker->pool)
+		{
+			job.finished.store(true, std::memory_order_relaxed);
+			job.pooled = true;
+		}
+		worker->nextPoolSlot = 0;
+		worker->nextVictim = i + 1;
+		workers.push_back(std::move(worker));
+	}
+
+	running.store(true);
+
+	// Worker of another job system stays external thread here. Worker 0 then has no thread, caller still runs jobs while it waits.
+	if(currentJobSystem == nullptr)
+	{
+		currentJobSystem = this;
+		currentWorkerIndex = 0;
+	}
+
+	for(uint32_t i=1; i<workersNumber; i++)
+	{
+		workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+	}
+}
+
+void JobSystem::shutdown()
+{
+	if(!running.load())
+	{
+		return;
+	}
+
+	// Jobs nobody waits for may still be queued
+	while(executeNext(getCurrentWorkerIndex()))
+	{
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running.store(false);
+	}
+	sleepCondition.notify_all();
+
+	for(size_t i=1; i<workers.size(); i++)
+	{
+		workers[i]->thread.join();
+	}
+	workers.clear();
+
+	if(currentJobSystem == this)
+	{
+		currentJobSystem = nullptr;
+		currentWorkerIndex = NO_WORKER;
+	}
+}
+
+uint32_t JobSystem::getWorkersNumber() const
+{
+	return static_cast<uint32_t>(workers.size());
+}
+
+uint32_t JobSystem::getCurrentWorkerIndex() const
+{
+	return currentJobSystem == this ? currentWorkerIndex : NO_WORKER;
+}
+
+Job* JobSystem::allocateJob(std::function<void()> function, JobCounter* counter)
+{
+	Job* job = nullptr;
+	const uint32_t workerIndex = getCurrentWorkerIndex();
+
+	if(workerIndex != NO_WORKER)
+	{
+		Worker& worker = *workers[workerIndex];
+		job = &worker.pool[worker.nextPoolSlot & (JOB_POOL_SIZE - 1)];
+
+		// Pool wrapped around while job from previous round is queued or running. Waiting for it could deadlock
+		// when it is this thread which runs it further up the stack.
+		if(job->finished.load(std::memory_order_acquire))
+		{
+			++worker.nextPoolSlot;
+		}
+		else
+		{
+			job = nullptr;
+		}
+	}
+
+	if(job == nullptr)
+	{
+		job = new Job();
+		job->pooled = false;
+	}
+
+	job->function = std::move(function);
+	job->counter = counter;
+	job->finished.store(false, std::memory_order_relaxed);
+
+	if(counter != nullptr)
+	{
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+void JobSystem::schedule(Job* job)
+{
+	const uint32_t workerIndex = getCurrentWorkerIndex();
+
+	if(workerIndex == NO_WORKER)
+	{
+		std::lock_guard<std::mutex> lock(externalJobsMutex);
+		externalJobs.push_back(job);
+		externalJobsNumber.fetch_add(1, std::memory_order_release);
+	}
+	else if(!workers[workerIndex]->queue.push(job))
+	{
+		// Queue is full, job runs right away instead
+		execute(job);
+		return;
+	}
+
+	if(sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		sleepCondition.notify_one();
+	}
+}
+
+void JobSystem::run(std::function<void()> function, JobCounter* counter)
+{
+	if(workers.empty())
+	{
+		function();
+		return;
+	}
+	schedule(allocateJob(std::move(function), counter));
+}
+
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter)
+{
+	if(workers.empty())
+	{
+		function();
+		return;
+	}
+
+	Job* job = allocateJob(std::move(function), counter);
+
+	{
+		std::lock_guard<std::mutex> lock(dependency.continuationsMutex);
+		// Checked under lock, so job which finishes dependency either sees this continuation or it is scheduled here
+		if(!dependency.isDone())
+		{
+			dependency.continuations.push_back(job);
+			return;
+		}
+	}
+	schedule(job);
+}
+
+Job* JobSystem::findJob(uint32_t workerIndex)
+{
+	Job* job = nullptr;
+
+	if(workerIndex != NO_WORKER)
+	{
+		job = workers[workerIndex]->queue.pop();
+		if(job != nullptr)
+		{
+			return job;
+		}
+	}
+
+	if(externalJobsNumber.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(externalJobsMutex);
+		if(!externalJobs.empty())
+		{
+			job = externalJobs.front();
+			externalJobs.pop_front();
+			externalJobsNumber.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	// Victims are visited in turn starting from different worker every time so one queue is not drained by everybody
+	uint32_t workersNumber = static_cast<uint32_t>(workers.size());
+	uint32_t firstVictim = workerIndex != NO_WORKER ? workers[workerIndex]->nextVictim++ : 0;
+
+	for(uint32_t i=0; i<workersNumber; i++)
+	{
+		uint32_t victim = (firstVictim + i) % workersNumber;
+		if(victim == workerIndex)
+		{
+			continue;
+		}
+		job = workers[victim]->queue.steal();
+		if(job != nullptr)
+		{
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+bool JobSystem::executeNext(uint32_t workerIndex)
+{
+	Job* job = findJob(workerIndex);
+
+	if(job == nullptr)
+	{
+		return false;
+	}
+	execute(job);
+	return true;
+}
+
+void JobSystem::execute(Job* job)
+{
+	job->function();
+	job->function = nullptr;
+
+	JobCounter* counter = job->counter;
+
+	if(counter != nullptr)
+	{
+		std::vector<Job*> continuations;
+
+		{
+			// Decrement is under lock so waiter which saw zero can not destroy counter before lock is released
+			std::lock_guard<std::mutex> lock(counter->continuationsMutex);
+			if(counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				continuations.swap(counter->continuations);
+			}
+		}
+
+		for(Job* continuation: continuations)
+		{
+			schedule(continuation);
+		}
+	}
+
+	if(job->pooled)
+	{
+		job->finished.store(true, std::memory_order_release);
+	}
+	else
+	{
+		delete job;
+	}
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	const uint32_t workerIndex = getCurrentWorkerIndex();
+
+	while(!counter.isDone())
+	{
+		if(!executeNext(workerIndex))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// Last job may still hold lock of counter
+	std::lock_guard<std::mutex> lock(counter.continuationsMutex);
+}
+
+void JobSystem::splitRange(uint32_t begin, uint32_t end, const ParallelForTask* task)
+{
+	// Upper halves go to queue where idle workers steal them, lower half is split further on this thread
+	while(end - begin > task->grain)
+	{
+		uint32_t middle = begin + (end - begin) / 2;
+		run([task, middle, end]
+		{
+			task->jobSystem->splitRange(middle, end, task);
+		}, task->counter);
+		end = middle;
+	}
+	(*task->function)(begin, end);
+}
+
+void JobSystem::parallelFor(uint32_t begin, uint32_t end, uint32_t grain, const std::function<void(uint32_t, uint32_t)>& function)
+{
+	if(begin >= end)
+	{
+		return;
+	}
+
+	JobCounter counter;
+	ParallelForTask task = {this, &function, &counter, std::max(grain, 1U)};
+	splitRange(begin, end, &task);
+	wait(counter);
+}
+
+void JobSystem::workerLoop(uint32_t workerIndex)
+{
+	YAS_PROFILE_THREAD_NAME("Job worker");
+	currentJobSystem = this;
+	currentWorkerIndex = workerIndex;
+	uint32_t idleSpins = 0;
+
+	while(running.load(std::memory_order_relaxed))
+	{
+		if(executeNext(workerIndex))
+		{
+			idleSpins = 0;
+			continue;
+		}
+
+		if(++idleSpins < JOB_IDLE_SPINS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Timeout covers job pushed between last search and going to sleep
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+		if(running.load())
+		{
+			sleepCondition.wait_for(lock, std::chrono::milliseconds(1));
+		}
+		sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+		idleSpins = 0;
+	}
+}
@@ -0,0 +1,128 @@
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Both must be power of two. When next pool slot is still in use job is allocated on heap.
+const uint32_t JOB_QUEUE_CAPACITY			= 4096;
+const uint32_t JOB_POOL_SIZE				= 4096;
+const uint32_t NO_WORKER					= 0xFFFFFFFF;
+
+class JobCounter;
+
+struct Job
+{
+	std::function<void()>			function;
+	JobCounter*						counter;
+	// Slot of worker pool can be reused. Jobs from other threads are allocated with new and deleted when done.
+	std::atomic<bool>				finished;
+	bool							pooled;
+};
+
+// Number of jobs which still have to finish. Counter must stay alive until JobSystem::wait on it returned.
+class JobCounter
+{
+	public:
+
+										JobCounter();
+		bool							isDone() const;
+
+	private:
+
+		friend class JobSystem;
+
+		std::atomic<uint32_t>			pending;
+		// Jobs started by JobSystem::runAfter when pending reaches zero
+		std::mutex						continuationsMutex;
+		std::vector<Job*>				continuations;
+};
+
+// Chase-Lev work stealing deque. Owner pushes and pops at bottom, other threads steal from top.
+class JobQueue
+{
+	public:
+
+										JobQueue();
+		// Owner thread only. Returns false when queue is full.
+		bool							push(Job* job);
+		Job*							pop();
+		Job*							steal();
+
+	private:
+
+		alignas(64) std::atomic<int64_t> top;
+		alignas(64) std::atomic<int64_t> bottom;
+		alignas(64) std::array<std::atomic<Job*>, JOB_QUEUE_CAPACITY> jobs;
+};
+
+// One worker per core. Thread which calls initialize is worker 0 and executes jobs whenever it waits.
+// Threads which are not workers can add and wait for jobs too, they go through shared queue.
+// Thread is worker of at most one job system. To others, also one initialized on it, it is external thread.
+class JobSystem
+{
+	public:
+
+										JobSystem();
+										~JobSystem();
+		void							initialize(uint32_t workersNumber);
+		// Waits until all scheduled jobs are done
+		void							shutdown();
+		uint32_t						getWorkersNumber() const;
+		// NO_WORKER on threads which are not workers of this job system
+		uint32_t						getCurrentWorkerIndex() const;
+
+		// Counter can be nullptr when nobody waits for job
+		void							run(std::function<void()> function, JobCounter* counter);
+		// Job is scheduled when dependency reaches zero
+		void							runAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter);
+		// Calls function for ranges of at most grain elements on all workers. Returns when whole range is done.
+		void							parallelFor(uint32_t begin, uint32_t end, uint32_t grain, const std::function<void(uint32_t, uint32_t)>& function);
+		// Executes other jobs until counter reaches zero
+		void							wait(JobCounter& counter);
+
+	private:
+
+		struct Worker
+		{
+			JobQueue					queue;
+			std::array<Job, JOB_POOL_SIZE> pool;
+			uint32_t					nextPoolSlot;
+			uint32_t					nextVictim;
+			std::thread					thread;
+		};
+
+		Job*							allocateJob(std::function<void()> function, JobCounter* counter);
+		void							schedule(Job* job);
+		Job*							findJob(uint32_t workerIndex);
+		bool							executeNext(uint32_t workerIndex);
+		void							execute(Job* job);
+		// Shared by all jobs of one parallelFor, so job captures only pointer to it and range which fits std::function without heap
+		struct ParallelForTask
+		{
+			JobSystem*					jobSystem;
+			const std::function<void(uint32_t, uint32_t)>* function;
+			JobCounter*					counter;
+			uint32_t					grain;
+		};
+
+		void							splitRange(uint32_t begin, uint32_t end, const ParallelForTask* task);
+		void							workerLoop(uint32_t workerIndex);
+
+		// Worker index is valid only in job system which owns the thread
+		static thread_local JobSystem*	currentJobSystem;
+		static thread_local uint32_t	currentWorkerIndex;
+
+		std::vector<std::unique_ptr<Worker>> workers;
+		std::atomic<bool>				running;
+		// Jobs added by threads which are not workers
+		std::deque<Job*>				externalJobs;
+		std::atomic<uint32_t>			externalJobsNumber;
+		std::mutex						externalJobsMutex;
+		// Idle workers sleep here instead of spinning
+		std::mutex						sleepMutex;
+		std::condition_variable			sleepCondition;
+		std::atomic<uint32_t>			sleepingWorkers;
+};
+
+#endif
@@ -1,17 +1,251 @@
 #include"stdafx.hpp"
 #include"Main.hpp"
+#include"YasLog.hpp"
 
 //-----------------------------------------------------------------------------|---------------------------------------|
 
+// Reads --frames, --width, --height, --statistics, --screenshot, --characters, --occluded-boxes, --skinning, --device, --startup-timeline, --descriptor-stress, --new-materials, --pipelines, --geometry-churn, --streamed-assets and --residency-budget. Returns false on unknown or incomplete option.
+bool parseHeadlessSettings(int argc, char* argv[], HeadlessSettings& settings)
+{
+	for(int i=1; i<argc; i++)
+	{
+		std::string option = argv[i];
+
+		if(option == "--headless")
+		{
+			continue;
+		}
+
+		if(i + 1 >= argc)
+		{
+			std::cerr << "Missing value of option " << option << std::endl;
+			return false;
+		}
+
+		const char* value = argv[++i];
+
+		if(option == "--frames")
+		{
+			settings.framesNumber = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--width")
+		{
+			settings.width = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--height")
+		{
+			settings.height = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--statistics")
+		{
+			settings.statisticsPath = value;
+		}
+		else if(option == "--screenshot")
+		{
+			settings.screenshotPath = value;
+		}
+		else if(option == "--characters")
+		{
+			settings.charactersNumber = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--occluded-boxes")
+		{
+			settings.occludedBoxesNumber = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--skinning")
+		{
+			if(std::string(value) != "cpu" && std::string(value) != "gpu")
+			{
+				std::cerr << "Skinning has to be cpu or gpu" << std::endl;
+				return false;
+			}
+			settings.cpuSkinning = std::string(value) == "cpu";
+		}
+		else if(option == "--device")
+		{
+			settings.preferredDevice = value;
+		}
+		else if(option == "--startup-timeline")
+		{
+			settings.startupTimelinePath = value;
+		}
+		else if(option == "--descriptor-stress")
+		{
+			settings.descriptorStressSets = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--new-materials")
+		{
+			settings.newMaterialsNumber = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--pipelines")
+		{
+			if(std::string(value) != "async" && std::string(value) != "blocking")
+			{
+				std::cerr << "Pipelines have to be async or blocking" << std::endl;
+				return false;
+			}
+			settings.blockingPipelines = std::string(value) == "blocking";
+		}
+		else if(option == "--geometry-churn")
+		{
+			settings.geometryChurnMeshes = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--streamed-assets")
+		{
+			settings.streamedAssets = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(option == "--residency-budget")
+		{
+			settings.residencyBudgetMegabytes = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return false;
+		}
+	}
+
+	if(settings.width == 0 || settings.height == 0)
+	{
+		std::cerr << "Offscreen image size must not be zero" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int runHeadless(int argc, char* argv[])
+{
+	HeadlessSettings settings;
+
+	if(!parseHeadlessSettings(argc, argv, settings))
+	{
+		std::cerr << "Usage: YasEngine --headless [--frames N] [--width W] [--height H] [--statistics file] [--screenshot file.png] [--characters N] [--occluded-boxes N] [--skinning cpu|gpu] [--device name|uuid] [--startup-timeline file.json] [--descriptor-stress N] [--new-materials N] [--pipelines async|blocking] [--geometry-churn N] [--streamed-assets N] [--residency-budget MB]" << std::endl;
+		return 1;
+	}
+
+	try
+	{
+		YasEngine yasEngine;
+		yasEngine.runHeadless(settings);
+	}
+	catch(const std::exception& exception)
+	{
+		// Messages logged before failure are written first
+		YasLog::stop();
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// YasEngine --pack-assets archive [--compress] [files...]. Without files packs mesh file of model, its texture and shader pack.
+int packAssets(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		std::cerr << "Usage: YasEngine --pack-assets archive [--compress] [files...]" << std::endl;
+		return 1;
+	}
+
+	const std::string archiveFileName = argv[2];
+	bool compress = false;
+	std::vector<std::string> fileNames;
+
+	for(int i = 3; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if(argument == "--compress")
+		{
+			compress = true;
+		}
+		else
+		{
+			fileNames.push_back(argument);
+		}
+	}
+
+	try
+	{
+		if(fileNames.empty())
+		{
+			// Default assets are generated from their sources when they were not yet
+			const std::string meshFileName = ModelLoader::getMeshFileName(YasEngine::MODEL_PATH);
+			MappedFile meshFile;
+
+			if(!meshFile.open(meshFileName) || MeshCodec::readHeader(meshFile.data(), meshFile.size()) == nullptr)
+			{
+				meshFile.close();
+				JobSystem jobSystem;
+				jobSystem.initialize(std::max(std::thread::hardware_concurrency(), 1U));
+				ModelLoader::convertObj(YasEngine::MODEL_PATH, meshFileName, jobSystem);
+			}
+			meshFile.close();
+
+			MappedFile shaderPack;
+
+			if(!shaderPack.open(SHADER_PACK_PATH))
+			{
+				ShaderVariantCache::writeShaderPack(SHADER_PACK_PATH);
+			}
+			shaderPack.close();
+
+			fileNames = {meshFileName, YasEngine::TEXTURE_PATH, SHADER_PACK_PATH};
+		}
+
+		AssetArchive::write(archiveFileName, fileNames, compress);
+	}
+	catch(const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << "Packed " << fileNames.size() << " assets into " << archiveFileName << std::endl;
+	return 0;
+}
+
+#ifdef _WIN32
 // Main function off windows application. Return int. 0 - there were not errors. !=0 there were errors.
 // hInstance handle to this application. hPrevInstance - not using (deprecated)
 // lpCmdLine pointer to char table- string with witch applications are call.
 // nShowCmd - variable which tell how to show window.
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nShowCmd)
 {
+	// Headless run is started from scripts, it returns without waiting for key
+	if(__argc > 1 && std::string(__argv[1]) == "--headless")
+	{
+		return runHeadless(__argc, __argv);
+	}
+
+	if(__argc > 1 && std::string(__argv[1]) == "--pack-assets")
+	{
+		return packAssets(__argc, __argv);
+	}
+
+	// Window is not configurable otherwise, only --device is read
+	std::string preferredDevice;
+	for(int i=1; i + 1 < __argc; i++)
+	{
+		if(std::string(__argv[i]) == "--device")
+		{
+			preferredDevice = __argv[i + 1];
+		}
+	}
+
 	YasEngine yasEngine = YasEngine();
-	yasEngine.run(hInstance);
+	yasEngine.run(hInstance, preferredDevice);
 	system("PAUSE");
 	return 0;
 }
-
+#else
+// There is no window implementation outside Windows, engine always runs headless
+int main(int argc, char* argv[])
+{
+	if(argc > 1 && std::string(argv[1]) == "--pack-assets")
+	{
+		return packAssets(argc, argv);
+	}
+	return runHeadless(argc, argv);
+}
+#endif
@@ -0,0 +1,161 @@
+#include"stdafx.hpp"
+#include"MappedFile.hpp"
+#ifndef _WIN32
+	#include<sys/mman.h>
+	#include<sys/stat.h>
+	#include<fcntl.h>
+	#include<unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+{
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+	view = nullptr;
+	viewSize = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& fileName)
+{
+	close();
+
+	fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if(fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+
+	// Empty file can not be mapped
+	if(!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if(mappingHandle == NULL)
+	{
+		close();
+		return false;
+	}
+
+	view = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+
+	if(view == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	viewSize = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(view != nullptr)
+	{
+		UnmapViewOfFile(view);
+		view = nullptr;
+	}
+
+	if(mappingHandle != NULL)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = NULL;
+	}
+
+	if(fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+	}
+
+	viewSize = 0;
+}
+
+#else
+MappedFile::MappedFile()
+{
+	view = nullptr;
+	viewSize = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& fileName)
+{
+	close();
+
+	int fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+
+	if(fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+
+	// Empty file can not be mapped
+	if(fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		::close(fileDescriptor);
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	// Mapping keeps file alive, descriptor is not needed anymore
+	::close(fileDescriptor);
+
+	if(mapping == MAP_FAILED)
+	{
+		return false;
+	}
+
+	view = static_cast<const char*>(mapping);
+	viewSize = static_cast<size_t>(fileStatus.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(view != nullptr)
+	{
+		munmap(const_cast<char*>(view), viewSize);
+		view = nullptr;
+	}
+
+	viewSize = 0;
+}
+
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return view != nullptr;
+}
+
+const char* MappedFile::data() const
+{
+	return view;
+}
+
+size_t MappedFile::size() const
+{
+	return viewSize;
+}
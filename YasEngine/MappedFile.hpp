@@ -0,0 +1,34 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Read only view of whole file. Pages are loaded by OS on first access so opening is cheap even for big files.
+class MappedFile
+{
+	public:
+
+										MappedFile();
+										~MappedFile();
+										MappedFile(const MappedFile&) = delete;
+		MappedFile&						operator=(const MappedFile&) = delete;
+
+		// Returns false when file does not exist or can not be mapped
+		bool							open(const std::string& fileName);
+		void							close();
+		bool							isOpen() const;
+		const char*						data() const;
+		size_t							size() const;
+
+	private:
+
+#ifdef _WIN32
+		HANDLE							fileHandle;
+		HANDLE							mappingHandle;
+#endif
+		const char*						view;
+		size_t							viewSize;
+};
+
+#endif
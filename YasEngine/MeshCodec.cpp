@@ -0,0 +1,633 @@
+#include"stdafx.hpp"
+#include"MeshCodec.hpp"
+#include"YasMathLib.hpp"
+#include"Arena.hpp"
+#include"CpuProfiler.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Bytes of packed group of 16 bytes for every width selector
+static const uint32_t PLANE_GROUP_SIZES[4] = {0, 4, 8, 16};
+// Two planes per component, low bytes first
+const uint32_t MESH_VERTEX_PLANES = 2 * MESH_VERTEX_COMPONENTS;
+
+static float vertexCacheScore(int32_t cachePosition, uint32_t remainingTriangles)
+{
+	// Vertex without triangles left must never be picked
+	if(remainingTriangles == 0)
+	{
+		return -1.0F;
+	}
+
+	float score = 0.0F;
+	if(cachePosition >= 0)
+	{
+		// Vertices of last triangle get fixed score, so it is not favoured over triangles which reuse older entries
+		if(cachePosition < 3)
+		{
+			score = 0.75F;
+		}
+		else
+		{
+			score = std::pow(1.0F - (cachePosition - 3) / static_cast<float>(VERTEX_CACHE_SIZE - 3), 1.5F);
+		}
+	}
+
+	// Vertices with few triangles left are finished first, so they do not stay as lonely triangles at the end
+	return score + 2.0F / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+void MeshCodec::optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t verticesNumber)
+{
+	YAS_PROFILE_FUNCTION();
+	const uint32_t trianglesNumber = static_cast<uint32_t>(indices.size() / 3);
+
+	// Triangles of every vertex, list of vertex v starts at trianglesOffsets[v]
+	std::vector<uint32_t> trianglesOffsets(verticesNumber + 1, 0);
+	for(uint32_t index: indices)
+	{
+		++trianglesOffsets[index + 1];
+	}
+	for(uint32_t i=0; i<verticesNumber; i++)
+	{
+		trianglesOffsets[i + 1] += trianglesOffsets[i];
+	}
+
+	std::vector<uint32_t> vertexTriangles(indices.size());
+	std::vector<uint32_t> remainingTriangles(verticesNumber, 0);
+	for(uint32_t triangle=0; triangle<trianglesNumber; triangle++)
+	{
+		for(uint32_t corner=0; corner<3; corner++)
+		{
+			uint32_t vertex = indices[triangle * 3 + corner];
+			vertexTriangles[trianglesOffsets[vertex] + remainingTriangles[vertex]++] = triangle;
+		}
+	}
+
+	std::vector<int32_t> cachePositions(verticesNumber, -1);
+	std::vector<float> vertexScores(verticesNumber);
+	for(uint32_t i=0; i<verticesNumber; i++)
+	{
+		vertexScores[i] = vertexCacheScore(-1, remainingTriangles[i]);
+	}
+
+	std::vector<bool> emitted(trianglesNumber, false);
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> newCache;
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	uint32_t nextTriangle = 0;
+	int64_t bestTriangle = -1;
+
+	for(uint32_t emittedNumber=0; emittedNumber<trianglesNumber; emittedNumber++)
+	{
+		// Nothing in cache has triangles left, next part of mesh starts with first triangle in original order
+		if(bestTriangle < 0)
+		{
+			while(emitted[nextTriangle])
+			{
+				nextTriangle++;
+			}
+			bestTriangle = nextTriangle;
+		}
+
+		const uint32_t* triangleIndices = &indices[static_cast<size_t>(bestTriangle) * 3];
+		result.insert(result.end(), triangleIndices, triangleIndices + 3);
+		emitted[static_cast<size_t>(bestTriangle)] = true;
+
+		// LRU cache, vertices of emitted triangle move to front
+		newCache.assign(triangleIndices, triangleIndices + 3);
+		for(uint32_t corner=0; corner<3; corner++)
+		{
+			--remainingTriangles[triangleIndices[corner]];
+		}
+		for(uint32_t vertex: cache)
+		{
+			if(vertex != triangleIndices[0] && vertex != triangleIndices[1] && vertex != triangleIndices[2])
+			{
+				newCache.push_back(vertex);
+			}
+		}
+
+		// Vertices which fell out of cache get score without cache bonus
+		for(size_t i=0; i<newCache.size(); i++)
+		{
+			uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < VERTEX_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+			vertexScores[vertex] = vertexCacheScore(cachePositions[vertex], remainingTriangles[vertex]);
+		}
+		if(newCache.size() > VERTEX_CACHE_SIZE)
+		{
+			newCache.resize(VERTEX_CACHE_SIZE);
+		}
+		cache.swap(newCache);
+
+		// Only triangles of cached vertices changed score, best one of them is emitted next
+		bestTriangle = -1;
+		float bestScore = 0.0F;
+		for(uint32_t vertex: cache)
+		{
+			for(uint32_t i=trianglesOffsets[vertex]; i<trianglesOffsets[vertex + 1]; i++)
+			{
+				uint32_t triangle = vertexTriangles[i];
+				if(emitted[triangle])
+				{
+					continue;
+				}
+
+				float score = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+				if(score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = triangle;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+void MeshCodec::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	YAS_PROFILE_FUNCTION();
+	const uint32_t NOT_USED = 0xFFFFFFFF;
+	std::vector<uint32_t> newIndices(vertices.size(), NOT_USED);
+	std::vector<Vertex> newVertices;
+	newVertices.reserve(vertices.size());
+
+	for(uint32_t& index: indices)
+	{
+		if(newIndices[index] == NOT_USED)
+		{
+			newIndices[index] = static_cast<uint32_t>(newVertices.size());
+			newVertices.push_back(vertices[index]);
+		}
+		index = newIndices[index];
+	}
+
+	vertices.swap(newVertices);
+}
+
+void MeshCodec::encode(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint64_t sourceSize, uint64_t sourceModificationTime, std::vector<char>& data)
+{
+	YAS_PROFILE_FUNCTION();
+	optimizeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+	optimizeVertexFetch(vertices, indices);
+
+	MeshFileHeader header = {};
+	header.magic = MESH_FILE_MAGIC;
+	header.version = MESH_FILE_VERSION;
+	header.verticesNumber = static_cast<uint32_t>(vertices.size());
+	header.indicesNumber = static_cast<uint32_t>(indices.size());
+	header.sourceSize = sourceSize;
+	header.sourceModificationTime = sourceModificationTime;
+	header.vertexBlocksNumber = (header.verticesNumber + MESH_VERTEX_BLOCK_SIZE - 1) / MESH_VERTEX_BLOCK_SIZE;
+	header.indexBlocksNumber = (header.indicesNumber + MESH_INDEX_BLOCK_SIZE - 1) / MESH_INDEX_BLOCK_SIZE;
+
+	// Every component is quantized within its own range
+	const float* components = reinterpret_cast<const float*>(vertices.data());
+	float maximums[MESH_VERTEX_COMPONENTS];
+	for(uint32_t c=0; c<MESH_VERTEX_COMPONENTS; c++)
+	{
+		header.offsets[c] = vertices.empty() ? 0.0F : components[c];
+		maximums[c] = header.offsets[c];
+	}
+	for(uint32_t v=0; v<header.verticesNumber; v++)
+	{
+		for(uint32_t c=0; c<MESH_VERTEX_COMPONENTS; c++)
+		{
+			header.offsets[c] = std::min(header.offsets[c], components[v * MESH_VERTEX_COMPONENTS + c]);
+			maximums[c] = std::max(maximums[c], components[v * MESH_VERTEX_COMPONENTS + c]);
+		}
+	}
+	for(uint32_t c=0; c<MESH_VERTEX_COMPONENTS; c++)
+	{
+		header.scales[c] = (maximums[c] - header.offsets[c]) / 65535.0F;
+	}
+
+	const size_t tablesSize = sizeof(uint32_t) * (header.vertexBlocksNumber + 1 + header.indexBlocksNumber + 1);
+	data.assign(sizeof(MeshFileHeader) + tablesSize, 0);
+	memcpy(data.data(), &header, sizeof(header));
+	std::vector<uint32_t> blockOffsets;
+
+	std::vector<uint8_t> planes(MESH_VERTEX_PLANES * MESH_VERTEX_BLOCK_SIZE);
+	for(uint32_t block=0; block<header.vertexBlocksNumber; block++)
+	{
+		blockOffsets.push_back(static_cast<uint32_t>(data.size()));
+		const uint32_t firstVertex = block * MESH_VERTEX_BLOCK_SIZE;
+		const uint32_t blockVertices = std::min(MESH_VERTEX_BLOCK_SIZE, header.verticesNumber - firstVertex);
+		uint16_t previous[MESH_VERTEX_COMPONENTS] = {};
+
+		for(uint32_t v=0; v<blockVertices; v++)
+		{
+			for(uint32_t c=0; c<MESH_VERTEX_COMPONENTS; c++)
+			{
+				uint16_t quantized = 0;
+				if(header.scales[c] > 0.0F)
+				{
+					float normalized = (components[(firstVertex + v) * MESH_VERTEX_COMPONENTS + c] - header.offsets[c]) / header.scales[c];
+					quantized = static_cast<uint16_t>(std::min(std::max(normalized + 0.5F, 0.0F), 65535.0F));
+				}
+
+				// Deltas wrap around, decoder adds them with the same 16 bit overflow
+				uint16_t delta = static_cast<uint16_t>(quantized - previous[c]);
+				uint16_t zigzag = static_cast<uint16_t>((delta << 1) ^ (0 - (delta >> 15)));
+				previous[c] = quantized;
+				planes[(2 * c) * MESH_VERTEX_BLOCK_SIZE + v] = static_cast<uint8_t>(zigzag);
+				planes[(2 * c + 1) * MESH_VERTEX_BLOCK_SIZE + v] = static_cast<uint8_t>(zigzag >> 8);
+			}
+		}
+
+		for(uint32_t plane=0; plane<MESH_VERTEX_PLANES; plane++)
+		{
+			encodePlane(&planes[plane * MESH_VERTEX_BLOCK_SIZE], blockVertices, data);
+		}
+	}
+	blockOffsets.push_back(static_cast<uint32_t>(data.size()));
+
+	for(uint32_t block=0; block<header.indexBlocksNumber; block++)
+	{
+		blockOffsets.push_back(static_cast<uint32_t>(data.size()));
+		const uint32_t firstIndex = block * MESH_INDEX_BLOCK_SIZE;
+		const uint32_t blockIndices = std::min(MESH_INDEX_BLOCK_SIZE, header.indicesNumber - firstIndex);
+		uint32_t previous = 0;
+
+		for(uint32_t i=0; i<blockIndices; i++)
+		{
+			uint32_t delta = indices[firstIndex + i] - previous;
+			uint32_t value = (delta << 1) ^ (0 - (delta >> 31));
+			previous = indices[firstIndex + i];
+
+			while(value >= 0x80)
+			{
+				data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+				value >>= 7;
+			}
+			data.push_back(static_cast<char>(value));
+		}
+	}
+	blockOffsets.push_back(static_cast<uint32_t>(data.size()));
+
+	memcpy(data.data() + sizeof(MeshFileHeader), blockOffsets.data(), tablesSize);
+}
+
+void MeshCodec::encodePlane(const uint8_t* plane, uint32_t size, std::vector<char>& data)
+{
+	const uint32_t groupsNumber = (size + 15) / 16;
+	const size_t selectorsStart = data.size();
+	data.resize(data.size() + (groupsNumber + 3) / 4, 0);
+
+	for(uint32_t group=0; group<groupsNumber; group++)
+	{
+		// Last group is padded with zeros
+		uint8_t values[16] = {};
+		memcpy(values, plane + group * 16, std::min(16U, size - group * 16));
+
+		uint8_t maximum = 0;
+		for(uint8_t value: values)
+		{
+			maximum = std::max(maximum, value);
+		}
+
+		uint32_t selector = maximum == 0 ? 0 : (maximum < 4 ? 1 : (maximum < 16 ? 2 : 3));
+		data[selectorsStart + group / 4] |= static_cast<char>(selector << (2 * (group % 4)));
+
+		// Byte k holds values k, k + 4, k + 8 and k + 12 at 2 bits or values k and k + 8 at 4 bits, decoder unpacks them with shifts
+		if(selector == 1)
+		{
+			for(uint32_t k=0; k<4; k++)
+			{
+				data.push_back(static_cast<char>(values[k] | (values[k + 4] << 2) | (values[k + 8] << 4) | (values[k + 12] << 6)));
+			}
+		}
+		else if(selector == 2)
+		{
+			for(uint32_t k=0; k<8; k++)
+			{
+				data.push_back(static_cast<char>(values[k] | (values[k + 8] << 4)));
+			}
+		}
+		else if(selector == 3)
+		{
+			data.insert(data.end(), reinterpret_cast<const char*>(values), reinterpret_cast<const char*>(values) + 16);
+		}
+	}
+}
+
+const MeshFileHeader* MeshCodec::readHeader(const char* data, size_t size)
+{
+	if(size < sizeof(MeshFileHeader))
+	{
+		return nullptr;
+	}
+
+	const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(data);
+
+	if(header->magic != MESH_FILE_MAGIC || header->version != MESH_FILE_VERSION ||
+		header->vertexBlocksNumber != (header->verticesNumber + MESH_VERTEX_BLOCK_SIZE - 1) / MESH_VERTEX_BLOCK_SIZE ||
+		header->indexBlocksNumber != (header->indicesNumber + MESH_INDEX_BLOCK_SIZE - 1) / MESH_INDEX_BLOCK_SIZE)
+	{
+		return nullptr;
+	}
+
+	if(size < sizeof(MeshFileHeader) + sizeof(uint32_t) * (static_cast<size_t>(header->vertexBlocksNumber) + header->indexBlocksNumber + 2))
+	{
+		return nullptr;
+	}
+	return header;
+}
+
+void MeshCodec::decode(const char* data, size_t size, JobSystem& jobSystem, Vertex* vertices, uint32_t* indices)
+{
+	YAS_PROFILE_FUNCTION();
+	const MeshFileHeader* header = readHeader(data, size);
+
+	if(header == nullptr)
+	{
+		throw std::runtime_error("Mesh file has wrong format");
+	}
+
+	// Vertex table is followed by index table, end of last vertex block is repeated as its first entry
+	const uint32_t* vertexBlockOffsets = reinterpret_cast<const uint32_t*>(data + sizeof(MeshFileHeader));
+	const uint32_t* indexBlockOffsets = vertexBlockOffsets + header->vertexBlocksNumber + 1;
+	const uint32_t blocksNumber = header->vertexBlocksNumber + header->indexBlocksNumber;
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+
+	// Jobs must not throw, blocks only report corrupted data
+	std::atomic<bool> isCorrupted(false);
+
+	jobSystem.parallelFor(0, blocksNumber, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for(uint32_t block=begin; block<end; block++)
+		{
+			bool isVertexBlock = block < header->vertexBlocksNumber;
+			const uint32_t* offsets = isVertexBlock ? &vertexBlockOffsets[block] : &indexBlockOffsets[block - header->vertexBlocksNumber];
+
+			if(offsets[0] > offsets[1] || offsets[1] > size)
+			{
+				isCorrupted = true;
+				continue;
+			}
+
+			if(isVertexBlock)
+			{
+				if(!decodeVertexBlock(bytes + offsets[0], bytes + offsets[1], *header, block * MESH_VERTEX_BLOCK_SIZE, reinterpret_cast<float*>(vertices)))
+				{
+					isCorrupted = true;
+				}
+			}
+			else
+			{
+				const uint32_t firstIndex = (block - header->vertexBlocksNumber) * MESH_INDEX_BLOCK_SIZE;
+				if(!decodeIndexBlock(bytes + offsets[0], bytes + offsets[1], header->verticesNumber, indices + firstIndex, std::min(MESH_INDEX_BLOCK_SIZE, header->indicesNumber - firstIndex)))
+				{
+					isCorrupted = true;
+				}
+			}
+		}
+	});
+
+	if(isCorrupted)
+	{
+		throw std::runtime_error("Mesh file is corrupted, delete it to convert OBJ again");
+	}
+}
+
+bool MeshCodec::decodePlane(const uint8_t*& data, const uint8_t* end, uint32_t size, uint8_t* plane)
+{
+	const uint32_t groupsNumber = (size + 15) / 16;
+	const uint32_t selectorsSize = (groupsNumber + 3) / 4;
+
+	if(static_cast<size_t>(end - data) < selectorsSize)
+	{
+		return false;
+	}
+
+	const uint8_t* selectors = data;
+	const uint8_t* packed = data + selectorsSize;
+
+	// Size of packed groups follows from selectors, so groups are unpacked without bounds checks
+	size_t packedSize = 0;
+	for(uint32_t group=0; group<groupsNumber; group++)
+	{
+		packedSize += PLANE_GROUP_SIZES[(selectors[group / 4] >> (2 * (group % 4))) & 3];
+	}
+
+	if(static_cast<size_t>(end - packed) < packedSize)
+	{
+		return false;
+	}
+
+	for(uint32_t group=0; group<groupsNumber; group++)
+	{
+		const uint32_t selector = (selectors[group / 4] >> (2 * (group % 4))) & 3;
+		uint8_t* values = plane + group * 16;
+
+#ifdef YAS_MATH_SSE
+		__m128i result;
+		if(selector == 0)
+		{
+			result = _mm_setzero_si128();
+		}
+		else if(selector == 1)
+		{
+			int32_t packedBytes;
+			memcpy(&packedBytes, packed, sizeof(packedBytes));
+			const __m128i source = _mm_cvtsi32_si128(packedBytes);
+			const __m128i mask = _mm_set1_epi8(3);
+			__m128i first = _mm_unpacklo_epi32(_mm_and_si128(source, mask), _mm_and_si128(_mm_srli_epi16(source, 2), mask));
+			__m128i second = _mm_unpacklo_epi32(_mm_and_si128(_mm_srli_epi16(source, 4), mask), _mm_and_si128(_mm_srli_epi16(source, 6), mask));
+			result = _mm_unpacklo_epi64(first, second);
+		}
+		else if(selector == 2)
+		{
+			const __m128i source = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(packed));
+			const __m128i mask = _mm_set1_epi8(15);
+			result = _mm_unpacklo_epi64(_mm_and_si128(source, mask), _mm_and_si128(_mm_srli_epi16(source, 4), mask));
+		}
+		else
+		{
+			result = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(values), result);
+#else
+		if(selector == 0)
+		{
+			memset(values, 0, 16);
+		}
+		else if(selector == 1)
+		{
+			for(uint32_t k=0; k<4; k++)
+			{
+				values[k] = packed[k] & 3;
+				values[k + 4] = (packed[k] >> 2) & 3;
+				values[k + 8] = (packed[k] >> 4) & 3;
+				values[k + 12] = packed[k] >> 6;
+			}
+		}
+		else if(selector == 2)
+		{
+			for(uint32_t k=0; k<8; k++)
+			{
+				values[k] = packed[k] & 15;
+				values[k + 8] = packed[k] >> 4;
+			}
+		}
+		else
+		{
+			memcpy(values, packed, 16);
+		}
+#endif
+		packed += PLANE_GROUP_SIZES[selector];
+	}
+
+	data = packed;
+	return true;
+}
+
+bool MeshCodec::decodeVertexBlock(const uint8_t* data, const uint8_t* end, const MeshFileHeader& header, uint32_t firstVertex, float* vertices)
+{
+	const uint32_t blockVertices = std::min(MESH_VERTEX_BLOCK_SIZE, header.verticesNumber - firstVertex);
+
+	// Planes of block fit into scratch arena of worker, they are unpacked in whole groups of 16
+	ArenaScope arenaScope;
+	ArenaVector<uint8_t> planes(MESH_VERTEX_PLANES * MESH_VERTEX_BLOCK_SIZE);
+
+	for(uint32_t plane=0; plane<MESH_VERTEX_PLANES; plane++)
+	{
+		if(!decodePlane(data, end, blockVertices, &planes[plane * MESH_VERTEX_BLOCK_SIZE]))
+		{
+			return false;
+		}
+	}
+
+	float* output = vertices + static_cast<size_t>(firstVertex) * MESH_VERTEX_COMPONENTS;
+
+#ifdef YAS_MATH_SSE
+	// Eight vertices at once. Register of component holds it for eight vertices, prefix sum turns deltas into values
+	// and transposition gives register per vertex whose eight lanes are its components.
+	const __m128 offsetsLow = _mm_loadu_ps(&header.offsets[0]);
+	const __m128 offsetsHigh = _mm_loadu_ps(&header.offsets[4]);
+	const __m128 scalesLow = _mm_loadu_ps(&header.scales[0]);
+	const __m128 scalesHigh = _mm_loadu_ps(&header.scales[4]);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	__m128i previous[MESH_VERTEX_COMPONENTS];
+	for(uint32_t c=0; c<MESH_VERTEX_COMPONENTS; c++)
+	{
+		previous[c] = zero;
+	}
+
+	for(uint32_t v=0; v<blockVertices; v+=8)
+	{
+		__m128i values[MESH_VERTEX_COMPONENTS];
+		for(uint32_t c=0; c<MESH_VERTEX_COMPONENTS; c++)
+		{
+			__m128i low = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&planes[(2 * c) * MESH_VERTEX_BLOCK_SIZE + v]));
+			__m128i high = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&planes[(2 * c + 1) * MESH_VERTEX_BLOCK_SIZE + v]));
+			__m128i zigzag = _mm_unpacklo_epi8(low, high);
+			__m128i delta = _mm_xor_si128(_mm_srli_epi16(zigzag, 1), _mm_sub_epi16(zero, _mm_and_si128(zigzag, one)));
+
+			delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 2));
+			delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 4));
+			delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 8));
+			values[c] = _mm_add_epi16(delta, previous[c]);
+
+			// Last vertex in every lane is base of next eight
+			__m128i last = _mm_shufflehi_epi16(values[c], 0xFF);
+			previous[c] = _mm_unpackhi_epi64(last, last);
+		}
+
+		__m128i t0 = _mm_unpacklo_epi16(values[0], values[1]);
+		__m128i t1 = _mm_unpackhi_epi16(values[0], values[1]);
+		__m128i t2 = _mm_unpacklo_epi16(values[2], values[3]);
+		__m128i t3 = _mm_unpackhi_epi16(values[2], values[3]);
+		__m128i t4 = _mm_unpacklo_epi16(values[4], values[5]);
+		__m128i t5 = _mm_unpackhi_epi16(values[4], values[5]);
+		__m128i t6 = _mm_unpacklo_epi16(values[6], values[7]);
+		__m128i t7 = _mm_unpackhi_epi16(values[6], values[7]);
+		__m128i u0 = _mm_unpacklo_epi32(t0, t2);
+		__m128i u1 = _mm_unpackhi_epi32(t0, t2);
+		__m128i u2 = _mm_unpacklo_epi32(t1, t3);
+		__m128i u3 = _mm_unpackhi_epi32(t1, t3);
+		__m128i u4 = _mm_unpacklo_epi32(t4, t6);
+		__m128i u5 = _mm_unpackhi_epi32(t4, t6);
+		__m128i u6 = _mm_unpacklo_epi32(t5, t7);
+		__m128i u7 = _mm_unpackhi_epi32(t5, t7);
+		__m128i vertexValues[8] =
+		{
+			_mm_unpacklo_epi64(u0, u4), _mm_unpackhi_epi64(u0, u4), _mm_unpacklo_epi64(u1, u5), _mm_unpackhi_epi64(u1, u5),
+			_mm_unpacklo_epi64(u2, u6), _mm_unpackhi_epi64(u2, u6), _mm_unpacklo_epi64(u3, u7), _mm_unpackhi_epi64(u3, u7)
+		};
+
+		// Padding after last vertex of block is decoded but not stored
+		const uint32_t vertexCount = std::min(8U, blockVertices - v);
+		for(uint32_t j=0; j<vertexCount; j++)
+		{
+			__m128 low = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(vertexValues[j], zero)), scalesLow), offsetsLow);
+			__m128 high = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(vertexValues[j], zero)), scalesHigh), offsetsHigh);
+			_mm_storeu_ps(output + (v + j) * MESH_VERTEX_COMPONENTS, low);
+			_mm_storeu_ps(output + (v + j) * MESH_VERTEX_COMPONENTS + 4, high);
+		}
+	}
+#else
+	uint16_t previous[MESH_VERTEX_COMPONENTS] = {};
+
+	for(uint32_t v=0; v<blockVertices; v++)
+	{
+		for(uint32_t c=0; c<MESH_VERTEX_COMPONENTS; c++)
+		{
+			uint16_t zigzag = static_cast<uint16_t>(planes[(2 * c) * MESH_VERTEX_BLOCK_SIZE + v] | (planes[(2 * c + 1) * MESH_VERTEX_BLOCK_SIZE + v] << 8));
+			previous[c] = static_cast<uint16_t>(previous[c] + ((zigzag >> 1) ^ (0 - (zigzag & 1))));
+			output[v * MESH_VERTEX_COMPONENTS + c] = static_cast<float>(previous[c]) * header.scales[c] + header.offsets[c];
+		}
+	}
+#endif
+	return true;
+}
+
+bool MeshCodec::decodeIndexBlock(const uint8_t* data, const uint8_t* end, uint32_t verticesNumber, uint32_t* indices, uint32_t indicesNumber)
+{
+	uint32_t previous = 0;
+
+	for(uint32_t i=0; i<indicesNumber; i++)
+	{
+		if(data == end)
+		{
+			return false;
+		}
+
+		// After vertex fetch optimization most deltas fit into one byte
+		uint32_t value = *data++;
+
+		if(value & 0x80)
+		{
+			value &= 0x7F;
+			uint32_t shift = 7;
+			uint8_t byte;
+
+			do
+			{
+				if(data == end || shift > 28)
+				{
+					return false;
+				}
+				byte = *data++;
+				value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+				shift += 7;
+			}
+			while(byte & 0x80);
+		}
+
+		previous += (value >> 1) ^ (0 - (value & 1));
+
+		// Index outside of mesh would make GPU read outside of its vertices
+		if(previous >= verticesNumber)
+		{
+			return false;
+		}
+		indices[i] = previous;
+	}
+	return true;
+}
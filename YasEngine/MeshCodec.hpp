@@ -0,0 +1,69 @@
+#ifndef MESHCODEC_HPP
+#define MESHCODEC_HPP
+#include"stdafx.hpp"
+#include"VariousTools.hpp"
+#include"JobSystem.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Compressed mesh is stored next to OBJ it was converted from
+const char* const MESH_FILE_EXTENSION		= ".ymesh";
+const uint32_t MESH_FILE_MAGIC				= 0x48534D59; // "YMSH"
+const uint32_t MESH_FILE_VERSION			= 2;
+// Vertex is decoded as eight floats: position, color and texture coordinates
+const uint32_t MESH_VERTEX_COMPONENTS		= 8;
+// Blocks are decoded by separate jobs, deltas start from zero in every block
+const uint32_t MESH_VERTEX_BLOCK_SIZE		= 4096;
+const uint32_t MESH_INDEX_BLOCK_SIZE		= 3 * 16384;
+// Size of post transform vertex cache triangles are ordered for
+const uint32_t VERTEX_CACHE_SIZE			= 32;
+
+static_assert(sizeof(Vertex) == MESH_VERTEX_COMPONENTS * sizeof(float), "Vertex is decoded as eight floats");
+
+// File layout: header, offsets of vertex blocks, offsets of index blocks, then blocks.
+// Both offset tables have one more entry than blocks, last one is end of last block. Offsets are from start of file.
+struct MeshFileHeader
+{
+	uint32_t						magic;
+	uint32_t						version;
+	uint32_t						verticesNumber;
+	uint32_t						indicesNumber;
+	// Size and modification time of OBJ file mesh was converted from, OBJ with either changed is converted again
+	uint64_t						sourceSize;
+	uint64_t						sourceModificationTime;
+	uint32_t						vertexBlocksNumber;
+	uint32_t						indexBlocksNumber;
+	// Component c of vertex is offsets[c] + quantized * scales[c]
+	float							offsets[MESH_VERTEX_COMPONENTS];
+	float							scales[MESH_VERTEX_COMPONENTS];
+};
+
+// Lossy mesh codec. Vertex components are quantized to 16 bits within bounds of mesh, indices are kept exactly.
+// Indices are deltas of previous index, zigzag and varint encoded. Vertex components are deltas of previous vertex,
+// split into planes of low and high bytes and every 16 bytes of plane are packed with 0, 2, 4 or 8 bits per byte.
+class MeshCodec
+{
+	public:
+
+		// Tom Forsyth's linear speed vertex cache optimization. Reorders triangles, mesh stays the same.
+		static void						optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t verticesNumber);
+		// Vertices are renumbered in order of first use, unused ones are dropped. Index deltas become small after it.
+		static void						optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// Optimizes mesh in place and writes whole file into data
+		static void						encode(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint64_t sourceSize, uint64_t sourceModificationTime, std::vector<char>& data);
+		// Returns nullptr when data is not mesh file of current version or its tables are truncated
+		static const MeshFileHeader*	readHeader(const char* data, size_t size);
+		// Decodes blocks on all workers straight into given memory. Throws when data is corrupted.
+		static void						decode(const char* data, size_t size, JobSystem& jobSystem, Vertex* vertices, uint32_t* indices);
+
+	private:
+
+		static void						encodePlane(const uint8_t* plane, uint32_t size, std::vector<char>& data);
+		// Returns false when data ends before plane
+		static bool						decodePlane(const uint8_t*& data, const uint8_t* end, uint32_t size, uint8_t* plane);
+		static bool						decodeVertexBlock(const uint8_t* data, const uint8_t* end, const MeshFileHeader& header, uint32_t firstVertex, float* vertices);
+		static bool						decodeIndexBlock(const uint8_t* data, const uint8_t* end, uint32_t verticesNumber, uint32_t* indices, uint32_t indicesNumber);
+};
+
+#endif
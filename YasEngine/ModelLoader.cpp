@@ -0,0 +1,184 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+#include"stdafx.hpp"
+#include"ModelLoader.hpp"
+#include"CpuProfiler.hpp"
+#include<filesystem>
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+void ModelLoader::loadObj(const std::string& fileName, JobSystem& jobSystem, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	YAS_PROFILE_FUNCTION();
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string tinyobjLoadingError;
+	std::string tinyobjLoadingWarnings;
+	
+	if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &tinyobjLoadingWarnings, &tinyobjLoadingError, fileName.c_str()))
+	{
+		throw std::runtime_error(tinyobjLoadingError);
+	}
+
+	weldCorners(attrib, shapes, jobSystem, vertices, indices);
+}
+
+void ModelLoader::weldCorners(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, JobSystem& jobSystem, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	YAS_PROFILE_FUNCTION();
+
+	// Corners of all faces in file order
+	std::vector<const tinyobj::index_t*> objIndices;
+	for(const auto& shape: shapes)
+	{
+		for(const auto& index: shape.mesh.indices)
+		{
+			objIndices.push_back(&index);
+		}
+	}
+
+	const uint32_t cornersNumber = static_cast<uint32_t>(objIndices.size());
+	std::vector<Vertex> corners(cornersNumber);
+	std::vector<uint32_t> cornerShards(cornersNumber);
+
+	jobSystem.parallelFor(0, cornersNumber, MODEL_CORNERS_GRAIN, [&](uint32_t begin, uint32_t end)
+	{
+		for(uint32_t i=begin; i<end; i++)
+		{
+			const tinyobj::index_t& index = *objIndices[i];
+			Vertex& vertex = corners[i];
+
+			vertex.pos =
+			{
+				attrib.vertices[3 * index.vertex_index + 0],
+				attrib.vertices[3 * index.vertex_index + 1],
+				attrib.vertices[3 * index.vertex_index + 2]
+			};
+
+			vertex.texCoord =
+			{
+				attrib.texcoords[2 * index.texcoord_index + 0],
+				1.0F - attrib.texcoords[2 * index.texcoord_index + 1]
+			};
+
+			vertex.color = {1.0F, 1.0F, 1.0F};
+
+			// Top bits of mixed hash, equal vertices always land in the same shard
+			cornerShards[i] = static_cast<uint32_t>((static_cast<uint64_t>(std::hash<Vertex>()(vertex)) * 0x9E3779B97F4A7C15ULL) >> 58);
+		}
+	});
+
+	// Counting sort by shard keeps file order inside shard, so result does not depend on number of workers
+	std::vector<uint32_t> shardStarts(MODEL_DEDUP_SHARDS + 1, 0);
+	for(uint32_t shard: cornerShards)
+	{
+		++shardStarts[shard + 1];
+	}
+	for(uint32_t i=0; i<MODEL_DEDUP_SHARDS; i++)
+	{
+		shardStarts[i + 1] += shardStarts[i];
+	}
+
+	std::vector<uint32_t> cornersByShard(cornersNumber);
+	std::vector<uint32_t> shardFill(shardStarts.begin(), shardStarts.end() - 1);
+	for(uint32_t i=0; i<cornersNumber; i++)
+	{
+		cornersByShard[shardFill[cornerShards[i]]++] = i;
+	}
+
+	std::vector<std::vector<Vertex>> shardVertices(MODEL_DEDUP_SHARDS);
+	std::vector<uint32_t> localIndices(cornersNumber);
+
+	jobSystem.parallelFor(0, MODEL_DEDUP_SHARDS, 1, [&](uint32_t firstShard, uint32_t endShard)
+	{
+		for(uint32_t shard=firstShard; shard<endShard; shard++)
+		{
+			std::unordered_map<Vertex, uint32_t> uniqueVertices;
+			uniqueVertices.reserve(shardStarts[shard + 1] - shardStarts[shard]);
+
+			for(uint32_t i=shardStarts[shard]; i<shardStarts[shard + 1]; i++)
+			{
+				uint32_t corner = cornersByShard[i];
+				std::pair<std::unordered_map<Vertex, uint32_t>::iterator, bool> result = uniqueVertices.emplace(corners[corner], static_cast<uint32_t>(shardVertices[shard].size()));
+				if(result.second)
+				{
+					shardVertices[shard].push_back(corners[corner]);
+				}
+				localIndices[corner] = result.first->second;
+			}
+		}
+	});
+
+	// Vertices of shard follow vertices of all previous shards
+	std::vector<uint32_t> shardOffsets(MODEL_DEDUP_SHARDS, 0);
+	for(uint32_t i=1; i<MODEL_DEDUP_SHARDS; i++)
+	{
+		shardOffsets[i] = shardOffsets[i - 1] + static_cast<uint32_t>(shardVertices[i - 1].size());
+	}
+
+	vertices.resize(shardOffsets[MODEL_DEDUP_SHARDS - 1] + shardVertices[MODEL_DEDUP_SHARDS - 1].size());
+	indices.resize(cornersNumber);
+
+	jobSystem.parallelFor(0, MODEL_DEDUP_SHARDS, 1, [&](uint32_t firstShard, uint32_t endShard)
+	{
+		for(uint32_t shard=firstShard; shard<endShard; shard++)
+		{
+			std::copy(shardVertices[shard].begin(), shardVertices[shard].end(), vertices.begin() + shardOffsets[shard]);
+		}
+	});
+
+	jobSystem.parallelFor(0, cornersNumber, MODEL_CORNERS_GRAIN, [&](uint32_t begin, uint32_t end)
+	{
+		for(uint32_t i=begin; i<end; i++)
+		{
+			indices[i] = shardOffsets[cornerShards[i]] + localIndices[i];
+		}
+	});
+}
+
+std::string ModelLoader::getMeshFileName(const std::string& objFileName)
+{
+	return objFileName.substr(0, objFileName.find_last_of('.')) + MESH_FILE_EXTENSION;
+}
+
+uint64_t ModelLoader::getFileSize(const std::string& fileName)
+{
+	std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+
+	if(!file.is_open())
+	{
+		return 0;
+	}
+	return static_cast<uint64_t>(file.tellg());
+}
+
+uint64_t ModelLoader::getFileModificationTime(const std::string& fileName)
+{
+	std::error_code error;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(fileName, error);
+
+	if(error)
+	{
+		return 0;
+	}
+	return static_cast<uint64_t>(time.time_since_epoch().count());
+}
+
+void ModelLoader::convertObj(const std::string& objFileName, const std::string& meshFileName, JobSystem& jobSystem)
+{
+	YAS_PROFILE_FUNCTION();
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	loadObj(objFileName, jobSystem, vertices, indices);
+
+	std::vector<char> data;
+	MeshCodec::encode(vertices, indices, getFileSize(objFileName), getFileModificationTime(objFileName), data);
+
+	std::ofstream meshFile(meshFileName, std::ios::binary | std::ios::trunc);
+
+	if(!meshFile.is_open())
+	{
+		throw std::runtime_error("Failed to create mesh file " + meshFileName);
+	}
+	meshFile.write(data.data(), data.size());
+}
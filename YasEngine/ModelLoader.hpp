@@ -0,0 +1,33 @@
+#ifndef MODELLOADER_HPP
+#define MODELLOADER_HPP
+#include"stdafx.hpp"
+#include"VariousTools.hpp"
+#include"JobSystem.hpp"
+#include"MeshCodec.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Model vertices are deduplicated in shards selected by vertex hash, each shard by one job
+const uint32_t MODEL_DEDUP_SHARDS			= 64;
+const uint32_t MODEL_CORNERS_GRAIN			= 16384;
+
+// Loads OBJ files without Vulkan, so it can run on workers and in benchmarks
+class ModelLoader
+{
+	public:
+
+		// Parses file and welds its corners. Throws when file can not be read.
+		static void						loadObj(const std::string& fileName, JobSystem& jobSystem, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		// Equal corners get one vertex. Result is the same for any number of workers, vertices are in order of first use within shard.
+		static void						weldCorners(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, JobSystem& jobSystem, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		// Compressed mesh file next to OBJ file, with the same name and MESH_FILE_EXTENSION
+		static std::string				getMeshFileName(const std::string& objFileName);
+		// Returns 0 when file does not exist
+		static uint64_t					getFileSize(const std::string& fileName);
+		// Ticks of file clock, only compared with earlier value of the same file. Returns 0 when file does not exist.
+		static uint64_t					getFileModificationTime(const std::string& fileName);
+		// Loads OBJ, reorders it for vertex cache and writes it compressed
+		static void						convertObj(const std::string& objFileName, const std::string& meshFileName, JobSystem& jobSystem);
+};
+
+#endif
@@ -0,0 +1,444 @@
+#include"stdafx.hpp"
+#include"OcclusionCulling.hpp"
+#include"CpuProfiler.hpp"
+#if defined(__AVX2__)
+#include<immintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+OcclusionCuller::OcclusionCuller()
+{
+	jobSystem = nullptr;
+	statistics = {};
+
+	uint32_t width = OCCLUSION_BUFFER_WIDTH;
+	uint32_t height = OCCLUSION_BUFFER_HEIGHT;
+
+	while(true)
+	{
+		depthPyramid.push_back(std::vector<float>(width * height, 1.0F));
+		depthPyramidWidths.push_back(width);
+		depthPyramidHeights.push_back(height);
+
+		if(width == 1 && height == 1)
+		{
+			break;
+		}
+		width = std::max(width / 2, 1U);
+		height = std::max(height / 2, 1U);
+	}
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+void OcclusionCuller::initialize(JobSystem* jobSystem)
+{
+	this->jobSystem = jobSystem;
+}
+
+void OcclusionCuller::cull(const std::vector<glm::mat4>& modelViewProjections, const std::vector<RenderObject>& renderObjects, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<uint32_t>& visibleObjects)
+{
+	YAS_PROFILE_FUNCTION();
+	std::chrono::steady_clock::time_point rasterizationStart = std::chrono::steady_clock::now();
+
+	clearDepthBuffer();
+
+	for(size_t i=0; i<renderObjects.size(); i++)
+	{
+		if(renderObjects[i].isOccluder)
+		{
+			addOccluder(modelViewProjections[i], renderObjects[i], vertices, indices);
+		}
+	}
+
+	statistics.occluderTriangles = static_cast<uint32_t>(screenTriangles.size());
+	rasterizeTiles();
+	buildDepthPyramid();
+
+	std::chrono::steady_clock::time_point testStart = std::chrono::steady_clock::now();
+
+	visibleObjects.clear();
+	statistics.testedObjects = static_cast<uint32_t>(renderObjects.size());
+	statistics.culledObjects = 0;
+
+	for(size_t i=0; i<renderObjects.size(); i++)
+	{
+		if(isVisible(modelViewProjections[i], renderObjects[i].boundsMin, renderObjects[i].boundsMax))
+		{
+			visibleObjects.push_back(static_cast<uint32_t>(i));
+		}
+		else
+		{
+			++statistics.culledObjects;
+		}
+	}
+
+	std::chrono::steady_clock::time_point testEnd = std::chrono::steady_clock::now();
+	statistics.rasterizationMilliseconds = std::chrono::duration<double, std::milli>(testStart - rasterizationStart).count();
+	statistics.testMilliseconds = std::chrono::duration<double, std::milli>(testEnd - testStart).count();
+}
+
+void OcclusionCuller::clearDepthBuffer()
+{
+	std::fill(depthPyramid[0].begin(), depthPyramid[0].end(), 1.0F);
+	screenTriangles.clear();
+
+	for(std::vector<uint32_t>& tileBin: tileBins)
+	{
+		tileBin.clear();
+	}
+}
+
+void OcclusionCuller::addOccluder(const glm::mat4& modelViewProjection, const RenderObject& renderObject, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	for(uint32_t i=0; i+2<renderObject.indexCount; i+=3)
+	{
+		ScreenTriangle triangle;
+		bool isClipped = false;
+
+		for(int j=0; j<3; j++)
+		{
+			const Vertex& vertex = vertices[renderObject.vertexOffset + indices[renderObject.firstIndex + i + j]];
+			glm::vec4 clip = modelViewProjection * glm::vec4(vertex.pos, 1.0F);
+
+			// Triangle crossing near plane is dropped. Missing occluder can only make culling less effective never wrong.
+			if(clip.w <= 0.0F || clip.z < 0.0F)
+			{
+				isClipped = true;
+				break;
+			}
+
+			float inverseW = 1.0F / clip.w;
+			triangle.x[j] = (clip.x * inverseW * 0.5F + 0.5F) * OCCLUSION_BUFFER_WIDTH;
+			triangle.y[j] = (clip.y * inverseW * 0.5F + 0.5F) * OCCLUSION_BUFFER_HEIGHT;
+			triangle.z[j] = std::min(clip.z * inverseW, 1.0F);
+		}
+
+		if(isClipped)
+		{
+			continue;
+		}
+
+		float minX = std::min({triangle.x[0], triangle.x[1], triangle.x[2]});
+		float maxX = std::max({triangle.x[0], triangle.x[1], triangle.x[2]});
+		float minY = std::min({triangle.y[0], triangle.y[1], triangle.y[2]});
+		float maxY = std::max({triangle.y[0], triangle.y[1], triangle.y[2]});
+
+		if(maxX < 0.0F || maxY < 0.0F || minX >= OCCLUSION_BUFFER_WIDTH || minY >= OCCLUSION_BUFFER_HEIGHT)
+		{
+			continue;
+		}
+
+		uint32_t triangleIndex = static_cast<uint32_t>(screenTriangles.size());
+		screenTriangles.push_back(triangle);
+
+		// Triangle goes to every tile which its bounding rectangle touches
+		int firstTileX = std::max(static_cast<int>(minX) / static_cast<int>(OCCLUSION_TILE_WIDTH), 0);
+		int lastTileX = std::min(static_cast<int>(maxX) / static_cast<int>(OCCLUSION_TILE_WIDTH), static_cast<int>(OCCLUSION_TILES_X) - 1);
+		int firstTileY = std::max(static_cast<int>(minY) / static_cast<int>(OCCLUSION_TILE_HEIGHT), 0);
+		int lastTileY = std::min(static_cast<int>(maxY) / static_cast<int>(OCCLUSION_TILE_HEIGHT), static_cast<int>(OCCLUSION_TILES_Y) - 1);
+
+		for(int tileY=firstTileY; tileY<=lastTileY; tileY++)
+		{
+			for(int tileX=firstTileX; tileX<=lastTileX; tileX++)
+			{
+				tileBins[tileY * OCCLUSION_TILES_X + tileX].push_back(triangleIndex);
+			}
+		}
+	}
+}
+
+void OcclusionCuller::rasterizeTiles()
+{
+	// Tiles write to disjoint parts of depth buffer. Each tile is own job because their costs differ a lot.
+	jobSystem->parallelFor(0, OCCLUSION_TILES_NUMBER, 1, [this](uint32_t firstTile, uint32_t endTile)
+	{
+		for(uint32_t tileIndex=firstTile; tileIndex<endTile; tileIndex++)
+		{
+			rasterizeTile(tileIndex);
+		}
+	});
+}
+
+void OcclusionCuller::rasterizeTile(uint32_t tileIndex)
+{
+	YAS_PROFILE_FUNCTION();
+	int tileMinX = (tileIndex % OCCLUSION_TILES_X) * OCCLUSION_TILE_WIDTH;
+	int tileMinY = (tileIndex / OCCLUSION_TILES_X) * OCCLUSION_TILE_HEIGHT;
+	int tileMaxX = tileMinX + OCCLUSION_TILE_WIDTH - 1;
+	int tileMaxY = tileMinY + OCCLUSION_TILE_HEIGHT - 1;
+
+	for(uint32_t triangleIndex: tileBins[tileIndex])
+	{
+		rasterizeTriangle(screenTriangles[triangleIndex], tileMinX, tileMinY, tileMaxX, tileMaxY);
+	}
+}
+
+void OcclusionCuller::rasterizeTriangle(const ScreenTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+{
+	float x0 = triangle.x[0], y0 = triangle.y[0], z0 = triangle.z[0];
+	float x1 = triangle.x[1], y1 = triangle.y[1], z1 = triangle.z[1];
+	float x2 = triangle.x[2], y2 = triangle.y[2], z2 = triangle.z[2];
+
+	float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+
+	// Occluders are rasterized from both sides so winding is made positive
+	if(area < 0.0F)
+	{
+		std::swap(x1, x2);
+		std::swap(y1, y2);
+		std::swap(z1, z2);
+		area = -area;
+	}
+
+	if(area < 1e-6F)
+	{
+		return;
+	}
+
+	int minX = std::max(static_cast<int>(std::floor(std::min({x0, x1, x2}))), tileMinX);
+	int maxX = std::min(static_cast<int>(std::ceil(std::max({x0, x1, x2}))), tileMaxX);
+	int minY = std::max(static_cast<int>(std::floor(std::min({y0, y1, y2}))), tileMinY);
+	int maxY = std::min(static_cast<int>(std::ceil(std::max({y0, y1, y2}))), tileMaxY);
+
+	if(minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	// Edge functions w = a*x + b*y + c. Sum of all three is equal to triangle area.
+	float a0 = y1 - y2, b0 = x2 - x1, c0 = -a0 * x1 - b0 * y1;
+	float a1 = y2 - y0, b1 = x0 - x2, c1 = -a1 * x2 - b1 * y2;
+	float a2 = y0 - y1, b2 = x1 - x0, c2 = -a2 * x0 - b2 * y0;
+
+	// Depth divided by area so z = w0*z0 + w1*z1 + w2*z2 without division per pixel
+	float inverseArea = 1.0F / area;
+	z0 *= inverseArea;
+	z1 *= inverseArea;
+	z2 *= inverseArea;
+
+	float* depthBuffer = depthPyramid[0].data();
+
+#if defined(__AVX2__)
+	// Start of row is aligned to 8 pixels. Tile borders are multiple of 8 so whole vector stays in this tile.
+	int startX = minX & ~7;
+	const __m256 laneOffsets = _mm256_setr_ps(0.5F, 1.5F, 2.5F, 3.5F, 4.5F, 5.5F, 6.5F, 7.5F);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 edgeA0 = _mm256_set1_ps(a0);
+	const __m256 edgeA1 = _mm256_set1_ps(a1);
+	const __m256 edgeA2 = _mm256_set1_ps(a2);
+	const __m256 depth0 = _mm256_set1_ps(z0);
+	const __m256 depth1 = _mm256_set1_ps(z1);
+	const __m256 depth2 = _mm256_set1_ps(z2);
+
+	for(int y=minY; y<=maxY; y++)
+	{
+		float pixelY = y + 0.5F;
+		const __m256 rowW0 = _mm256_set1_ps(b0 * pixelY + c0);
+		const __m256 rowW1 = _mm256_set1_ps(b1 * pixelY + c1);
+		const __m256 rowW2 = _mm256_set1_ps(b2 * pixelY + c2);
+		float* row = depthBuffer + y * OCCLUSION_BUFFER_WIDTH;
+
+		for(int x=startX; x<=maxX; x+=8)
+		{
+			__m256 pixelX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets);
+			__m256 w0 = _mm256_add_ps(_mm256_mul_ps(edgeA0, pixelX), rowW0);
+			__m256 w1 = _mm256_add_ps(_mm256_mul_ps(edgeA1, pixelX), rowW1);
+			__m256 w2 = _mm256_add_ps(_mm256_mul_ps(edgeA2, pixelX), rowW2);
+
+			__m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ), _mm256_cmp_ps(w1, zero, _CMP_GE_OQ)), _mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+
+			if(_mm256_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m256 depth = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, depth0), _mm256_mul_ps(w1, depth1)), _mm256_mul_ps(w2, depth2));
+			__m256 previousDepth = _mm256_loadu_ps(row + x);
+			__m256 nearestDepth = _mm256_min_ps(previousDepth, depth);
+			_mm256_storeu_ps(row + x, _mm256_blendv_ps(previousDepth, nearestDepth, inside));
+		}
+	}
+#else
+	for(int y=minY; y<=maxY; y++)
+	{
+		float pixelY = y + 0.5F;
+		float* row = depthBuffer + y * OCCLUSION_BUFFER_WIDTH;
+
+		for(int x=minX; x<=maxX; x++)
+		{
+			float pixelX = x + 0.5F;
+			float w0 = a0 * pixelX + b0 * pixelY + c0;
+			float w1 = a1 * pixelX + b1 * pixelY + c1;
+			float w2 = a2 * pixelX + b2 * pixelY + c2;
+
+			if(w0 >= 0.0F && w1 >= 0.0F && w2 >= 0.0F)
+			{
+				float depth = w0 * z0 + w1 * z1 + w2 * z2;
+				row[x] = std::min(row[x], depth);
+			}
+		}
+	}
+#endif
+}
+
+void OcclusionCuller::buildDepthPyramid()
+{
+	for(size_t level=1; level<depthPyramid.size(); level++)
+	{
+		const std::vector<float>& source = depthPyramid[level - 1];
+		std::vector<float>& destination = depthPyramid[level];
+		uint32_t sourceWidth = depthPyramidWidths[level - 1];
+		uint32_t sourceHeight = depthPyramidHeights[level - 1];
+		uint32_t width = depthPyramidWidths[level];
+		uint32_t height = depthPyramidHeights[level];
+
+		for(uint32_t y=0; y<height; y++)
+		{
+			uint32_t sourceY0 = std::min(y * 2, sourceHeight - 1);
+			uint32_t sourceY1 = std::min(y * 2 + 1, sourceHeight - 1);
+
+			for(uint32_t x=0; x<width; x++)
+			{
+				uint32_t sourceX0 = std::min(x * 2, sourceWidth - 1);
+				uint32_t sourceX1 = std::min(x * 2 + 1, sourceWidth - 1);
+
+				// Farthest depth is kept so test against this level is conservative
+				destination[y * width + x] = std::max(
+					std::max(source[sourceY0 * sourceWidth + sourceX0], source[sourceY0 * sourceWidth + sourceX1]),
+					std::max(source[sourceY1 * sourceWidth + sourceX0], source[sourceY1 * sourceWidth + sourceX1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::isVisible(const glm::mat4& modelViewProjection, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = -std::numeric_limits<float>::max();
+	float maxY = -std::numeric_limits<float>::max();
+	float minZ = 1.0F;
+
+	for(int i=0; i<8; i++)
+	{
+		glm::vec3 corner((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z);
+		glm::vec4 clip = modelViewProjection * glm::vec4(corner, 1.0F);
+
+		// Box crossing near plane covers large part of screen and is treated as visible
+		if(clip.w <= 0.0F || clip.z < 0.0F)
+		{
+			return true;
+		}
+
+		float inverseW = 1.0F / clip.w;
+		float x = (clip.x * inverseW * 0.5F + 0.5F) * OCCLUSION_BUFFER_WIDTH;
+		float y = (clip.y * inverseW * 0.5F + 0.5F) * OCCLUSION_BUFFER_HEIGHT;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		minZ = std::min(minZ, clip.z * inverseW);
+	}
+
+	// Outside of screen
+	if(maxX < 0.0F || maxY < 0.0F || minX >= OCCLUSION_BUFFER_WIDTH || minY >= OCCLUSION_BUFFER_HEIGHT)
+	{
+		return false;
+	}
+
+	uint32_t x0 = static_cast<uint32_t>(std::max(minX, 0.0F));
+	uint32_t y0 = static_cast<uint32_t>(std::max(minY, 0.0F));
+	uint32_t x1 = static_cast<uint32_t>(std::min(maxX, static_cast<float>(OCCLUSION_BUFFER_WIDTH - 1)));
+	uint32_t y1 = static_cast<uint32_t>(std::min(maxY, static_cast<float>(OCCLUSION_BUFFER_HEIGHT - 1)));
+
+	// Level on which rectangle covers at most 2x2 texels
+	size_t level = 0;
+	while(level + 1 < depthPyramid.size() && (((x1 >> level) - (x0 >> level)) > 1 || ((y1 >> level) - (y0 >> level)) > 1))
+	{
+		++level;
+	}
+
+	uint32_t width = depthPyramidWidths[level];
+	uint32_t height = depthPyramidHeights[level];
+	float maxDepth = 0.0F;
+
+	for(uint32_t y = y0 >> level; y <= std::min(y1 >> level, height - 1); y++)
+	{
+		for(uint32_t x = x0 >> level; x <= std::min(x1 >> level, width - 1); x++)
+		{
+			maxDepth = std::max(maxDepth, depthPyramid[level][y * width + x]);
+		}
+	}
+
+	return minZ <= maxDepth;
+}
+
+void createBoxMesh(float halfSize, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	vertices.clear();
+	indices.clear();
+
+	for(int axis=0; axis<3; axis++)
+	{
+		for(int side=0; side<2; side++)
+		{
+			uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+
+			for(int corner=0; corner<4; corner++)
+			{
+				float u = (corner == 1 || corner == 2) ? 1.0F : 0.0F;
+				float v = (corner >= 2) ? 1.0F : 0.0F;
+
+				Vertex vertex = {};
+				vertex.pos[axis] = side ? halfSize : -halfSize;
+				vertex.pos[(axis + 1) % 3] = (u * 2.0F - 1.0F) * halfSize;
+				vertex.pos[(axis + 2) % 3] = (v * 2.0F - 1.0F) * halfSize;
+				vertex.color = glm::vec3(1.0F, 1.0F, 1.0F);
+				vertex.texCoord = glm::vec2(u, v);
+				vertices.push_back(vertex);
+			}
+
+			const uint32_t faceIndices[6] = {0, 1, 2, 2, 3, 0};
+			for(uint32_t faceIndex: faceIndices)
+			{
+				indices.push_back(firstVertex + faceIndex);
+			}
+		}
+	}
+}
+
+// Same camera as computeViewProjection, looking from (2, 2, 2) at origin with z up
+static void getCameraAxes(glm::vec3& forward, glm::vec3& right, glm::vec3& up)
+{
+	forward = glm::normalize(glm::vec3(-2.0F, -2.0F, -2.0F));
+	right = glm::normalize(glm::cross(forward, glm::vec3(0.0F, 0.0F, 1.0F)));
+	up = glm::cross(right, forward);
+}
+
+glm::vec3 computeOccluderWallPosition()
+{
+	glm::vec3 forward, right, up;
+	getCameraAxes(forward, right, up);
+
+	// Between camera and model, moved to the side so model stays visible
+	return forward * -1.2F + right * 0.7F;
+}
+
+glm::vec3 computeOccludedBoxPosition(uint32_t index)
+{
+	glm::vec3 forward, right, up;
+	getCameraAxes(forward, right, up);
+
+	const uint32_t BOXES_IN_ROW = 4;
+	const float BOX_SPACING = 0.06F;
+	uint32_t column = index % BOXES_IN_ROW;
+	uint32_t row = (index / BOXES_IN_ROW) % BOXES_IN_ROW;
+	uint32_t layer = index / (BOXES_IN_ROW * BOXES_IN_ROW);
+	float offset = (BOXES_IN_ROW - 1) * 0.5F;
+
+	return computeOccluderWallPosition() + forward * (0.5F + 0.1F * layer) + right * ((column - offset) * BOX_SPACING) + up * ((row - offset) * BOX_SPACING);
+}
@@ -0,0 +1,83 @@
+#ifndef OCCLUSIONCULLING_HPP
+#define OCCLUSIONCULLING_HPP
+#include"stdafx.hpp"
+#include"VariousTools.hpp"
+#include"JobSystem.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Software depth buffer is small on purpose. Occluders only need to hide whole objects not pixels.
+const uint32_t OCCLUSION_BUFFER_WIDTH		= 256;
+const uint32_t OCCLUSION_BUFFER_HEIGHT		= 128;
+// Tile width must be multiple of 8 so AVX2 rows never cross tile border
+const uint32_t OCCLUSION_TILE_WIDTH			= 64;
+const uint32_t OCCLUSION_TILE_HEIGHT		= 32;
+const uint32_t OCCLUSION_TILES_X			= OCCLUSION_BUFFER_WIDTH / OCCLUSION_TILE_WIDTH;
+const uint32_t OCCLUSION_TILES_Y			= OCCLUSION_BUFFER_HEIGHT / OCCLUSION_TILE_HEIGHT;
+const uint32_t OCCLUSION_TILES_NUMBER		= OCCLUSION_TILES_X * OCCLUSION_TILES_Y;
+
+// Test scene seen by engine camera: wall occluder in front of the model hides grid of small boxes behind it.
+// Added only by headless --occluded-boxes and occlusion benchmark, default number is the one benchmark uses.
+const float OCCLUDER_WALL_HALF_SIZE			= 0.35F;
+const float OCCLUDED_BOX_HALF_SIZE			= 0.02F;
+const uint32_t DEFAULT_OCCLUDED_BOXES_NUMBER	= 64;
+
+struct OcclusionStatistics
+{
+	uint32_t						occluderTriangles;
+	uint32_t						testedObjects;
+	uint32_t						culledObjects;
+	double							rasterizationMilliseconds;
+	double							testMilliseconds;
+};
+
+// CPU occlusion culling. Occluders are rasterized into low resolution depth buffer (tiles in parallel),
+// then bounding boxes of objects are tested against hierarchical depth pyramid built from it.
+class OcclusionCuller
+{
+	public:
+
+										OcclusionCuller();
+										~OcclusionCuller();
+		// Tiles are rasterized in parallel by jobs
+		void							initialize(JobSystem* jobSystem);
+		// Fills visibleObjects with indices of objects which are not hidden behind occluders.
+		// Model view projection matrix of every render object comes from TransformBatch.
+		void							cull(const std::vector<glm::mat4>& modelViewProjections, const std::vector<RenderObject>& renderObjects, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<uint32_t>& visibleObjects);
+		bool							isVisible(const glm::mat4& modelViewProjection, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+		OcclusionStatistics				statistics;
+
+	private:
+
+		struct ScreenTriangle
+		{
+			float x[3];
+			float y[3];
+			float z[3];
+		};
+
+		void							clearDepthBuffer();
+		void							addOccluder(const glm::mat4& modelViewProjection, const RenderObject& renderObject, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+		void							rasterizeTiles();
+		void							rasterizeTile(uint32_t tileIndex);
+		void							rasterizeTriangle(const ScreenTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+		void							buildDepthPyramid();
+
+		std::vector<ScreenTriangle>		screenTriangles;
+		std::array<std::vector<uint32_t>, OCCLUSION_TILES_NUMBER> tileBins;
+		// Level 0 is depth buffer to which occluders are rasterized. Next levels keep farthest depth of 2x2 texels.
+		std::vector<std::vector<float>>	depthPyramid;
+		std::vector<uint32_t>			depthPyramidWidths;
+		std::vector<uint32_t>			depthPyramidHeights;
+
+		JobSystem*						jobSystem;
+};
+
+// Cube with own vertices for every face so texture coordinates are not shared between faces
+void createBoxMesh(float halfSize, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+glm::vec3 computeOccluderWallPosition();
+// Boxes are placed in layers of 4x4 behind the wall along view direction
+glm::vec3 computeOccludedBoxPosition(uint32_t index);
+
+#endif
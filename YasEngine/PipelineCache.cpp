@@ -0,0 +1,497 @@
+#include"stdafx.hpp"
+#include"PipelineCache.hpp"
+#include"Clock.hpp"
+#include"CpuProfiler.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Variants without instancing, default one first so variation 0 is default state
+static const uint32_t VARIATION_VARIANTS[] = {DEFAULT_SHADER_VARIANT, 0, SHADER_FEATURE_VERTEX_COLOR, SHADER_FEATURE_VERTEX_COLOR | SHADER_FEATURE_TEXTURING,
+	SHADER_FEATURE_TEXTURING | SHADER_FEATURE_ALPHA_TEST, SHADER_FEATURE_ALPHA_TEST, SHADER_FEATURE_VERTEX_COLOR | SHADER_FEATURE_ALPHA_TEST,
+	SHADER_FEATURE_VERTEX_COLOR | SHADER_FEATURE_TEXTURING | SHADER_FEATURE_ALPHA_TEST};
+static const VkCullModeFlags VARIATION_CULL_MODES[] = {VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_NONE, VK_CULL_MODE_FRONT_BIT};
+static const PipelineBlendMode VARIATION_BLEND_MODES[] = {PIPELINE_BLEND_OPAQUE, PIPELINE_BLEND_ALPHA, PIPELINE_BLEND_ADDITIVE};
+static const VkCompareOp VARIATION_DEPTH_COMPARE_OPS[] = {VK_COMPARE_OP_LESS, VK_COMPARE_OP_LESS_OR_EQUAL};
+static const VkFrontFace VARIATION_FRONT_FACES[] = {VK_FRONT_FACE_COUNTER_CLOCKWISE, VK_FRONT_FACE_CLOCKWISE};
+
+PipelineCache::PipelineCache()
+{
+	device = VK_NULL_HANDLE;
+	shaderVariantCache = nullptr;
+	driverCache = VK_NULL_HANDLE;
+	compilingNumber = 0;
+	nextEntryId = 0;
+	stopping = false;
+	statistics = {};
+}
+
+PipelineCache::~PipelineCache()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	queueCondition.notify_all();
+
+	for(std::thread& thread: threads)
+	{
+		thread.join();
+	}
+}
+
+void PipelineCache::initialize(VkDevice device, ShaderVariantCache& shaderVariantCache)
+{
+	this->device = device;
+	this->shaderVariantCache = &shaderVariantCache;
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	if(vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &driverCache) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline cache");
+	}
+
+	// Render thread and job system workers keep their cores, compilation takes what is left
+	uint32_t threadsNumber = std::thread::hardware_concurrency() > 2 ? std::thread::hardware_concurrency() - 2 : 1;
+	threadsNumber = std::min(threadsNumber, PIPELINE_COMPILE_MAX_THREADS);
+
+	stopping = false;
+	for(uint32_t i=0; i<threadsNumber; i++)
+	{
+		threads.push_back(std::thread([this]()
+		{
+			YAS_PROFILE_THREAD_NAME("Pipeline compilation");
+			compileLoop();
+		}));
+	}
+}
+
+void PipelineCache::destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.clear();
+		stopping = true;
+	}
+	queueCondition.notify_all();
+
+	for(std::thread& thread: threads)
+	{
+		thread.join();
+	}
+	threads.clear();
+
+	// Exception from compile thread does not matter anymore when everything is destroyed
+	exception = nullptr;
+	destroyPipelines();
+
+	vkDestroyPipelineCache(device, driverCache, nullptr);
+	driverCache = VK_NULL_HANDLE;
+}
+
+PipelineCache::Entry* PipelineCache::findOrAddEntry(const PipelineState& state, bool& added)
+{
+	const uint64_t hash = hashState(state);
+	std::pair<std::unordered_multimap<uint64_t, Entry>::iterator, std::unordered_multimap<uint64_t, Entry>::iterator> range = entries.equal_range(hash);
+
+	for(std::unordered_multimap<uint64_t, Entry>::iterator entry = range.first; entry != range.second; ++entry)
+	{
+		if(std::memcmp(&entry->second.state, &state, sizeof(PipelineState)) == 0)
+		{
+			added = false;
+			return &entry->second;
+		}
+	}
+
+	Entry entry = {};
+	entry.state = state;
+	entry.pipeline = VK_NULL_HANDLE;
+	entry.id = nextEntryId++;
+	entry.failed = false;
+	added = true;
+	return &entries.insert({hash, entry})->second;
+}
+
+VkPipeline PipelineCache::requestPipeline(const PipelineState& state)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	rethrowException();
+
+	bool added;
+	Entry* entry = findOrAddEntry(state, added);
+
+	if(added)
+	{
+		queue.push_back(entry);
+		lock.unlock();
+		queueCondition.notify_one();
+		return VK_NULL_HANDLE;
+	}
+	return entry->pipeline;
+}
+
+VkPipeline PipelineCache::getPipeline(const PipelineState& state)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	bool added;
+	Entry* entry = findOrAddEntry(state, added);
+
+	if(!added && entry->pipeline == VK_NULL_HANDLE && !entry->failed)
+	{
+		// Queued state is taken over instead of waiting for compile threads to get to it
+		std::deque<Entry*>::iterator queued = std::find(queue.begin(), queue.end(), entry);
+
+		if(queued != queue.end())
+		{
+			queue.erase(queued);
+			added = true;
+		}
+	}
+
+	if(added)
+	{
+		compilingNumber++;
+		lock.unlock();
+		std::exception_ptr compileException = compileEntry(entry, false);
+
+		if(compileException)
+		{
+			std::rethrow_exception(compileException);
+		}
+		return entry->pipeline;
+	}
+
+	compiledCondition.wait(lock, [entry] { return entry->pipeline != VK_NULL_HANDLE || entry->failed; });
+
+	if(entry->failed)
+	{
+		throw std::runtime_error("Failed to create graphics pipeline");
+	}
+	return entry->pipeline;
+}
+
+void PipelineCache::precompile(const std::vector<PipelineState>& states)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for(const PipelineState& state: states)
+		{
+			bool added;
+			Entry* entry = findOrAddEntry(state, added);
+
+			if(added)
+			{
+				queue.push_back(entry);
+			}
+		}
+	}
+	queueCondition.notify_all();
+}
+
+void PipelineCache::waitForCompilation()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	compiledCondition.wait(lock, [this] { return queue.empty() && compilingNumber == 0; });
+	rethrowException();
+}
+
+void PipelineCache::destroyPipelines()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	queue.clear();
+	// Pipeline which is being compiled still points to its entry
+	compiledCondition.wait(lock, [this] { return compilingNumber == 0; });
+
+	for(const std::pair<const uint64_t, Entry>& entry: entries)
+	{
+		if(entry.second.pipeline != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(device, entry.second.pipeline, nullptr);
+		}
+	}
+	entries.clear();
+	nextEntryId = 0;
+	statistics.pipelinesNumber = 0;
+}
+
+PipelineCacheStatistics PipelineCache::getStatistics()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+uint32_t PipelineCache::getPipelineId(const PipelineState& state)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::pair<std::unordered_multimap<uint64_t, Entry>::iterator, std::unordered_multimap<uint64_t, Entry>::iterator> range = entries.equal_range(hashState(state));
+
+	for(std::unordered_multimap<uint64_t, Entry>::iterator entry = range.first; entry != range.second; ++entry)
+	{
+		if(std::memcmp(&entry->second.state, &state, sizeof(PipelineState)) == 0)
+		{
+			return entry->second.id;
+		}
+	}
+	throw std::runtime_error("Pipeline state was not requested");
+}
+
+void PipelineCache::rethrowException()
+{
+	if(exception)
+	{
+		std::exception_ptr pendingException = exception;
+		exception = nullptr;
+		std::rethrow_exception(pendingException);
+	}
+}
+
+void PipelineCache::compileLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while(true)
+	{
+		queueCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+
+		if(stopping)
+		{
+			return;
+		}
+
+		Entry* entry = queue.front();
+		queue.pop_front();
+		// Counted before unlocking so destroyPipelines can not free entry in between
+		compilingNumber++;
+
+		lock.unlock();
+		compileEntry(entry, true);
+		lock.lock();
+	}
+}
+
+std::exception_ptr PipelineCache::compileEntry(Entry* entry, bool background)
+{
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	std::exception_ptr compileException;
+	int64_t compileStart = Clock::nanoseconds();
+
+	try
+	{
+		pipeline = createPipeline(entry->state);
+	}
+	catch(...)
+	{
+		compileException = std::current_exception();
+	}
+
+	int64_t compileNanoseconds = Clock::nanoseconds() - compileStart;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		entry->pipeline = pipeline;
+		entry->failed = compileException != nullptr;
+		compilingNumber--;
+
+		if(compileException)
+		{
+			// Exception of compile thread waits for render thread, blocking caller gets it returned
+			if(background && !exception)
+			{
+				exception = compileException;
+			}
+		}
+		else
+		{
+			statistics.pipelinesNumber++;
+			(background ? statistics.backgroundCompilations : statistics.blockingCompilations)++;
+			statistics.compileNanoseconds += compileNanoseconds;
+			statistics.maxCompileNanoseconds = std::max(statistics.maxCompileNanoseconds, compileNanoseconds);
+		}
+	}
+	compiledCondition.notify_all();
+	return compileException;
+}
+
+VkPipeline PipelineCache::createPipeline(const PipelineState& state)
+{
+	YAS_PROFILE_FUNCTION();
+	VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
+	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertShaderStageInfo.module = shaderVariantCache->getShaderModule(VK_SHADER_STAGE_VERTEX_BIT, state.variantKey);
+	vertShaderStageInfo.pName = "main";
+
+	ShaderSpecializationData specializationData = ShaderVariantCache::getSpecializationData(state.variantKey);
+	std::array<VkSpecializationMapEntry, 2> specializationMapEntries = ShaderVariantCache::getSpecializationMapEntries();
+
+	VkSpecializationInfo specializationInfo = {};
+	specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationMapEntries.size());
+	specializationInfo.pMapEntries = specializationMapEntries.data();
+	specializationInfo.dataSize = sizeof(specializationData);
+	specializationInfo.pData = &specializationData;
+
+	VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
+	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragShaderStageInfo.module = shaderVariantCache->getShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, state.variantKey);
+	fragShaderStageInfo.pName = "main";
+	fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+	VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+	ShaderVariantCache::getVertexInputDescriptions(state.variantKey, bindingDescriptions, attributeDescriptions);
+
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputInfo.pVertexAttributeDescriptions =  attributeDescriptions.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = state.topology;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	// Only counts are part of pipeline, viewport and scissor are set when command buffer is recorded
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+	std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicState.pDynamicStates = dynamicStates.data();
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;
+	rasterizer.polygonMode = state.polygonMode;
+	rasterizer.lineWidth = 1.0F;
+	rasterizer.cullMode = state.cullMode;
+	rasterizer.frontFace = state.frontFace;
+	rasterizer.depthBiasEnable = VK_FALSE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.sampleShadingEnable = VK_FALSE;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo = {};
+	pipelineDepthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	pipelineDepthStencilStateCreateInfo.depthTestEnable = state.depthTestEnable;
+	pipelineDepthStencilStateCreateInfo.depthWriteEnable = state.depthWriteEnable;
+	pipelineDepthStencilStateCreateInfo.depthCompareOp = state.depthCompareOp;
+	pipelineDepthStencilStateCreateInfo.depthBoundsTestEnable = VK_FALSE;
+	pipelineDepthStencilStateCreateInfo.minDepthBounds = 0.0F;
+	pipelineDepthStencilStateCreateInfo.maxDepthBounds = 1.0F;
+	pipelineDepthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
+	pipelineDepthStencilStateCreateInfo.front = {};
+	pipelineDepthStencilStateCreateInfo.back = {};
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = state.blendMode == PIPELINE_BLEND_OPAQUE ? VK_FALSE : VK_TRUE;
+	colorBlendAttachment.srcColorBlendFactor = state.blendMode == PIPELINE_BLEND_ALPHA ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstColorBlendFactor = state.blendMode == PIPELINE_BLEND_ALPHA ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.logicOpEnable = VK_FALSE;
+	colorBlending.logicOp = VK_LOGIC_OP_COPY;
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+	colorBlending.blendConstants[0] = 0.0F;
+	colorBlending.blendConstants[1] = 0.0F;
+	colorBlending.blendConstants[2] = 0.0F;
+	colorBlending.blendConstants[3] = 0.0F;
+
+	VkGraphicsPipelineCreateInfo graphicsPiplineCreateInfo = {};
+	graphicsPiplineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	graphicsPiplineCreateInfo.stageCount = 2;
+	graphicsPiplineCreateInfo.pStages = shaderStages;
+	graphicsPiplineCreateInfo.pVertexInputState = &vertexInputInfo;
+	graphicsPiplineCreateInfo.pInputAssemblyState = &inputAssembly;
+	graphicsPiplineCreateInfo.pViewportState = &viewportState;
+	graphicsPiplineCreateInfo.pRasterizationState = &rasterizer;
+	graphicsPiplineCreateInfo.pMultisampleState = &multisampling;
+	graphicsPiplineCreateInfo.pColorBlendState = &colorBlending;
+	graphicsPiplineCreateInfo.pDynamicState = &dynamicState;
+	graphicsPiplineCreateInfo.layout = state.pipelineLayout;
+	graphicsPiplineCreateInfo.renderPass = state.renderPass;
+	graphicsPiplineCreateInfo.subpass = state.subpass;
+	graphicsPiplineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+	graphicsPiplineCreateInfo.pDepthStencilState = &pipelineDepthStencilStateCreateInfo;
+
+	VkPipeline pipeline;
+
+	// Pipeline cache object is internally synchronized, compile threads share it
+	if(vkCreateGraphicsPipelines(device, driverCache, 1, &graphicsPiplineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create graphics pipeline");
+	}
+
+	return pipeline;
+}
+
+//static function
+uint64_t PipelineCache::hashState(const PipelineState& state)
+{
+	return ShaderVariantCache::hashCode(reinterpret_cast<const char*>(&state), sizeof(PipelineState));
+}
+
+//static function
+PipelineState PipelineCache::getDefaultState(uint32_t variantKey)
+{
+	PipelineState state;
+	std::memset(&state, 0, sizeof(PipelineState));
+	state.variantKey = variantKey;
+	state.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	state.polygonMode = VK_POLYGON_MODE_FILL;
+	state.cullMode = VK_CULL_MODE_BACK_BIT;
+	state.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	state.depthTestEnable = VK_TRUE;
+	state.depthWriteEnable = VK_TRUE;
+	state.depthCompareOp = VK_COMPARE_OP_LESS;
+	state.blendMode = PIPELINE_BLEND_OPAQUE;
+	return state;
+}
+
+//static function
+PipelineState PipelineCache::getVariationState(uint32_t index)
+{
+	// Index is read as mixed radix number, one digit per varied field
+	PipelineState state = getDefaultState(VARIATION_VARIANTS[index % std::size(VARIATION_VARIANTS)]);
+	index /= static_cast<uint32_t>(std::size(VARIATION_VARIANTS));
+	state.cullMode = VARIATION_CULL_MODES[index % std::size(VARIATION_CULL_MODES)];
+	index /= static_cast<uint32_t>(std::size(VARIATION_CULL_MODES));
+	state.blendMode = VARIATION_BLEND_MODES[index % std::size(VARIATION_BLEND_MODES)];
+	index /= static_cast<uint32_t>(std::size(VARIATION_BLEND_MODES));
+	state.depthCompareOp = VARIATION_DEPTH_COMPARE_OPS[index % std::size(VARIATION_DEPTH_COMPARE_OPS)];
+	index /= static_cast<uint32_t>(std::size(VARIATION_DEPTH_COMPARE_OPS));
+	state.frontFace = VARIATION_FRONT_FACES[index % std::size(VARIATION_FRONT_FACES)];
+	// Blended materials do not hide what is drawn after them
+	state.depthWriteEnable = state.blendMode == PIPELINE_BLEND_OPAQUE ? VK_TRUE : VK_FALSE;
+	return state;
+}
+
+//static function
+uint32_t PipelineCache::getVariationsNumber()
+{
+	return static_cast<uint32_t>(std::size(VARIATION_VARIANTS) * std::size(VARIATION_CULL_MODES) * std::size(VARIATION_BLEND_MODES)
+		* std::size(VARIATION_DEPTH_COMPARE_OPS) * std::size(VARIATION_FRONT_FACES));
+}
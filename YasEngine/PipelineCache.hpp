@@ -0,0 +1,122 @@
+#ifndef PIPELINECACHE_HPP
+#define PIPELINECACHE_HPP
+#include"stdafx.hpp"
+#include"ShaderVariants.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Compile threads never draw, so pipelines are created while frames are recorded without stealing render thread time
+const uint32_t PIPELINE_COMPILE_MAX_THREADS	= 4;
+
+// Each mode maps to complete color blend attachment state
+enum PipelineBlendMode
+{
+	PIPELINE_BLEND_OPAQUE				= 0,
+	PIPELINE_BLEND_ALPHA				= 1,
+	PIPELINE_BLEND_ADDITIVE				= 2
+};
+
+// Everything graphics pipeline is created from. Shaders, vertex layout and specialization constants follow from variant key.
+// Viewport and scissor are dynamic so pipelines do not depend on swapchain extent, only on compatible render pass.
+// Struct has no padding, it is hashed and compared as bytes. Zero whole struct before filling it.
+struct PipelineState
+{
+	VkRenderPass					renderPass;
+	VkPipelineLayout				pipelineLayout;
+	uint32_t						subpass;
+	uint32_t						variantKey;
+	VkPrimitiveTopology				topology;
+	VkPolygonMode					polygonMode;
+	VkCullModeFlags					cullMode;
+	VkFrontFace						frontFace;
+	VkBool32						depthTestEnable;
+	VkBool32						depthWriteEnable;
+	VkCompareOp						depthCompareOp;
+	PipelineBlendMode				blendMode;
+};
+
+static_assert(sizeof(PipelineState) == 2 * sizeof(VkRenderPass) + 10 * sizeof(uint32_t), "PipelineState must not have padding");
+
+// Counters since initialize, compile times are measured around vkCreateGraphicsPipelines
+struct PipelineCacheStatistics
+{
+	uint32_t						pipelinesNumber;
+	uint32_t						backgroundCompilations;
+	uint32_t						blockingCompilations;
+	int64_t							compileNanoseconds;
+	int64_t							maxCompileNanoseconds;
+};
+
+// Pipelines keyed by hash of their complete state. Missing pipeline is either compiled on calling thread or queued for compile threads,
+// in which case caller draws with fallback until it is ready. All methods are thread safe.
+class PipelineCache
+{
+	public:
+
+										PipelineCache();
+										~PipelineCache();
+		// Shader variant cache must stay alive until destroy
+		void							initialize(VkDevice device, ShaderVariantCache& shaderVariantCache);
+		void							destroy();
+
+		// Never blocks. Queues compilation on first request and returns VK_NULL_HANDLE until pipeline is ready.
+		// Exception thrown by compilation is rethrown here or by waitForCompilation.
+		VkPipeline						requestPipeline(const PipelineState& state);
+		// Compiles on calling thread when pipeline was not requested yet, otherwise waits for it
+		VkPipeline						getPipeline(const PipelineState& state);
+		// Queues every state which is not in cache yet
+		void							precompile(const std::vector<PipelineState>& states);
+		// Returns when queue is empty and no thread compiles
+		void							waitForCompilation();
+		// Pipelines depend on render pass and layout so they are destroyed with swapchain. Queued states are dropped.
+		void							destroyPipelines();
+		PipelineCacheStatistics			getStatistics();
+		// Small number of pipeline of requested state, render queue sorts by it. The same until pipelines are destroyed.
+		uint32_t						getPipelineId(const PipelineState& state);
+
+		static uint64_t					hashState(const PipelineState& state);
+		// Opaque triangles with back face culling and depth test, the state scene was drawn with before materials
+		static PipelineState			getDefaultState(uint32_t variantKey);
+		// Distinct states of variants without instancing, which all read the same vertex buffer. Index 0 is default state.
+		static PipelineState			getVariationState(uint32_t index);
+		static uint32_t					getVariationsNumber();
+
+	private:
+
+		struct Entry
+		{
+			PipelineState				state;
+			VkPipeline					pipeline;
+			uint32_t					id;
+			bool						failed;
+		};
+
+		// Mutex has to be locked. Added is set when entry did not exist.
+		Entry*							findOrAddEntry(const PipelineState& state, bool& added);
+		// Called without lock after compilingNumber was increased for entry. Stores result into entry and returns exception thrown by compilation.
+		std::exception_ptr				compileEntry(Entry* entry, bool background);
+		VkPipeline						createPipeline(const PipelineState& state);
+		void							compileLoop();
+		// Mutex has to be locked
+		void							rethrowException();
+
+		VkDevice						device;
+		ShaderVariantCache*				shaderVariantCache;
+		// Lets driver reuse compiled shaders between pipelines of the same variant
+		VkPipelineCache					driverCache;
+		// Entries with equal hash are compared as bytes. Elements of multimap do not move, so queue points at them.
+		std::unordered_multimap<uint64_t, Entry> entries;
+		std::deque<Entry*>				queue;
+		uint32_t						compilingNumber;
+		// Id of next added entry, ids start from 0 again when pipelines are destroyed
+		uint32_t						nextEntryId;
+		bool							stopping;
+		std::mutex						mutex;
+		std::condition_variable			queueCondition;
+		std::condition_variable			compiledCondition;
+		std::vector<std::thread>		threads;
+		std::exception_ptr				exception;
+		PipelineCacheStatistics			statistics;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include"stdafx.hpp"
+#include"RenderQueue.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+uint64_t makeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depthBucket)
+{
+	uint64_t key = pass & ((1U << SORT_KEY_PASS_BITS) - 1);
+	key = (key << SORT_KEY_PIPELINE_BITS) | (pipeline & ((1U << SORT_KEY_PIPELINE_BITS) - 1));
+	key = (key << SORT_KEY_MATERIAL_BITS) | (material & ((1U << SORT_KEY_MATERIAL_BITS) - 1));
+	key = (key << SORT_KEY_MESH_BITS) | (mesh & ((1U << SORT_KEY_MESH_BITS) - 1));
+	key = (key << SORT_KEY_DEPTH_BITS) | (depthBucket & ((1U << SORT_KEY_DEPTH_BITS) - 1));
+	return key;
+}
+
+uint32_t quantizeDepth(float viewDepth, float nearPlane, float farPlane)
+{
+	const float maxBucket = static_cast<float>((1U << SORT_KEY_DEPTH_BITS) - 1);
+	float normalized = (viewDepth - nearPlane) / (farPlane - nearPlane);
+
+	// Also catches NaN of degenerate matrices
+	if(!(normalized > 0.0F))
+	{
+		return 0;
+	}
+	return normalized >= 1.0F ? static_cast<uint32_t>(maxBucket) : static_cast<uint32_t>(normalized * maxBucket);
+}
+
+void RenderQueue::clear(LinearArena& frameArena, size_t expectedPackets)
+{
+	// Arrays of previous frame are not freed one by one, their memory goes back when that arena is reset
+	drawPackets = ArenaVector<DrawPacket>(ArenaAllocator<DrawPacket>(frameArena));
+	sortKeys = ArenaVector<uint64_t>(ArenaAllocator<uint64_t>(frameArena));
+	packetIndices = ArenaVector<uint32_t>(ArenaAllocator<uint32_t>(frameArena));
+	sortKeysTemp = ArenaVector<uint64_t>(ArenaAllocator<uint64_t>(frameArena));
+	packetIndicesTemp = ArenaVector<uint32_t>(ArenaAllocator<uint32_t>(frameArena));
+
+	drawPackets.reserve(expectedPackets);
+	sortKeys.reserve(expectedPackets);
+	packetIndices.reserve(expectedPackets);
+}
+
+void RenderQueue::submit(const DrawPacket& drawPacket)
+{
+	sortKeys.push_back(drawPacket.sortKey);
+	packetIndices.push_back(static_cast<uint32_t>(drawPackets.size()));
+	drawPackets.push_back(drawPacket);
+}
+
+size_t RenderQueue::size() const
+{
+	return drawPackets.size();
+}
+
+void RenderQueue::sort()
+{
+	radixSort(sortKeys, packetIndices, sortKeysTemp, packetIndicesTemp);
+}
+
+void RenderQueue::radixSort(ArenaVector<uint64_t>& keys, ArenaVector<uint32_t>& values, ArenaVector<uint64_t>& keysTemp, ArenaVector<uint32_t>& valuesTemp)
+{
+	const size_t count = keys.size();
+
+	if(count < 2)
+	{
+		return;
+	}
+
+	keysTemp.resize(count);
+	valuesTemp.resize(count);
+
+	// All eight histograms are built in one read of the keys
+	std::array<std::array<uint32_t, 256>, 8> histograms = {};
+
+	for(size_t i=0; i<count; i++)
+	{
+		uint64_t key = keys[i];
+		for(int pass=0; pass<8; pass++)
+		{
+			++histograms[pass][(key >> (pass * 8)) & 0xFF];
+		}
+	}
+
+	uint64_t* sourceKeys = keys.data();
+	uint32_t* sourceValues = values.data();
+	uint64_t* destinationKeys = keysTemp.data();
+	uint32_t* destinationValues = valuesTemp.data();
+
+	for(int pass=0; pass<8; pass++)
+	{
+		std::array<uint32_t, 256>& histogram = histograms[pass];
+		const uint32_t shift = pass * 8;
+
+		// Every key has the same digit in this pass so order would not change
+		if(histogram[(sourceKeys[0] >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for(uint32_t& bucket: histogram)
+		{
+			uint32_t bucketSize = bucket;
+			bucket = offset;
+			offset += bucketSize;
+		}
+
+		for(size_t i=0; i<count; i++)
+		{
+			uint32_t destination = histogram[(sourceKeys[i] >> shift) & 0xFF]++;
+			destinationKeys[destination] = sourceKeys[i];
+			destinationValues[destination] = sourceValues[i];
+		}
+
+		std::swap(sourceKeys, destinationKeys);
+		std::swap(sourceValues, destinationValues);
+	}
+
+	// Odd number of executed passes leaves result in temporary arrays
+	if(sourceKeys != keys.data())
+	{
+		keys.swap(keysTemp);
+		values.swap(valuesTemp);
+	}
+}
+
+RenderQueueStatistics RenderQueue::record(VkCommandBuffer commandBuffer)
+{
+	RenderQueueStatistics statistics = {};
+
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkPipelineLayout boundPipelineLayout = VK_NULL_HANDLE;
+	VkDescriptorSet boundDescriptorSet = VK_NULL_HANDLE;
+	VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+
+	for(uint32_t packetIndex: packetIndices)
+	{
+		const DrawPacket& packet = drawPackets[packetIndex];
+
+		if(packet.pipeline != boundPipeline)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipeline);
+			boundPipeline = packet.pipeline;
+			++statistics.pipelineBinds;
+		}
+		else
+		{
+			++statistics.skippedBinds;
+		}
+
+		// Set bound with different pipeline layout is not guaranteed to stay compatible so it is bound again
+		if(packet.descriptorSet != boundDescriptorSet || packet.pipelineLayout != boundPipelineLayout)
+		{
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipelineLayout, 0, 1, &packet.descriptorSet, 0, nullptr);
+			boundDescriptorSet = packet.descriptorSet;
+			boundPipelineLayout = packet.pipelineLayout;
+			++statistics.descriptorSetBinds;
+		}
+		else
+		{
+			++statistics.skippedBinds;
+		}
+
+		if(packet.vertexBuffer != boundVertexBuffer)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &packet.vertexBuffer, &offset);
+			boundVertexBuffer = packet.vertexBuffer;
+			++statistics.vertexBufferBinds;
+		}
+		else
+		{
+			++statistics.skippedBinds;
+		}
+
+		if(packet.indexBuffer != boundIndexBuffer)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, packet.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			boundIndexBuffer = packet.indexBuffer;
+			++statistics.indexBufferBinds;
+		}
+		else
+		{
+			++statistics.skippedBinds;
+		}
+
+		vkCmdPushConstants(commandBuffer, packet.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstantObject), &packet.pushConstantObject);
+		vkCmdDrawIndexed(commandBuffer, packet.indexCount, 1, packet.firstIndex, packet.vertexOffset, 0);
+		++statistics.drawCalls;
+	}
+
+	return statistics;
+}
@@ -0,0 +1,72 @@
+#ifndef RENDERQUEUE_HPP
+#define RENDERQUEUE_HPP
+#include"stdafx.hpp"
+#include"YasMathLib.hpp"
+#include"Arena.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Bit layout of 64 bit sort key from most to least significant bits:
+// pass(4) | pipeline(12) | material(16) | mesh(16) | depth bucket(16)
+// Sorting by key groups draws which share state so redundant binds can be skipped during recording.
+const uint32_t SORT_KEY_PASS_BITS			= 4;
+const uint32_t SORT_KEY_PIPELINE_BITS		= 12;
+const uint32_t SORT_KEY_MATERIAL_BITS		= 16;
+const uint32_t SORT_KEY_MESH_BITS			= 16;
+const uint32_t SORT_KEY_DEPTH_BITS			= 16;
+
+uint64_t makeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depthBucket);
+// Depth bucket of view depth between planes, nearer objects get smaller buckets so opaque draws go front to back
+uint32_t quantizeDepth(float viewDepth, float nearPlane, float farPlane);
+
+// Everything needed to record one indexed draw.
+struct DrawPacket
+{
+	uint64_t						sortKey;
+	VkPipeline						pipeline;
+	VkPipelineLayout				pipelineLayout;
+	VkDescriptorSet					descriptorSet;
+	VkBuffer						vertexBuffer;
+	VkBuffer						indexBuffer;
+	uint32_t						indexCount;
+	uint32_t						firstIndex;
+	int32_t							vertexOffset;
+	PushConstantObject				pushConstantObject;
+};
+
+// Number of state changes recorded and skipped during last RenderQueue::record call.
+struct RenderQueueStatistics
+{
+	uint32_t						drawCalls;
+	uint32_t						pipelineBinds;
+	uint32_t						descriptorSetBinds;
+	uint32_t						vertexBufferBinds;
+	uint32_t						indexBufferBinds;
+	uint32_t						skippedBinds;
+};
+
+class RenderQueue
+{
+	public:
+
+		// Packets of previous frame are dropped and new ones go to given arena, it has to live until record is done
+		void							clear(LinearArena& frameArena, size_t expectedPackets);
+		void							submit(const DrawPacket& drawPacket);
+		void							sort();
+		RenderQueueStatistics			record(VkCommandBuffer commandBuffer);
+		size_t							size() const;
+
+		// LSD radix sort by 64 bit key, 8 bits per pass. Stable, passes where all keys share digit are skipped.
+		static void						radixSort(ArenaVector<uint64_t>& keys, ArenaVector<uint32_t>& values, ArenaVector<uint64_t>& keysTemp, ArenaVector<uint32_t>& valuesTemp);
+
+	private:
+
+		ArenaVector<DrawPacket>			drawPackets;
+		// Keys and packet indices are kept in separate arrays so radix sort moves 12 bytes per element instead of whole packets
+		ArenaVector<uint64_t>			sortKeys;
+		ArenaVector<uint32_t>			packetIndices;
+		ArenaVector<uint64_t>			sortKeysTemp;
+		ArenaVector<uint32_t>			packetIndicesTemp;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include"stdafx.hpp"
+#include"ResidencyCache.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+ResidencyCache::ResidencyCache()
+{
+	first = NO_RESIDENT_RESOURCE;
+	last = NO_RESIDENT_RESOURCE;
+	frame = 0;
+	destroyDelayFrames = 0;
+	isOverBudget = false;
+	statistics = {};
+}
+
+void ResidencyCache::initialize(uint64_t budget, uint32_t destroyDelayFrames)
+{
+	resources.clear();
+	pendingDestructions.clear();
+	first = NO_RESIDENT_RESOURCE;
+	last = NO_RESIDENT_RESOURCE;
+	frame = 0;
+	this->destroyDelayFrames = destroyDelayFrames;
+	isOverBudget = false;
+	statistics = {};
+	statistics.budget = budget;
+}
+
+void ResidencyCache::setBudget(uint64_t budget)
+{
+	statistics.budget = budget;
+}
+
+uint32_t ResidencyCache::addResource(uint64_t size)
+{
+	Resource resource = {};
+	resource.size = size;
+	resource.state = RESIDENCY_NOT_RESIDENT;
+	resource.previous = NO_RESIDENT_RESOURCE;
+	resource.next = NO_RESIDENT_RESOURCE;
+	resources.push_back(resource);
+	return static_cast<uint32_t>(resources.size() - 1);
+}
+
+bool ResidencyCache::request(uint32_t resource)
+{
+	Resource& entry = resources[resource];
+
+	if(entry.state == RESIDENCY_RESIDENT)
+	{
+		++statistics.hits;
+
+		if(entry.lastUsedFrame != frame)
+		{
+			entry.lastUsedFrame = frame;
+			unlink(resource);
+			link(resource);
+		}
+		return false;
+	}
+
+	bool isLoaded = entry.state == RESIDENCY_NOT_RESIDENT;
+
+	if(isLoaded)
+	{
+		++statistics.misses;
+	}
+	else
+	{
+		// Still in memory, its pending destruction is skipped
+		++statistics.hits;
+		statistics.evictedSize -= entry.size;
+	}
+
+	entry.state = RESIDENCY_RESIDENT;
+	entry.lastUsedFrame = frame;
+	link(resource);
+	statistics.residentSize += entry.size;
+	++statistics.residentNumber;
+	evict();
+	statistics.peakResidentSize = std::max(statistics.peakResidentSize, statistics.residentSize);
+	return isLoaded;
+}
+
+void ResidencyCache::advanceFrame(std::vector<uint32_t>& destroyedResources)
+{
+	++frame;
+	isOverBudget = false;
+
+	while(!pendingDestructions.empty() && pendingDestructions.front().frame + destroyDelayFrames <= frame)
+	{
+		Resource& entry = resources[pendingDestructions.front().resource];
+
+		if(entry.state == RESIDENCY_EVICTED && entry.evictedFrame == pendingDestructions.front().frame)
+		{
+			entry.state = RESIDENCY_NOT_RESIDENT;
+			statistics.evictedSize -= entry.size;
+			++statistics.destructions;
+			destroyedResources.push_back(pendingDestructions.front().resource);
+		}
+		pendingDestructions.pop_front();
+	}
+
+	// Resources of frame over budget or lowered budget are evicted before new frame uses anything, hits do not evict
+	evict();
+}
+
+ResidencyState ResidencyCache::getState(uint32_t resource) const
+{
+	return resources[resource].state;
+}
+
+double ResidencyCache::getHitRate() const
+{
+	uint64_t requests = statistics.hits + statistics.misses;
+
+	if(requests == 0)
+	{
+		return 1.0;
+	}
+	return static_cast<double>(statistics.hits) / requests;
+}
+
+ResidencyStatistics ResidencyCache::getStatistics() const
+{
+	ResidencyStatistics result = statistics;
+	result.resourcesNumber = static_cast<uint32_t>(resources.size());
+	return result;
+}
+
+void ResidencyCache::link(uint32_t resource)
+{
+	Resource& entry = resources[resource];
+	entry.previous = NO_RESIDENT_RESOURCE;
+	entry.next = first;
+
+	if(first != NO_RESIDENT_RESOURCE)
+	{
+		resources[first].previous = resource;
+	}
+	else
+	{
+		last = resource;
+	}
+	first = resource;
+}
+
+void ResidencyCache::unlink(uint32_t resource)
+{
+	Resource& entry = resources[resource];
+
+	if(entry.previous != NO_RESIDENT_RESOURCE)
+	{
+		resources[entry.previous].next = entry.next;
+	}
+	else
+	{
+		first = entry.next;
+	}
+
+	if(entry.next != NO_RESIDENT_RESOURCE)
+	{
+		resources[entry.next].previous = entry.previous;
+	}
+	else
+	{
+		last = entry.previous;
+	}
+	entry.previous = NO_RESIDENT_RESOURCE;
+	entry.next = NO_RESIDENT_RESOURCE;
+}
+
+void ResidencyCache::evict()
+{
+	while(statistics.residentSize > statistics.budget)
+	{
+		// List is ordered by last use, so once its end was used in this frame every resident resource was
+		if(last == NO_RESIDENT_RESOURCE || resources[last].lastUsedFrame == frame)
+		{
+			if(!isOverBudget)
+			{
+				isOverBudget = true;
+				++statistics.overBudgetFrames;
+			}
+			return;
+		}
+
+		uint32_t resource = last;
+		Resource& entry = resources[resource];
+		unlink(resource);
+		entry.state = RESIDENCY_EVICTED;
+		entry.evictedFrame = frame;
+		statistics.residentSize -= entry.size;
+		statistics.evictedSize += entry.size;
+		--statistics.residentNumber;
+		++statistics.evictions;
+		pendingDestructions.push_back({resource, frame});
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef RESIDENCYCACHE_HPP
+#define RESIDENCYCACHE_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+const uint32_t NO_RESIDENT_RESOURCE			= 0xFFFFFFFF;
+
+enum ResidencyState
+{
+	RESIDENCY_NOT_RESIDENT				= 0,
+	RESIDENCY_RESIDENT					= 1,
+	// Evicted, but frames in flight can still read it, so it is not destroyed yet
+	RESIDENCY_EVICTED					= 2
+};
+
+struct ResidencyStatistics
+{
+	uint64_t						budget;
+	uint64_t						residentSize;
+	uint64_t						peakResidentSize;
+	// Size of evicted resources waiting for destruction. They still hold memory.
+	uint64_t						evictedSize;
+	uint32_t						resourcesNumber;
+	uint32_t						residentNumber;
+	// Counters since initialize. Request of evicted resource before it was destroyed is hit, it is only made resident again.
+	uint64_t						hits;
+	uint64_t						misses;
+	uint64_t						evictions;
+	uint64_t						destructions;
+	// Frames in which resources used by frame alone did not fit into budget
+	uint32_t						overBudgetFrames;
+};
+
+// Decides which resources stay in device memory. It does not own them, it only knows their sizes,
+// so policy can be driven by recorded or simulated trace without device.
+// Resources are kept in list ordered by last use. When loaded resource does not fit into budget, least recently used
+// ones are evicted, but never resources used in current frame. Evicted resource is destroyed by caller
+// only after destroyDelayFrames calls of advanceFrame, when no frame in flight reads it.
+class ResidencyCache
+{
+	public:
+
+										ResidencyCache();
+		// Budget in bytes
+		void							initialize(uint64_t budget, uint32_t destroyDelayFrames);
+		// Smaller budget evicts on next load or next frame
+		void							setBudget(uint64_t budget);
+		// Returns id of resource, which is not resident until it is requested
+		uint32_t						addResource(uint64_t size);
+
+		// Marks resource as used in current frame. Returns true when it is not resident and caller has to load it.
+		// Space for it is made by evicting least recently used resources.
+		bool							request(uint32_t resource);
+		// Appends resources caller has to destroy now. Their ids stay valid and they can be requested again.
+		void							advanceFrame(std::vector<uint32_t>& destroyedResources);
+		ResidencyState					getState(uint32_t resource) const;
+		// Hits of all requests, 1 when nothing was requested yet
+		double							getHitRate() const;
+		ResidencyStatistics				getStatistics() const;
+
+	private:
+
+		struct Resource
+		{
+			uint64_t					size;
+			uint64_t					lastUsedFrame;
+			// Frame of eviction tells apart pending destruction of resource which was made resident and evicted again
+			uint64_t					evictedFrame;
+			ResidencyState				state;
+			// Neighbours in list of resident resources
+			uint32_t					previous;
+			uint32_t					next;
+		};
+
+		struct PendingDestruction
+		{
+			uint32_t					resource;
+			uint64_t					frame;
+		};
+
+		void							link(uint32_t resource);
+		void							unlink(uint32_t resource);
+		void							evict();
+
+		std::vector<Resource>			resources;
+		// Most recently used resident resource is first, least recently used is last
+		uint32_t						first;
+		uint32_t						last;
+		std::deque<PendingDestruction>	pendingDestructions;
+		uint64_t						frame;
+		uint32_t						destroyDelayFrames;
+		// Over budget is counted once per frame
+		bool							isOverBudget;
+		ResidencyStatistics				statistics;
+};
+
+#endif
@@ -0,0 +1,346 @@
+#include"stdafx.hpp"
+#include"ShaderVariants.hpp"
+#include"VariousTools.hpp"
+#include"CpuProfiler.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+ShaderVariantCache::ShaderVariantCache()
+{
+	device = VK_NULL_HANDLE;
+	pack = {};
+}
+
+ShaderVariantCache::~ShaderVariantCache()
+{
+	if(backgroundThread.joinable())
+	{
+		backgroundThread.join();
+	}
+}
+
+void ShaderVariantCache::openShaderPack(const AssetArchive& assetArchive)
+{
+	if(!assetArchive.read(SHADER_PACK_PATH, pack, packBuffer))
+	{
+		if(!shaderPack.open(SHADER_PACK_PATH))
+		{
+			writeShaderPack(SHADER_PACK_PATH);
+
+			if(!shaderPack.open(SHADER_PACK_PATH))
+			{
+				throw std::runtime_error("Failed to open shader pack");
+			}
+		}
+
+		pack.data = shaderPack.data();
+		pack.size = shaderPack.size();
+	}
+
+	loadShaderPack();
+}
+
+void ShaderVariantCache::initialize(VkDevice device)
+{
+	this->device = device;
+
+	if(pack.data == nullptr)
+	{
+		AssetArchive noArchive;
+		openShaderPack(noArchive);
+	}
+}
+
+void ShaderVariantCache::destroy()
+{
+	// Exception from worker does not matter anymore when everything is destroyed
+	if(backgroundThread.joinable())
+	{
+		backgroundThread.join();
+	}
+	backgroundException = nullptr;
+
+	for(const std::pair<const uint64_t, VkShaderModule>& module: modulesByContentHash)
+	{
+		vkDestroyShaderModule(device, module.second, nullptr);
+	}
+	modulesByContentHash.clear();
+	packEntries.clear();
+	pack = {};
+	shaderPack.close();
+	packBuffer.clear();
+}
+
+void ShaderVariantCache::loadShaderPack()
+{
+	const char* packData = pack.data;
+	const size_t packSize = pack.size;
+
+	if(packSize < sizeof(ShaderPackHeader))
+	{
+		throw std::runtime_error("Shader pack is too small");
+	}
+
+	const ShaderPackHeader* header = reinterpret_cast<const ShaderPackHeader*>(packData);
+
+	if(header->magic != SHADER_PACK_MAGIC || header->version != SHADER_PACK_VERSION)
+	{
+		throw std::runtime_error("Shader pack has wrong format, delete it to rebuild");
+	}
+
+	if(packSize < sizeof(ShaderPackHeader) + static_cast<size_t>(header->entriesNumber) * sizeof(ShaderPackEntry))
+	{
+		throw std::runtime_error("Shader pack entries table is truncated");
+	}
+
+	const ShaderPackEntry* entries = reinterpret_cast<const ShaderPackEntry*>(packData + sizeof(ShaderPackHeader));
+	packEntries.clear();
+
+	for(uint32_t i=0; i<header->entriesNumber; i++)
+	{
+		if(static_cast<size_t>(entries[i].offset) + entries[i].size > packSize)
+		{
+			throw std::runtime_error("Shader pack entry points outside of file");
+		}
+		packEntries[entries[i].nameHash] = &entries[i];
+	}
+}
+
+void ShaderVariantCache::writeShaderPack(const std::string& packFileName)
+{
+	std::vector<std::string> fileNames;
+
+	// Every subset of features used by stage, the same files compileShaders.bat produces
+	for(uint32_t mask = VERTEX_SHADER_FEATURES; ; mask = (mask - 1) & VERTEX_SHADER_FEATURES)
+	{
+		fileNames.push_back(getSpirvFileName(VK_SHADER_STAGE_VERTEX_BIT, mask));
+		if(mask == 0)
+		{
+			break;
+		}
+	}
+
+	for(uint32_t mask = FRAGMENT_SHADER_FEATURES; ; mask = (mask - 1) & FRAGMENT_SHADER_FEATURES)
+	{
+		fileNames.push_back(getSpirvFileName(VK_SHADER_STAGE_FRAGMENT_BIT, mask));
+		if(mask == 0)
+		{
+			break;
+		}
+	}
+
+	fileNames.push_back(SKINNING_SHADER_PATH);
+
+	// SPIR-V files are only copied into pack, they are read into scratch arena
+	ArenaScope arenaScope;
+	std::vector<ShaderPackEntry> entries;
+	ArenaVector<ArenaVector<char>> codes;
+
+	for(const std::string& fileName: fileNames)
+	{
+		std::ifstream file(fileName, std::ios::binary);
+
+		// Variant which was not compiled is skipped, it fails only when something asks for it
+		if(!file.is_open())
+		{
+			continue;
+		}
+
+		codes.push_back(readFile(fileName));
+
+		ShaderPackEntry entry = {};
+		entry.nameHash = hashCode(fileName.data(), fileName.size());
+		entry.contentHash = hashCode(codes.back().data(), codes.back().size());
+		entry.size = static_cast<uint32_t>(codes.back().size());
+		entries.push_back(entry);
+	}
+
+	ShaderPackHeader header = {};
+	header.magic = SHADER_PACK_MAGIC;
+	header.version = SHADER_PACK_VERSION;
+	header.entriesNumber = static_cast<uint32_t>(entries.size());
+
+	// vkCreateShaderModule needs code aligned to 4 bytes. Mapped view starts at page boundary.
+	uint32_t offset = static_cast<uint32_t>(sizeof(ShaderPackHeader) + entries.size() * sizeof(ShaderPackEntry));
+	for(ShaderPackEntry& entry: entries)
+	{
+		entry.offset = offset;
+		offset = (offset + entry.size + 3) & ~3U;
+	}
+
+	std::ofstream packFile(packFileName, std::ios::binary | std::ios::trunc);
+
+	if(!packFile.is_open())
+	{
+		throw std::runtime_error("Failed to create shader pack");
+	}
+
+	packFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	packFile.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ShaderPackEntry));
+
+	const char padding[4] = {};
+	for(size_t i=0; i<entries.size(); i++)
+	{
+		packFile.write(codes[i].data(), codes[i].size());
+		packFile.write(padding, ((entries[i].size + 3) & ~3U) - entries[i].size);
+	}
+}
+
+std::string ShaderVariantCache::getSpirvFileName(VkShaderStageFlagBits stage, uint32_t variantKey)
+{
+	// Names must match files produced by compileShaders.bat. Features not used by stage are masked out.
+	if(stage == VK_SHADER_STAGE_COMPUTE_BIT)
+	{
+		return SKINNING_SHADER_PATH;
+	}
+	if(stage == VK_SHADER_STAGE_VERTEX_BIT)
+	{
+		return "Shaders/vert_" + std::to_string(variantKey & VERTEX_SHADER_FEATURES) + ".spv";
+	}
+	return "Shaders/frag_" + std::to_string(variantKey & FRAGMENT_SHADER_FEATURES) + ".spv";
+}
+
+// 64 bit FNV-1a
+uint64_t ShaderVariantCache::hashCode(const char* data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for(size_t i=0; i<size; i++)
+	{
+		hash ^= static_cast<uint8_t>(data[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+VkShaderModule ShaderVariantCache::getShaderModule(VkShaderStageFlagBits stage, uint32_t variantKey)
+{
+	std::string fileName = getSpirvFileName(stage, variantKey);
+	std::unordered_map<uint64_t, const ShaderPackEntry*>::iterator entry = packEntries.find(hashCode(fileName.data(), fileName.size()));
+
+	if(entry == packEntries.end())
+	{
+		throw std::runtime_error("Shader pack does not contain " + fileName);
+	}
+
+	return getShaderModule(*entry->second);
+}
+
+VkShaderModule ShaderVariantCache::getShaderModule(const ShaderPackEntry& entry)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::unordered_map<uint64_t, VkShaderModule>::iterator module = modulesByContentHash.find(entry.contentHash);
+
+	if(module != modulesByContentHash.end())
+	{
+		return module->second;
+	}
+
+	// Code is used directly from mapped pack or archive without copying
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = entry.size;
+	createInfo.pCode = reinterpret_cast<const uint32_t*>(pack.data + entry.offset);
+
+	VkShaderModule shaderModule;
+
+	if(vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create shader module");
+	}
+
+	modulesByContentHash[entry.contentHash] = shaderModule;
+	return shaderModule;
+}
+
+void ShaderVariantCache::startBackgroundCompilation()
+{
+	waitForBackgroundCompilation();
+
+	backgroundThread = std::thread([this]()
+	{
+		YAS_PROFILE_THREAD_NAME("Shader compilation");
+		try
+		{
+			// Entries are never changed after pack is loaded so they can be read without lock
+			for(const std::pair<const uint64_t, const ShaderPackEntry*>& entry: packEntries)
+			{
+				getShaderModule(*entry.second);
+			}
+		}
+		catch(...)
+		{
+			backgroundException = std::current_exception();
+		}
+	});
+}
+
+void ShaderVariantCache::waitForBackgroundCompilation()
+{
+	if(backgroundThread.joinable())
+	{
+		backgroundThread.join();
+	}
+
+	if(backgroundException)
+	{
+		std::exception_ptr exception = backgroundException;
+		backgroundException = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+void ShaderVariantCache::getVertexInputDescriptions(uint32_t variantKey, std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes)
+{
+	bindings.clear();
+	attributes.clear();
+
+	bindings.push_back(Vertex::getBindingDescription());
+
+	// Position is always used. Other attributes are fetched only when variant reads them.
+	attributes.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)});
+
+	if(variantKey & SHADER_FEATURE_VERTEX_COLOR)
+	{
+		attributes.push_back({1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)});
+	}
+
+	if(variantKey & SHADER_FEATURE_TEXTURING)
+	{
+		attributes.push_back({2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord)});
+	}
+
+	if(variantKey & SHADER_FEATURE_INSTANCING)
+	{
+		VkVertexInputBindingDescription instanceBindingDescription = {};
+		instanceBindingDescription.binding = 1;
+		instanceBindingDescription.stride = sizeof(InstanceData);
+		instanceBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		bindings.push_back(instanceBindingDescription);
+
+		// mat4 input takes four locations, one per column
+		for(uint32_t column=0; column<4; column++)
+		{
+			attributes.push_back({3 + column, 1, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(InstanceData, model) + column * sizeof(glm::vec4))});
+		}
+	}
+}
+
+ShaderSpecializationData ShaderVariantCache::getSpecializationData(uint32_t variantKey)
+{
+	ShaderSpecializationData specializationData = {};
+	specializationData.alphaTest = (variantKey & SHADER_FEATURE_ALPHA_TEST) ? VK_TRUE : VK_FALSE;
+	specializationData.alphaCutoff = 0.5F;
+	return specializationData;
+}
+
+std::array<VkSpecializationMapEntry, 2> ShaderVariantCache::getSpecializationMapEntries()
+{
+	std::array<VkSpecializationMapEntry, 2> mapEntries = {};
+	mapEntries[0].constantID = 0;
+	mapEntries[0].offset = offsetof(ShaderSpecializationData, alphaTest);
+	mapEntries[0].size = sizeof(VkBool32);
+	mapEntries[1].constantID = 1;
+	mapEntries[1].offset = offsetof(ShaderSpecializationData, alphaCutoff);
+	mapEntries[1].size = sizeof(float);
+	return mapEntries;
+}
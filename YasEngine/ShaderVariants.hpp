@@ -0,0 +1,111 @@
+#ifndef SHADERVARIANTS_HPP
+#define SHADERVARIANTS_HPP
+#include"stdafx.hpp"
+#include"AssetArchive.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Features which can be toggled per shader variant. Variant key is bitwise OR of these flags.
+// Vertex color, texturing and instancing change shader interface so they are compiled with defines by compileShaders.bat.
+// Alpha test is only specialization constant so it does not need separate SPIR-V.
+enum ShaderFeature
+{
+	SHADER_FEATURE_VERTEX_COLOR			= 1 << 0,
+	SHADER_FEATURE_TEXTURING			= 1 << 1,
+	SHADER_FEATURE_ALPHA_TEST			= 1 << 2,
+	SHADER_FEATURE_INSTANCING			= 1 << 3
+};
+
+const uint32_t VERTEX_SHADER_FEATURES		= SHADER_FEATURE_VERTEX_COLOR | SHADER_FEATURE_TEXTURING | SHADER_FEATURE_INSTANCING;
+const uint32_t FRAGMENT_SHADER_FEATURES		= SHADER_FEATURE_VERTEX_COLOR | SHADER_FEATURE_TEXTURING;
+const uint32_t DEFAULT_SHADER_VARIANT		= SHADER_FEATURE_TEXTURING;
+// Compute shaders have no variants, pack stores them under fixed names
+const char* const SKINNING_SHADER_PATH		= "Shaders/skinning_comp.spv";
+
+// All SPIR-V files packed together. Written on first start when missing, compile scripts delete it.
+const char* const SHADER_PACK_PATH			= "Shaders/shaders.pak";
+const uint32_t SHADER_PACK_MAGIC			= 0x4B505359; // "YSPK"
+const uint32_t SHADER_PACK_VERSION			= 2;
+
+// Pack layout: header, entries table, then SPIR-V of every entry aligned to 4 bytes
+struct ShaderPackHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entriesNumber;
+	uint32_t reserved;
+};
+
+struct ShaderPackEntry
+{
+	// Hash of SPIR-V file name from which entry was packed
+	uint64_t nameHash;
+	uint64_t contentHash;
+	uint32_t offset;
+	uint32_t size;
+};
+
+// Per instance data read from vertex binding 1 when SHADER_FEATURE_INSTANCING is enabled
+struct InstanceData
+{
+	glm::mat4 model;
+};
+
+// Values of specialization constants used by fragment shader
+struct ShaderSpecializationData
+{
+	VkBool32 alphaTest;
+	float alphaCutoff;
+};
+
+// Keeps shader modules for whole lifetime of device. Pipelines made of them live in PipelineCache.
+// All methods can be called while background compilation runs.
+class ShaderVariantCache
+{
+	public:
+
+										ShaderVariantCache();
+										~ShaderVariantCache();
+		// Uses shader pack from asset archive when it has one. Otherwise maps loose pack, writing it first from loose SPIR-V files when it does not exist.
+		// Does not need device, so startup runs it while instance and device are created. Archive has to stay open while cache is used.
+		void							openShaderPack(const AssetArchive& assetArchive);
+		// Opens shader pack when openShaderPack was not called
+		void							initialize(VkDevice device);
+		void							destroy();
+
+		// Module is created from shader pack on first use. Variants which compile to the same SPIR-V share one module.
+		VkShaderModule					getShaderModule(VkShaderStageFlagBits stage, uint32_t variantKey);
+
+		// Creates modules of all pack entries on worker thread, so pipelines of variants used later do not wait for them
+		void							startBackgroundCompilation();
+		// Rethrows exception thrown on worker thread
+		void							waitForBackgroundCompilation();
+
+		static std::string				getSpirvFileName(VkShaderStageFlagBits stage, uint32_t variantKey);
+		static uint64_t					hashCode(const char* data, size_t size);
+		static void						writeShaderPack(const std::string& packFileName);
+		static void						getVertexInputDescriptions(uint32_t variantKey, std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes);
+		static ShaderSpecializationData	getSpecializationData(uint32_t variantKey);
+		static std::array<VkSpecializationMapEntry, 2> getSpecializationMapEntries();
+
+	private:
+
+		void							loadShaderPack();
+		VkShaderModule					getShaderModule(const ShaderPackEntry& entry);
+
+		VkDevice						device;
+		// Pack in archive, or in shaderPack when archive does not have it
+		AssetSpan						pack;
+		MappedFile						shaderPack;
+		// Decompressed pack when archive stores it compressed
+		std::vector<char>				packBuffer;
+		// Name hash -> entry in mapped pack
+		std::unordered_map<uint64_t, const ShaderPackEntry*> packEntries;
+		std::unordered_map<uint64_t, VkShaderModule> modulesByContentHash;
+		std::mutex						cacheMutex;
+
+		std::thread						backgroundThread;
+		std::exception_ptr				backgroundException;
+};
+
+#endif
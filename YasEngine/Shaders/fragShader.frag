@@ -1,13 +1,35 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+// Variants are compiled by compileShaders.bat with defines:
+// VERTEX_COLOR, TEXTURING
+// Alpha test is specialization constant so it does not need separate SPIR-V.
+
+layout(constant_id = 0) const bool ALPHA_TEST = false;
+layout(constant_id = 1) const float ALPHA_CUTOFF = 0.5;
+
 layout(binding = 1) uniform sampler2D texSampler;
 
+#ifdef VERTEX_COLOR
 layout(location = 0) in vec3 fragColor;
+#endif
+
+#ifdef TEXTURING
 layout(location = 1) in vec2 fragTexCoord;
+#endif
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    vec4 color = vec4(1.0);
+#ifdef TEXTURING
+    color = texture(texSampler, fragTexCoord);
+#endif
+#ifdef VERTEX_COLOR
+    color.rgb *= fragColor;
+#endif
+    if(ALPHA_TEST && color.a < ALPHA_CUTOFF) {
+        discard;
+    }
+    outColor = color;
 }
\ No newline at end of file
@@ -1,26 +1,48 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+// Variants are compiled by compileShaders.bat with defines:
+// VERTEX_COLOR, TEXTURING, INSTANCING
 
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
+    mat4 viewProjection;
 } ubo;
 
+layout(push_constant) uniform PushConstantObject {
+    mat4 model;
+} push;
+
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
 
+#ifdef VERTEX_COLOR
+layout(location = 1) in vec3 inColor;
 layout(location = 0) out vec3 fragColor;
+#endif
+
+#ifdef TEXTURING
+layout(location = 2) in vec2 inTexCoord;
 layout(location = 1) out vec2 fragTexCoord;
+#endif
+
+#ifdef INSTANCING
+layout(location = 3) in mat4 inInstanceModel;
+#endif
 
 out gl_PerVertex {
     vec4 gl_Position;
 };
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+#ifdef INSTANCING
+    mat4 model = push.model * inInstanceModel;
+#else
+    mat4 model = push.model;
+#endif
+    gl_Position = ubo.viewProjection * (model * vec4(inPosition, 1.0));
+#ifdef VERTEX_COLOR
     fragColor = inColor;
+#endif
+#ifdef TEXTURING
     fragTexCoord = inTexCoord;
+#endif
 }
\ No newline at end of file
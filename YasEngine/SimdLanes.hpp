@@ -0,0 +1,249 @@
+#ifndef SIMDLANES_HPP
+#define SIMDLANES_HPP
+#include"stdafx.hpp"
+#include"YasMathLib.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Kernels over structure of arrays data are written once for lanes of one, four and eight objects.
+// Lanes hold one component of consecutive objects. Element i of matrix array is component i of all objects in group.
+
+inline float* matrixAt(float* matrices, uint32_t index, size_t stride)
+{
+	return reinterpret_cast<float*>(reinterpret_cast<char*>(matrices) + index * stride);
+}
+
+struct ScalarLanes
+{
+	float value;
+
+	static ScalarLanes load(const float* data)
+	{
+		return {*data};
+	}
+
+	static ScalarLanes broadcast(float value)
+	{
+		return {value};
+	}
+
+	void store(float* data) const
+	{
+		*data = value;
+	}
+
+	// Single lane stores only one matrix, so there is no next matrix stride would lead to
+	static void storeMatrices(const ScalarLanes elements[16], float* matrices, size_t /*stride*/)
+	{
+		for(int i=0; i<16; i++)
+		{
+			matrices[i] = elements[i].value;
+		}
+	}
+};
+
+inline ScalarLanes operator+(ScalarLanes left, ScalarLanes right)
+{
+	return {left.value + right.value};
+}
+
+inline ScalarLanes operator-(ScalarLanes left, ScalarLanes right)
+{
+	return {left.value - right.value};
+}
+
+inline ScalarLanes operator*(ScalarLanes left, ScalarLanes right)
+{
+	return {left.value * right.value};
+}
+
+inline ScalarLanes operator/(ScalarLanes left, ScalarLanes right)
+{
+	return {left.value / right.value};
+}
+
+inline ScalarLanes squareRoot(ScalarLanes lanes)
+{
+	return {std::sqrt(lanes.value)};
+}
+
+// Magnitude of first with sign of second
+inline ScalarLanes copySign(ScalarLanes magnitude, ScalarLanes sign)
+{
+	return {std::copysign(magnitude.value, sign.value)};
+}
+
+#if defined(YAS_MATH_SSE)
+struct SseLanes
+{
+	__m128 value;
+
+	static SseLanes load(const float* data)
+	{
+		return {_mm_loadu_ps(data)};
+	}
+
+	static SseLanes broadcast(float value)
+	{
+		return {_mm_set1_ps(value)};
+	}
+
+	void store(float* data) const
+	{
+		_mm_storeu_ps(data, value);
+	}
+
+	static void storeMatrices(const SseLanes elements[16], float* matrices, size_t stride)
+	{
+		for(int column=0; column<4; column++)
+		{
+			__m128 object0 = elements[column * 4 + 0].value;
+			__m128 object1 = elements[column * 4 + 1].value;
+			__m128 object2 = elements[column * 4 + 2].value;
+			__m128 object3 = elements[column * 4 + 3].value;
+			// Rows of one column for four objects become column of each object
+			_MM_TRANSPOSE4_PS(object0, object1, object2, object3);
+			_mm_storeu_ps(matrixAt(matrices, 0, stride) + column * 4, object0);
+			_mm_storeu_ps(matrixAt(matrices, 1, stride) + column * 4, object1);
+			_mm_storeu_ps(matrixAt(matrices, 2, stride) + column * 4, object2);
+			_mm_storeu_ps(matrixAt(matrices, 3, stride) + column * 4, object3);
+		}
+	}
+};
+
+inline SseLanes operator+(SseLanes left, SseLanes right)
+{
+	return {_mm_add_ps(left.value, right.value)};
+}
+
+inline SseLanes operator-(SseLanes left, SseLanes right)
+{
+	return {_mm_sub_ps(left.value, right.value)};
+}
+
+inline SseLanes operator*(SseLanes left, SseLanes right)
+{
+	return {_mm_mul_ps(left.value, right.value)};
+}
+
+inline SseLanes operator/(SseLanes left, SseLanes right)
+{
+	return {_mm_div_ps(left.value, right.value)};
+}
+
+inline SseLanes squareRoot(SseLanes lanes)
+{
+	return {_mm_sqrt_ps(lanes.value)};
+}
+
+inline SseLanes copySign(SseLanes magnitude, SseLanes sign)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0F);
+	return {_mm_or_ps(_mm_andnot_ps(signMask, magnitude.value), _mm_and_ps(signMask, sign.value))};
+}
+#endif
+
+#if defined(YAS_MATH_AVX)
+struct AvxLanes
+{
+	__m256 value;
+
+	static AvxLanes load(const float* data)
+	{
+		return {_mm256_loadu_ps(data)};
+	}
+
+	static AvxLanes broadcast(float value)
+	{
+		return {_mm256_set1_ps(value)};
+	}
+
+	// Transposes 8x8 block, afterwards row i holds 8 consecutive elements of object i
+	static void transpose(__m256 rows[8])
+	{
+		__m256 low01 = _mm256_unpacklo_ps(rows[0], rows[1]);
+		__m256 high01 = _mm256_unpackhi_ps(rows[0], rows[1]);
+		__m256 low23 = _mm256_unpacklo_ps(rows[2], rows[3]);
+		__m256 high23 = _mm256_unpackhi_ps(rows[2], rows[3]);
+		__m256 low45 = _mm256_unpacklo_ps(rows[4], rows[5]);
+		__m256 high45 = _mm256_unpackhi_ps(rows[4], rows[5]);
+		__m256 low67 = _mm256_unpacklo_ps(rows[6], rows[7]);
+		__m256 high67 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+		__m256 quad0 = _mm256_shuffle_ps(low01, low23, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 quad1 = _mm256_shuffle_ps(low01, low23, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 quad2 = _mm256_shuffle_ps(high01, high23, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 quad3 = _mm256_shuffle_ps(high01, high23, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 quad4 = _mm256_shuffle_ps(low45, low67, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 quad5 = _mm256_shuffle_ps(low45, low67, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 quad6 = _mm256_shuffle_ps(high45, high67, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 quad7 = _mm256_shuffle_ps(high45, high67, _MM_SHUFFLE(3, 2, 3, 2));
+
+		rows[0] = _mm256_permute2f128_ps(quad0, quad4, 0x20);
+		rows[1] = _mm256_permute2f128_ps(quad1, quad5, 0x20);
+		rows[2] = _mm256_permute2f128_ps(quad2, quad6, 0x20);
+		rows[3] = _mm256_permute2f128_ps(quad3, quad7, 0x20);
+		rows[4] = _mm256_permute2f128_ps(quad0, quad4, 0x31);
+		rows[5] = _mm256_permute2f128_ps(quad1, quad5, 0x31);
+		rows[6] = _mm256_permute2f128_ps(quad2, quad6, 0x31);
+		rows[7] = _mm256_permute2f128_ps(quad3, quad7, 0x31);
+	}
+
+	void store(float* data) const
+	{
+		_mm256_storeu_ps(data, value);
+	}
+
+	static void storeMatrices(const AvxLanes elements[16], float* matrices, size_t stride)
+	{
+		// First two and last two columns of all eight objects
+		for(int half=0; half<2; half++)
+		{
+			__m256 rows[8];
+			for(int i=0; i<8; i++)
+			{
+				rows[i] = elements[half * 8 + i].value;
+			}
+			transpose(rows);
+
+			for(uint32_t object=0; object<8; object++)
+			{
+				_mm256_storeu_ps(matrixAt(matrices, object, stride) + half * 8, rows[object]);
+			}
+		}
+	}
+};
+
+inline AvxLanes operator+(AvxLanes left, AvxLanes right)
+{
+	return {_mm256_add_ps(left.value, right.value)};
+}
+
+inline AvxLanes operator-(AvxLanes left, AvxLanes right)
+{
+	return {_mm256_sub_ps(left.value, right.value)};
+}
+
+inline AvxLanes operator*(AvxLanes left, AvxLanes right)
+{
+	return {_mm256_mul_ps(left.value, right.value)};
+}
+
+inline AvxLanes operator/(AvxLanes left, AvxLanes right)
+{
+	return {_mm256_div_ps(left.value, right.value)};
+}
+
+inline AvxLanes squareRoot(AvxLanes lanes)
+{
+	return {_mm256_sqrt_ps(lanes.value)};
+}
+
+inline AvxLanes copySign(AvxLanes magnitude, AvxLanes sign)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0F);
+	return {_mm256_or_ps(_mm256_andnot_ps(signMask, magnitude.value), _mm256_and_ps(signMask, sign.value))};
+}
+#endif
+
+#endif
@@ -0,0 +1,144 @@
+#include"stdafx.hpp"
+#include"Simulation.hpp"
+#include"CpuProfiler.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+const float TWO_PI = 6.28318530717958647692F;
+
+Simulation::Simulation()
+{
+	tick = 0;
+	running.store(false);
+	startNanoseconds = 0;
+}
+
+Simulation::~Simulation()
+{
+	stop();
+}
+
+void Simulation::initialize(const std::vector<SimulatedObject>& initialObjects)
+{
+	objects = initialObjects;
+	previousObjects = initialObjects;
+	tick = 0;
+	publish();
+}
+
+int64_t Simulation::getTickTime(uint64_t tick)
+{
+	return static_cast<int64_t>(tick) * SIMULATION_TICK_NANOSECONDS;
+}
+
+void Simulation::step()
+{
+	const float tickSeconds = static_cast<float>(Clock::toSeconds(SIMULATION_TICK_NANOSECONDS));
+	previousObjects = objects;
+
+	for(SimulatedObject& object: objects)
+	{
+		object.angle = std::fmod(object.angle + object.angularVelocity * tickSeconds, TWO_PI);
+		if(object.angle < 0.0F)
+		{
+			object.angle += TWO_PI;
+		}
+	}
+	++tick;
+}
+
+void Simulation::publish()
+{
+	SimulationSnapshot& snapshot = snapshots.getWriteBuffer();
+	// Slots are reused so vectors keep capacity and nothing is allocated after first three publishes
+	snapshot.tick = tick;
+	snapshot.previousObjects = previousObjects;
+	snapshot.objects = objects;
+	snapshots.publish();
+}
+
+void Simulation::advanceTo(int64_t timeNanoseconds)
+{
+	while(getTickTime(tick) < timeNanoseconds)
+	{
+		step();
+		publish();
+	}
+}
+
+void Simulation::start(int64_t startNanoseconds)
+{
+	if(running.load())
+	{
+		return;
+	}
+	this->startNanoseconds = startNanoseconds;
+	running.store(true);
+	thread = std::thread(&Simulation::threadLoop, this);
+}
+
+void Simulation::stop()
+{
+	if(!running.load())
+	{
+		return;
+	}
+	running.store(false);
+	thread.join();
+}
+
+void Simulation::threadLoop()
+{
+	YAS_PROFILE_THREAD_NAME("Simulation");
+
+	while(running.load())
+	{
+		{
+			YAS_PROFILE_SCOPE("Simulation ticks");
+			// One tick ahead so renderer has both snapshots it interpolates between when frame starts
+			advanceTo(Clock::nanoseconds() - startNanoseconds + SIMULATION_TICK_NANOSECONDS);
+		}
+		// Next tick is needed when real time reaches time of last computed tick
+		Clock::sleepUntil(startNanoseconds + getTickTime(tick));
+	}
+}
+
+void Simulation::interpolate(int64_t timeNanoseconds, TransformBatch& transformBatch)
+{
+	snapshots.update();
+	const SimulationSnapshot& snapshot = snapshots.getReadBuffer();
+
+	if(snapshot.tick == 0)
+	{
+		return;
+	}
+
+	// Render time can be ahead of newest tick when simulation thread is late, then newest state is shown
+	float alpha = static_cast<float>(Clock::toSeconds(timeNanoseconds - getTickTime(snapshot.tick - 1)) / Clock::toSeconds(SIMULATION_TICK_NANOSECONDS));
+	alpha = glm::clamp(alpha, 0.0F, 1.0F);
+
+	uint32_t objectsNumber = static_cast<uint32_t>(std::min<size_t>(snapshot.objects.size(), transformBatch.size()));
+
+	for(uint32_t i=0; i<objectsNumber; i++)
+	{
+		const SimulatedObject& previous = snapshot.previousObjects[i];
+		const SimulatedObject& current = snapshot.objects[i];
+
+		// Angle is wrapped, interpolation goes the short way
+		float angleDifference = current.angle - previous.angle;
+		if(angleDifference > TWO_PI * 0.5F)
+		{
+			angleDifference -= TWO_PI;
+		}
+		else if(angleDifference < -TWO_PI * 0.5F)
+		{
+			angleDifference += TWO_PI;
+		}
+
+		glm::vec3 position = glm::mix(previous.position, current.position, alpha);
+		float angle = previous.angle + angleDifference * alpha;
+		// Matrices of all objects are computed later in one batch
+		transformBatch.setPosition(i, YasMathLib::vec3(position.x, position.y, position.z));
+		transformBatch.setRotation(i, YasMathLib::angleAxis(angle, YasMathLib::vec3(0.0F, 0.0F, 1.0F)));
+	}
+}
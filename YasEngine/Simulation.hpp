@@ -0,0 +1,67 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+#include"stdafx.hpp"
+#include"VariousTools.hpp"
+#include"Clock.hpp"
+#include"TripleBuffer.hpp"
+#include"TransformBatch.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Simulation always advances by this step, so its results do not depend on frame rate
+const int64_t SIMULATION_TICK_NANOSECONDS		= NANOSECONDS_PER_SECOND / 60;
+
+struct SimulatedObject
+{
+	glm::vec3						position;
+	// Rotation around Z axis in radians, kept in [0, 2 pi)
+	float							angle;
+	float							angularVelocity;
+};
+
+struct SimulationSnapshot
+{
+	uint64_t						tick;
+	// State after tick - 1 and after tick. Renderer interpolates between them.
+	std::vector<SimulatedObject>	previousObjects;
+	std::vector<SimulatedObject>	objects;
+};
+
+// Fixed timestep simulation. Can run on own thread one tick ahead of rendering or be advanced by caller.
+// Results go to renderer through triple buffer so neither thread waits for the other.
+class Simulation
+{
+	public:
+
+										Simulation();
+										~Simulation();
+		// Must be called before start or advanceTo. Time 0 is state of given objects.
+		void							initialize(const std::vector<SimulatedObject>& initialObjects);
+		// Time of simulation is counted from startNanoseconds of Clock
+		void							start(int64_t startNanoseconds);
+		void							stop();
+		// Computes ticks on calling thread until tick at or after given time exists. Not for use while thread runs.
+		void							advanceTo(int64_t timeNanoseconds);
+		// Render thread. Takes newest snapshot and writes interpolated positions and rotations of simulated objects.
+		void							interpolate(int64_t timeNanoseconds, TransformBatch& transformBatch);
+
+		static int64_t					getTickTime(uint64_t tick);
+
+	private:
+
+		void							step();
+		void							publish();
+		void							threadLoop();
+
+		// Owned by thread which computes ticks
+		std::vector<SimulatedObject>	objects;
+		std::vector<SimulatedObject>	previousObjects;
+		uint64_t						tick;
+
+		TripleBuffer<SimulationSnapshot> snapshots;
+		std::thread						thread;
+		std::atomic<bool>				running;
+		int64_t							startNanoseconds;
+};
+
+#endif
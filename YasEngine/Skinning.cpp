@@ -0,0 +1,275 @@
+#include"stdafx.hpp"
+#include"Skinning.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Skinning shader reads and writes vertices as arrays of 8 floats
+static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex layout differs from skinning shader");
+static_assert(sizeof(SkinWeights) == 32, "Skin weights layout differs from skinning shader");
+
+const float TWO_PI = 6.28318530717958647692F;
+
+SkinnedCharacter::SkinnedCharacter()
+{
+	mesh = nullptr;
+	timeOffset = 0.0F;
+	blendWeight = 0.0F;
+}
+
+void SkinnedCharacter::initialize(const SkinnedMesh* mesh, float timeOffset, float blendWeight)
+{
+	this->mesh = mesh;
+	this->timeOffset = timeOffset;
+	this->blendWeight = blendWeight;
+
+	uint32_t jointsNumber = mesh->skeleton.getJointsNumber();
+	pose.resize(jointsNumber);
+	secondPose.resize(jointsNumber);
+	modelMatrices.resize(jointsNumber);
+}
+
+void SkinnedCharacter::computeSkinningMatrices(float time, YasMathLib::mat4* skinningMatrices)
+{
+	mesh->clips[0].sample(time + timeOffset, pose);
+
+	if(mesh->clips.size() > 1 && blendWeight > 0.0F)
+	{
+		mesh->clips[1].sample(time + timeOffset, secondPose);
+		AnimationClip::blendPoses(pose, secondPose, blendWeight, pose);
+	}
+
+	mesh->skeleton.computeModelMatrices(pose, modelMatrices.data());
+	mesh->skeleton.computeSkinningMatrices(modelMatrices.data(), skinningMatrices);
+}
+
+SkinningPass::SkinningPass()
+{
+	device = VK_NULL_HANDLE;
+	layoutCache = nullptr;
+	descriptorLayout = {};
+	pipelineLayout = VK_NULL_HANDLE;
+	pipeline = VK_NULL_HANDLE;
+}
+
+void SkinningPass::initialize(VkDevice device, DescriptorLayoutCache& layoutCache, DescriptorAllocator& allocator, VkShaderModule shaderModule, uint32_t descriptorSetsNumber)
+{
+	this->device = device;
+	this->layoutCache = &layoutCache;
+
+	// Bind pose vertices, skin weights, skinning matrices and skinned vertices
+	std::array<VkDescriptorSetLayoutBinding, 4> bindings = {};
+	for(uint32_t i=0; i<bindings.size(); i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorCount = 1;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	descriptorLayout = layoutCache.getLayout(bindings.data(), static_cast<uint32_t>(bindings.size()));
+
+	descriptorSets.resize(descriptorSetsNumber);
+	for(VkDescriptorSet& descriptorSet: descriptorSets)
+	{
+		descriptorSet = allocator.allocate(descriptorLayout.layout);
+	}
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(SkinningDispatch);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &descriptorLayout.layout;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	if(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create skinning pipeline layout");
+	}
+
+	VkComputePipelineCreateInfo computePipelineCreateInfo = {};
+	computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	computePipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	computePipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	computePipelineCreateInfo.stage.module = shaderModule;
+	computePipelineCreateInfo.stage.pName = "main";
+	computePipelineCreateInfo.layout = pipelineLayout;
+
+	// Does not depend on render pass or viewport, so unlike graphics pipelines it lives as long as device
+	if(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create skinning pipeline");
+	}
+}
+
+void SkinningPass::destroy()
+{
+	if(device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	// Sets go back when allocator is destroyed
+	descriptorSets.clear();
+	device = VK_NULL_HANDLE;
+}
+
+void SkinningPass::updateDescriptorSet(uint32_t index, VkBuffer bindVertices, VkBuffer skinWeights, VkBuffer skinningMatrices, VkBuffer skinnedVertices)
+{
+	VkBuffer buffers[] = {bindVertices, skinWeights, skinningMatrices, skinnedVertices};
+	std::array<DescriptorInfo, 4> descriptors = {};
+
+	for(uint32_t i=0; i<descriptors.size(); i++)
+	{
+		descriptors[i].buffer.buffer = buffers[i];
+		descriptors[i].buffer.offset = 0;
+		descriptors[i].buffer.range = VK_WHOLE_SIZE;
+	}
+
+	layoutCache->writeDescriptorSet(descriptorSets[index], descriptorLayout, descriptors.data());
+}
+
+void SkinningPass::recordDispatch(VkCommandBuffer commandBuffer, uint32_t index, const SkinningDispatch& dispatch, uint32_t charactersNumber, VkBuffer skinnedVertices)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[index], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(dispatch), &dispatch);
+	vkCmdDispatch(commandBuffer, (dispatch.verticesNumber + SKINNING_WORKGROUP_SIZE - 1) / SKINNING_WORKGROUP_SIZE, charactersNumber, 1);
+
+	// Buffers belong to one swapchain image and its previous frame is finished, so only read after write has to be ordered
+	VkBufferMemoryBarrier bufferMemoryBarrier = {};
+	bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	bufferMemoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferMemoryBarrier.buffer = skinnedVertices;
+	bufferMemoryBarrier.offset = 0;
+	bufferMemoryBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+}
+
+void SkinningPass::skinVertices(const Vertex* bindVertices, const SkinWeights* skinWeights, uint32_t verticesNumber, const YasMathLib::mat4* skinningMatrices, Vertex* skinnedVertices)
+{
+	for(uint32_t i=0; i<verticesNumber; i++)
+	{
+		const Vertex& bindVertex = bindVertices[i];
+		const SkinWeights& skin = skinWeights[i];
+		const glm::vec3& position = bindVertex.pos;
+
+		// Same order of operations as skinning shader. Weight is folded into position, so each joint costs four multiply adds of columns.
+		// Zero weights are not skipped, branch costs more than multiply.
+		YasMathLib::vec4 skinned(0.0F);
+		for(uint32_t joint=0; joint<SKIN_JOINTS_PER_VERTEX; joint++)
+		{
+			const YasMathLib::mat4& matrix = skinningMatrices[skin.jointIndices[joint]];
+			const float weight = skin.weights[joint];
+			skinned = skinned + matrix[0] * (position.x * weight) + matrix[1] * (position.y * weight) + matrix[2] * (position.z * weight) + matrix[3] * weight;
+		}
+
+		Vertex& skinnedVertex = skinnedVertices[i];
+		skinnedVertex.pos = glm::vec3(skinned.x, skinned.y, skinned.z);
+		skinnedVertex.color = bindVertex.color;
+		skinnedVertex.texCoord = bindVertex.texCoord;
+	}
+}
+
+void SkinningPass::createTestMesh(uint32_t jointsNumber, uint32_t ringsPerJoint, uint32_t segmentsNumber, SkinnedMesh& mesh)
+{
+	const float jointLength = 0.6F / jointsNumber;
+	const float radius = 0.04F;
+	const float height = jointLength * jointsNumber;
+	const uint32_t ringsNumber = jointsNumber * ringsPerJoint + 1;
+
+	mesh.skeleton = Skeleton();
+	for(uint32_t joint=0; joint<jointsNumber; joint++)
+	{
+		mesh.skeleton.addJoint(static_cast<int32_t>(joint) - 1, YasMathLib::translate(YasMathLib::mat4(1.0F), YasMathLib::vec3(0.0F, 0.0F, -(joint * jointLength))));
+	}
+
+	mesh.vertices.clear();
+	mesh.skinWeights.clear();
+	for(uint32_t ring=0; ring<ringsNumber; ring++)
+	{
+		float z = height * ring / (ringsNumber - 1);
+		// Joint j bends part of column between j and j + 1. Weights fall off linearly over two joint lengths, so up to four joints move vertex.
+		float jointPosition = z / jointLength;
+		SkinWeights skin = {};
+		uint32_t influences = 0;
+		float weightsSum = 0.0F;
+
+		for(uint32_t joint=0; joint<jointsNumber && influences<SKIN_JOINTS_PER_VERTEX; joint++)
+		{
+			float weight = 2.0F - std::fabs(jointPosition - (joint + 0.5F));
+			if(weight > 0.0F)
+			{
+				skin.jointIndices[influences] = joint;
+				skin.weights[influences] = weight;
+				weightsSum += weight;
+				influences++;
+			}
+		}
+
+		for(uint32_t i=0; i<influences; i++)
+		{
+			skin.weights[i] /= weightsSum;
+		}
+
+		for(uint32_t segment=0; segment<segmentsNumber; segment++)
+		{
+			float angle = TWO_PI * segment / segmentsNumber;
+			Vertex vertex = {};
+			vertex.pos = glm::vec3(radius * std::cos(angle), radius * std::sin(angle), z);
+			vertex.color = glm::vec3(z / height, 0.3F, 1.0F - z / height);
+			vertex.texCoord = glm::vec2(static_cast<float>(segment) / segmentsNumber, z / height);
+			mesh.vertices.push_back(vertex);
+			mesh.skinWeights.push_back(skin);
+		}
+	}
+
+	mesh.indices.clear();
+	for(uint32_t ring=0; ring+1<ringsNumber; ring++)
+	{
+		for(uint32_t segment=0; segment<segmentsNumber; segment++)
+		{
+			uint32_t current = ring * segmentsNumber + segment;
+			uint32_t next = ring * segmentsNumber + (segment + 1) % segmentsNumber;
+			mesh.indices.insert(mesh.indices.end(), {current, next, next + segmentsNumber, current, next + segmentsNumber, current + segmentsNumber});
+		}
+	}
+
+	// Sway bends column around x axis, twist around y axis. Phases of keys repeat so last key equals first.
+	const uint32_t keysNumber = 31;
+	const float amplitudes[] = {0.25F, 0.35F};
+	const YasMathLib::vec3 axes[] = {YasMathLib::vec3(1.0F, 0.0F, 0.0F), YasMathLib::vec3(0.0F, 1.0F, 0.0F)};
+	mesh.clips.assign(2, AnimationClip());
+
+	for(uint32_t clip=0; clip<2; clip++)
+	{
+		mesh.clips[clip].initialize(jointsNumber, keysNumber, 30.0F);
+
+		for(uint32_t key=0; key<keysNumber; key++)
+		{
+			float phase = TWO_PI * (key % (keysNumber - 1)) / (keysNumber - 1);
+			TransformBatch& pose = mesh.clips[clip].getKey(key);
+
+			for(uint32_t joint=0; joint<jointsNumber; joint++)
+			{
+				pose.setPosition(joint, YasMathLib::vec3(0.0F, 0.0F, joint == 0 ? 0.0F : jointLength));
+				pose.setRotation(joint, YasMathLib::angleAxis(amplitudes[clip] * std::sin(phase + 0.5F * joint), axes[clip]));
+			}
+		}
+	}
+
+	// Column can curl in any direction but never gets further from root than its height
+	float reach = height + radius;
+	mesh.boundsMin = glm::vec3(-reach);
+	mesh.boundsMax = glm::vec3(reach);
+}
@@ -0,0 +1,101 @@
+#ifndef SKINNING_HPP
+#define SKINNING_HPP
+#include"stdafx.hpp"
+#include"VariousTools.hpp"
+#include"Animation.hpp"
+#include"Descriptors.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+const uint32_t SKIN_JOINTS_PER_VERTEX			= 4;
+// Has to match local_size_x of Shaders/skinning.comp
+const uint32_t SKINNING_WORKGROUP_SIZE			= 64;
+// Procedural test character, 2080 vertices
+const uint32_t TEST_CHARACTER_JOINTS			= 16;
+const uint32_t TEST_CHARACTER_RINGS_PER_JOINT	= 4;
+const uint32_t TEST_CHARACTER_SEGMENTS			= 32;
+
+// Second vertex stream of skinned mesh, next to Vertex of bind pose. Weights sum to one, unused joints have weight 0.
+// Layout matches struct SkinWeights of skinning shader.
+struct SkinWeights
+{
+	uint32_t jointIndices[SKIN_JOINTS_PER_VERTEX];
+	float weights[SKIN_JOINTS_PER_VERTEX];
+};
+
+struct SkinnedMesh
+{
+	// Bind pose
+	std::vector<Vertex> vertices;
+	std::vector<SkinWeights> skinWeights;
+	std::vector<uint32_t> indices;
+	Skeleton skeleton;
+	std::vector<AnimationClip> clips;
+	// Box which contains mesh in every pose of its clips
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+};
+
+// Values of push constants of skinning shader. One dispatch skins all characters of one mesh, workgroup y is character.
+struct SkinningDispatch
+{
+	uint32_t verticesNumber;
+	uint32_t jointsNumber;
+	// Characters are stored one after another in skinning matrices and skinned vertices
+	uint32_t firstJoint;
+	uint32_t firstSkinnedVertex;
+};
+
+// Instance of skinned mesh. Poses and model matrices are kept between frames so animating does not allocate.
+class SkinnedCharacter
+{
+	public:
+
+										SkinnedCharacter();
+		// Mesh has to outlive character
+		void							initialize(const SkinnedMesh* mesh, float timeOffset, float blendWeight);
+		// Samples first two clips of mesh, blends them and writes one skinning matrix per joint
+		void							computeSkinningMatrices(float time, YasMathLib::mat4* skinningMatrices);
+
+	private:
+
+		const SkinnedMesh*				mesh;
+		float							timeOffset;
+		// Weight of second clip over first one
+		float							blendWeight;
+		TransformBatch					pose;
+		TransformBatch					secondPose;
+		std::vector<YasMathLib::mat4>	modelMatrices;
+};
+
+// Compute pass which writes skinned vertices into buffer bound later as vertex buffer of ordinary pipeline.
+// Descriptor set per swapchain image, so skinning matrices and output of frames in flight do not overlap.
+class SkinningPass
+{
+	public:
+
+										SkinningPass();
+		// Layout comes from cache and sets from allocator, both own them
+		void							initialize(VkDevice device, DescriptorLayoutCache& layoutCache, DescriptorAllocator& allocator, VkShaderModule shaderModule, uint32_t descriptorSetsNumber);
+		void							destroy();
+		// Bind pose vertices and skin weights are shared, matrices and skinned vertices belong to one image
+		void							updateDescriptorSet(uint32_t index, VkBuffer bindVertices, VkBuffer skinWeights, VkBuffer skinningMatrices, VkBuffer skinnedVertices);
+		// Skins charactersNumber characters and makes result visible to vertex input of following draws
+		void							recordDispatch(VkCommandBuffer commandBuffer, uint32_t index, const SkinningDispatch& dispatch, uint32_t charactersNumber, VkBuffer skinnedVertices);
+
+		// Linear blend skinning on CPU. Reference for compute shader and fallback when it can not be used.
+		static void						skinVertices(const Vertex* bindVertices, const SkinWeights* skinWeights, uint32_t verticesNumber, const YasMathLib::mat4* skinningMatrices, Vertex* skinnedVertices);
+		// Procedural character used until skinned models can be loaded: column of rings bent by chain of joints, with sway and twist clips
+		static void						createTestMesh(uint32_t jointsNumber, uint32_t ringsPerJoint, uint32_t segmentsNumber, SkinnedMesh& mesh);
+
+	private:
+
+		VkDevice						device;
+		DescriptorLayoutCache*			layoutCache;
+		DescriptorLayout				descriptorLayout;
+		std::vector<VkDescriptorSet>	descriptorSets;
+		VkPipelineLayout				pipelineLayout;
+		VkPipeline						pipeline;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#include"stdafx.hpp"
+#include"TransformBatch.hpp"
+#include"SimdLanes.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+TransformBatch::TransformBatch()
+{
+	objectsNumber = 0;
+}
+
+void TransformBatch::resize(uint32_t objectsNumber)
+{
+	this->objectsNumber = objectsNumber;
+
+	for(uint32_t i=0; i<TRANSFORM_COMPONENTS_NUMBER; i++)
+	{
+		bool isOne = i == TRANSFORM_ROTATION_W || i >= TRANSFORM_SCALE_X;
+		components[i].resize(objectsNumber, isOne ? 1.0F : 0.0F);
+	}
+}
+
+uint32_t TransformBatch::size() const
+{
+	return objectsNumber;
+}
+
+void TransformBatch::setPosition(uint32_t index, const YasMathLib::vec3& position)
+{
+	components[TRANSFORM_POSITION_X][index] = position.x;
+	components[TRANSFORM_POSITION_Y][index] = position.y;
+	components[TRANSFORM_POSITION_Z][index] = position.z;
+}
+
+void TransformBatch::setRotation(uint32_t index, const YasMathLib::quat& rotation)
+{
+	components[TRANSFORM_ROTATION_X][index] = rotation.x;
+	components[TRANSFORM_ROTATION_Y][index] = rotation.y;
+	components[TRANSFORM_ROTATION_Z][index] = rotation.z;
+	components[TRANSFORM_ROTATION_W][index] = rotation.w;
+}
+
+void TransformBatch::setScale(uint32_t index, const YasMathLib::vec3& scale)
+{
+	components[TRANSFORM_SCALE_X][index] = scale.x;
+	components[TRANSFORM_SCALE_Y][index] = scale.y;
+	components[TRANSFORM_SCALE_Z][index] = scale.z;
+}
+
+float* TransformBatch::getComponent(TransformComponent component)
+{
+	return components[component].data();
+}
+
+const float* TransformBatch::getComponent(TransformComponent component) const
+{
+	return components[component].data();
+}
+
+template<typename Lanes>
+void TransformBatch::computeGroup(const YasMathLib::mat4& viewProjection, uint32_t first, float* world, size_t worldStride, float* modelViewProjection, size_t modelViewProjectionStride) const
+{
+	const Lanes x = Lanes::load(&components[TRANSFORM_ROTATION_X][first]);
+	const Lanes y = Lanes::load(&components[TRANSFORM_ROTATION_Y][first]);
+	const Lanes z = Lanes::load(&components[TRANSFORM_ROTATION_Z][first]);
+	const Lanes w = Lanes::load(&components[TRANSFORM_ROTATION_W][first]);
+	const Lanes scaleX = Lanes::load(&components[TRANSFORM_SCALE_X][first]);
+	const Lanes scaleY = Lanes::load(&components[TRANSFORM_SCALE_Y][first]);
+	const Lanes scaleZ = Lanes::load(&components[TRANSFORM_SCALE_Z][first]);
+	const Lanes zero = Lanes::broadcast(0.0F);
+	const Lanes one = Lanes::broadcast(1.0F);
+	const Lanes two = Lanes::broadcast(2.0F);
+
+	const Lanes xx = x * x;
+	const Lanes yy = y * y;
+	const Lanes zz = z * z;
+	const Lanes xz = x * z;
+	const Lanes xy = x * y;
+	const Lanes yz = y * z;
+	const Lanes wx = w * x;
+	const Lanes wy = w * y;
+	const Lanes wz = w * z;
+
+	// Columns of YasMathLib::toMat4 multiplied by scale, translation in last column
+	Lanes elements[16];
+	elements[0] = (one - two * (yy + zz)) * scaleX;
+	elements[1] = two * (xy + wz) * scaleX;
+	elements[2] = two * (xz - wy) * scaleX;
+	elements[3] = zero;
+	elements[4] = two * (xy - wz) * scaleY;
+	elements[5] = (one - two * (xx + zz)) * scaleY;
+	elements[6] = two * (yz + wx) * scaleY;
+	elements[7] = zero;
+	elements[8] = two * (xz + wy) * scaleZ;
+	elements[9] = two * (yz - wx) * scaleZ;
+	elements[10] = (one - two * (xx + yy)) * scaleZ;
+	elements[11] = zero;
+	elements[12] = Lanes::load(&components[TRANSFORM_POSITION_X][first]);
+	elements[13] = Lanes::load(&components[TRANSFORM_POSITION_Y][first]);
+	elements[14] = Lanes::load(&components[TRANSFORM_POSITION_Z][first]);
+	elements[15] = one;
+
+	if(world != nullptr)
+	{
+		Lanes::storeMatrices(elements, matrixAt(world, first, worldStride), worldStride);
+	}
+
+	if(modelViewProjection == nullptr)
+	{
+		return;
+	}
+
+	// Last row of world matrix is (0, 0, 0, 1) so product needs three terms per element, four in last column
+	Lanes products[16];
+	for(int column=0; column<4; column++)
+	{
+		for(int row=0; row<4; row++)
+		{
+			Lanes sum = Lanes::broadcast(viewProjection[0][row]) * elements[column * 4 + 0] + Lanes::broadcast(viewProjection[1][row]) * elements[column * 4 + 1] + Lanes::broadcast(viewProjection[2][row]) * elements[column * 4 + 2];
+			if(column == 3)
+			{
+				sum = sum + Lanes::broadcast(viewProjection[3][row]);
+			}
+			products[column * 4 + row] = sum;
+		}
+	}
+	Lanes::storeMatrices(products, matrixAt(modelViewProjection, first, modelViewProjectionStride), modelViewProjectionStride);
+}
+
+void TransformBatch::computeMatrices(const YasMathLib::mat4& viewProjection, uint32_t begin, uint32_t end, float* world, size_t worldStride, float* modelViewProjection, size_t modelViewProjectionStride) const
+{
+	uint32_t index = begin;
+
+#if defined(YAS_MATH_AVX)
+	for(; index + 8 <= end; index += 8)
+	{
+		computeGroup<AvxLanes>(viewProjection, index, world, worldStride, modelViewProjection, modelViewProjectionStride);
+	}
+#endif
+#if defined(YAS_MATH_SSE)
+	for(; index + 4 <= end; index += 4)
+	{
+		computeGroup<SseLanes>(viewProjection, index, world, worldStride, modelViewProjection, modelViewProjectionStride);
+	}
+#endif
+	for(; index < end; index++)
+	{
+		computeGroup<ScalarLanes>(viewProjection, index, world, worldStride, modelViewProjection, modelViewProjectionStride);
+	}
+}
+
+void TransformBatch::computeMatrices(JobSystem& jobSystem, const YasMathLib::mat4& viewProjection, float* world, size_t worldStride, float* modelViewProjection, size_t modelViewProjectionStride) const
+{
+	if(objectsNumber <= TRANSFORM_BATCH_GRAIN)
+	{
+		computeMatrices(viewProjection, 0, objectsNumber, world, worldStride, modelViewProjection, modelViewProjectionStride);
+		return;
+	}
+
+	// Lambda captures one pointer so std::function does not allocate
+	struct Task
+	{
+		const TransformBatch* transformBatch;
+		const YasMathLib::mat4* viewProjection;
+		float* world;
+		size_t worldStride;
+		float* modelViewProjection;
+		size_t modelViewProjectionStride;
+	} task = {this, &viewProjection, world, worldStride, modelViewProjection, modelViewProjectionStride};
+
+	// Range is split in whole groups, so only last job can have objects left for scalar code
+	uint32_t groupsNumber = (objectsNumber + TRANSFORM_BATCH_WIDTH - 1) / TRANSFORM_BATCH_WIDTH;
+	jobSystem.parallelFor(0, groupsNumber, TRANSFORM_BATCH_GRAIN / TRANSFORM_BATCH_WIDTH, [&task](uint32_t firstGroup, uint32_t endGroup)
+	{
+		uint32_t end = std::min(endGroup * TRANSFORM_BATCH_WIDTH, task.transformBatch->objectsNumber);
+		task.transformBatch->computeMatrices(*task.viewProjection, firstGroup * TRANSFORM_BATCH_WIDTH, end, task.world, task.worldStride, task.modelViewProjection, task.modelViewProjectionStride);
+	});
+}
@@ -0,0 +1,63 @@
+#ifndef TRANSFORMBATCH_HPP
+#define TRANSFORMBATCH_HPP
+#include"stdafx.hpp"
+#include"YasMathLib.hpp"
+#include"JobSystem.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Objects processed by one iteration of kernel, groups handed to parallelFor are never split
+const uint32_t TRANSFORM_BATCH_WIDTH			= 8;
+// Objects per job of parallel version
+const uint32_t TRANSFORM_BATCH_GRAIN			= 2048;
+
+enum TransformComponent
+{
+	TRANSFORM_POSITION_X,
+	TRANSFORM_POSITION_Y,
+	TRANSFORM_POSITION_Z,
+	TRANSFORM_ROTATION_X,
+	TRANSFORM_ROTATION_Y,
+	TRANSFORM_ROTATION_Z,
+	TRANSFORM_ROTATION_W,
+	TRANSFORM_SCALE_X,
+	TRANSFORM_SCALE_Y,
+	TRANSFORM_SCALE_Z,
+	TRANSFORM_COMPONENTS_NUMBER
+};
+
+// Position, rotation and scale of many objects in structure of arrays layout.
+// Kernel loads one component of 4 (SSE) or 8 (AVX) objects with single instruction and computes their matrices together.
+class TransformBatch
+{
+	public:
+
+										TransformBatch();
+		// New objects get identity transform
+		void							resize(uint32_t objectsNumber);
+		uint32_t						size() const;
+
+		void							setPosition(uint32_t index, const YasMathLib::vec3& position);
+		void							setRotation(uint32_t index, const YasMathLib::quat& rotation);
+		void							setScale(uint32_t index, const YasMathLib::vec3& scale);
+		// One component of all objects, for kernels which process the batch directly
+		float*							getComponent(TransformComponent component);
+		const float*					getComponent(TransformComponent component) const;
+
+		// World matrix is translation * rotation * scale, model view projection is viewProjection * world.
+		// Matrices are written as 16 floats in column major order, stride in bytes lets them go straight into arrays of bigger structs.
+		// Either output can be null.
+		void							computeMatrices(const YasMathLib::mat4& viewProjection, uint32_t begin, uint32_t end, float* world, size_t worldStride, float* modelViewProjection, size_t modelViewProjectionStride) const;
+		// All objects, split into jobs when there are more than TRANSFORM_BATCH_GRAIN
+		void							computeMatrices(JobSystem& jobSystem, const YasMathLib::mat4& viewProjection, float* world, size_t worldStride, float* modelViewProjection, size_t modelViewProjectionStride) const;
+
+	private:
+
+		template<typename Lanes>
+		void							computeGroup(const YasMathLib::mat4& viewProjection, uint32_t first, float* world, size_t worldStride, float* modelViewProjection, size_t modelViewProjectionStride) const;
+
+		uint32_t						objectsNumber;
+		std::vector<float>				components[TRANSFORM_COMPONENTS_NUMBER];
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+#include"stdafx.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Lock free hand over of newest value from one writer thread to one reader thread.
+// Writer and reader each own one slot, third slot is exchanged between them with single atomic swap,
+// so neither side ever waits and reader always gets whole value written last.
+template<typename T>
+class TripleBuffer
+{
+	public:
+
+										TripleBuffer() : writeIndex(0), readIndex(1), middle(2)
+		{
+		}
+
+		// Writer thread. Slot still contains value written three publishes ago.
+		T&								getWriteBuffer()
+		{
+			return buffers[writeIndex];
+		}
+
+		void							publish()
+		{
+			uint32_t previous = middle.exchange(writeIndex | NEW_VALUE_BIT, std::memory_order_acq_rel);
+			writeIndex = previous & INDEX_MASK;
+		}
+
+		// Reader thread. Returns true when value was published since last call.
+		bool							update()
+		{
+			if((middle.load(std::memory_order_relaxed) & NEW_VALUE_BIT) == 0)
+			{
+				return false;
+			}
+			uint32_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+			readIndex = previous & INDEX_MASK;
+			return true;
+		}
+
+		const T&						getReadBuffer() const
+		{
+			return buffers[readIndex];
+		}
+
+	private:
+
+		static const uint32_t			INDEX_MASK = 3;
+		static const uint32_t			NEW_VALUE_BIT = 4;
+
+		std::array<T, 3>				buffers;
+		// Indices owned by each side are on own cache lines
+		alignas(64) uint32_t			writeIndex;
+		alignas(64) uint32_t			readIndex;
+		alignas(64) std::atomic<uint32_t> middle;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define VARIOUSTOOLS_HPP
 #include"stdafx.hpp"
 #include"YasMathLib.hpp"
+#include"Arena.hpp"
 
 //-----------------------------------------------------------------------------|---------------------------------------|
 
@@ -15,14 +16,16 @@ struct QueueFamilyIndices
 	}
 };
 
+// Queried on every swapchain recreation. Lists are in scratch arena so caller has to keep ArenaScope open while using them.
 struct SwapchainSupportDetails
 {
 	VkSurfaceCapabilitiesKHR capabilities;
-	std::vector<VkSurfaceFormatKHR> formats;
-	std::vector<VkPresentModeKHR> presentModes;
+	ArenaVector<VkSurfaceFormatKHR> formats;
+	ArenaVector<VkPresentModeKHR> presentModes;
 };
 
-static std::vector<char> readFile(const std::string& fileName)
+// Contents are in scratch arena, caller has to keep ArenaScope open while using them
+static ArenaVector<char> readFile(const std::string& fileName)
 {
 	std::ifstream file(fileName, std::ios::ate | std::ios::binary);
 
@@ -32,7 +35,7 @@ static std::vector<char> readFile(const std::string& fileName)
 	}
 
 	size_t fileSize = static_cast<size_t>(file.tellg());
-	std::vector<char> buffer(fileSize);
+	ArenaVector<char> buffer(fileSize);
 
 	file.seekg(0);
 	file.read(buffer.data(), fileSize);
@@ -43,6 +46,7 @@ static std::vector<char> readFile(const std::string& fileName)
 
 static QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR& surface)
 {
+	ArenaScope arenaScope;
 	QueueFamilyIndices queueFamilyIndices;
 	uint32_t queueFamilyCount = 0;
 	
@@ -50,7 +54,7 @@ static QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKH
     // In this call function retrieve only number of queueFamilyCount
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
 
-	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	ArenaVector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     // In this call function retrieve queue family properties
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
@@ -63,7 +67,16 @@ static QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKH
 		}
 
 		VkBool32 presentationFamilySupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentationFamilySupport);
+
+		// Headless mode has no surface, nothing is presented so graphics queue is used for both
+		if(surface == VK_NULL_HANDLE)
+		{
+			presentationFamilySupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+		}
+		else
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentationFamilySupport);
+		}
 
 		if(queueFamily.queueCount > 0 && presentationFamilySupport)
 		{
@@ -80,55 +93,6 @@ static QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKH
 	return queueFamilyIndices;
 }
 
-class TimePicker
-{
-	private:
-
-		LARGE_INTEGER frequency;
-		bool isFrequencyOfThePerformanceCounterPickedUp;
-
-		TimePicker()
-		{
-			isFrequencyOfThePerformanceCounterPickedUp = (QueryPerformanceFrequency(&frequency) != 0);
-		}
-
-	public:
-
-		float getSeconds()
-		{
-			if(!isFrequencyOfThePerformanceCounterPickedUp)
-			{
-				return GetTickCount64() / 1000.0F;
-			} 
-			else
-			{
-				LARGE_INTEGER ticks;
-				QueryPerformanceCounter(&ticks);
-				return (float)(ticks.QuadPart / (double)frequency.QuadPart);
-			}
-		}
-
-		static TimePicker* getTimePicker()
-		{
-			return new TimePicker();
-		}
-};
- /* TODO implement vectors in YasMathLib
-	struct vec2
-	{
-		float x;
-		float y;
-	};
-
-	struct vec3
-	{
-		float x;
-		float y;
-		float z;
-	};
-*/
-
-
 struct Vertex
 {
 
@@ -152,27 +116,26 @@ struct Vertex
 		
 		return vertInBindingDescription;
 	}
+};
 
-	static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
-	{
-		std::array<VkVertexInputAttributeDescription, 3> vertexInputAttributeDescription = {};
-		vertexInputAttributeDescription[0].binding = 0;
-		vertexInputAttributeDescription[0].location = 0;
-		vertexInputAttributeDescription[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-		vertexInputAttributeDescription[0].offset = offsetof(Vertex, pos);
-
-		vertexInputAttributeDescription[1].binding = 0;
-		vertexInputAttributeDescription[1].location = 1;
-		vertexInputAttributeDescription[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-		vertexInputAttributeDescription[1].offset = offsetof(Vertex, color);
-
-        vertexInputAttributeDescription[2].binding = 0;
-        vertexInputAttributeDescription[2].location = 2;
-        vertexInputAttributeDescription[2].format = VK_FORMAT_R32G32_SFLOAT;
-        vertexInputAttributeDescription[2].offset = offsetof(Vertex, texCoord);
-
-		return vertexInputAttributeDescription;
-	}
+// Object placed in scene. Geometry is range of shared vertex and index buffers.
+struct RenderObject
+{
+	glm::mat4 model;
+	// Axis aligned bounding box in object space
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	// Mesh in geometry pool, firstIndex and vertexOffset are its ranges in pool buffers
+	uint32_t meshIndex;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	int32_t vertexOffset;
+	// Occluders are rasterized into software depth buffer and hide objects behind them
+	bool isOccluder;
+	// Vertices come from skinned vertex buffer of current image, vertexOffset points into it
+	bool isSkinned;
+	// Index into materials of engine, each material has its own pipeline state
+	uint32_t material;
 };
 
 template<> struct std::hash<Vertex>
@@ -183,6 +146,19 @@ template<> struct std::hash<Vertex>
 	}
 };
 
+// Depth range of camera, render queue quantizes view depth of objects inside it
+const float CAMERA_NEAR_PLANE = 0.1F;
+const float CAMERA_FAR_PLANE = 10.0F;
+
+// Camera of scene. View and projection are multiplied once per frame on CPU instead of per vertex in shader.
+static YasMathLib::mat4 computeViewProjection(float aspectRatio)
+{
+	YasMathLib::mat4 view = YasMathLib::lookAt(YasMathLib::vec3(2.0F, 2.0F, 2.0F), YasMathLib::vec3(0.0F, 0.0F, 0.0F), YasMathLib::vec3(0.0F, 0.0F, 1.0F));
+	YasMathLib::mat4 proj = YasMathLib::perspective(YasMathLib::radians(45.0F), aspectRatio, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+	proj[1][1] *= -1;
+	return proj * view;
+}
+
 static VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags imageAspectFlags, VkDevice& vulkanLogicDevice, uint32_t mipLevelsNumber)
 {
 	VkImageViewCreateInfo imageViewCreateInfo = {};
@@ -3,62 +3,137 @@
 #include"VariousTools.hpp"
 #include"VulkanInstance.hpp"
 #include"VulkanSwapchain.hpp"
+#include"YasLog.hpp"
 //-----------------------------------------------------------------------------|---------------------------------------|
 
 //static function
 bool VulkanDevice::isPhysicalDeviceSuitable(VkPhysicalDevice physDevice, VulkanInstance& vulkanInstance, VkSurfaceKHR surface)
 {
 	QueueFamilyIndices indices = findQueueFamilies(physDevice, surface);
-	VkPhysicalDeviceProperties physicalDeviceProperties;
-	vkGetPhysicalDeviceProperties(physDevice, &physicalDeviceProperties);
 	VkPhysicalDeviceFeatures physicalDeviceSupportedFeatures;
 	vkGetPhysicalDeviceFeatures(physDevice, &physicalDeviceSupportedFeatures);
 
-	if(physicalDeviceProperties.vendorID == 4130)
+	bool extensionsSupported = vulkanInstance.layersAndExtensions->CheckIfAllRequestedPhysicalDeviceExtensionAreSupported(physDevice);
+	YAS_LOG_DEBUG("extensionSupported= {}", extensionsSupported);
+	bool swapchainSuitable = false;
+	
+	// Headless mode renders to offscreen images so swapchain support does not matter
+	if(surface == VK_NULL_HANDLE)
 	{
-		std::cout << "Physical device vendor: AMD" << std::endl;
+		swapchainSuitable = true;
 	}
-	else
+	else if(extensionsSupported)
+	{
+		ArenaScope arenaScope;
+		SwapchainSupportDetails swapchainSupport = VulkanSwapchain::querySwapchainSupport(physDevice, surface);
+		swapchainSuitable = !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
+		YAS_LOG_DEBUG("swapchainSuitable= {}", swapchainSuitable);
+	}
+
+	return indices.isComplete() && extensionsSupported && swapchainSuitable && physicalDeviceSupportedFeatures.samplerAnisotropy;
+}
+
+//static function
+PhysicalDeviceCapabilities VulkanDevice::queryCapabilities(VkPhysicalDevice physDevice)
+{
+	PhysicalDeviceCapabilities capabilities = {};
+
+	// UUID comes from Vulkan 1.1 properties, device itself may report higher version
+	VkPhysicalDeviceIDProperties idProperties = {};
+	idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+	VkPhysicalDeviceProperties2 properties2 = {};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &idProperties;
+	vkGetPhysicalDeviceProperties2(physDevice, &properties2);
+	capabilities.properties = properties2.properties;
+	std::memcpy(capabilities.deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physDevice, &memoryProperties);
+	for(uint32_t i=0; i<memoryProperties.memoryHeapCount; i++)
+	{
+		if(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			capabilities.deviceLocalMemory = std::max(capabilities.deviceLocalMemory, memoryProperties.memoryHeaps[i].size);
+		}
+	}
+
+	ArenaScope arenaScope;
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physDevice, &queueFamilyCount, nullptr);
+	ArenaVector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physDevice, &queueFamilyCount, queueFamilies.data());
+
+	for(const VkQueueFamilyProperties& queueFamily: queueFamilies)
 	{
-		if(physicalDeviceProperties.vendorID == 4318)
+		if((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
 		{
-					std::cout << "Physical device vendor: NVIDIA" << std::endl;
+			capabilities.dedicatedTransferQueue = true;
 		}
-		else
+		if((queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
 		{
-			if(physicalDeviceProperties.vendorID == 8086)
-			{
-					std::cout << "Physical device vendor: INTEL" << std::endl;
-			}
-			else
-			{
-				std::cout << "Physical device vendor: Other vendor." << std::endl;
-			}
+			capabilities.dedicatedComputeQueue = true;
 		}
 	}
-	bool extensionsSupported = vulkanInstance.layersAndExtensions->CheckIfAllRequestedPhysicalDeviceExtensionAreSupported(physDevice);
-	std::cout << "extensionSupported= " << extensionsSupported << std::endl;
-	bool swapchainSuitable = false;
-	
-	if(extensionsSupported)
+
+	// Both features are core in Vulkan 1.2, before that their extensions have to be present
+	// or chained structures must not be passed to the device
+	bool descriptorIndexingExtension = capabilities.properties.apiVersion >= VK_API_VERSION_1_2;
+	bool timelineSemaphoreExtension = capabilities.properties.apiVersion >= VK_API_VERSION_1_2;
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(physDevice, nullptr, &extensionCount, nullptr);
+	ArenaVector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(physDevice, nullptr, &extensionCount, extensions.data());
+
+	for(const VkExtensionProperties& extension: extensions)
 	{
-		SwapchainSupportDetails swapchainSupport = VulkanSwapchain::querySwapchainSupport(physDevice, surface);
-		swapchainSuitable = !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
-		std::cout <<"swapchainSuitable= " << swapchainSuitable << std::endl;
+		if(std::strcmp(extension.extensionName, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0)
+		{
+			descriptorIndexingExtension = true;
+		}
+		if(std::strcmp(extension.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0)
+		{
+			timelineSemaphoreExtension = true;
+		}
+		if(std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+		{
+			capabilities.memoryBudget = true;
+		}
 	}
 
-	std::cout << "Before return in isPhysicalDeviceSuitable(VkPhysicalDevice device) " << std::endl;
-	return indices.isComplete() && extensionsSupported && swapchainSuitable && physicalDeviceSupportedFeatures.samplerAnisotropy; // && physicalDeviceProperties.vendorID == 4318;
-}
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+	descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures = {};
+	timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+	VkPhysicalDeviceFeatures2 features2 = {};
+	features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
 
+	if(descriptorIndexingExtension)
+	{
+		descriptorIndexingFeatures.pNext = features2.pNext;
+		features2.pNext = &descriptorIndexingFeatures;
+	}
+	if(timelineSemaphoreExtension)
+	{
+		timelineSemaphoreFeatures.pNext = features2.pNext;
+		features2.pNext = &timelineSemaphoreFeatures;
+	}
+	vkGetPhysicalDeviceFeatures2(physDevice, &features2);
 
-VulkanDevice::VulkanDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface, VkQueue& graphicsQueue, VkQueue& presentationQueue, bool enableValidationLayers)
+	// Bindless texture arrays need non uniform indexing and partially bound descriptors
+	capabilities.descriptorIndexing = descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing && descriptorIndexingFeatures.descriptorBindingPartiallyBound;
+	capabilities.timelineSemaphore = timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE;
+
+	return capabilities;
+}
+
+VulkanDevice::VulkanDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface, VkQueue& graphicsQueue, VkQueue& presentationQueue, bool enableValidationLayers, const std::string& preferredDevice)
 {
-	selectPhysicalDevice(vulkanInstance, surface);
+	selectPhysicalDevice(vulkanInstance, surface, preferredDevice);
 	createLogicalDevice(vulkanInstance, surface, graphicsQueue, presentationQueue, enableValidationLayers);
 }
 
-void VulkanDevice::selectPhysicalDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface)
+void VulkanDevice::selectPhysicalDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface, const std::string& preferredDevice)
 {
 	uint32_t deviceCount = 0;
     // This function in this call retrieve number of available Physical Devices (graphics cards)
@@ -73,20 +148,45 @@ void VulkanDevice::selectPhysicalDevice(VulkanInstance& vulkanInstance, VkSurfac
     // This function in this call retrieve available Physical Devices (graphics cards)
 	vkEnumeratePhysicalDevices(vulkanInstance.instance, &deviceCount, physicalDevices.data());
 
-	for(const VkPhysicalDevice& device: physicalDevices)
+	uint64_t bestScore = 0;
+	uint32_t chosenIndex = 0;
+
+	// Every device is reported, so logs of a node show what was available even when choice was forced
+	for(uint32_t i=0; i<deviceCount; i++)
 	{
-		if(isPhysicalDeviceSuitable(device, vulkanInstance, surface))
+		PhysicalDeviceCapabilities capabilities = queryCapabilities(physicalDevices[i]);
+		const VkPhysicalDeviceProperties& properties = capabilities.properties;
+		bool suitable = isPhysicalDeviceSuitable(physicalDevices[i], vulkanInstance, surface);
+		bool preferred = !preferredDevice.empty() && DeviceSelection::matchesPreferredDevice(capabilities, preferredDevice);
+		uint64_t score = suitable ? DeviceSelection::scorePhysicalDevice(capabilities) : 0;
+
+		YAS_LOG_INFO("Physical device {}: name=\"{}\" vendor={} type={} uuid={}", i, properties.deviceName, DeviceSelection::getVendorName(properties.vendorID), DeviceSelection::getDeviceTypeName(properties.deviceType), DeviceSelection::formatUUID(capabilities.deviceUUID));
+		YAS_LOG_INFO("Physical device {}: api={}.{}.{} driver={} deviceLocalMemoryMiB={}", i, VK_VERSION_MAJOR(properties.apiVersion), VK_VERSION_MINOR(properties.apiVersion), VK_VERSION_PATCH(properties.apiVersion), properties.driverVersion, capabilities.deviceLocalMemory / (1024 * 1024));
+		YAS_LOG_INFO("Physical device {}: dedicatedTransferQueue={} dedicatedComputeQueue={} descriptorIndexing={} timelineSemaphore={} memoryBudget={} suitable={} score={}", i, capabilities.dedicatedTransferQueue, capabilities.dedicatedComputeQueue, capabilities.descriptorIndexing, capabilities.timelineSemaphore, capabilities.memoryBudget, suitable, score);
+
+		if(!suitable || (!preferredDevice.empty() && !preferred))
+		{
+			continue;
+		}
+
+		if(physicalDevice == VK_NULL_HANDLE || score > bestScore)
 		{
-			physicalDevice = device;
-			std::cout << "YasEngine chosen physical device." << std::endl;
-			break;
+			physicalDevice = physicalDevices[i];
+			bestScore = score;
+			chosenIndex = i;
 		}
 	}
 
 	if(physicalDevice == VK_NULL_HANDLE)
 	{
+		if(!preferredDevice.empty())
+		{
+			throw std::runtime_error("Failed to find suitable graphic card matching " + preferredDevice);
+		}
 		throw std::runtime_error("Failed to find suitable graphic card");
 	}
+
+	YAS_LOG_INFO("YasEngine chosen physical device {} with score {}.", chosenIndex, bestScore);
 }
 
 void VulkanDevice::createLogicalDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface, VkQueue& graphicsQueue, VkQueue& presentationQueue, bool enableValidationLayers)
@@ -110,13 +210,22 @@ void VulkanDevice::createLogicalDevice(VulkanInstance& vulkanInstance, VkSurface
 	VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
 	physicalDeviceFeatures.samplerAnisotropy = VK_TRUE;
 
+	// Optional extension, device is used without it when it is missing
+	std::vector<const char*> deviceExtensions = vulkanInstance.layersAndExtensions->requestedDeviceExtensions;
+	memoryBudgetEnabled = queryCapabilities(physicalDevice).memoryBudget;
+
+	if(memoryBudgetEnabled)
+	{
+		deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 	createInfo.pEnabledFeatures = &physicalDeviceFeatures;
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(vulkanInstance.layersAndExtensions->requestedDeviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = vulkanInstance.layersAndExtensions->requestedDeviceExtensions.data();
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 	
 	if(enableValidationLayers)
 	{
@@ -135,4 +244,32 @@ void VulkanDevice::createLogicalDevice(VulkanInstance& vulkanInstance, VkSurface
 
 	vkGetDeviceQueue(logicalDevice, indices.graphicsFamily, 0, &graphicsQueue);
 	vkGetDeviceQueue(logicalDevice, indices.presentationFamily, 0, &presentationQueue);
-}
\ No newline at end of file
+}
+
+bool VulkanDevice::queryMemoryBudget(VkDeviceSize& budget, VkDeviceSize& usage)
+{
+	budget = 0;
+	usage = 0;
+
+	if(!memoryBudgetEnabled)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+	budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	VkPhysicalDeviceMemoryProperties2 memoryProperties2 = {};
+	memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	memoryProperties2.pNext = &budgetProperties;
+	vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memoryProperties2);
+
+	for(uint32_t i=0; i<memoryProperties2.memoryProperties.memoryHeapCount; i++)
+	{
+		if(memoryProperties2.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			budget += budgetProperties.heapBudget[i];
+			usage += budgetProperties.heapUsage[i];
+		}
+	}
+	return true;
+}
@@ -3,6 +3,7 @@
 #include"stdafx.hpp"
 #include"VulkanDevice.hpp"
 #include"VulkanInstance.hpp"
+#include"DeviceSelection.hpp"
 
 //-----------------------------------------------------------------------------|---------------------------------------|
 
@@ -12,11 +13,16 @@ class VulkanDevice
 
 		VkDevice						logicalDevice;
 		VkPhysicalDevice				physicalDevice = VK_NULL_HANDLE;
+		bool							memoryBudgetEnabled = false;
 
-										VulkanDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface, VkQueue& graphicsQueue, VkQueue& presentationQueue, bool enableValidationLayers);
+		// Preferred device is name substring or UUID, empty one picks device with highest score
+										VulkanDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface, VkQueue& graphicsQueue, VkQueue& presentationQueue, bool enableValidationLayers, const std::string& preferredDevice);
 		static bool						isPhysicalDeviceSuitable(VkPhysicalDevice physDevice, VulkanInstance& vulkanInstance, VkSurfaceKHR surface);
-		void							selectPhysicalDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface);
+		static PhysicalDeviceCapabilities	queryCapabilities(VkPhysicalDevice physDevice);
+		void							selectPhysicalDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface, const std::string& preferredDevice);
 		void							createLogicalDevice(VulkanInstance& vulkanInstance, VkSurfaceKHR& surface, VkQueue& graphicsQueue, VkQueue& presentationQueue, bool enableValidationLayers);
+		// Budget and usage of device local heaps in bytes. Returns false when VK_EXT_memory_budget is not enabled.
+		bool							queryMemoryBudget(VkDeviceSize& budget, VkDeviceSize& usage);
 
 	private:
 };
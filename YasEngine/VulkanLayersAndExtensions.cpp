@@ -10,10 +10,25 @@ VulkanLayersAndExtensions::VulkanLayersAndExtensions()
 	requestedDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
 	requestedInstanceExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#ifdef _WIN32
 	requestedInstanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#endif
 	requestedInstanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
 }
 
+void VulkanLayersAndExtensions::requestHeadlessExtensions(bool validationLayersEnabled)
+{
+	// Without surface nothing is presented so neither surface nor swapchain extensions are needed.
+	// Some ICDs (lavapipe, drivers on build machines) do not expose them at all.
+	requestedInstanceExtensions.clear();
+	requestedDeviceExtensions.clear();
+
+	if(validationLayersEnabled)
+	{
+		requestedInstanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+	}
+}
+
 bool VulkanLayersAndExtensions::CheckIfAllRequestedInstanceExtensionAreSupported()
 {
 	bool allEnabledExtensionsAreAvailable = false;
@@ -27,6 +42,11 @@ bool VulkanLayersAndExtensions::CheckIfAllRequestedInstanceExtensionAreSupported
     vkEnumerateInstanceExtensionProperties(nullptr, &numberOfAvailableExtensions, availableExtensions.data());
 	int extensionsCounter = 0;
 
+	if(requestedInstanceExtensions.empty())
+	{
+		return true;
+	}
+
 	for(size_t i=0; i<requestedInstanceExtensions.size(); i++)
 	{
 		for(int j=0; j<static_cast<int>(availableExtensions.size()); j++)
@@ -9,6 +9,7 @@ class VulkanLayersAndExtensions
 	public:
 
 		VulkanLayersAndExtensions();
+		void							requestHeadlessExtensions(bool validationLayersEnabled);
 		bool							CheckIfAllRequestedLayersAreSupported();
 		bool							CheckIfAllRequestedInstanceExtensionAreSupported();
 		bool							CheckIfAllRequestedPhysicalDeviceExtensionAreSupported(VkPhysicalDevice device);
@@ -30,7 +30,7 @@ SwapchainSupportDetails	VulkanSwapchain::querySwapchainSupport(VkPhysicalDevice
 }
 
 
-VkSurfaceFormatKHR VulkanSwapchain::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats)
+VkSurfaceFormatKHR VulkanSwapchain::chooseSwapSurfaceFormat(const ArenaVector<VkSurfaceFormatKHR>& availableFormats)
 {
 	for(const VkSurfaceFormatKHR& availableFormat: availableFormats)
 	{
@@ -44,7 +44,7 @@ VkSurfaceFormatKHR VulkanSwapchain::chooseSwapSurfaceFormat(const std::vector<Vk
 	return availableFormats[0];
 }
 
-VkPresentModeKHR VulkanSwapchain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes)
+VkPresentModeKHR VulkanSwapchain::chooseSwapPresentMode(const ArenaVector<VkPresentModeKHR>& availablePresentModes)
 {
 	VkPresentModeKHR chosenPresentMode = VK_PRESENT_MODE_FIFO_KHR;
 	//To avoid tearing it is goode idea to choose tripple buffering
@@ -61,6 +61,7 @@ VkPresentModeKHR VulkanSwapchain::chooseSwapPresentMode(const std::vector<VkPres
 	return chosenPresentMode;
 }
 
+#ifdef _WIN32
 VkExtent2D	VulkanSwapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR surfaceCapabilities, HWND& window)
 {
 	if(surfaceCapabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
@@ -81,6 +82,7 @@ VkExtent2D	VulkanSwapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR surf
 
 void VulkanSwapchain::createSwapchain(VkPhysicalDevice& physicalDevice, VkSurfaceKHR& surface, VkDevice& vulkanLogicalDevice, QueueFamilyIndices& queueIndices, HWND& window)
 {
+	ArenaScope arenaScope;
 	SwapchainSupportDetails swapchainSupport = querySwapchainSupport(physicalDevice, surface);
 	VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapchainSupport.formats);
 	VkPresentModeKHR presentMode = chooseSwapPresentMode(swapchainSupport.presentModes);
@@ -132,6 +134,7 @@ void VulkanSwapchain::createSwapchain(VkPhysicalDevice& physicalDevice, VkSurfac
 	swapchainImageFormat = surfaceFormat.format;
 	swapchainExtent = extent;
 }
+#endif
 
 void VulkanSwapchain::createImageViews(VkDevice& device, int32_t mipLevelsNumber)
 {
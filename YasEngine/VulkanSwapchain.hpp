@@ -11,7 +11,9 @@ class VulkanSwapchain
 {
 	public:
 
+#ifdef _WIN32
 		void							createSwapchain(VkPhysicalDevice& physicalDevice, VkSurfaceKHR& surface, VkDevice& vulkanLogicalDevice, QueueFamilyIndices& queueIndices, HWND& window);
+#endif
 		static SwapchainSupportDetails	querySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);		
 		void							destroySwapchain(VkDevice vulkanLogicalDevice);
 		void							createImageViews(VkDevice& device, int32_t mipLevelsNumber);
@@ -24,9 +26,11 @@ class VulkanSwapchain
 
 	private:
 
-		VkSurfaceFormatKHR				chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats);
-		VkPresentModeKHR				chooseSwapPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes);
+		VkSurfaceFormatKHR				chooseSwapSurfaceFormat(const ArenaVector<VkSurfaceFormatKHR>& availableFormats);
+		VkPresentModeKHR				chooseSwapPresentMode(const ArenaVector<VkPresentModeKHR>& availablePresentModes);
+#ifdef _WIN32
 		VkExtent2D						chooseSwapExtent(const VkSurfaceCapabilitiesKHR surfaceCapabilities, HWND& window);
+#endif
 };
 
 #endif
@@ -1,8 +1,10 @@
 #define STB_IMAGE_IMPLEMENTATION
-#define TINYOBJLOADER_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
 #include"stdafx.hpp"
 #include"YasEngine.hpp"
 #include"VariousTools.hpp"
+#include"AllocationCounter.hpp"
+#include"YasLog.hpp"
 
 //-----------------------------------------------------------------------------|---------------------------------------|---------|---------|---------|---------|---------|---------|---------|---------|
 
@@ -10,12 +12,24 @@ int YasEngine::windowPositionX				= 64;
 int YasEngine::windowPositionY				= 64;
 int YasEngine::windowWidth					= 800;
 int YasEngine::windowHeight					= 600;
-const std::string				YasEngine::MODEL_PATH="Models\\chalet.obj";
-const std::string				YasEngine::TEXTURE_PATH="Textures\\chalet.jpg";
+const std::string				YasEngine::MODEL_PATH="Models/chalet.obj";
+const std::string				YasEngine::TEXTURE_PATH="Textures/chalet.jpg";
 bool YasEngine::framebufferResized = false;
 const int MAX_FRAMES_IN_FLIGHT = 2;
-
-
+// Headless run introduces new materials after warm up frames, at most this many per frame
+const uint32_t NEW_MATERIALS_FIRST_FRAME = 10;
+const uint32_t NEW_MATERIALS_PER_FRAME = 4;
+// Streamed meshes are copies of these many procedural meshes of different sizes
+const uint32_t GEOMETRY_CHURN_VARIANTS = 8;
+// Fragmentation of geometry pool is checked once per this many frames
+const uint32_t GEOMETRY_COMPACTION_INTERVAL = 60;
+// Camera of streaming run moves over this many assets per frame and sees this many ahead of it
+const float STREAMING_ASSETS_PER_FRAME = 0.25F;
+const uint32_t STREAMING_VISIBLE_ASSETS = 16;
+// Budget of streamed meshes without --residency-budget and VK_EXT_memory_budget
+const uint64_t RESIDENCY_DEFAULT_BUDGET = 16ULL * 1024 * 1024;
+
+#ifdef _WIN32
 LRESULT CALLBACK windowProcedure(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
 	switch(message)
@@ -29,6 +43,7 @@ LRESULT CALLBACK windowProcedure(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 	}
 	return DefWindowProc(hWnd, message, wParam, lParam);
 }
+#endif
 
 // Two functions below createDebugReportCallbackEXT, destroyDebugReportCallbackEXT are part of extensions not core Vulkan API
 
@@ -65,7 +80,18 @@ void destroyDebugReportCallbackEXT(VkInstance vulkanInstance, VkDebugReportCallb
 
 VKAPI_ATTR VkBool32 VKAPI_CALL YasEngine::debugCallback	(VkDebugReportFlagsEXT debugReportFlags, VkDebugReportObjectTypeEXT objectType,	uint64_t object, size_t location, int32_t code,	const char* layerPrefix, const char* msg, void* userData)
 {
-	std::cerr << "Validation layer: " << msg << std::endl;
+	if(debugReportFlags & VK_DEBUG_REPORT_ERROR_BIT_EXT)
+	{
+		YAS_LOG_ERROR("Validation layer: {}", msg);
+	}
+	else if(debugReportFlags & (VK_DEBUG_REPORT_WARNING_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT))
+	{
+		YAS_LOG_WARNING("Validation layer: {}", msg);
+	}
+	else
+	{
+		YAS_LOG_DEBUG("Validation layer: {}", msg);
+	}
 	//If return true, then call is aborted with the VK_ERROR_VALIDATION_FAILED_EXT
 	//because this is used to test the validation layers themeselves
 	//then for now always return false
@@ -74,6 +100,7 @@ VKAPI_ATTR VkBool32 VKAPI_CALL YasEngine::debugCallback	(VkDebugReportFlagsEXT d
 
 YasEngine::YasEngine()
 {
+#ifdef _WIN32
     // Allocates a new console for the calling process.
     AllocConsole();
     // Attaches the calling process to the console of the specified process.
@@ -86,6 +113,7 @@ YasEngine::YasEngine()
 	freopen_s(&file, "CON", "w", stderr);
 	SetConsoleTitle("YasEngine logging");
     std::cout.clear();
+#endif
 }
 
 void YasEngine::setupDebugCallback()
@@ -110,16 +138,58 @@ void YasEngine::setupDebugCallback()
 	}
 }
 
-void YasEngine::run(HINSTANCE hInstance)
+#ifdef _WIN32
+void YasEngine::run(HINSTANCE hInstance, const std::string& preferredDevice)
 {
+	YasLog::start("");
+	this->preferredDevice = preferredDevice;
+	YAS_PROFILE_START("cpu_trace.json");
+	YAS_PROFILE_THREAD_NAME("Main");
 	createWindow(hInstance);
 	initializeVulkan();
 	mainLoop();
 	cleanUp();
+	YAS_PROFILE_STOP();
+	YasLog::stop();
+}
+#endif
+
+void YasEngine::runHeadless(const HeadlessSettings& settings)
+{
+	runStartNanoseconds = Clock::nanoseconds();
+	YasLog::start("");
+	YAS_PROFILE_START("cpu_trace.json");
+	YAS_PROFILE_THREAD_NAME("Main");
+	headless = true;
+	surface = VK_NULL_HANDLE;
+	offscreenExtent.width = settings.width;
+	offscreenExtent.height = settings.height;
+	charactersNumber = settings.charactersNumber;
+	occludedBoxesNumber = settings.occludedBoxesNumber;
+	cpuSkinning = settings.cpuSkinning;
+	preferredDevice = settings.preferredDevice;
+	startupTimelinePath = settings.startupTimelinePath;
+	descriptorStressSets = settings.descriptorStressSets;
+	// Variation 0 is default state, the rest are new
+	newMaterialsNumber = std::min(settings.newMaterialsNumber, PipelineCache::getVariationsNumber() - 1);
+	if(newMaterialsNumber < settings.newMaterialsNumber)
+	{
+		YAS_LOG_WARNING("Only {} distinct new materials exist", newMaterialsNumber);
+	}
+	blockingPipelines = settings.blockingPipelines;
+	geometryChurnMeshes = settings.geometryChurnMeshes;
+	streamedAssetsNumber = settings.streamedAssets;
+	residencyBudgetMegabytes = settings.residencyBudgetMegabytes;
+	initializeVulkan();
+	headlessLoop(settings);
+	cleanUp();
+	YAS_PROFILE_STOP();
+	YasLog::stop();
 }
 
 //Private functions
 
+#ifdef _WIN32
 void YasEngine::createWindow(HINSTANCE hInstance)
 {
 	WNDCLASSEX windowClassEx;
@@ -180,18 +250,18 @@ void YasEngine::createWindow(HINSTANCE hInstance)
 
 void YasEngine::mainLoop()
 {
-	float time;
-	float newTime;
-	float deltaTime;
-	float fps, fpsTime;
+	double fps, fpsTime;
 	unsigned int frames;
 	MSG message;
 
-	TimePicker* timePicker = TimePicker::getTimePicker();
-	time = timePicker->getSeconds();
-	fpsTime = 0.0F;
+	int64_t startNanoseconds = Clock::nanoseconds();
+	frameTimer.reset(startNanoseconds);
+	simulation.start(startNanoseconds);
+	fpsTime = 0.0;
 	frames = 0;
 	message.message = WM_NULL;
+	uint64_t threadAllocations = AllocationCounter::getThreadAllocations();
+	uint64_t allAllocations = AllocationCounter::getAllAllocations();
 
 	while(message.message != WM_QUIT)
 	{
@@ -202,51 +272,356 @@ void YasEngine::mainLoop()
 		}
 		else
 		{
-			newTime = timePicker->getSeconds();
-			deltaTime = newTime - time;
-			time = newTime;
-			drawFrame(deltaTime);			
+			fpsTime += frameTimer.tick(Clock::nanoseconds());
+			drawFrame();
 			frames++;
-			fpsTime = fpsTime + deltaTime;
-			if(fpsTime >= 1.0F)
+			if(fpsTime >= 1.0)
 			{
 				fps = frames / fpsTime;
+
+				if(AllocationCounter::isEnabled())
+				{
+					// Render thread alone and all threads together, workers allocate for jobs this thread started
+					uint64_t newThreadAllocations = AllocationCounter::getThreadAllocations();
+					uint64_t newAllAllocations = AllocationCounter::getAllAllocations();
+					YAS_LOG_INFO("Heap allocations per frame: render thread {} all threads {}", static_cast<double>(newThreadAllocations - threadAllocations) / frames,
+						static_cast<double>(newAllAllocations - allAllocations) / frames);
+					threadAllocations = newThreadAllocations;
+					allAllocations = newAllAllocations;
+				}
+
 				frames = 0;
-				fpsTime = 0.0F;
+				fpsTime = 0.0;
+
+				const OcclusionStatistics& occlusion = occlusionCuller.statistics;
+				float cullRate = occlusion.testedObjects > 0 ? 100.0F * occlusion.culledObjects / occlusion.testedObjects : 0.0F;
+				YAS_LOG_INFO("FPS: {} Occlusion culled: {}/{} ({}%) occluder triangles: {} rasterization: {} ms test: {} ms", fps, occlusion.culledObjects, occlusion.testedObjects, cullRate,
+					occlusion.occluderTriangles, occlusion.rasterizationMilliseconds, occlusion.testMilliseconds);
+				YAS_LOG_INFO("Draw calls: {} binds: pipeline {} vertex buffer {} index buffer {}", renderQueueStatistics.drawCalls, renderQueueStatistics.pipelineBinds,
+					renderQueueStatistics.vertexBufferBinds, renderQueueStatistics.indexBufferBinds);
+
+				for(const GpuRegionStatistics& region: gpuProfiler.getAllStatistics())
+				{
+					YAS_LOG_INFO("GPU {}: avg {} ms p50 {} ms p95 {} ms p99 {} ms", region.name, region.averageMilliseconds, region.medianMilliseconds,
+						region.percentile95Milliseconds, region.percentile99Milliseconds);
+				}
+			}
+		}
+	}
+	simulation.stop();
+}
+#endif
+
+void YasEngine::headlessLoop(const HeadlessSettings& settings)
+{
+	// Scene is animated with fixed step so every run renders the same frames and results can be compared
+	const int64_t frameStepNanoseconds = NANOSECONDS_PER_SECOND / 60;
+	std::vector<double> frameMilliseconds;
+	frameMilliseconds.reserve(settings.framesNumber);
+	int64_t firstFrameEnd = 0;
+	uint32_t lastNewMaterialsFrame = 0;
+	// Summed over all frames, statistics print averages
+	RenderQueueStatistics renderQueueTotals = {};
+	uint64_t occlusionTestedTotal = 0;
+	uint64_t occlusionCulledTotal = 0;
+
+	frameTimer.reset(0);
+	int64_t runStart = Clock::nanoseconds();
+	uint64_t threadAllocationsStart = AllocationCounter::getThreadAllocations();
+	uint64_t allAllocationsStart = AllocationCounter::getAllAllocations();
+
+	for(uint32_t i=0; i<settings.framesNumber; i++)
+	{
+		int64_t frameStart = Clock::nanoseconds();
+		frameTimer.tick(frameTimer.getLastTickNanoseconds() + frameStepNanoseconds);
+		// Ticks are computed on this thread, thread timing must not change what benchmark renders
+		simulation.advanceTo(frameTimer.getSimulationNanoseconds());
+
+		if(i >= NEW_MATERIALS_FIRST_FRAME && introducedMaterials < newMaterialsNumber)
+		{
+			introduceNewMaterials();
+			lastNewMaterialsFrame = i;
+		}
+
+		if(geometryChurnMeshes > 0)
+		{
+			churnGeometry(i);
+		}
+
+		if(streamedAssetsNumber > 0)
+		{
+			streamAssets(i);
+		}
+
+		drawHeadlessFrame();
+		frameMilliseconds.push_back(Clock::toSeconds(Clock::nanoseconds() - frameStart) * 1000.0);
+		renderQueueTotals.drawCalls += renderQueueStatistics.drawCalls;
+		renderQueueTotals.pipelineBinds += renderQueueStatistics.pipelineBinds;
+		renderQueueTotals.vertexBufferBinds += renderQueueStatistics.vertexBufferBinds;
+		renderQueueTotals.indexBufferBinds += renderQueueStatistics.indexBufferBinds;
+		occlusionTestedTotal += occlusionCuller.statistics.testedObjects;
+		occlusionCulledTotal += occlusionCuller.statistics.culledObjects;
+
+		// Submitted on CPU, GPU may still be drawing it
+		if(i == 0)
+		{
+			firstFrameEnd = Clock::nanoseconds();
+		}
+	}
+
+	vkDeviceWaitIdle(vulkanDevice->logicalDevice);
+	double runSeconds = Clock::toSeconds(Clock::nanoseconds() - runStart);
+	uint64_t threadAllocations = AllocationCounter::getThreadAllocations() - threadAllocationsStart;
+	uint64_t allAllocations = AllocationCounter::getAllAllocations() - allAllocationsStart;
+
+	if(!frameMilliseconds.empty())
+	{
+		std::vector<double> sorted = frameMilliseconds;
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum = 0.0;
+		for(double milliseconds: sorted)
+		{
+			sum += milliseconds;
+		}
+
+		// Nearest rank percentiles, the same as GPU profiler
+		const size_t last = sorted.size() - 1;
+
+		// Frame which took more than twice the median is a hitch
+		uint32_t hitchFrames = 0;
+		uint32_t newMaterialsHitchFrames = 0;
+		for(uint32_t i=0; i<frameMilliseconds.size(); i++)
+		{
+			if(frameMilliseconds[i] > 2.0 * sorted[last / 2])
+			{
+				hitchFrames++;
+				if(introducedMaterials > 0 && i >= NEW_MATERIALS_FIRST_FRAME && i <= lastNewMaterialsFrame)
+				{
+					newMaterialsHitchFrames++;
+				}
+			}
+		}
+
+		std::ostringstream statistics;
+		statistics << "frames " << sorted.size() << "\n"
+			<< "resolution " << offscreenExtent.width << "x" << offscreenExtent.height << "\n"
+			<< "startup_ms " << Clock::toSeconds(startupNanoseconds) * 1000.0 << "\n"
+			<< "time_to_first_frame_ms " << Clock::toSeconds(firstFrameEnd - runStartNanoseconds) * 1000.0 << "\n"
+			<< "fps " << (runSeconds > 0.0 ? sorted.size() / runSeconds : 0.0) << "\n"
+			<< "cpu_frame_avg_ms " << sum / sorted.size() << "\n"
+			<< "cpu_frame_min_ms " << sorted[0] << "\n"
+			<< "cpu_frame_p50_ms " << sorted[last / 2] << "\n"
+			<< "cpu_frame_p95_ms " << sorted[(last * 95 + 50) / 100] << "\n"
+			<< "cpu_frame_p99_ms " << sorted[(last * 99 + 50) / 100] << "\n"
+			<< "cpu_frame_max_ms " << sorted[last] << "\n"
+			<< "hitch_frames " << hitchFrames << "\n";
+
+		// With shared pool buffers every static mesh draws without binding its own vertex and index buffer
+		GeometryPoolStatistics geometryStatistics = geometryPool.getStatistics();
+		statistics << "draw_calls_per_frame " << static_cast<double>(renderQueueTotals.drawCalls) / sorted.size() << "\n"
+			<< "pipeline_binds_per_frame " << static_cast<double>(renderQueueTotals.pipelineBinds) / sorted.size() << "\n"
+			<< "vertex_buffer_binds_per_frame " << static_cast<double>(renderQueueTotals.vertexBufferBinds) / sorted.size() << "\n"
+			<< "index_buffer_binds_per_frame " << static_cast<double>(renderQueueTotals.indexBufferBinds) / sorted.size() << "\n"
+			<< "occlusion_tested_per_frame " << static_cast<double>(occlusionTestedTotal) / sorted.size() << "\n"
+			<< "occlusion_culled_per_frame " << static_cast<double>(occlusionCulledTotal) / sorted.size() << "\n"
+			<< "geometry_meshes " << geometryStatistics.meshesNumber << "\n"
+			<< "geometry_vertices_used " << geometryStatistics.verticesUsed << "/" << geometryStatistics.verticesCapacity << "\n"
+			<< "geometry_indices_used " << geometryStatistics.indicesUsed << "/" << geometryStatistics.indicesCapacity << "\n"
+			<< "geometry_vertex_free_ranges " << geometryStatistics.vertexFreeRanges << "\n"
+			<< "geometry_index_free_ranges " << geometryStatistics.indexFreeRanges << "\n"
+			<< "geometry_vertex_fragmentation " << geometryStatistics.vertexFragmentation << "\n"
+			<< "geometry_index_fragmentation " << geometryStatistics.indexFragmentation << "\n";
+
+		if(geometryChurnMeshes > 0)
+		{
+			statistics << "geometry_meshes_loaded " << geometryStatistics.meshesAdded << "\n"
+				<< "geometry_meshes_unloaded " << geometryStatistics.meshesRemoved << "\n"
+				<< "geometry_vertex_fragmentation_max " << maxVertexFragmentation << "\n"
+				<< "geometry_index_fragmentation_max " << maxIndexFragmentation << "\n"
+				<< "geometry_compactions " << geometryStatistics.compactions << "\n"
+				<< "geometry_compaction_avg_ms " << (geometryStatistics.compactions > 0 ? Clock::toSeconds(geometryCompactionNanoseconds) * 1000.0 / geometryStatistics.compactions : 0.0) << "\n";
+		}
+
+		if(streamedAssetsNumber > 0)
+		{
+			ResidencyStatistics residencyStatistics = residencyCache.getStatistics();
+			statistics << "streamed_assets " << residencyStatistics.resourcesNumber << "\n"
+				<< "residency_budget_mb " << residencyStatistics.budget / (1024.0 * 1024.0) << "\n"
+				<< "residency_resident_mb " << residencyStatistics.residentSize / (1024.0 * 1024.0) << "\n"
+				<< "residency_peak_mb " << residencyStatistics.peakResidentSize / (1024.0 * 1024.0) << "\n"
+				<< "residency_resident_assets " << residencyStatistics.residentNumber << "\n"
+				<< "residency_hit_rate " << residencyCache.getHitRate() << "\n"
+				<< "residency_misses " << residencyStatistics.misses << "\n"
+				<< "residency_evictions " << residencyStatistics.evictions << "\n"
+				<< "residency_destructions " << residencyStatistics.destructions << "\n"
+				<< "residency_over_budget_frames " << residencyStatistics.overBudgetFrames << "\n";
+		}
+
+		if(newMaterialsNumber > 0)
+		{
+			PipelineCacheStatistics pipelineStatistics = pipelineCache.getStatistics();
+			uint32_t compilations = pipelineStatistics.backgroundCompilations + pipelineStatistics.blockingCompilations;
+			statistics << "new_materials " << introducedMaterials << "\n"
+				<< "new_materials_frames " << (introducedMaterials > 0 ? lastNewMaterialsFrame - NEW_MATERIALS_FIRST_FRAME + 1 : 0) << "\n"
+				<< "hitch_frames_while_introducing " << newMaterialsHitchFrames << "\n"
+				<< "pipeline_fallback_draws " << fallbackDraws << "\n"
+				<< "pipelines_compiled_background " << pipelineStatistics.backgroundCompilations << "\n"
+				<< "pipelines_compiled_blocking " << pipelineStatistics.blockingCompilations << "\n"
+				<< "pipeline_compile_avg_ms " << (compilations > 0 ? Clock::toSeconds(pipelineStatistics.compileNanoseconds) * 1000.0 / compilations : 0.0) << "\n"
+				<< "pipeline_compile_max_ms " << Clock::toSeconds(pipelineStatistics.maxCompileNanoseconds) * 1000.0 << "\n";
+		}
+
+		if(descriptorStressSets > 0)
+		{
+			// Rate of allocating and writing one set, timed only over stress loop
+			uint64_t stressAllocations = static_cast<uint64_t>(descriptorStressSets) * sorted.size();
+			statistics << "descriptor_stress_sets_per_frame " << descriptorStressSets << "\n"
+				<< "descriptor_allocations_per_second " << (descriptorStressNanoseconds > 0 ? stressAllocations / Clock::toSeconds(descriptorStressNanoseconds) : 0.0) << "\n"
+				<< "descriptor_pools " << frameDescriptorAllocator.getPoolsNumber() + descriptorAllocator.getPoolsNumber() << "\n";
+		}
+
+		if(AllocationCounter::isEnabled())
+		{
+			statistics << "heap_allocations_per_frame " << static_cast<double>(threadAllocations) / sorted.size() << "\n"
+				<< "heap_allocations_per_frame_all_threads " << static_cast<double>(allAllocations) / sorted.size() << "\n";
+		}
+
+		for(const GpuRegionStatistics& region: gpuProfiler.getAllStatistics())
+		{
+			statistics << "gpu \"" << region.name << "\" avg " << region.averageMilliseconds << " p50 " << region.medianMilliseconds
+				<< " p95 " << region.percentile95Milliseconds << " p99 " << region.percentile99Milliseconds << " max " << region.maxMilliseconds << "\n";
+		}
+
+		// Statistics are printed after everything logged during run
+		YasLog::flush();
+		std::cout << statistics.str();
+
+		if(!settings.statisticsPath.empty())
+		{
+			std::ofstream statisticsFile(settings.statisticsPath, std::ios::trunc);
+
+			if(!statisticsFile.is_open())
+			{
+				throw std::runtime_error("Failed to create statistics file");
 			}
+			statisticsFile << statistics.str();
 		}
+
+		// Boxes behind wall are hidden in every frame, culling which never hides anything is broken
+		if(occludedBoxesNumber > 0 && occlusionCulledTotal == 0)
+		{
+			throw std::runtime_error("Occlusion culling did not cull any of boxes behind occluder wall");
+		}
+	}
+
+	if(!settings.screenshotPath.empty() && settings.framesNumber > 0)
+	{
+		saveOffscreenImage(lastImageIndex, settings.screenshotPath);
 	}
 }
 
 void YasEngine::initializeVulkan()
 {
-	createVulkanInstance();
-	setupDebugCallback();
-	createSurface();
-	vulkanDevice = new VulkanDevice(vulkanInstance, surface, graphicsQueue, presentationQueue, enableValidationLayers);
-	createSwapchain();
-	createImageViews();
-	createRenderPass();
-	createDescriptorSetLayout();
-	createGraphicsPipeline();
-	createCommandPool();
-	createDepthResources();
-	createFramebuffers();
-	createTextureImage();
-	createTextureImageView();
-	createTextureSampler();
-	loadModel();
-	createVertexBuffer();
-	createIndexBuffer();
-	createUniformBuffers();
-    createDescriptorPool();
-    createDescriptorSets();
-	createCommandBuffers();
-	createSyncObjects();
+	YAS_PROFILE_FUNCTION();
+	jobSystem.initialize(std::max(std::thread::hardware_concurrency(), 1U));
+	frameArena.initialize(MAX_FRAMES_IN_FLIGHT, FRAME_ARENA_SIZE);
+
+	// File reading and decoding do not wait for device, Vulkan objects wait only for what they use.
+	// Steps which record into command pool and submit to graphics queue are chained, both are externally synchronized.
+	InitGraph initGraph;
+	const uint32_t assetArchiveStep = initGraph.addStep("openAssetArchive", [this]
+	{
+		if(assetArchive.open(ASSET_ARCHIVE_PATH))
+		{
+			YAS_LOG_INFO("Asset archive {} with {} entries is used instead of loose files", ASSET_ARCHIVE_PATH, assetArchive.getEntriesNumber());
+		}
+	}, {});
+	const uint32_t decodeTextureStep = initGraph.addStep("decodeTexture", [this] { decodeTexture(); }, {assetArchiveStep});
+	const uint32_t loadModelStep = initGraph.addStep("loadModel", [this] { loadModel(); }, {assetArchiveStep});
+	const uint32_t openShaderPackStep = initGraph.addStep("openShaderPack", [this] { shaderVariantCache.openShaderPack(assetArchive); }, {assetArchiveStep});
+	const uint32_t instanceStep = initGraph.addStep("createVulkanInstance", [this] { createVulkanInstance(); }, {});
+	const uint32_t debugCallbackStep = initGraph.addStep("setupDebugCallback", [this] { setupDebugCallback(); }, {instanceStep});
+	const uint32_t surfaceStep = initGraph.addStep("createSurface", [this]
+	{
+#ifdef _WIN32
+		if(!headless)
+		{
+			createSurface();
+		}
+#endif
+	}, {instanceStep});
+	const uint32_t deviceStep = initGraph.addStep("createDevice", [this]
+	{
+		vulkanDevice = new VulkanDevice(vulkanInstance, surface, graphicsQueue, presentationQueue, enableValidationLayers, preferredDevice);
+	}, {debugCallbackStep, surfaceStep});
+	const uint32_t shaderCacheStep = initGraph.addStep("initializeShaderCache", [this] { shaderVariantCache.initialize(vulkanDevice->logicalDevice); }, {openShaderPackStep, deviceStep});
+	const uint32_t pipelineCacheStep = initGraph.addStep("initializePipelineCache", [this] { pipelineCache.initialize(vulkanDevice->logicalDevice, shaderVariantCache); }, {shaderCacheStep});
+	const uint32_t swapchainStep = initGraph.addStep("createSwapchain", [this] { createSwapchain(); }, {deviceStep});
+	const uint32_t gpuProfilerStep = initGraph.addStep("initializeGpuProfiler", [this]
+	{
+		gpuProfiler.initialize(vulkanDevice->physicalDevice, vulkanDevice->logicalDevice, findQueueFamilies(vulkanDevice->physicalDevice, surface).graphicsFamily, static_cast<uint32_t>(vulkanSwapchain.swapchainImages.size()));
+	}, {swapchainStep});
+	const uint32_t imageViewsStep = initGraph.addStep("createImageViews", [this] { createImageViews(); }, {swapchainStep});
+	const uint32_t renderPassStep = initGraph.addStep("createRenderPass", [this] { createRenderPass(); }, {swapchainStep});
+	const uint32_t descriptorAllocatorsStep = initGraph.addStep("createDescriptorAllocators", [this] { createDescriptorAllocators(); }, {deviceStep});
+	const uint32_t descriptorSetLayoutStep = initGraph.addStep("createDescriptorSetLayout", [this] { createDescriptorSetLayout(); }, {descriptorAllocatorsStep});
+	const uint32_t graphicsPipelineStep = initGraph.addStep("createGraphicsPipeline", [this] { createGraphicsPipeline(); }, {pipelineCacheStep, renderPassStep, descriptorSetLayoutStep});
+	const uint32_t commandPoolStep = initGraph.addStep("createCommandPool", [this] { createCommandPool(); }, {deviceStep});
+	// Immediate command buffers are measured by GPU profiler, so queue chain starts after it
+	const uint32_t depthResourcesStep = initGraph.addStep("createDepthResources", [this] { createDepthResources(); }, {commandPoolStep, gpuProfilerStep});
+	const uint32_t framebuffersStep = initGraph.addStep("createFramebuffers", [this] { createFramebuffers(); }, {imageViewsStep, renderPassStep, depthResourcesStep});
+	const uint32_t textureImageStep = initGraph.addStep("createTextureImage", [this] { createTextureImage(); }, {decodeTextureStep, depthResourcesStep});
+	initGraph.addStep("createTextureImageView", [this] { createTextureImageView(); }, {textureImageStep});
+	initGraph.addStep("createTextureSampler", [this] { createTextureSampler(); }, {textureImageStep});
+	const uint32_t charactersStep = initGraph.addStep("createCharacters", [this] { createCharacters(); }, {loadModelStep});
+	// Render objects and materials are appended by one step after another
+	const uint32_t occluderSceneStep = initGraph.addStep("createOccluderScene", [this] { createOccluderScene(); }, {charactersStep});
+	initGraph.addStep("createSimulation", [this] { createSimulation(); }, {occluderSceneStep});
+	const uint32_t churnMeshesStep = initGraph.addStep("createChurnMeshes", [this] { createChurnMeshes(); }, {});
+	initGraph.addStep("createResidencyCache", [this] { createResidencyCache(); }, {deviceStep, churnMeshesStep});
+	initGraph.addStep("initializeOcclusionCuller", [this] { occlusionCuller.initialize(&jobSystem); }, {});
+	const uint32_t geometryBuffersStep = initGraph.addStep("createGeometryBuffers", [this] { createGeometryBuffers(); }, {occluderSceneStep, textureImageStep});
+	initGraph.addStep("createUniformBuffers", [this] { createUniformBuffers(); }, {swapchainStep});
+	const uint32_t skinningResourcesStep = initGraph.addStep("createSkinningResources", [this] { createSkinningResources(); }, {shaderCacheStep, descriptorAllocatorsStep, geometryBuffersStep});
+	initGraph.addStep("createCommandBuffers", [this] { createCommandBuffers(); }, {framebuffersStep, skinningResourcesStep});
+	initGraph.addStep("createSyncObjects", [this] { createSyncObjects(); }, {deviceStep});
+
+	// Fallback pipeline already exists, pipelines of materials used by scene are compiled meanwhile buffers are uploaded and first frames are drawn
+	initGraph.addStep("startPipelinePrecompilation", [this]
+	{
+		startPipelinePrecompilation();
+		shaderVariantCache.startBackgroundCompilation();
+	}, {graphicsPipelineStep, occluderSceneStep});
+
+	initGraph.run(jobSystem);
+	startupNanoseconds = initGraph.getDurationNanoseconds();
+
+	for(const InitStepTiming& timing: initGraph.getTimeline())
+	{
+		YAS_LOG_DEBUG("Startup step {} on worker {}: {} ms", timing.name, timing.worker, Clock::toSeconds(timing.endNanoseconds - timing.beginNanoseconds) * 1000.0);
+	}
+
+	if(!startupTimelinePath.empty())
+	{
+		initGraph.writeTimeline(startupTimelinePath);
+	}
+
+	YAS_LOG_INFO("Vulkan initialized in {} ms", Clock::toSeconds(startupNanoseconds) * 1000.0);
 }
 
 void YasEngine::createVulkanInstance()
 {
+	if(headless)
+	{
+		// Build machines and containers often have only ICD installed, benchmark runs without validation there
+		if(enableValidationLayers && !vulkanInstance.layersAndExtensions->CheckIfAllRequestedLayersAreSupported())
+		{
+			YAS_LOG_WARNING("Validation layers not available, headless run continues without them");
+			enableValidationLayers = false;
+		}
+		vulkanInstance.layersAndExtensions->requestHeadlessExtensions(enableValidationLayers);
+	}
 	vulkanInstance.createVulkanInstance(enableValidationLayers);
 }
 
@@ -257,6 +632,8 @@ void YasEngine::createCommandPool()
 	VkCommandPoolCreateInfo commandPoolCreateInfo = {};
 	commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+	// Command buffers are recorded again every frame because per draw data goes through push constants
+	commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
 	if(vkCreateCommandPool(vulkanDevice->logicalDevice, &commandPoolCreateInfo, nullptr, &commandPool) != VK_SUCCESS)
 	{
@@ -264,47 +641,280 @@ void YasEngine::createCommandPool()
 	}
 }
 
-void YasEngine::createVertexBuffer()
+void YasEngine::createGeometryBuffers()
 {
-	//VkDeviceSize is alias to uint64_t
-	VkDeviceSize vertexBufferSize = sizeof(vertices[0]) * vertices.size();
+	GeometryPoolStatistics geometryStatistics = geometryPool.getStatistics();
+
+	// Compaction copies from old buffers into new ones, so pool buffers are transfer sources too
+	createBuffer(sizeof(Vertex) * geometryStatistics.verticesCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
+	createBuffer(sizeof(uint32_t) * geometryStatistics.indicesCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+
+	uploadGeometry(0, static_cast<uint32_t>(geometryPool.getVertices().size()), 0, static_cast<uint32_t>(geometryPool.getIndices().size()));
+}
+
+void YasEngine::uploadGeometry(uint32_t firstVertex, uint32_t verticesNumber, uint32_t firstIndex, uint32_t indicesNumber)
+{
+	const VkDeviceSize verticesSize = sizeof(Vertex) * verticesNumber;
+	const VkDeviceSize indicesSize = sizeof(uint32_t) * indicesNumber;
+
+	if(verticesSize + indicesSize == 0)
+	{
+		return;
+	}
+
+	// Vertices and indices share one staging buffer and one submit
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
 
-	createBuffer(vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	createBuffer(verticesSize + indicesSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
 
-	void* data;
+	char* mappedData;
 
-	vkMapMemory(vulkanDevice->logicalDevice, stagingBufferMemory, 0, vertexBufferSize, 0, &data);
-	memcpy(data, vertices.data(), (size_t)vertexBufferSize);
+	vkMapMemory(vulkanDevice->logicalDevice, stagingBufferMemory, 0, verticesSize + indicesSize, 0, reinterpret_cast<void**>(&mappedData));
+	memcpy(mappedData, geometryPool.getVertices().data() + firstVertex, static_cast<size_t>(verticesSize));
+	memcpy(mappedData + verticesSize, geometryPool.getIndices().data() + firstIndex, static_cast<size_t>(indicesSize));
 	vkUnmapMemory(vulkanDevice->logicalDevice, stagingBufferMemory);
 
-	createBuffer(vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
-	copyBuffer(stagingBuffer, vertexBuffer, vertexBufferSize);
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands("Geometry upload");
+
+	if(verticesSize > 0)
+	{
+		VkBufferCopy copyRegion = {0, sizeof(Vertex) * firstVertex, verticesSize};
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, vertexBuffer, 1, &copyRegion);
+	}
+
+	if(indicesSize > 0)
+	{
+		VkBufferCopy copyRegion = {verticesSize, sizeof(uint32_t) * firstIndex, indicesSize};
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, indexBuffer, 1, &copyRegion);
+	}
+
+	endSingleTimeCommands(commandBuffer);
 
 	vkDestroyBuffer(vulkanDevice->logicalDevice, stagingBuffer, nullptr);
 	vkFreeMemory(vulkanDevice->logicalDevice, stagingBufferMemory, nullptr);
 }
 
-void YasEngine::createIndexBuffer()
+void YasEngine::compactGeometryPool()
+{
+	YAS_PROFILE_FUNCTION();
+	int64_t compactionStart = Clock::nanoseconds();
+
+	std::vector<VkBufferCopy> vertexCopies;
+	std::vector<VkBufferCopy> indexCopies;
+	geometryPool.compact(vertexCopies, indexCopies);
+
+	// Frames in flight still draw from old buffers, live meshes are copied into new ones on GPU instead of being uploaded again
+	GeometryPoolStatistics geometryStatistics = geometryPool.getStatistics();
+	VkBuffer newVertexBuffer;
+	VkDeviceMemory newVertexBufferMemory;
+	VkBuffer newIndexBuffer;
+	VkDeviceMemory newIndexBufferMemory;
+
+	createBuffer(sizeof(Vertex) * geometryStatistics.verticesCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, newVertexBuffer, newVertexBufferMemory);
+	createBuffer(sizeof(uint32_t) * geometryStatistics.indicesCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, newIndexBuffer, newIndexBufferMemory);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands("Geometry compaction");
+
+	if(!vertexCopies.empty())
+	{
+		vkCmdCopyBuffer(commandBuffer, vertexBuffer, newVertexBuffer, static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+	}
+
+	if(!indexCopies.empty())
+	{
+		vkCmdCopyBuffer(commandBuffer, indexBuffer, newIndexBuffer, static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+	}
+
+	// Waits until queue is idle, so no frame reads old buffers anymore
+	endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(vulkanDevice->logicalDevice, indexBuffer, nullptr);
+	vkFreeMemory(vulkanDevice->logicalDevice, indexBufferMemory, nullptr);
+	vkDestroyBuffer(vulkanDevice->logicalDevice, vertexBuffer, nullptr);
+	vkFreeMemory(vulkanDevice->logicalDevice, vertexBufferMemory, nullptr);
+
+	vertexBuffer = newVertexBuffer;
+	vertexBufferMemory = newVertexBufferMemory;
+	indexBuffer = newIndexBuffer;
+	indexBufferMemory = newIndexBufferMemory;
+
+	updateRenderObjectGeometry();
+	geometryCompactionNanoseconds += Clock::nanoseconds() - compactionStart;
+}
+
+void YasEngine::updateRenderObjectGeometry()
+{
+	for(RenderObject& renderObject: renderObjects)
+	{
+		const GeometryMesh& mesh = geometryPool.getMesh(renderObject.meshIndex);
+		renderObject.firstIndex = mesh.firstIndex;
+
+		// Skinned vertices are not in pool, their offset points into skinned vertex buffer
+		if(!renderObject.isSkinned)
+		{
+			renderObject.vertexOffset = static_cast<int32_t>(mesh.firstVertex);
+		}
+	}
+}
+
+void YasEngine::createChurnMeshes()
+{
+	if(geometryChurnMeshes == 0 && streamedAssetsNumber == 0)
+	{
+		return;
+	}
+
+	// Sizes range from under a hundred to a few thousand vertices, so freed ranges rarely fit exactly
+	churnMeshes.resize(GEOMETRY_CHURN_VARIANTS);
+
+	for(uint32_t i=0; i<GEOMETRY_CHURN_VARIANTS; i++)
+	{
+		SkinningPass::createTestMesh(2 + 2 * i, TEST_CHARACTER_RINGS_PER_JOINT, 8 << (i % 4), churnMeshes[i]);
+	}
+}
+
+uint32_t YasEngine::loadStreamedMesh(const SkinnedMesh& mesh)
+{
+	const uint32_t verticesNumber = static_cast<uint32_t>(mesh.vertices.size());
+	const uint32_t indicesNumber = static_cast<uint32_t>(mesh.indices.size());
+	uint32_t poolMesh = geometryPool.addMesh(mesh.vertices.data(), verticesNumber, mesh.indices.data(), indicesNumber);
+
+	// Enough space can be free while no single range is large enough
+	if(poolMesh == NO_GEOMETRY_MESH)
+	{
+		compactGeometryPool();
+		poolMesh = geometryPool.addMesh(mesh.vertices.data(), verticesNumber, mesh.indices.data(), indicesNumber);
+
+		if(poolMesh == NO_GEOMETRY_MESH)
+		{
+			throw std::runtime_error("Geometry pool is full");
+		}
+	}
+
+	const GeometryMesh& geometryMesh = geometryPool.getMesh(poolMesh);
+	uploadGeometry(geometryMesh.firstVertex, geometryMesh.verticesNumber, geometryMesh.firstIndex, geometryMesh.indicesNumber);
+	return poolMesh;
+}
+
+void YasEngine::churnGeometry(uint32_t frame)
+{
+	YAS_PROFILE_FUNCTION();
+
+	// Hash of frame number picks meshes, every run loads and unloads the same ones
+	uint32_t random = frame * 2654435761U;
+
+	if(streamedMeshes.size() >= geometryChurnMeshes)
+	{
+		uint32_t unloaded = (random >> 8) % static_cast<uint32_t>(streamedMeshes.size());
+		geometryPool.removeMesh(streamedMeshes[unloaded]);
+		streamedMeshes[unloaded] = streamedMeshes.back();
+		streamedMeshes.pop_back();
+	}
+
+	streamedMeshes.push_back(loadStreamedMesh(churnMeshes[(random >> 16) % GEOMETRY_CHURN_VARIANTS]));
+
+	GeometryPoolStatistics geometryStatistics = geometryPool.getStatistics();
+	maxVertexFragmentation = std::max(maxVertexFragmentation, geometryStatistics.vertexFragmentation);
+	maxIndexFragmentation = std::max(maxIndexFragmentation, geometryStatistics.indexFragmentation);
+
+	if(frame % GEOMETRY_COMPACTION_INTERVAL == GEOMETRY_COMPACTION_INTERVAL - 1 && geometryPool.needsCompaction())
+	{
+		compactGeometryPool();
+	}
+}
+
+void YasEngine::createResidencyCache()
+{
+	if(streamedAssetsNumber == 0)
+	{
+		return;
+	}
+
+	uint64_t budget = RESIDENCY_DEFAULT_BUDGET;
+	VkDeviceSize heapBudget;
+	VkDeviceSize heapUsage;
+
+	if(residencyBudgetMegabytes > 0)
+	{
+		budget = residencyBudgetMegabytes * 1024ULL * 1024;
+	}
+	else if(vulkanDevice->queryMemoryBudget(heapBudget, heapUsage))
+	{
+		// Half of what is left, the rest stays for other resources of engine and other applications
+		budget = heapBudget > heapUsage ? (heapBudget - heapUsage) / 2 : 0;
+		YAS_LOG_INFO("Device local memory budget {} MB, used {} MB", heapBudget / (1024 * 1024), heapUsage / (1024 * 1024));
+	}
+
+	// Streamed meshes live in spare space of pool. Half of it leaves room for meshes of evicted assets
+	// until they are destroyed and for vertex and index parts of meshes not having the same proportions as pool.
+	const uint64_t poolSpareSize = sizeof(Vertex) * static_cast<uint64_t>(GEOMETRY_POOL_SPARE_VERTICES) + sizeof(uint32_t) * static_cast<uint64_t>(GEOMETRY_POOL_SPARE_INDICES);
+	budget = std::min(budget, poolSpareSize / 2);
+	YAS_LOG_INFO("Residency budget of {} streamed assets is {} MB", streamedAssetsNumber, budget / (1024.0 * 1024.0));
+
+	residencyCache.initialize(budget, MAX_FRAMES_IN_FLIGHT);
+	streamedAssetMeshes.assign(streamedAssetsNumber, NO_GEOMETRY_MESH);
+
+	for(uint32_t i=0; i<streamedAssetsNumber; i++)
+	{
+		const SkinnedMesh& mesh = churnMeshes[i % GEOMETRY_CHURN_VARIANTS];
+		residencyCache.addResource(sizeof(Vertex) * mesh.vertices.size() + sizeof(uint32_t) * mesh.indices.size());
+	}
+}
+
+void YasEngine::streamAssets(uint32_t frame)
+{
+	YAS_PROFILE_FUNCTION();
+
+	// Camera moves forward through level, which repeats after its last asset.
+	// One more asset anywhere in level is seen every frame, as when camera looks around.
+	const uint32_t position = static_cast<uint32_t>(frame * STREAMING_ASSETS_PER_FRAME);
+
+	for(uint32_t i=0; i<=STREAMING_VISIBLE_ASSETS; i++)
+	{
+		uint32_t asset = i < STREAMING_VISIBLE_ASSETS ? (position + i) % streamedAssetsNumber : ((frame * 2654435761U) >> 8) % streamedAssetsNumber;
+
+		if(residencyCache.request(asset))
+		{
+			streamedAssetMeshes[asset] = loadStreamedMesh(churnMeshes[asset % GEOMETRY_CHURN_VARIANTS]);
+		}
+	}
+}
+
+void YasEngine::destroyEvictedAssets()
+{
+	destroyedAssets.clear();
+	residencyCache.advanceFrame(destroyedAssets);
+
+	for(uint32_t asset: destroyedAssets)
+	{
+		geometryPool.removeMesh(streamedAssetMeshes[asset]);
+		streamedAssetMeshes[asset] = NO_GEOMETRY_MESH;
+	}
+}
+
+void YasEngine::createDeviceLocalBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
 {
-	VkDeviceSize indexBufferSize = sizeof(indices[0]) * indices.size();
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
 
-	createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT	| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
 
-	void* data;
+	void* mappedData;
 
-	vkMapMemory(vulkanDevice->logicalDevice, stagingBufferMemory, 0, indexBufferSize, 0, &data);
-	memcpy(data, indices.data(), (size_t)indexBufferSize);
+	vkMapMemory(vulkanDevice->logicalDevice, stagingBufferMemory, 0, size, 0, &mappedData);
+	memcpy(mappedData, data, (size_t)size);
 	vkUnmapMemory(vulkanDevice->logicalDevice, stagingBufferMemory);
 
-	createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
-	copyBuffer(stagingBuffer, indexBuffer, indexBufferSize);
+	createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+	copyBuffer(stagingBuffer, buffer, size);
 
 	vkDestroyBuffer(vulkanDevice->logicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(vulkanDevice->logicalDevice, stagingBufferMemory, nullptr);	
+	vkFreeMemory(vulkanDevice->logicalDevice, stagingBufferMemory, nullptr);
 }
 
 uint32_t YasEngine::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags memoryPropertiesFlags)
@@ -337,59 +947,141 @@ void YasEngine::createCommandBuffers()
 	{
 		throw std::runtime_error("Failed to allocatae command buffers.");
 	}
+}
+
+void YasEngine::recordCommandBuffer(uint32_t imageIndex)
+{
+	YAS_PROFILE_FUNCTION();
+	VkCommandBuffer commandBuffer = commandBuffers[imageIndex];
 
-	for(size_t i=0; i<commandBuffers.size(); i++)
+	vkResetCommandBuffer(commandBuffer, 0);
+
+	VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+	commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if(vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
 	{
-		VkCommandBufferBeginInfo commandBufferBeginInfo = {};
-		commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		throw std::runtime_error("Failed to begin recording command buffer.");
+	}
+
+	gpuProfiler.beginFrame(commandBuffer, imageIndex);
+	uint32_t frameRegion = gpuProfiler.beginRegion(commandBuffer, "Frame");
 
-		if(vkBeginCommandBuffer(commandBuffers[i], &commandBufferBeginInfo) != VK_SUCCESS)
+	VkRenderPassBeginInfo renderPassBeginInfo = {};
+	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassBeginInfo.renderPass = renderPass;
+	renderPassBeginInfo.framebuffer = swapchainFramebuffers[imageIndex];
+	renderPassBeginInfo.renderArea.offset = {0, 0};
+	renderPassBeginInfo.renderArea.extent = vulkanSwapchain.swapchainExtent;
+
+	std::array<VkClearValue, 2> clearValues = {};
+	clearValues[0].color = {0.0F, 0.0F, 0.0F, 1.0F};
+	clearValues[1].depthStencil = {1.0F, 0};
+
+	renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassBeginInfo.pClearValues = clearValues.data();
+
+	renderQueue.clear(frameArena.current(), visibleRenderObjects.size());
+	VkDescriptorSet sceneDescriptorSet = writeSceneDescriptorSet(imageIndex);
+
+	// Stress sets are only allocated and written, what is drawn does not change
+	if(descriptorStressSets > 0)
+	{
+		int64_t stressStart = Clock::nanoseconds();
+		for(uint32_t i=0; i<descriptorStressSets; i++)
 		{
-			throw std::runtime_error("Failed to begin recording command buffer.");
+			writeSceneDescriptorSet(imageIndex);
 		}
+		descriptorStressNanoseconds += Clock::nanoseconds() - stressStart;
+	}
 
-		VkRenderPassBeginInfo renderPassBeginInfo = {};
-		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassBeginInfo.renderPass = renderPass;
-		renderPassBeginInfo.framebuffer = swapchainFramebuffers[i];
-		renderPassBeginInfo.renderArea.offset = {0, 0};
-		renderPassBeginInfo.renderArea.extent = vulkanSwapchain.swapchainExtent;
+	// Only objects which survived occlusion culling are drawn
+	for(uint32_t renderObjectIndex: visibleRenderObjects)
+	{
+		const RenderObject& renderObject = renderObjects[renderObjectIndex];
+
+		// Key groups draws by pipeline which is really bound, fallback included, then front to back by view depth of bounds center
+		uint32_t pipelineId;
+		DrawPacket drawPacket = {};
+		drawPacket.pipeline = getMaterialPipeline(renderObject.material, pipelineId);
+		const glm::vec3 center = (renderObject.boundsMin + renderObject.boundsMax) * 0.5F;
+		const glm::mat4& modelViewProjection = modelViewProjections[renderObjectIndex];
+		const float viewDepth = modelViewProjection[0][3] * center.x + modelViewProjection[1][3] * center.y + modelViewProjection[2][3] * center.z + modelViewProjection[3][3];
+		drawPacket.sortKey = makeSortKey(0, pipelineId, renderObject.material, renderObject.meshIndex, quantizeDepth(viewDepth, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE));
+		drawPacket.pipelineLayout = pipelineLayout;
+		drawPacket.descriptorSet = sceneDescriptorSet;
+		drawPacket.vertexBuffer = renderObject.isSkinned ? skinnedVertexBuffers[imageIndex] : vertexBuffer;
+		drawPacket.indexBuffer = indexBuffer;
+		drawPacket.indexCount = renderObject.indexCount;
+		drawPacket.firstIndex = renderObject.firstIndex;
+		drawPacket.vertexOffset = renderObject.vertexOffset;
+		// Per object model matrix. View-projection stays in per frame uniform buffer.
+		drawPacket.pushConstantObject.model = renderObject.model;
+		renderQueue.submit(drawPacket);
+	}
 
-		std::array<VkClearValue, 2> clearValues = {};
-		clearValues[0].color = {0.0F, 0.0F, 0.0F, 1.0F};
-		clearValues[1].depthStencil = {1.0F, 0};
+	renderQueue.sort();
 
-		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassBeginInfo.pClearValues = clearValues.data();
+	// Compute pass has to be recorded outside of render pass
+	if(!characters.empty() && !cpuSkinning)
+	{
+		SkinningDispatch skinningDispatch = {};
+		skinningDispatch.verticesNumber = static_cast<uint32_t>(skinnedMesh.vertices.size());
+		skinningDispatch.jointsNumber = skinnedMesh.skeleton.getJointsNumber();
+		skinningDispatch.firstJoint = 0;
+		skinningDispatch.firstSkinnedVertex = 0;
+
+		uint32_t skinningRegion = gpuProfiler.beginRegion(commandBuffer, "Skinning");
+		skinningPass.recordDispatch(commandBuffer, imageIndex, skinningDispatch, static_cast<uint32_t>(characters.size()), skinnedVertexBuffers[imageIndex]);
+		gpuProfiler.endRegion(commandBuffer, skinningRegion);
+	}
 
-		vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-		vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-		
-		VkBuffer vertexBuffers[] = {vertexBuffer};
-		VkDeviceSize offsets[] = {0};
+	uint32_t renderPassRegion = gpuProfiler.beginRegion(commandBuffer, "Render pass");
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-		vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-		vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	// Dynamic in every pipeline, so pipelines do not depend on swapchain extent
+	VkViewport viewport = {};
+	viewport.x = 0.0F;
+	viewport.y = 0.0F;
+	viewport.width = (float)(vulkanSwapchain.swapchainExtent.width);
+	viewport.height = (float)(vulkanSwapchain.swapchainExtent.height);
+	viewport.minDepth = 0.0F;
+	viewport.maxDepth = 1.0F;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &renderPassBeginInfo.renderArea);
 
-		vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[i], 0, nullptr);
-		vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-		vkCmdEndRenderPass(commandBuffers[i]);
+	renderQueueStatistics = renderQueue.record(commandBuffer);
+	vkCmdEndRenderPass(commandBuffer);
+	gpuProfiler.endRegion(commandBuffer, renderPassRegion);
+	gpuProfiler.endRegion(commandBuffer, frameRegion);
 
-		if(vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to record command buffer");
-		}
+	if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer");
 	}
 }
 
-void YasEngine::drawFrame(float deltaTime)
+void YasEngine::drawFrame()
 {
-	vkWaitForFences(vulkanDevice->logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	YAS_PROFILE_FUNCTION();
+
+	{
+		YAS_PROFILE_SCOPE("vkWaitForFences frame");
+		vkWaitForFences(vulkanDevice->logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+	frameArena.beginFrame(currentFrame);
+	frameDescriptorAllocator.beginFrame(currentFrame);
+	geometryPool.advanceFrame();
+	destroyEvictedAssets();
 	
 	uint32_t imageIndex;
+	VkResult result;
 
-	VkResult result = vkAcquireNextImageKHR(vulkanDevice->logicalDevice, vulkanSwapchain.swapchain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+	{
+		YAS_PROFILE_SCOPE("vkAcquireNextImageKHR");
+		result = vkAcquireNextImageKHR(vulkanDevice->logicalDevice, vulkanSwapchain.swapchain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+	}
 	
 	if(result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
@@ -403,7 +1095,17 @@ void YasEngine::drawFrame(float deltaTime)
 		}
 	}
 
-	updateUniformBuffer(imageIndex, deltaTime);
+	// Command buffer of this image can still be executed by other frame in flight
+	if(imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+	{
+		YAS_PROFILE_SCOPE("vkWaitForFences image");
+		vkWaitForFences(vulkanDevice->logicalDevice, 1, &imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+	imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+
+	updateUniformBuffer(imageIndex);
+	occlusionCuller.cull(modelViewProjections, renderObjects, geometryPool.getVertices(), geometryPool.getIndices(), visibleRenderObjects);
+	recordCommandBuffer(imageIndex);
 
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -424,9 +1126,12 @@ void YasEngine::drawFrame(float deltaTime)
 
 	vkResetFences(vulkanDevice->logicalDevice, 1, &inFlightFences[currentFrame]);
 
-	if(vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to submit draw command buffer.");
+		YAS_PROFILE_SCOPE("vkQueueSubmit");
+		if(vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit draw command buffer.");
+		}
 	}
 	
 	VkPresentInfoKHR presentInfoKhr = {};
@@ -439,7 +1144,10 @@ void YasEngine::drawFrame(float deltaTime)
 	presentInfoKhr.swapchainCount = 1;
 	presentInfoKhr.pSwapchains = swapChains;
 	presentInfoKhr.pImageIndices = &imageIndex;
-	result = vkQueuePresentKHR(presentationQueue, &presentInfoKhr);
+	{
+		YAS_PROFILE_SCOPE("vkQueuePresentKHR");
+		result = vkQueuePresentKHR(presentationQueue, &presentInfoKhr);
+	}
 
 	if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || YasEngine::framebufferResized)
 	{
@@ -456,11 +1164,130 @@ void YasEngine::drawFrame(float deltaTime)
 	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
+void YasEngine::drawHeadlessFrame()
+{
+	YAS_PROFILE_FUNCTION();
+
+	{
+		YAS_PROFILE_SCOPE("vkWaitForFences frame");
+		vkWaitForFences(vulkanDevice->logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+	frameArena.beginFrame(currentFrame);
+	frameDescriptorAllocator.beginFrame(currentFrame);
+	geometryPool.advanceFrame();
+	destroyEvictedAssets();
+
+	// Nothing to acquire from, offscreen images are used in turn
+	uint32_t imageIndex = (lastImageIndex + 1) % static_cast<uint32_t>(vulkanSwapchain.swapchainImages.size());
+
+	if(imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+	{
+		YAS_PROFILE_SCOPE("vkWaitForFences image");
+		vkWaitForFences(vulkanDevice->logicalDevice, 1, &imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+	imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+
+	updateUniformBuffer(imageIndex);
+	occlusionCuller.cull(modelViewProjections, renderObjects, geometryPool.getVertices(), geometryPool.getIndices(), visibleRenderObjects);
+	recordCommandBuffer(imageIndex);
+
+	// Without presentation queue submission order is enough, no semaphores are needed
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+
+	vkResetFences(vulkanDevice->logicalDevice, 1, &inFlightFences[currentFrame]);
+
+	{
+		YAS_PROFILE_SCOPE("vkQueueSubmit");
+		if(vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit draw command buffer.");
+		}
+	}
+
+	lastImageIndex = imageIndex;
+	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+void YasEngine::saveOffscreenImage(uint32_t imageIndex, const std::string& fileName)
+{
+	const uint32_t width = vulkanSwapchain.swapchainExtent.width;
+	const uint32_t height = vulkanSwapchain.swapchainExtent.height;
+	VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+
+	VkBuffer readbackBuffer;
+	VkDeviceMemory readbackBufferMemory;
+	createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackBufferMemory);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands("Screenshot readback");
+
+	// Render pass left image in TRANSFER_SRC_OPTIMAL, only writes of color attachment have to be made visible
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = vulkanSwapchain.swapchainImages[imageIndex];
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = {0, 0, 0};
+	region.imageExtent = {width, height, 1};
+
+	vkCmdCopyImageToBuffer(commandBuffer, vulkanSwapchain.swapchainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = readbackBuffer;
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+	endSingleTimeCommands(commandBuffer);
+
+	void* data;
+	vkMapMemory(vulkanDevice->logicalDevice, readbackBufferMemory, 0, imageSize, 0, &data);
+	int result = stbi_write_png(fileName.c_str(), static_cast<int>(width), static_cast<int>(height), 4, data, static_cast<int>(width * 4));
+	vkUnmapMemory(vulkanDevice->logicalDevice, readbackBufferMemory);
+
+	vkDestroyBuffer(vulkanDevice->logicalDevice, readbackBuffer, nullptr);
+	vkFreeMemory(vulkanDevice->logicalDevice, readbackBufferMemory, nullptr);
+
+	if(result == 0)
+	{
+		throw std::runtime_error("Failed to write screenshot.");
+	}
+}
+
 void YasEngine::createSyncObjects()
 {
 	imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 	renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 	inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+	imagesInFlight.resize(vulkanSwapchain.swapchainImages.size(), VK_NULL_HANDLE);
 
 	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
 
@@ -514,7 +1341,7 @@ void YasEngine::createBuffer(VkDeviceSize size,VkBufferUsageFlags usage,VkMemory
 
 void YasEngine::copyBuffer(VkBuffer sourceBuffer,VkBuffer destinationBuffer,VkDeviceSize deviceSize)
 {
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands("Buffer upload");
 
 	VkBufferCopy copyRegion = {};
 	copyRegion.size = deviceSize;
@@ -540,16 +1367,7 @@ void YasEngine::createDescriptorSetLayout()
 	samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uniformBufferObjectLayoutBinding, samplerLayoutBinding};
-
-	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
-	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-	descriptorSetLayoutCreateInfo.pBindings = bindings.data();
-
-	if(vkCreateDescriptorSetLayout(vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create descriptor set layout");
-	}
+	sceneDescriptorLayout = descriptorLayoutCache.getLayout(bindings.data(), static_cast<uint32_t>(bindings.size()));
 }
 
 void YasEngine::createUniformBuffers()
@@ -558,29 +1376,37 @@ void YasEngine::createUniformBuffers()
 	
 	uniformBuffers.resize(vulkanSwapchain.swapchainImages.size());
 	uniformBuffersMemory.resize(vulkanSwapchain.swapchainImages.size());
+	uniformBuffersMapped.resize(vulkanSwapchain.swapchainImages.size());
 	
 	for(size_t i = 0; i < vulkanSwapchain.swapchainImages.size(); i++)
 	{
 		createBuffer(uniformBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
+		// Memory stays mapped until cleanUp. Coherent memory does not need flushing.
+		vkMapMemory(vulkanDevice->logicalDevice, uniformBuffersMemory[i], 0, uniformBufferSize, 0, &uniformBuffersMapped[i]);
 	}
 
 }
 
-void YasEngine::updateUniformBuffer(uint32_t currentImage, float deltaTime)
+void YasEngine::updateUniformBuffer(uint32_t currentImage)
 {
-	float time = zeroTime += deltaTime;
+	YAS_PROFILE_FUNCTION();
 
-	UniformBufferObject uniformBufferObject = {};
-	uniformBufferObject.model = glm::rotate(glm::mat4(1.0F), time * glm::radians(90.0F), glm::vec3(0.0F, 0.0F, 1.0F));
-	uniformBufferObject.view = glm::lookAt(glm::vec3(2.0F, 2.0F, 2.0F), glm::vec3(0.0F, 0.0F, 0.0F), glm::vec3(0.0F, 0.0F, 1.0F));
-	uniformBufferObject.proj = glm::perspective(glm::radians(45.0F), vulkanSwapchain.swapchainExtent.width / (float) vulkanSwapchain.swapchainExtent.height, 0.1f, 10.0F);
-	uniformBufferObject.proj[1][1] *= -1;
+	float aspectRatio = vulkanSwapchain.swapchainExtent.width / (float) vulkanSwapchain.swapchainExtent.height;
 
-	void* data;
+	if(aspectRatio != cameraAspectRatio)
+	{
+		viewProjection = computeViewProjection(aspectRatio);
+		cameraAspectRatio = aspectRatio;
+	}
 
-	vkMapMemory(vulkanDevice->logicalDevice, uniformBuffersMemory[currentImage], 0, sizeof(uniformBufferObject), 0, &data);
-	memcpy(data, &uniformBufferObject, sizeof(uniformBufferObject));
-	vkUnmapMemory(vulkanDevice->logicalDevice, uniformBuffersMemory[currentImage]);
+	UniformBufferObject uniformBufferObject = {};
+	uniformBufferObject.viewProjection = viewProjection;
+	memcpy(uniformBuffersMapped[currentImage], &uniformBufferObject, sizeof(uniformBufferObject));
+
+	simulation.interpolate(frameTimer.getSimulationNanoseconds(), transformBatch);
+	// Model matrices are written straight into render objects for push constants
+	transformBatch.computeMatrices(jobSystem, viewProjection, &renderObjects[0].model[0][0], sizeof(RenderObject), &modelViewProjections[0][0][0], sizeof(glm::mat4));
+	animateCharacters(currentImage);
 }
 
 void YasEngine::createLogicalDevice()
@@ -588,6 +1414,7 @@ void YasEngine::createLogicalDevice()
 	vulkanDevice->createLogicalDevice(vulkanInstance, surface, graphicsQueue, presentationQueue, enableValidationLayers);
 }
 
+#ifdef _WIN32
 void YasEngine::createSurface()
 {
     // Both below: structure VkWin32SurfaceCreateInfoKHR and function vkCreateWin32SurfaceKHR
@@ -609,29 +1436,62 @@ void YasEngine::createSurface()
 		throw std::runtime_error("Failed to create Vulkan surface!");
 	}
 }
+#endif
 
 void YasEngine::createSwapchain()
 {
+	if(headless)
+	{
+		createOffscreenImages();
+		return;
+	}
+#ifdef _WIN32
 	QueueFamilyIndices queueIndices = findQueueFamilies(vulkanDevice->physicalDevice, surface);
 	vulkanSwapchain.createSwapchain(vulkanDevice->physicalDevice, surface, vulkanDevice->logicalDevice, queueIndices, window);
+#endif
+}
+
+void YasEngine::createOffscreenImages()
+{
+	// One image more than frames in flight, like minimal image count of swapchain plus one
+	const size_t imagesNumber = MAX_FRAMES_IN_FLIGHT + 1;
+
+	vulkanSwapchain.swapchain = VK_NULL_HANDLE;
+	vulkanSwapchain.swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	vulkanSwapchain.swapchainExtent = offscreenExtent;
+	vulkanSwapchain.swapchainImages.resize(imagesNumber);
+	offscreenImagesMemory.resize(imagesNumber);
+
+	for(size_t i=0; i<imagesNumber; i++)
+	{
+		createImage(offscreenExtent.width, offscreenExtent.height, 1, vulkanSwapchain.swapchainImageFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vulkanSwapchain.swapchainImages[i], offscreenImagesMemory[i]);
+	}
 }
 
 void YasEngine::recreateSwapchain()
 {
+	YAS_PROFILE_FUNCTION();
+	std::chrono::steady_clock::time_point recreationStart = std::chrono::steady_clock::now();
 	vkDeviceWaitIdle(vulkanDevice->logicalDevice);
 	cleanupSwapchain();
 	createSwapchain();
+	gpuProfiler.setFramesNumber(static_cast<uint32_t>(vulkanSwapchain.swapchainImages.size()));
 	createImageViews();
 	createRenderPass();
 	createGraphicsPipeline();
 	createDepthResources();
 	createFramebuffers();
 	createCommandBuffers();
+	imagesInFlight.assign(vulkanSwapchain.swapchainImages.size(), VK_NULL_HANDLE);
+	// Modules are kept so only pipelines are created again
+	startPipelinePrecompilation();
+
+	YAS_LOG_INFO("Swapchain recreated in {} ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recreationStart).count());
 }
 
 void YasEngine::createImageViews()
 {
-	vulkanSwapchain.createImageViews(vulkanDevice->logicalDevice, mipLevels);
+	vulkanSwapchain.createImageViews(vulkanDevice->logicalDevice, 1);
 }
 
 void YasEngine::cleanupSwapchain()
@@ -646,15 +1506,32 @@ void YasEngine::cleanupSwapchain()
 	}
 
 	vkFreeCommandBuffers(vulkanDevice->logicalDevice, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-	vkDestroyPipeline(vulkanDevice->logicalDevice, graphicsPipeline, nullptr);
+	// Compile thread may still create pipeline for render pass which is going to be destroyed, destroyPipelines waits for it
+	pipelineCache.destroyPipelines();
+	std::fill(materialPipelines.begin(), materialPipelines.end(), VK_NULL_HANDLE);
+	fallbackPipeline = VK_NULL_HANDLE;
+	vkDestroyPipelineLayout(vulkanDevice->logicalDevice, pipelineLayout, nullptr);
 	vkDestroyRenderPass(vulkanDevice->logicalDevice, renderPass, nullptr);
 
 	for(size_t i=0; i<vulkanSwapchain.swapchainImageViews.size(); i++)
 	{
 		vkDestroyImageView(vulkanDevice->logicalDevice, vulkanSwapchain.swapchainImageViews[i], nullptr);
 	}
-	
-	vkDestroySwapchainKHR(vulkanDevice->logicalDevice, vulkanSwapchain.swapchain, nullptr);
+
+	if(headless)
+	{
+		for(size_t i=0; i<vulkanSwapchain.swapchainImages.size(); i++)
+		{
+			vkDestroyImage(vulkanDevice->logicalDevice, vulkanSwapchain.swapchainImages[i], nullptr);
+			vkFreeMemory(vulkanDevice->logicalDevice, offscreenImagesMemory[i], nullptr);
+		}
+		vulkanSwapchain.swapchainImages.clear();
+		offscreenImagesMemory.clear();
+	}
+	else
+	{
+		vkDestroySwapchainKHR(vulkanDevice->logicalDevice, vulkanSwapchain.swapchain, nullptr);
+	}
 }
 
 void YasEngine::createRenderPass()
@@ -667,7 +1544,8 @@ void YasEngine::createRenderPass()
 	colorAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	// Offscreen image is only ever copied out for screenshot
+	colorAttachmentDescription.finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentDescription depthAttachmentDescription = {};
 	depthAttachmentDescription.format = findDepthFormat();
@@ -720,140 +1598,96 @@ void YasEngine::createRenderPass()
 
 void YasEngine::createGraphicsPipeline()
 {
-	std::vector<char> vertShaderCode = readFile("Shaders\\vert.spv");
-	std::vector<char> fragShaderCode = readFile("Shaders\\frag.spv");
-
-	VkShaderModule vertShaderModule;
-	VkShaderModule fragShaderModule;
-
-	vertShaderModule = createShaderModule(vertShaderCode);
-	fragShaderModule = createShaderModule(fragShaderCode);
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &sceneDescriptorLayout.layout;
 
-	VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertShaderStageInfo.module = vertShaderModule;
-	vertShaderStageInfo.pName = "main";
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstantObject);
 
-	VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragShaderStageInfo.module = fragShaderModule;
-	fragShaderStageInfo.pName = "main";
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
-	VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+	if(vkCreatePipelineLayout(vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Filed to create pipeline layout!");
+	}
 
-	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	// Fallback is created up front so first frame has something to draw with
+	PipelineState fallbackState = PipelineCache::getDefaultState(DEFAULT_SHADER_VARIANT);
+	fallbackState.renderPass = renderPass;
+	fallbackState.pipelineLayout = pipelineLayout;
+	fallbackPipeline = pipelineCache.getPipeline(fallbackState);
+	fallbackPipelineId = pipelineCache.getPipelineId(fallbackState);
+}
 
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+uint32_t YasEngine::addMaterial(const PipelineState& state)
+{
+	materials.push_back(state);
+	materialPipelines.push_back(VK_NULL_HANDLE);
+	materialPipelineIds.push_back(0);
+	return static_cast<uint32_t>(materials.size() - 1);
+}
 
-	
-	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputInfo.pVertexAttributeDescriptions =  attributeDescriptions.data();
+PipelineState YasEngine::getMaterialState(uint32_t material)
+{
+	PipelineState state = materials[material];
+	state.renderPass = renderPass;
+	state.pipelineLayout = pipelineLayout;
+	return state;
+}
 
-	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	inputAssembly.primitiveRestartEnable = VK_FALSE;
+VkPipeline YasEngine::getMaterialPipeline(uint32_t material, uint32_t& pipelineId)
+{
+	if(materialPipelines[material] != VK_NULL_HANDLE)
+	{
+		pipelineId = materialPipelineIds[material];
+		return materialPipelines[material];
+	}
 
-	VkViewport viewport = {};
-	viewport.x = 0.0F;
-	viewport.x = 0.0F;
-	viewport.width = (float)(vulkanSwapchain.swapchainExtent.width);
-	viewport.height = (float)(vulkanSwapchain.swapchainExtent.height);
-	viewport.minDepth = 0.0F;
-	viewport.maxDepth = 1.0F;
+	const PipelineState state = getMaterialState(material);
+	VkPipeline pipeline = blockingPipelines ? pipelineCache.getPipeline(state) : pipelineCache.requestPipeline(state);
 
-	VkRect2D scissor = {};
-	scissor.offset = {0, 0};
-	scissor.extent = vulkanSwapchain.swapchainExtent;
-
-	VkPipelineViewportStateCreateInfo viewportState = {};
-	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
-	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
-
-	VkPipelineRasterizationStateCreateInfo rasterizer = {};
-	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterizer.depthClampEnable = VK_FALSE;
-	rasterizer.rasterizerDiscardEnable = VK_FALSE;
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-	rasterizer.lineWidth = 1.0F;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-	rasterizer.depthBiasEnable = VK_FALSE;
-
-	VkPipelineMultisampleStateCreateInfo multisampling = {};
-	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampling.sampleShadingEnable = VK_FALSE;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-	VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo = {};
-	pipelineDepthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-	pipelineDepthStencilStateCreateInfo.depthTestEnable = VK_TRUE;
-	pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_TRUE;
-	pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
-	pipelineDepthStencilStateCreateInfo.depthBoundsTestEnable = VK_FALSE;
-	pipelineDepthStencilStateCreateInfo.minDepthBounds = 0.0F;
-	pipelineDepthStencilStateCreateInfo.maxDepthBounds = 1.0F;
-	pipelineDepthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
-	pipelineDepthStencilStateCreateInfo.front = {};
-	pipelineDepthStencilStateCreateInfo.back = {};
-
-	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable = VK_FALSE;
-
-	VkPipelineColorBlendStateCreateInfo colorBlending = {};
-	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlending.logicOpEnable = VK_FALSE;
-	colorBlending.logicOp = VK_LOGIC_OP_COPY;
-	colorBlending.attachmentCount = 1;
-	colorBlending.pAttachments = &colorBlendAttachment;
-	colorBlending.blendConstants[0] = 0.0F;
-	colorBlending.blendConstants[1] = 0.0F;
-	colorBlending.blendConstants[2] = 0.0F;
-	colorBlending.blendConstants[3] = 0.0F;
+	if(pipeline == VK_NULL_HANDLE)
+	{
+		fallbackDraws++;
+		pipelineId = fallbackPipelineId;
+		return fallbackPipeline;
+	}
 
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+	// Materials of equal states share pipeline and so its id
+	materialPipelines[material] = pipeline;
+	materialPipelineIds[material] = pipelineCache.getPipelineId(state);
+	pipelineId = materialPipelineIds[material];
+	return pipeline;
+}
 
-	if(vkCreatePipelineLayout(vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+void YasEngine::startPipelinePrecompilation()
+{
+	std::vector<PipelineState> states;
+	for(const RenderObject& renderObject: renderObjects)
 	{
-		throw std::runtime_error("Filed to create pipeline layout!");
+		states.push_back(getMaterialState(renderObject.material));
 	}
+	pipelineCache.precompile(states);
+}
 
-	VkGraphicsPipelineCreateInfo graphicsPiplineCreateInfo = {};
-	graphicsPiplineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	graphicsPiplineCreateInfo.stageCount = 2;
-	graphicsPiplineCreateInfo.pStages = shaderStages;
-	graphicsPiplineCreateInfo.pVertexInputState = &vertexInputInfo;
-	graphicsPiplineCreateInfo.pInputAssemblyState = &inputAssembly;
-	graphicsPiplineCreateInfo.pViewportState = &viewportState;
-	graphicsPiplineCreateInfo.pRasterizationState = &rasterizer;
-	graphicsPiplineCreateInfo.pMultisampleState = &multisampling;
-	graphicsPiplineCreateInfo.pColorBlendState = &colorBlending;
-	graphicsPiplineCreateInfo.layout = pipelineLayout;
-	graphicsPiplineCreateInfo.renderPass = renderPass;
-	graphicsPiplineCreateInfo.subpass = 0;
-	graphicsPiplineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
-	graphicsPiplineCreateInfo.pDepthStencilState = &pipelineDepthStencilStateCreateInfo;
+void YasEngine::introduceNewMaterials()
+{
+	// Each new material replaces material of one object, so it is drawn and its pipeline requested in the same frame
+	uint32_t materialsNumber = std::min(NEW_MATERIALS_PER_FRAME, newMaterialsNumber - introducedMaterials);
+	materialsNumber = std::min(materialsNumber, static_cast<uint32_t>(renderObjects.size()));
 
-	if(vkCreateGraphicsPipelines(vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &graphicsPiplineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+	for(uint32_t i=0; i<materialsNumber; i++)
 	{
-		throw std::runtime_error("Failed to create graphics pipeline");
+		RenderObject& renderObject = renderObjects[introducedMaterials % renderObjects.size()];
+		// Variation 0 is default state which scene already uses
+		renderObject.material = addMaterial(PipelineCache::getVariationState(introducedMaterials + 1));
+		introducedMaterials++;
 	}
-
-	vkDestroyShaderModule(vulkanDevice->logicalDevice, fragShaderModule, nullptr);
-	vkDestroyShaderModule(vulkanDevice->logicalDevice, vertShaderModule, nullptr);
 }
 
 void YasEngine::createFramebuffers()
@@ -879,22 +1713,6 @@ void YasEngine::createFramebuffers()
 	}
 }
 
-VkShaderModule YasEngine::createShaderModule(const std::vector<char>& code)
-{
-	VkShaderModuleCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-	VkShaderModule shaderModule;
-
-	if(vkCreateShaderModule(vulkanDevice->logicalDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create shader module");
-	}
-	return shaderModule;
-}
-
 void YasEngine::destroySwapchain()
 {
 	vulkanSwapchain.destroySwapchain(vulkanDevice->logicalDevice);
@@ -902,20 +1720,25 @@ void YasEngine::destroySwapchain()
 
 void YasEngine::cleanUp()
 {
+	jobSystem.shutdown();
 	cleanupSwapchain();
 	vkDestroySampler(vulkanDevice->logicalDevice, textureSampler, nullptr);
 	vkDestroyImageView(vulkanDevice->logicalDevice, textureImageView, nullptr);
     vkDestroyImage(vulkanDevice->logicalDevice, textureImage, nullptr);
     vkFreeMemory(vulkanDevice->logicalDevice, textureImageMemory, nullptr);
-	vkDestroyDescriptorPool(vulkanDevice->logicalDevice, descriptorPool, nullptr);
-	vkDestroyDescriptorSetLayout(vulkanDevice->logicalDevice, descriptorSetLayout, nullptr);
+	frameDescriptorAllocator.destroy();
+	descriptorAllocator.destroy();
 
 	for(size_t i=0; i<vulkanSwapchain.swapchainImages.size(); i++)
 	{
+		vkUnmapMemory(vulkanDevice->logicalDevice, uniformBuffersMemory[i]);
 		vkDestroyBuffer(vulkanDevice->logicalDevice, uniformBuffers[i], nullptr);
 		vkFreeMemory(vulkanDevice->logicalDevice, uniformBuffersMemory[i], nullptr);
 	}
 
+	destroySkinningResources();
+	descriptorLayoutCache.destroy();
+
 	vkDestroyBuffer(vulkanDevice->logicalDevice, indexBuffer, nullptr);
 	vkFreeMemory(vulkanDevice->logicalDevice, indexBufferMemory, nullptr);
 
@@ -930,6 +1753,10 @@ void YasEngine::cleanUp()
 	}
 
 	vkDestroyCommandPool(vulkanDevice->logicalDevice, commandPool, nullptr);
+	gpuProfiler.destroy();
+	pipelineCache.destroy();
+	shaderVariantCache.destroy();
+	assetArchive.close();
 	vkDestroyDevice(vulkanDevice->logicalDevice, nullptr);
 
 	if(enableValidationLayers)
@@ -937,99 +1764,74 @@ void YasEngine::cleanUp()
 		destroyDebugReportCallbackEXT(vulkanInstance.instance, callback, nullptr);
 	}
 
-	vkDestroySurfaceKHR(vulkanInstance.instance, surface, nullptr);
+	if(!headless)
+	{
+		vkDestroySurfaceKHR(vulkanInstance.instance, surface, nullptr);
+	}
 	vkDestroyInstance(vulkanInstance.instance, nullptr);
-	DestroyWindow(window);
+#ifdef _WIN32
+	if(!headless)
+	{
+		DestroyWindow(window);
+	}
+#endif
 }
 
-void YasEngine::createDescriptorPool()
+void YasEngine::createDescriptorAllocators()
 {
-	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	poolSizes[0].descriptorCount = static_cast<uint32_t>(vulkanSwapchain.swapchainImages.size());
-	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[1].descriptorCount = static_cast<uint32_t>(vulkanSwapchain.swapchainImages.size());	
-
-	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
-	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-	descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
-	descriptorPoolCreateInfo.maxSets = static_cast<uint32_t>(vulkanSwapchain.swapchainImages.size());
-
-	if(vkCreateDescriptorPool(vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create descriptor pool.");
-	}
+	descriptorLayoutCache.initialize(vulkanDevice->logicalDevice);
 
+	// Scene sets have one uniform buffer and one texture, skinning sets four storage buffers
+	std::vector<DescriptorPoolRatio> ratios = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0F}, {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0F}, {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4.0F}};
+	descriptorAllocator.initialize(vulkanDevice->logicalDevice, ratios);
+	frameDescriptorAllocator.initialize(vulkanDevice->logicalDevice, MAX_FRAMES_IN_FLIGHT, ratios);
 }
 
-void YasEngine::createDescriptorSets()
+VkDescriptorSet YasEngine::writeSceneDescriptorSet(uint32_t imageIndex)
 {
-	std::vector<VkDescriptorSetLayout> descriptorSetLayouts(vulkanSwapchain.swapchainImages.size(), descriptorSetLayout);
-
-	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
-	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	descriptorSetAllocateInfo.descriptorPool = descriptorPool;
-	descriptorSetAllocateInfo.descriptorSetCount = static_cast<uint32_t>(vulkanSwapchain.swapchainImages.size());
-	descriptorSetAllocateInfo.pSetLayouts = descriptorSetLayouts.data();
+	VkDescriptorSet descriptorSet = frameDescriptorAllocator.current().allocate(sceneDescriptorLayout.layout);
+
+	std::array<DescriptorInfo, 2> descriptors = {};
+	descriptors[0].buffer.buffer = uniformBuffers[imageIndex];
+	descriptors[0].buffer.offset = 0;
+	descriptors[0].buffer.range = sizeof(UniformBufferObject);
+	descriptors[1].image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	descriptors[1].image.imageView = textureImageView;
+	descriptors[1].image.sampler = textureSampler;
+
+	descriptorLayoutCache.writeDescriptorSet(descriptorSet, sceneDescriptorLayout, descriptors.data());
+	return descriptorSet;
+}
 
-	descriptorSets.resize(vulkanSwapchain.swapchainImages.size());
+void YasEngine::decodeTexture()
+{
+	YAS_PROFILE_FUNCTION();
+	int textureChannels;
+	AssetSpan texture;
+	std::vector<char> textureBuffer;
 
-	if(vkAllocateDescriptorSets(vulkanDevice->logicalDevice, &descriptorSetAllocateInfo, &descriptorSets[0]) != VK_SUCCESS)
+	// JPEG is decoded straight from archive mapping
+	if(assetArchive.read(TEXTURE_PATH, texture, textureBuffer))
 	{
-		throw std::runtime_error("failed to allocate descriptor sets!");
+		texturePixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(texture.data), static_cast<int>(texture.size), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
 	}
-
-	for(size_t i=0; i<vulkanSwapchain.swapchainImages.size(); i++)
+	else
 	{
+		texturePixels = stbi_load(TEXTURE_PATH.c_str(), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
+	}
 
-		VkDescriptorBufferInfo descriptorBufferInfo = {};
-		descriptorBufferInfo.buffer = uniformBuffers[i];
-		descriptorBufferInfo.offset = 0;
-		descriptorBufferInfo.range = sizeof(UniformBufferObject);
-
-		VkDescriptorImageInfo descriptorImageInfo = {};
-		descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		descriptorImageInfo.imageView = textureImageView;
-		descriptorImageInfo.sampler = textureSampler;
-
-		std::array<VkWriteDescriptorSet, 2> writeDescriptorSets = {};
-
-		writeDescriptorSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		writeDescriptorSets[0].dstSet = descriptorSets[i];
-		writeDescriptorSets[0].dstBinding = 0;
-		writeDescriptorSets[0].dstArrayElement = 0;
-		writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		writeDescriptorSets[0].descriptorCount = 1;
-		writeDescriptorSets[0].pBufferInfo = &descriptorBufferInfo;
-
-		writeDescriptorSets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		writeDescriptorSets[1].dstSet = descriptorSets[i];
-		writeDescriptorSets[1].dstBinding = 1;
-		writeDescriptorSets[1].dstArrayElement = 0;
-		writeDescriptorSets[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		writeDescriptorSets[1].descriptorCount = 1;
-		writeDescriptorSets[1].pImageInfo = &descriptorImageInfo;
-
-		vkUpdateDescriptorSets(vulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+	if(!texturePixels)
+	{
+		throw std::runtime_error("Failed to load texture image.");
 	}
 }
 
 void YasEngine::createTextureImage()
 {
-	int textureWidth;
-	int textureHeight;
-	int textureChannels;
-	stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
+	stbi_uc* pixels = texturePixels;
 	VkDeviceSize imageSize = textureWidth * textureHeight * 4;
 	mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(textureWidth, textureHeight)))) + 1;
 
-	if(!pixels)
-	{
-		throw std::runtime_error("Failed to load texture image.");
-	}
-
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
 	
@@ -1042,6 +1844,7 @@ void YasEngine::createTextureImage()
 	vkUnmapMemory(vulkanDevice->logicalDevice, stagingBufferMemory);
 
 	stbi_image_free(pixels);
+	texturePixels = nullptr;
 
 	createImage(textureWidth, textureHeight, mipLevels, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
 	transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
@@ -1091,7 +1894,7 @@ void YasEngine::createImage(uint32_t textureWidth, uint32_t textureHeight, uint3
 	vkBindImageMemory(vulkanDevice->logicalDevice, image, imageMemory, 0);
 }
 
-VkCommandBuffer YasEngine::beginSingleTimeCommands()
+VkCommandBuffer YasEngine::beginSingleTimeCommands(const char* profilerRegionName)
 {
     VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
     commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -1107,12 +1910,14 @@ VkCommandBuffer YasEngine::beginSingleTimeCommands()
     commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
     vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+	gpuProfiler.beginImmediate(commandBuffer, profilerRegionName);
 
     return commandBuffer;
 }
 
 void YasEngine::endSingleTimeCommands(VkCommandBuffer commandBuffer)
 {
+	gpuProfiler.endImmediate(commandBuffer);
     vkEndCommandBuffer(commandBuffer);
 
     VkSubmitInfo submitInfo = {};
@@ -1122,13 +1927,14 @@ void YasEngine::endSingleTimeCommands(VkCommandBuffer commandBuffer)
 
     vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
     vkQueueWaitIdle(graphicsQueue);
+	gpuProfiler.collectImmediate();
 
     vkFreeCommandBuffers(vulkanDevice->logicalDevice, commandPool, 1, &commandBuffer);
 }
 
 void YasEngine::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldImageLayout, VkImageLayout newImageLayout, uint32_t mipLevelsNumber)
 {
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands("Layout transition");
 	VkImageMemoryBarrier imageMemoryBarrier = {};
 	imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	imageMemoryBarrier.oldLayout = oldImageLayout;
@@ -1195,7 +2001,7 @@ void YasEngine::transitionImageLayout(VkImage image, VkFormat format, VkImageLay
 
 void YasEngine::copyBufferToImage(VkBuffer buffer,VkImage image,uint32_t imageWidth,uint32_t imageHeight)
 {
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands("Image upload");
 
 	VkBufferImageCopy bufferImageCopyRegion = {};
 	bufferImageCopyRegion.bufferOffset = 0;
@@ -1285,47 +2091,330 @@ bool YasEngine::hasStencilComponent(VkFormat format)
 
 void YasEngine::loadModel()
 {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
-	std::string tinyobjLoadingError;
-	std::string tinyobjLoadingWarnings;
-	
-	if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &tinyobjLoadingWarnings, &tinyobjLoadingError, MODEL_PATH.c_str()))
+	YAS_PROFILE_FUNCTION();
+	// OBJ is parsed only once, later runs decode mesh file converted from it. Mesh file in archive is used as it is.
+	const std::string meshPath = ModelLoader::getMeshFileName(MODEL_PATH);
+	const uint64_t objSize = ModelLoader::getFileSize(MODEL_PATH);
+	const uint64_t objModificationTime = ModelLoader::getFileModificationTime(MODEL_PATH);
+	MappedFile meshFile;
+	AssetSpan meshData = {};
+	std::vector<char> meshBuffer;
+	const MeshFileHeader* header = nullptr;
+
+	if(assetArchive.read(meshPath, meshData, meshBuffer))
 	{
-		throw std::runtime_error(tinyobjLoadingError);
+		if((header = MeshCodec::readHeader(meshData.data, meshData.size)) == nullptr)
+		{
+			throw std::runtime_error("Mesh file " + meshPath + " in asset archive is corrupted, pack archive again");
+		}
 	}
-	
-	for(const auto& shape: shapes)
+	else
 	{
-		for(const auto& index: shape.mesh.indices)
+		if(meshFile.open(meshPath))
 		{
-			Vertex vertex = {};
+			header = MeshCodec::readHeader(meshFile.data(), meshFile.size());
+		}
 
-			vertex.pos =
-			{
-				attrib.vertices[3 * index.vertex_index + 0],
-				attrib.vertices[3 * index.vertex_index + 1],
-				attrib.vertices[3 * index.vertex_index + 2]
-			};
+		// OBJ edited to the same size is told apart by its modification time
+		if(header == nullptr || (objSize != 0 && (header->sourceSize != objSize || header->sourceModificationTime != objModificationTime)))
+		{
+			meshFile.close();
+			ModelLoader::convertObj(MODEL_PATH, meshPath, jobSystem);
 
-			vertex.texCoord =
+			if(!meshFile.open(meshPath) || (header = MeshCodec::readHeader(meshFile.data(), meshFile.size())) == nullptr)
 			{
-				attrib.texcoords[2 * index.texcoord_index + 0],
-				1.0F - attrib.texcoords[2 * index.texcoord_index + 1]
-			};
+				throw std::runtime_error("Failed to read mesh file " + meshPath);
+			}
+		}
+
+		meshData.data = meshFile.data();
+		meshData.size = meshFile.size();
+	}
+
+	const uint32_t verticesNumber = header->verticesNumber;
+	const uint32_t indicesNumber = header->indicesNumber;
+
+	// Bounds start at first vertex and empty model would not draw anything anyway
+	if(verticesNumber == 0 || indicesNumber == 0)
+	{
+		throw std::runtime_error("Mesh file " + meshPath + " has " + std::to_string(verticesNumber) + " vertices and " + std::to_string(indicesNumber) + " indices, model " + MODEL_PATH + " is empty");
+	}
+
+	// Model is first mesh in pool. Pool is sized for it with room for meshes loaded later.
+	geometryPool.initialize(verticesNumber + GEOMETRY_POOL_SPARE_VERTICES, indicesNumber + GEOMETRY_POOL_SPARE_INDICES, MAX_FRAMES_IN_FLIGHT);
+	const uint32_t mesh = geometryPool.allocateMesh(verticesNumber, indicesNumber);
+
+	// Decoded straight into CPU copy of pool, which is source of staging buffer of pool buffers
+	int64_t decodeStart = Clock::nanoseconds();
+	MeshCodec::decode(meshData.data, meshData.size, jobSystem, geometryPool.getMeshVertices(mesh), geometryPool.getMeshIndices(mesh));
+	double decodeSeconds = Clock::toSeconds(Clock::nanoseconds() - decodeStart);
+
+	const size_t decodedSize = sizeof(Vertex) * verticesNumber + sizeof(uint32_t) * indicesNumber;
+	YAS_LOG_INFO("Mesh {}: {} vertices {} indices, {} KB compressed, ratio {} to binary {} to OBJ, decoded in {} ms at {} GB/s", meshPath,
+		verticesNumber, indicesNumber, meshData.size / 1024, static_cast<double>(decodedSize) / meshData.size,
+		static_cast<double>(objSize) / meshData.size, decodeSeconds * 1000.0, decodedSize / decodeSeconds / 1e9);
+
+	const Vertex* vertices = geometryPool.getMeshVertices(mesh);
+
+	RenderObject renderObject = {};
+	renderObject.model = glm::mat4(1.0F);
+	renderObject.boundsMin = vertices[0].pos;
+	renderObject.boundsMax = vertices[0].pos;
+
+	for(uint32_t i=0; i<verticesNumber; i++)
+	{
+		renderObject.boundsMin = glm::min(renderObject.boundsMin, vertices[i].pos);
+		renderObject.boundsMax = glm::max(renderObject.boundsMax, vertices[i].pos);
+	}
+
+	renderObject.meshIndex = mesh;
+	renderObject.firstIndex = geometryPool.getMesh(mesh).firstIndex;
+	renderObject.indexCount = geometryPool.getMesh(mesh).indicesNumber;
+	renderObject.vertexOffset = static_cast<int32_t>(geometryPool.getMesh(mesh).firstVertex);
+	renderObject.isOccluder = false;
+	renderObject.isSkinned = false;
+	renderObject.material = addMaterial(PipelineCache::getDefaultState(DEFAULT_SHADER_VARIANT));
+	renderObjects.push_back(renderObject);
+}
+
+void YasEngine::createSimulation()
+{
+	std::vector<SimulatedObject> simulatedObjects(renderObjects.size());
+	transformBatch.resize(static_cast<uint32_t>(renderObjects.size()));
+	modelViewProjections.resize(renderObjects.size());
+
+	for(size_t i=0; i<renderObjects.size(); i++)
+	{
+		simulatedObjects[i].position = glm::vec3(renderObjects[i].model[3]);
+		transformBatch.setPosition(static_cast<uint32_t>(i), YasMathLib::vec3(simulatedObjects[i].position.x, simulatedObjects[i].position.y, simulatedObjects[i].position.z));
+		simulatedObjects[i].angle = 0.0F;
+		simulatedObjects[i].angularVelocity = 0.0F;
+	}
+
+	// Model turns 90 degrees per second
+	simulatedObjects[0].angularVelocity = glm::radians(90.0F);
+	simulation.initialize(simulatedObjects);
+}
+
+void YasEngine::createCharacters()
+{
+	if(charactersNumber == 0)
+	{
+		return;
+	}
+
+	SkinningPass::createTestMesh(TEST_CHARACTER_JOINTS, TEST_CHARACTER_RINGS_PER_JOINT, TEST_CHARACTER_SEGMENTS, skinnedMesh);
+	// Only indices go to pool, vertices of every character are written into skinned vertex buffers
+	const uint32_t mesh = geometryPool.addMesh(nullptr, 0, skinnedMesh.indices.data(), static_cast<uint32_t>(skinnedMesh.indices.size()));
+
+	if(mesh == NO_GEOMETRY_MESH)
+	{
+		throw std::runtime_error("Geometry pool is full");
+	}
+
+	// Characters stand in square grid around model. Time offsets and blend weights differ, so they do not move in sync.
+	const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(charactersNumber))));
+	const float spacing = 0.15F;
+	characters.resize(charactersNumber);
+	const uint32_t characterMaterial = addMaterial(PipelineCache::getDefaultState(SHADER_FEATURE_VERTEX_COLOR));
+
+	for(uint32_t i=0; i<charactersNumber; i++)
+	{
+		characters[i].initialize(&skinnedMesh, 0.37F * i, (i % 5) / 4.0F);
+
+		RenderObject renderObject = {};
+		renderObject.model = glm::mat4(1.0F);
+		renderObject.model[3] = glm::vec4(spacing * (i % columns - 0.5F * (columns - 1)), spacing * (i / columns - 0.5F * (columns - 1)), 0.0F, 1.0F);
+		renderObject.boundsMin = skinnedMesh.boundsMin;
+		renderObject.boundsMax = skinnedMesh.boundsMax;
+		renderObject.meshIndex = mesh;
+		renderObject.firstIndex = geometryPool.getMesh(mesh).firstIndex;
+		renderObject.indexCount = geometryPool.getMesh(mesh).indicesNumber;
+		renderObject.vertexOffset = static_cast<int32_t>(i * skinnedMesh.vertices.size());
+		renderObject.isOccluder = false;
+		renderObject.isSkinned = true;
+		renderObject.material = characterMaterial;
+		renderObjects.push_back(renderObject);
+	}
+}
+
+void YasEngine::createOccluderScene()
+{
+	if(occludedBoxesNumber == 0)
+	{
+		return;
+	}
 
-			vertex.color = {1.0F, 1.0F, 1.0F};
+	// Simulation keeps only position of model matrix, so meshes are built in their final size
+	std::vector<Vertex> wallVertices;
+	std::vector<uint32_t> wallIndices;
+	std::vector<Vertex> boxVertices;
+	std::vector<uint32_t> boxIndices;
+	createBoxMesh(OCCLUDER_WALL_HALF_SIZE, wallVertices, wallIndices);
+	createBoxMesh(OCCLUDED_BOX_HALF_SIZE, boxVertices, boxIndices);
 
-			if(uniqueVertices.count(vertex) == 0)
+	const uint32_t wallMesh = geometryPool.addMesh(wallVertices.data(), static_cast<uint32_t>(wallVertices.size()), wallIndices.data(), static_cast<uint32_t>(wallIndices.size()));
+	const uint32_t boxMesh = geometryPool.addMesh(boxVertices.data(), static_cast<uint32_t>(boxVertices.size()), boxIndices.data(), static_cast<uint32_t>(boxIndices.size()));
+
+	if(wallMesh == NO_GEOMETRY_MESH || boxMesh == NO_GEOMETRY_MESH)
+	{
+		throw std::runtime_error("Geometry pool is full");
+	}
+
+	const uint32_t material = addMaterial(PipelineCache::getDefaultState(SHADER_FEATURE_VERTEX_COLOR));
+
+	for(uint32_t i=0; i<=occludedBoxesNumber; i++)
+	{
+		const bool isWall = (i == 0);
+		const uint32_t mesh = isWall ? wallMesh : boxMesh;
+		const float halfSize = isWall ? OCCLUDER_WALL_HALF_SIZE : OCCLUDED_BOX_HALF_SIZE;
+
+		RenderObject renderObject = {};
+		renderObject.model = glm::translate(glm::mat4(1.0F), isWall ? computeOccluderWallPosition() : computeOccludedBoxPosition(i - 1));
+		renderObject.boundsMin = glm::vec3(-halfSize);
+		renderObject.boundsMax = glm::vec3(halfSize);
+		renderObject.meshIndex = mesh;
+		renderObject.firstIndex = geometryPool.getMesh(mesh).firstIndex;
+		renderObject.indexCount = geometryPool.getMesh(mesh).indicesNumber;
+		renderObject.vertexOffset = static_cast<int32_t>(geometryPool.getMesh(mesh).firstVertex);
+		renderObject.isOccluder = isWall;
+		renderObject.isSkinned = false;
+		renderObject.material = material;
+		renderObjects.push_back(renderObject);
+	}
+}
+
+void YasEngine::createSkinningResources()
+{
+	if(characters.empty())
+	{
+		return;
+	}
+
+	// Compute pass runs on graphics queue, CPU skins when its family can not run compute shaders
+	if(!cpuSkinning)
+	{
+		uint32_t queueFamiliesNumber = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(vulkanDevice->physicalDevice, &queueFamiliesNumber, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamiliesNumber);
+		vkGetPhysicalDeviceQueueFamilyProperties(vulkanDevice->physicalDevice, &queueFamiliesNumber, queueFamilies.data());
+
+		if(!(queueFamilies[findQueueFamilies(vulkanDevice->physicalDevice, surface).graphicsFamily].queueFlags & VK_QUEUE_COMPUTE_BIT))
+		{
+			YAS_LOG_WARNING("Graphics queue does not support compute, characters are skinned on CPU");
+			cpuSkinning = true;
+		}
+	}
+
+	const size_t imagesNumber = vulkanSwapchain.swapchainImages.size();
+	const VkDeviceSize skinningMatricesSize = sizeof(YasMathLib::mat4) * skinnedMesh.skeleton.getJointsNumber() * characters.size();
+	const VkDeviceSize skinnedVerticesSize = sizeof(Vertex) * skinnedMesh.vertices.size() * characters.size();
+	skinnedVertexBuffers.resize(imagesNumber);
+	skinnedVertexBuffersMemory.resize(imagesNumber);
+
+	if(cpuSkinning)
+	{
+		skinningMatrices.resize(skinnedMesh.skeleton.getJointsNumber() * characters.size());
+		skinnedVertexBuffersMapped.resize(imagesNumber);
+
+		for(size_t i=0; i<imagesNumber; i++)
+		{
+			createBuffer(skinnedVerticesSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, skinnedVertexBuffers[i], skinnedVertexBuffersMemory[i]);
+			vkMapMemory(vulkanDevice->logicalDevice, skinnedVertexBuffersMemory[i], 0, skinnedVerticesSize, 0, &skinnedVertexBuffersMapped[i]);
+		}
+		return;
+	}
+
+	createDeviceLocalBuffer(skinnedMesh.vertices.data(), sizeof(Vertex) * skinnedMesh.vertices.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, bindVerticesBuffer, bindVerticesBufferMemory);
+	createDeviceLocalBuffer(skinnedMesh.skinWeights.data(), sizeof(SkinWeights) * skinnedMesh.skinWeights.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, skinWeightsBuffer, skinWeightsBufferMemory);
+	skinningPass.initialize(vulkanDevice->logicalDevice, descriptorLayoutCache, descriptorAllocator, shaderVariantCache.getShaderModule(VK_SHADER_STAGE_COMPUTE_BIT, 0), static_cast<uint32_t>(imagesNumber));
+
+	skinningMatricesBuffers.resize(imagesNumber);
+	skinningMatricesBuffersMemory.resize(imagesNumber);
+	skinningMatricesBuffersMapped.resize(imagesNumber);
+
+	for(size_t i=0; i<imagesNumber; i++)
+	{
+		// Matrices are written every frame like uniform buffers, memory stays mapped until cleanUp
+		createBuffer(skinningMatricesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, skinningMatricesBuffers[i], skinningMatricesBuffersMemory[i]);
+		vkMapMemory(vulkanDevice->logicalDevice, skinningMatricesBuffersMemory[i], 0, skinningMatricesSize, 0, &skinningMatricesBuffersMapped[i]);
+		createBuffer(skinnedVerticesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, skinnedVertexBuffers[i], skinnedVertexBuffersMemory[i]);
+		skinningPass.updateDescriptorSet(static_cast<uint32_t>(i), bindVerticesBuffer, skinWeightsBuffer, skinningMatricesBuffers[i], skinnedVertexBuffers[i]);
+	}
+}
+
+void YasEngine::destroySkinningResources()
+{
+	skinningPass.destroy();
+
+	for(size_t i=0; i<skinningMatricesBuffers.size(); i++)
+	{
+		vkUnmapMemory(vulkanDevice->logicalDevice, skinningMatricesBuffersMemory[i]);
+		vkDestroyBuffer(vulkanDevice->logicalDevice, skinningMatricesBuffers[i], nullptr);
+		vkFreeMemory(vulkanDevice->logicalDevice, skinningMatricesBuffersMemory[i], nullptr);
+	}
+
+	for(size_t i=0; i<skinnedVertexBuffers.size(); i++)
+	{
+		if(!skinnedVertexBuffersMapped.empty())
+		{
+			vkUnmapMemory(vulkanDevice->logicalDevice, skinnedVertexBuffersMemory[i]);
+		}
+		vkDestroyBuffer(vulkanDevice->logicalDevice, skinnedVertexBuffers[i], nullptr);
+		vkFreeMemory(vulkanDevice->logicalDevice, skinnedVertexBuffersMemory[i], nullptr);
+	}
+
+	// Null handles are ignored when CPU skinned or there are no characters
+	vkDestroyBuffer(vulkanDevice->logicalDevice, skinWeightsBuffer, nullptr);
+	vkFreeMemory(vulkanDevice->logicalDevice, skinWeightsBufferMemory, nullptr);
+	vkDestroyBuffer(vulkanDevice->logicalDevice, bindVerticesBuffer, nullptr);
+	vkFreeMemory(vulkanDevice->logicalDevice, bindVerticesBufferMemory, nullptr);
+}
+
+void YasEngine::animateCharacters(uint32_t currentImage)
+{
+	if(characters.empty())
+	{
+		return;
+	}
+	YAS_PROFILE_FUNCTION();
+
+	// Lambda captures one pointer so std::function does not allocate
+	struct Task
+	{
+		YasEngine* engine;
+		float time;
+		YasMathLib::mat4* skinningMatrices;
+		Vertex* skinnedVertices;
+	} task = {this, static_cast<float>(Clock::toSeconds(frameTimer.getSimulationNanoseconds())), nullptr, nullptr};
+
+	if(cpuSkinning)
+	{
+		task.skinningMatrices = skinningMatrices.data();
+		task.skinnedVertices = static_cast<Vertex*>(skinnedVertexBuffersMapped[currentImage]);
+	}
+	else
+	{
+		task.skinningMatrices = static_cast<YasMathLib::mat4*>(skinningMatricesBuffersMapped[currentImage]);
+	}
+
+	jobSystem.parallelFor(0, static_cast<uint32_t>(characters.size()), 1, [&task](uint32_t begin, uint32_t end)
+	{
+		const SkinnedMesh& mesh = task.engine->skinnedMesh;
+		const uint32_t jointsNumber = mesh.skeleton.getJointsNumber();
+		const uint32_t verticesNumber = static_cast<uint32_t>(mesh.vertices.size());
+
+		for(uint32_t i=begin; i<end; i++)
+		{
+			YasMathLib::mat4* characterMatrices = task.skinningMatrices + i * jointsNumber;
+			task.engine->characters[i].computeSkinningMatrices(task.time, characterMatrices);
+
+			if(task.skinnedVertices != nullptr)
 			{
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				vertices.push_back(vertex);
+				SkinningPass::skinVertices(mesh.vertices.data(), mesh.skinWeights.data(), verticesNumber, characterMatrices, task.skinnedVertices + i * verticesNumber);
 			}
-			indices.push_back(uniqueVertices[vertex]);
 		}
-	}
+	});
 }
 
 void YasEngine::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t textureWidth,int32_t textureHeight,uint32_t mipLevelsNumber)
@@ -1338,7 +2427,7 @@ void YasEngine::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t tex
 		throw std::runtime_error("texture image format does not support linear blitting!");
 	}
 
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands("Mipmap generation");
 
 	VkImageMemoryBarrier imageMemoryBarrier = {};
 	imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -5,10 +5,59 @@
 #include"VariousTools.hpp"
 #include"VulkanInstance.hpp"
 #include"VulkanDevice.hpp"
+#include"RenderQueue.hpp"
+#include"OcclusionCulling.hpp"
+#include"ShaderVariants.hpp"
+#include"PipelineCache.hpp"
+#include"GpuProfiler.hpp"
+#include"CpuProfiler.hpp"
+#include"Clock.hpp"
+#include"Simulation.hpp"
+#include"JobSystem.hpp"
+#include"InitGraph.hpp"
+#include"Descriptors.hpp"
+#include"ModelLoader.hpp"
+#include"Skinning.hpp"
+#include"GeometryPool.hpp"
+#include"ResidencyCache.hpp"
 //-----------------------------------------------------------------------------|---------------------------------------|
 
 //#define NDEBUG
 
+// Settings of benchmark run without window
+struct HeadlessSettings
+{
+	uint32_t						framesNumber = 1000;
+	uint32_t						width = 800;
+	uint32_t						height = 600;
+	// Frame time statistics are always printed, file is written only when path is not empty
+	std::string						statisticsPath;
+	// PNG of last rendered frame
+	std::string						screenshotPath;
+	// Animated characters added to scene
+	uint32_t						charactersNumber = 0;
+	// Characters are skinned on CPU instead of compute pass
+	bool							cpuSkinning = false;
+	// Boxes hidden behind wall occluder, none by default. When there are some, run fails if culling does not hide any of them.
+	uint32_t						occludedBoxesNumber = 0;
+	// Name substring or UUID of physical device, empty picks device with highest score
+	std::string						preferredDevice;
+	// Chrome trace of startup steps, written only when path is not empty
+	std::string						startupTimelinePath;
+	// Extra descriptor sets allocated and written every frame to measure descriptor allocator
+	uint32_t						descriptorStressSets = 0;
+	// Materials with pipeline states scene did not use yet, introduced a few per frame while it runs
+	uint32_t						newMaterialsNumber = 0;
+	// Missing pipelines are compiled on render thread instead of being drawn with fallback meanwhile
+	bool							blockingPipelines = false;
+	// Streamed meshes kept resident in geometry pool, one of them is replaced every frame
+	uint32_t						geometryChurnMeshes = 0;
+	// Meshes of level streamed in and out by residency cache as camera passes them
+	uint32_t						streamedAssets = 0;
+	// Device memory for streamed meshes, 0 takes it from VK_EXT_memory_budget when device has it
+	uint32_t						residencyBudgetMegabytes = 0;
+};
+
 VkResult createDebugReportCallbackEXT ( VkInstance& vulkanInstance, const VkDebugReportCallbackCreateInfoEXT* createInfo, const VkAllocationCallbacks* allocator, VkDebugReportCallbackEXT* callback);
 
 class YasEngine
@@ -16,7 +65,12 @@ class YasEngine
 	public:
 
 		YasEngine();
-		void							run(HINSTANCE hInstance);
+#ifdef _WIN32
+		// Preferred device is name substring or UUID, empty one picks device with highest score
+		void							run(HINSTANCE hInstance, const std::string& preferredDevice);
+#endif
+		// Renders fixed number of frames to offscreen images. Does not need surface or swapchain extensions.
+		void							runHeadless(const HeadlessSettings& settings);
 		static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback( VkDebugReportFlagsEXT debugReportFlags, VkDebugReportObjectTypeEXT objectType, uint64_t object, size_t location, int32_t code, const char* layerPrefix, const char* msg, void* userData);
 
 		static int						windowPositionX;
@@ -24,13 +78,14 @@ class YasEngine
 		static int						windowWidth;
 		static int						windowHeight;
 
-		static const std::string				MODEL_PATH;//="Models\\chalet.obj";
-		static const std::string				TEXTURE_PATH;//="Textures\\chalet.jpg";
+		static const std::string				MODEL_PATH;//="Models/chalet.obj";
+		static const std::string				TEXTURE_PATH;//="Textures/chalet.jpg";
 
+		// Headless mode turns validation off when layers are not installed
 		#ifdef NDEBUG
-			const bool					enableValidationLayers = false;
+			bool						enableValidationLayers = false;
 		#else
-			const bool					enableValidationLayers = true;
+			bool						enableValidationLayers = true;
 		#endif
 
 		static bool framebufferResized;
@@ -38,40 +93,72 @@ class YasEngine
 
 	private:
 
+#ifdef _WIN32
 		void							createWindow(HINSTANCE hInstance);
 		void							mainLoop();
+		void							createSurface();
+#endif
+		void							headlessLoop(const HeadlessSettings& settings);
 		void							cleanUp();
 		void							createVulkanInstance();
 		void							initializeVulkan();
 		void							setupDebugCallback();
 		void							createLogicalDevice();
-		void							createSurface();
 		void							createSwapchain();
+		void							createOffscreenImages();
 		void							recreateSwapchain();
 		void							cleanupSwapchain();
 		void							destroySwapchain();
 		void							createImageViews();
 		void							createRenderPass();
 		void							createGraphicsPipeline();
+		uint32_t						addMaterial(const PipelineState& state);
+		// State of material with render pass and layout of current swapchain
+		PipelineState					getMaterialState(uint32_t material);
+		// Fallback pipeline is returned while pipeline of material is compiled. Id is the one pipeline cache gave to returned pipeline.
+		VkPipeline						getMaterialPipeline(uint32_t material, uint32_t& pipelineId);
+		void							startPipelinePrecompilation();
+		void							introduceNewMaterials();
 		void							createFramebuffers();
-		VkShaderModule					createShaderModule(const std::vector<char>& code);
 		void							createCommandPool();
 		void							createCommandBuffers();
-		void							createVertexBuffer();
-		void							createIndexBuffer();
+		void							recordCommandBuffer(uint32_t imageIndex);
+		// Pool buffers are created with whole capacity, meshes added during startup are uploaded into them
+		void							createGeometryBuffers();
+		// Copies ranges of CPU copy of geometry pool into pool buffers
+		void							uploadGeometry(uint32_t firstVertex, uint32_t verticesNumber, uint32_t firstIndex, uint32_t indicesNumber);
+		// Copies live meshes into new pool buffers without holes and moves render objects to their new ranges
+		void							compactGeometryPool();
+		void							updateRenderObjectGeometry();
+		void							createChurnMeshes();
+		// Adds copy of mesh into pool and uploads it, pool is compacted when no free range is large enough
+		uint32_t						loadStreamedMesh(const SkinnedMesh& mesh);
+		// Unloads one streamed mesh and loads another, compacting pool now and then
+		void							churnGeometry(uint32_t frame);
+		void							createResidencyCache();
+		// Requests assets camera sees in frame, missing ones are loaded
+		void							streamAssets(uint32_t frame);
+		// Removes assets evicted before frames in flight started from pool
+		void							destroyEvictedAssets();
+		// Copies data through staging buffer, usage gets transfer destination added
+		void							createDeviceLocalBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
 		uint32_t						findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags memoryPropertiesFlags);
-		void							drawFrame(float deltaTime);
+		void							drawFrame();
+		void							drawHeadlessFrame();
+		void							saveOffscreenImage(uint32_t imageIndex, const std::string& fileName);
 		void							createSyncObjects();
 		void							createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
 		void							copyBuffer(VkBuffer sourceBuffer, VkBuffer destinationBuffer, VkDeviceSize deviceSize);
 		void							createDescriptorSetLayout();
 		void							createUniformBuffers();
-		void							updateUniformBuffer(uint32_t currentImage, float deltaTime);
-		void							createDescriptorPool();
-		void							createDescriptorSets();
+		void							updateUniformBuffer(uint32_t currentImage);
+		void							createDescriptorAllocators();
+		// Allocates set of current frame and writes uniform buffer of image and texture into it
+		VkDescriptorSet					writeSceneDescriptorSet(uint32_t imageIndex);
+		void							decodeTexture();
 		void							createTextureImage();
 		void							createImage(uint32_t width, uint32_t height, uint32_t mipLevelsNumber, VkFormat format, VkImageTiling imageTiling, VkImageUsageFlags imageUsageFlags, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-		VkCommandBuffer					beginSingleTimeCommands();
+		VkCommandBuffer					beginSingleTimeCommands(const char* profilerRegionName);
 		void							endSingleTimeCommands(VkCommandBuffer commandBuffer);
 		void							transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldImageLayout, VkImageLayout newImageLayout,  uint32_t mipLevelsNumber);
 		void							copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t imageWidth, uint32_t imageHeight);
@@ -82,14 +169,28 @@ class YasEngine
 		VkFormat						findDepthFormat();
 		bool							hasStencilComponent(VkFormat format);
 		void							loadModel();
+		void							createSimulation();
+		void							createCharacters();
+		void							createOccluderScene();
+		void							createSkinningResources();
+		void							destroySkinningResources();
+		void							animateCharacters(uint32_t currentImage);
 		void							generateMipmaps(VkImage image, VkFormat imageFormat, int32_t textureWidth,int32_t textureHeight,uint32_t mipLevelsNumber);
 
+#ifdef _WIN32
 		HINSTANCE						application;
 		HWND							window;
+#endif
+		bool							headless = false;
+		VkExtent2D						offscreenExtent;
+		// Stand in for swapchain images in headless mode
+		std::vector<VkDeviceMemory>		offscreenImagesMemory;
+		uint32_t						lastImageIndex = 0;
 		size_t							currentFrame = 0;
 		std::vector<VkSemaphore>		imageAvailableSemaphores;
 		std::vector<VkSemaphore>		renderFinishedSemaphores;
 		std::vector<VkFence>			inFlightFences;
+		std::vector<VkFence>			imagesInFlight;
 		VulkanInstance					vulkanInstance;
 		VkDebugReportCallbackEXT		callback;
 		VkSurfaceKHR					surface;
@@ -98,20 +199,73 @@ class YasEngine
 		VkQueue							presentationQueue;
 		VulkanSwapchain					vulkanSwapchain;
 		VkRenderPass					renderPass;
-		VkDescriptorSetLayout			descriptorSetLayout;
+		DescriptorLayoutCache			descriptorLayoutCache;
+		DescriptorLayout				sceneDescriptorLayout;
+		// Sets which live as long as device
+		DescriptorAllocator				descriptorAllocator;
+		// Scene set is written every frame, pools of frame are reset after its fence was waited for
+		FrameDescriptorAllocator		frameDescriptorAllocator;
+		uint32_t						descriptorStressSets = 0;
+		int64_t							descriptorStressNanoseconds = 0;
 		VkPipelineLayout				pipelineLayout;
-		VkPipeline						graphicsPipeline;
+		// Mapped for whole run, shader pack in it is used without copying
+		AssetArchive					assetArchive;
+		ShaderVariantCache				shaderVariantCache;
+		PipelineCache					pipelineCache;
+		// Pipeline states without render pass and layout, which change with swapchain
+		std::vector<PipelineState>		materials;
+		// Pipeline of every material once it is compiled, cleared when swapchain is recreated
+		std::vector<VkPipeline>			materialPipelines;
+		std::vector<uint32_t>			materialPipelineIds;
+		// Default state of default variant, compiled before first frame. Every variant without instancing reads the same vertices.
+		VkPipeline						fallbackPipeline;
+		uint32_t						fallbackPipelineId = 0;
+		bool							blockingPipelines = false;
+		uint64_t						fallbackDraws = 0;
+		uint32_t						newMaterialsNumber = 0;
+		uint32_t						introducedMaterials = 0;
 		std::vector<VkFramebuffer>		swapchainFramebuffers;
 		VkCommandPool					commandPool;
 		std::vector<VkCommandBuffer>	commandBuffers;
+		// Every mesh is sub-allocated from these two buffers, render objects point at their ranges
+		GeometryPool					geometryPool;
 		VkBuffer						vertexBuffer;
 		VkDeviceMemory					vertexBufferMemory;
 		VkBuffer						indexBuffer;
 		VkDeviceMemory					indexBufferMemory;
+		uint32_t						geometryChurnMeshes = 0;
+		// Procedural meshes of different sizes, streamed ones are their copies
+		std::vector<SkinnedMesh>		churnMeshes;
+		std::vector<uint32_t>			streamedMeshes;
+		int64_t							geometryCompactionNanoseconds = 0;
+		float							maxVertexFragmentation = 0.0F;
+		float							maxIndexFragmentation = 0.0F;
+		// Decides which streamed assets stay in pool, asset is index of its resource
+		ResidencyCache					residencyCache;
+		uint32_t						streamedAssetsNumber = 0;
+		uint32_t						residencyBudgetMegabytes = 0;
+		// Mesh of every asset in pool, NO_GEOMETRY_MESH when it is not resident
+		std::vector<uint32_t>			streamedAssetMeshes;
+		std::vector<uint32_t>			destroyedAssets;
 		std::vector<VkBuffer>			uniformBuffers;
 		std::vector<VkDeviceMemory>		uniformBuffersMemory;
-		VkDescriptorPool				descriptorPool;
-		std::vector<VkDescriptorSet>	descriptorSets;
+		std::vector<void*>				uniformBuffersMapped;
+		// Declared before render queue which gives memory back to it when destroyed
+		FrameArena						frameArena;
+		RenderQueue						renderQueue;
+		RenderQueueStatistics			renderQueueStatistics;
+		OcclusionCuller					occlusionCuller;
+		GpuProfiler						gpuProfiler;
+		FrameTimer						frameTimer;
+		JobSystem						jobSystem;
+		std::string						startupTimelinePath;
+		int64_t							runStartNanoseconds = 0;
+		int64_t							startupNanoseconds = 0;
+		// Decoded by init step while Vulkan objects are created
+		stbi_uc*						texturePixels = nullptr;
+		int								textureWidth = 0;
+		int								textureHeight = 0;
+		Simulation						simulation;
 		VkImage							textureImage;
 		uint32_t						mipLevels;
 		VkDeviceMemory					textureImageMemory;
@@ -120,9 +274,36 @@ class YasEngine
 		VkImage							depthImage;
 		VkDeviceMemory					depthImageMemory;
 		VkImageView						depthImageView;
-		float zeroTime = 0;
-		std::vector<Vertex> vertices;
-		std::vector<uint32_t> indices;
+		YasMathLib::mat4 viewProjection;
+		// Camera only depends on aspect ratio, view projection is computed again when it changes
+		float cameraAspectRatio = 0.0F;
+		std::vector<RenderObject> renderObjects;
+		// Transforms of render objects, their model matrices and model view projections are computed from it every frame
+		TransformBatch transformBatch;
+		std::vector<glm::mat4> modelViewProjections;
+		std::vector<uint32_t> visibleRenderObjects;
+		// Characters share one procedural skinned mesh, their render objects come after static ones
+		uint32_t						charactersNumber = 0;
+		// Wall occluder and boxes behind it come after characters. Test scene only, windowed run has none.
+		uint32_t						occludedBoxesNumber = 0;
+		bool							cpuSkinning = false;
+		std::string						preferredDevice;
+		SkinnedMesh						skinnedMesh;
+		std::vector<SkinnedCharacter>	characters;
+		SkinningPass					skinningPass;
+		VkBuffer						bindVerticesBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory					bindVerticesBufferMemory = VK_NULL_HANDLE;
+		VkBuffer						skinWeightsBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory					skinWeightsBufferMemory = VK_NULL_HANDLE;
+		// Skinning matrices and skinned vertices of all characters, one buffer per swapchain image
+		std::vector<VkBuffer>			skinningMatricesBuffers;
+		std::vector<VkDeviceMemory>		skinningMatricesBuffersMemory;
+		std::vector<void*>				skinningMatricesBuffersMapped;
+		std::vector<VkBuffer>			skinnedVertexBuffers;
+		std::vector<VkDeviceMemory>		skinnedVertexBuffersMemory;
+		// CPU skinning reads matrices from here instead of mapped memory and writes vertices straight into mapped vertex buffers
+		std::vector<YasMathLib::mat4>	skinningMatrices;
+		std::vector<void*>				skinnedVertexBuffersMapped;
 	//private end
 };
 
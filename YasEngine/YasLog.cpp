@@ -0,0 +1,399 @@
+#include"stdafx.hpp"
+#include"YasLog.hpp"
+#include"CpuProfiler.hpp"
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+static_assert(sizeof(LogRecord) == LOG_RECORD_SIZE, "Log record does not fill whole slot");
+
+std::atomic<bool> YasLog::running(false);
+std::unique_ptr<LogRecord[]> YasLog::ring;
+alignas(64) std::atomic<uint64_t> YasLog::enqueuePosition(0);
+std::atomic<uint32_t> YasLog::activeWriters(0);
+alignas(64) uint64_t YasLog::dequeuePosition = 0;
+uint64_t YasLog::writtenPosition = 0;
+std::atomic<uint16_t> YasLog::nextThreadIndex(0);
+int64_t YasLog::startNanoseconds = Clock::nanoseconds();
+std::ofstream YasLog::logFile;
+std::ostream* YasLog::output = &std::cout;
+std::string YasLog::batch;
+std::thread YasLog::writerThread;
+std::mutex YasLog::writerMutex;
+std::condition_variable YasLog::writerCondition;
+std::condition_variable YasLog::writtenCondition;
+std::mutex YasLog::directWriteMutex;
+
+static const char* const LOG_LEVEL_NAMES[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+void YasLog::start(const std::string& fileName)
+{
+	if(running.load())
+	{
+		return;
+	}
+
+	if(fileName.empty())
+	{
+		output = &std::cout;
+	}
+	else
+	{
+		logFile.open(fileName, std::ios::trunc);
+
+		if(!logFile.is_open())
+		{
+			throw std::runtime_error("Failed to create log file");
+		}
+		output = &logFile;
+	}
+
+	if(!ring)
+	{
+		ring.reset(new LogRecord[LOG_RING_SIZE]);
+	}
+
+	for(uint32_t i=0; i<LOG_RING_SIZE; i++)
+	{
+		ring[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	enqueuePosition.store(0);
+	dequeuePosition = 0;
+	writtenPosition = 0;
+	batch.reserve(LOG_RING_SIZE * 128);
+
+	running.store(true);
+	writerThread = std::thread(writerLoop);
+}
+
+void YasLog::stop()
+{
+	if(!running.load())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(writerMutex);
+		running.store(false, std::memory_order_seq_cst);
+	}
+	writerCondition.notify_one();
+	writerThread.join();
+
+	// Threads which saw logger running just before stop may still be filling reserved records or waiting for slot.
+	// Ring is drained until none of them is left, so every reserved position up to enqueue position gets written.
+	while(true)
+	{
+		const bool writersDone = activeWriters.load(std::memory_order_seq_cst) == 0;
+
+		if(writeBatch())
+		{
+			continue;
+		}
+
+		if(writersDone)
+		{
+			break;
+		}
+		std::this_thread::yield();
+	}
+
+	// Callers which came after stop write directly under this lock
+	std::lock_guard<std::mutex> lock(directWriteMutex);
+	if(logFile.is_open())
+	{
+		logFile.close();
+	}
+	output = &std::cout;
+}
+
+void YasLog::flush()
+{
+	if(!running.load())
+	{
+		return;
+	}
+
+	uint64_t target = enqueuePosition.load(std::memory_order_acquire);
+	std::unique_lock<std::mutex> lock(writerMutex);
+	writerCondition.notify_one();
+	writtenCondition.wait(lock, [target]
+	{
+		return writtenPosition >= target || !running.load();
+	});
+}
+
+LogRecord* YasLog::reserveRecord(uint64_t& position)
+{
+	position = enqueuePosition.load(std::memory_order_relaxed);
+
+	while(true)
+	{
+		LogRecord& record = ring[position & (LOG_RING_SIZE - 1)];
+		int64_t difference = static_cast<int64_t>(record.sequence.load(std::memory_order_acquire) - position);
+
+		if(difference == 0)
+		{
+			if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				return &record;
+			}
+		}
+		else if(difference < 0)
+		{
+			// Ring is full after stop, thread which stops logger drains it while caller writes directly
+			if(!running.load(std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+
+			// Ring is full, writer thread is woken up instead of dropping message
+			writerCondition.notify_one();
+			std::this_thread::yield();
+			position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+		else
+		{
+			// Other thread took this slot
+			position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+uint16_t YasLog::getThreadIndex()
+{
+	thread_local uint16_t threadIndex = nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+	return threadIndex;
+}
+
+void YasLog::encodeString(LogRecord& record, const char* text, size_t length)
+{
+	const size_t inlineSize = 1 + sizeof(uint16_t) + length;
+
+	if(!record.truncated && length <= UINT16_MAX && record.payloadSize + inlineSize <= LOG_RECORD_PAYLOAD_SIZE)
+	{
+		uint16_t inlineLength = static_cast<uint16_t>(length);
+		record.payload[record.payloadSize] = static_cast<char>(LOG_ARGUMENT_STRING);
+		std::memcpy(record.payload + record.payloadSize + 1, &inlineLength, sizeof(inlineLength));
+		std::memcpy(record.payload + record.payloadSize + 1 + sizeof(inlineLength), text, length);
+		record.payloadSize += static_cast<uint16_t>(inlineSize);
+		++record.argumentsNumber;
+		return;
+	}
+
+	// Long messages like validation layer output are rare, they are allowed to allocate
+	if(record.truncated || record.payloadSize + 1 + sizeof(uint64_t) + sizeof(char*) > LOG_RECORD_PAYLOAD_SIZE)
+	{
+		record.truncated = true;
+		return;
+	}
+
+	char* copy = new char[length];
+	std::memcpy(copy, text, length);
+	uint64_t heapLength = length;
+	record.payload[record.payloadSize] = static_cast<char>(LOG_ARGUMENT_HEAP_STRING);
+	std::memcpy(record.payload + record.payloadSize + 1, &heapLength, sizeof(heapLength));
+	std::memcpy(record.payload + record.payloadSize + 1 + sizeof(heapLength), &copy, sizeof(copy));
+	record.payloadSize += static_cast<uint16_t>(1 + sizeof(heapLength) + sizeof(copy));
+	++record.argumentsNumber;
+}
+
+void YasLog::writeNow(LogRecord& record)
+{
+	std::string line;
+	formatRecord(record, line);
+
+	std::lock_guard<std::mutex> lock(directWriteMutex);
+	output->write(line.data(), line.size());
+	output->flush();
+}
+
+void YasLog::formatRecord(LogRecord& record, std::string& output)
+{
+	char number[64];
+	double seconds = Clock::toSeconds(record.timeNanoseconds - startNanoseconds);
+	snprintf(number, sizeof(number), "[%11.6f][thread %u] ", seconds, static_cast<uint32_t>(record.threadIndex));
+	output += number;
+	output += LOG_LEVEL_NAMES[std::min<uint32_t>(record.level, YAS_LOG_LEVEL_ERROR)];
+	output += ": ";
+
+	const char* format = record.format;
+	size_t offset = 0;
+	uint32_t argument = 0;
+
+	while(*format != '\0')
+	{
+		if(format[0] != '{' || format[1] != '}')
+		{
+			output += *format;
+			++format;
+			continue;
+		}
+		format += 2;
+
+		if(argument >= record.argumentsNumber)
+		{
+			output += "{?}";
+			continue;
+		}
+		++argument;
+
+		LogArgumentType type = static_cast<LogArgumentType>(record.payload[offset]);
+		const char* value = record.payload + offset + 1;
+
+		switch(type)
+		{
+			case LOG_ARGUMENT_INT:
+			{
+				int64_t integer;
+				std::memcpy(&integer, value, sizeof(integer));
+				snprintf(number, sizeof(number), "%lld", static_cast<long long>(integer));
+				output += number;
+				offset += 1 + sizeof(integer);
+				break;
+			}
+			case LOG_ARGUMENT_UINT:
+			case LOG_ARGUMENT_BOOL:
+			case LOG_ARGUMENT_POINTER:
+			{
+				uint64_t integer;
+				std::memcpy(&integer, value, sizeof(integer));
+				if(type == LOG_ARGUMENT_BOOL)
+				{
+					output += integer != 0 ? "true" : "false";
+				}
+				else
+				{
+					snprintf(number, sizeof(number), type == LOG_ARGUMENT_POINTER ? "0x%llx" : "%llu", static_cast<unsigned long long>(integer));
+					output += number;
+				}
+				offset += 1 + sizeof(integer);
+				break;
+			}
+			case LOG_ARGUMENT_DOUBLE:
+			{
+				double real;
+				std::memcpy(&real, value, sizeof(real));
+				// Six significant digits like default formatting of streams
+				snprintf(number, sizeof(number), "%g", real);
+				output += number;
+				offset += 1 + sizeof(real);
+				break;
+			}
+			case LOG_ARGUMENT_STRING:
+			{
+				uint16_t length;
+				std::memcpy(&length, value, sizeof(length));
+				output.append(value + sizeof(length), length);
+				offset += 1 + sizeof(length) + length;
+				break;
+			}
+			case LOG_ARGUMENT_HEAP_STRING:
+			{
+				uint64_t length;
+				char* text;
+				std::memcpy(&length, value, sizeof(length));
+				std::memcpy(&text, value + sizeof(length), sizeof(text));
+				output.append(text, static_cast<size_t>(length));
+				offset += 1 + sizeof(length) + sizeof(text);
+				break;
+			}
+		}
+	}
+
+	if(record.truncated)
+	{
+		output += " (truncated)";
+	}
+	output += '\n';
+
+	// Heap copies are freed also for arguments which had no placeholder
+	offset = 0;
+	for(uint32_t i=0; i<record.argumentsNumber; i++)
+	{
+		LogArgumentType type = static_cast<LogArgumentType>(record.payload[offset]);
+		const char* value = record.payload + offset + 1;
+
+		if(type == LOG_ARGUMENT_STRING)
+		{
+			uint16_t length;
+			std::memcpy(&length, value, sizeof(length));
+			offset += 1 + sizeof(length) + length;
+		}
+		else if(type == LOG_ARGUMENT_HEAP_STRING)
+		{
+			char* text;
+			std::memcpy(&text, value + sizeof(uint64_t), sizeof(text));
+			delete[] text;
+			offset += 1 + sizeof(uint64_t) + sizeof(text);
+		}
+		else
+		{
+			offset += 1 + sizeof(uint64_t);
+		}
+	}
+}
+
+bool YasLog::writeBatch()
+{
+	batch.clear();
+	uint64_t position = dequeuePosition;
+
+	// Only this thread reads, slots are given back to writers one by one as soon as they are formatted.
+	// Batch is limited to one ring of messages so busy writers can not keep it growing.
+	while(position - dequeuePosition < LOG_RING_SIZE)
+	{
+		LogRecord& record = ring[position & (LOG_RING_SIZE - 1)];
+
+		if(record.sequence.load(std::memory_order_acquire) != position + 1)
+		{
+			break;
+		}
+
+		formatRecord(record, batch);
+		record.sequence.store(position + LOG_RING_SIZE, std::memory_order_release);
+		++position;
+	}
+
+	if(position == dequeuePosition)
+	{
+		return false;
+	}
+
+	// One write and one flush per batch instead of per line. Direct writes of callers after stop can happen at the same time.
+	{
+		std::lock_guard<std::mutex> lock(directWriteMutex);
+		output->write(batch.data(), batch.size());
+		output->flush();
+	}
+	dequeuePosition = position;
+
+	{
+		std::lock_guard<std::mutex> lock(writerMutex);
+		writtenPosition = position;
+	}
+	writtenCondition.notify_all();
+	return true;
+}
+
+void YasLog::writerLoop()
+{
+	YAS_PROFILE_THREAD_NAME("Logger");
+
+	while(running.load())
+	{
+		if(writeBatch())
+		{
+			continue;
+		}
+
+		// Writers do not notify, timeout bounds how long message waits in ring
+		std::unique_lock<std::mutex> lock(writerMutex);
+		if(running.load())
+		{
+			writerCondition.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_MILLISECONDS));
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(writerMutex);
+	writtenCondition.notify_all();
+}
@@ -1,19 +1,215 @@
 #ifndef YASLOG_HPP
 #define YASLOG_HPP
 #include"stdafx.hpp"
+#include"Clock.hpp"
 
 //-----------------------------------------------------------------------------|---------------------------------------|
 
-template<typename T>
+#define YAS_LOG_LEVEL_DEBUG				0
+#define YAS_LOG_LEVEL_INFO				1
+#define YAS_LOG_LEVEL_WARNING			2
+#define YAS_LOG_LEVEL_ERROR				3
+
+// Messages below this level are removed at compile time, their arguments are not evaluated
+#ifndef YAS_LOG_LEVEL
+	#ifdef NDEBUG
+		#define YAS_LOG_LEVEL			YAS_LOG_LEVEL_INFO
+	#else
+		#define YAS_LOG_LEVEL			YAS_LOG_LEVEL_DEBUG
+	#endif
+#endif
+
+// Must be power of two
+const uint32_t LOG_RING_SIZE					= 8192;
+const uint32_t LOG_RECORD_SIZE					= 256;
+const uint32_t LOG_RECORD_HEADER_SIZE			= 32;
+const uint32_t LOG_RECORD_PAYLOAD_SIZE			= LOG_RECORD_SIZE - LOG_RECORD_HEADER_SIZE;
+const uint32_t LOG_FLUSH_MILLISECONDS			= 10;
+
+enum LogArgumentType
+{
+	LOG_ARGUMENT_INT,
+	LOG_ARGUMENT_UINT,
+	LOG_ARGUMENT_DOUBLE,
+	LOG_ARGUMENT_BOOL,
+	LOG_ARGUMENT_POINTER,
+	// Length and characters are copied into record
+	LOG_ARGUMENT_STRING,
+	// String which does not fit into record is copied to heap, writer thread deletes it
+	LOG_ARGUMENT_HEAP_STRING
+};
+
+// Message before formatting. Format is not copied so it must be string literal.
+// Arguments are stored one after another in payload as type byte followed by value.
+struct alignas(64) LogRecord
+{
+	// Slot is free for writer at position when sequence equals position and ready for reader when it equals position + 1
+	std::atomic<uint64_t>			sequence;
+	int64_t							timeNanoseconds;
+	const char*						format;
+	uint16_t						threadIndex;
+	uint16_t						payloadSize;
+	uint8_t							level;
+	uint8_t							argumentsNumber;
+	// Set when some argument did not fit, placeholders from that one on are written as {?}
+	bool							truncated;
+	char							payload[LOG_RECORD_PAYLOAD_SIZE];
+};
+
+// Asynchronous logger. Calling thread only copies raw arguments into bounded multi producer ring,
+// formatting and writing happen in batches on background thread. When ring is full caller waits, messages are never dropped.
+// Before start and after stop messages are formatted and written on calling thread, also by callers which waited for full ring when stop came.
 class YasLog
 {
 	public:
-		static void log(std::string prefix, std::string additionalText, T loggedVariable)
+
+		// Empty file name writes to standard output
+		static void						start(const std::string& fileName);
+		// Stops background thread and writes all messages, also those which other threads are still putting into ring
+		static void						stop();
+		// Returns when every message logged before call was written
+		static void						flush();
+
+		// Format uses {} placeholders, arguments can be numbers, bool, pointers, C strings and std::string
+		template<typename... Arguments>
+		static void						write(uint32_t level, const char* format, const Arguments&... arguments)
 		{
-			std::cout << prefix << additionalText << loggedVariable << std::endl;
+			// Stop waits until writers which saw logger running are done with ring
+			activeWriters.fetch_add(1, std::memory_order_seq_cst);
+			uint64_t position;
+			LogRecord* record = running.load(std::memory_order_seq_cst) ? reserveRecord(position) : nullptr;
+
+			if(record == nullptr)
+			{
+				LogRecord directRecord;
+				fillRecord(directRecord, level, format, arguments...);
+				writeNow(directRecord);
+			}
+			else
+			{
+				fillRecord(*record, level, format, arguments...);
+				record->sequence.store(position + 1, std::memory_order_release);
+			}
+			activeWriters.fetch_sub(1, std::memory_order_release);
 		}
 
 	private:
+
+		template<typename... Arguments>
+		static void						fillRecord(LogRecord& record, uint32_t level, const char* format, const Arguments&... arguments)
+		{
+			record.timeNanoseconds = Clock::nanoseconds();
+			record.format = format;
+			record.threadIndex = getThreadIndex();
+			record.payloadSize = 0;
+			record.level = static_cast<uint8_t>(level);
+			record.argumentsNumber = 0;
+			record.truncated = false;
+			(encodeArgument(record, arguments), ...);
+		}
+
+		template<typename T>
+		static void						encodeArgument(LogRecord& record, const T& value)
+		{
+			if constexpr(std::is_same<T, bool>::value)
+			{
+				encodeValue(record, LOG_ARGUMENT_BOOL, static_cast<uint64_t>(value));
+			}
+			else if constexpr(std::is_enum<T>::value || (std::is_integral<T>::value && std::is_signed<T>::value))
+			{
+				encodeValue(record, LOG_ARGUMENT_INT, static_cast<int64_t>(value));
+			}
+			else if constexpr(std::is_integral<T>::value)
+			{
+				encodeValue(record, LOG_ARGUMENT_UINT, static_cast<uint64_t>(value));
+			}
+			else if constexpr(std::is_floating_point<T>::value)
+			{
+				encodeValue(record, LOG_ARGUMENT_DOUBLE, static_cast<double>(value));
+			}
+			else if constexpr(std::is_convertible<const T&, const char*>::value)
+			{
+				const char* text = value;
+				encodeString(record, text != nullptr ? text : "(null)", text != nullptr ? std::strlen(text) : 6);
+			}
+			else if constexpr(std::is_same<T, std::string>::value)
+			{
+				encodeString(record, value.data(), value.size());
+			}
+			else if constexpr(std::is_pointer<T>::value)
+			{
+				encodeValue(record, LOG_ARGUMENT_POINTER, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+			}
+			else
+			{
+				static_assert(std::is_same<T, void>::value, "Type of argument can not be logged");
+			}
+		}
+
+		template<typename T>
+		static void						encodeValue(LogRecord& record, LogArgumentType type, T value)
+		{
+			if(record.truncated || record.payloadSize + 1 + sizeof(T) > LOG_RECORD_PAYLOAD_SIZE)
+			{
+				record.truncated = true;
+				return;
+			}
+			record.payload[record.payloadSize] = static_cast<char>(type);
+			std::memcpy(record.payload + record.payloadSize + 1, &value, sizeof(T));
+			record.payloadSize += static_cast<uint16_t>(1 + sizeof(T));
+			++record.argumentsNumber;
+		}
+
+		static void						encodeString(LogRecord& record, const char* text, size_t length);
+		// Returns nullptr when ring is full and logger was stopped meanwhile, message is then written directly
+		static LogRecord*				reserveRecord(uint64_t& position);
+		static uint16_t					getThreadIndex();
+		static void						writeNow(LogRecord& record);
+		// Appends formatted line and deletes heap strings of record
+		static void						formatRecord(LogRecord& record, std::string& output);
+		static void						writerLoop();
+		// Returns true when something was written
+		static bool						writeBatch();
+
+		static std::atomic<bool>		running;
+		static std::unique_ptr<LogRecord[]> ring;
+		// Separate cache lines, producers only touch enqueue position
+		alignas(64) static std::atomic<uint64_t> enqueuePosition;
+		static std::atomic<uint32_t>	activeWriters;
+		alignas(64) static uint64_t		dequeuePosition;
+		static uint64_t					writtenPosition;
+		static std::atomic<uint16_t>	nextThreadIndex;
+		static int64_t					startNanoseconds;
+
+		static std::ofstream			logFile;
+		static std::ostream*			output;
+		static std::string				batch;
+		static std::thread				writerThread;
+		static std::mutex				writerMutex;
+		static std::condition_variable	writerCondition;
+		static std::condition_variable	writtenCondition;
+		// Serializes direct writes done when background thread is not running
+		static std::mutex				directWriteMutex;
 };
 
-#endif
\ No newline at end of file
+#if YAS_LOG_LEVEL <= YAS_LOG_LEVEL_DEBUG
+	#define YAS_LOG_DEBUG(...)			YasLog::write(YAS_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+	#define YAS_LOG_DEBUG(...)			((void)0)
+#endif
+
+#if YAS_LOG_LEVEL <= YAS_LOG_LEVEL_INFO
+	#define YAS_LOG_INFO(...)			YasLog::write(YAS_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+	#define YAS_LOG_INFO(...)			((void)0)
+#endif
+
+#if YAS_LOG_LEVEL <= YAS_LOG_LEVEL_WARNING
+	#define YAS_LOG_WARNING(...)		YasLog::write(YAS_LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+	#define YAS_LOG_WARNING(...)		((void)0)
+#endif
+
+#define YAS_LOG_ERROR(...)				YasLog::write(YAS_LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
@@ -1,59 +1,601 @@
 #ifndef YASMATHLIB_HPP
 #define YASMATHLIB_HPP
+#include"stdafx.hpp"
 
+// SSE is part of every x64 target. Define YAS_MATH_FORCE_SCALAR to build portable code path instead.
+#if !defined(YAS_MATH_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define YAS_MATH_SSE
+	#if defined(__AVX__)
+		#define YAS_MATH_AVX
+	#endif
+	#include<immintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------|---------------------------------------|
+
+// Column major like glm and GLSL, so matrices can be copied to uniform buffers as they are.
+// Operations are done in the same order as in glm, results of both paths are bit for bit equal to glm without FMA contraction.
 namespace YasMathLib
 {
 	struct vec2
 	{
 		float x;
 		float y;
+
+										vec2() = default;
+										vec2(float x, float y) : x(x), y(y)
+		{
+		}
 	};
 
+	// Not padded so it can be used in vertex layouts. SIMD operations use vec4.
 	struct vec3
 	{
 		float x;
 		float y;
 		float z;
+
+										vec3() = default;
+										vec3(float x, float y, float z) : x(x), y(y), z(z)
+		{
+		}
+		explicit						vec3(float scalar) : x(scalar), y(scalar), z(scalar)
+		{
+		}
+
+		float&							operator[](int index)
+		{
+			return (&x)[index];
+		}
+
+		float							operator[](int index) const
+		{
+			return (&x)[index];
+		}
 	};
-	
-	struct vec4
+
+	struct alignas(16) vec4
 	{
 		float x;
 		float y;
 		float z;
 		float w;
+
+										vec4() = default;
+										vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w)
+		{
+		}
+										vec4(const vec3& xyz, float w) : x(xyz.x), y(xyz.y), z(xyz.z), w(w)
+		{
+		}
+		explicit						vec4(float scalar) : x(scalar), y(scalar), z(scalar), w(scalar)
+		{
+		}
+
+		float&							operator[](int index)
+		{
+			return (&x)[index];
+		}
+
+		float							operator[](int index) const
+		{
+			return (&x)[index];
+		}
 	};
 
-	struct mat4x4
+	struct alignas(16) mat4x4
 	{
-		float x0;
-		float y0;
-		float z0;
-		float w0;
+		vec4 columns[4];
+
+										mat4x4() = default;
+		// Diagonal matrix, mat4x4(1.0F) is identity
+		explicit						mat4x4(float diagonal)
+		{
+			columns[0] = vec4(diagonal, 0.0F, 0.0F, 0.0F);
+			columns[1] = vec4(0.0F, diagonal, 0.0F, 0.0F);
+			columns[2] = vec4(0.0F, 0.0F, diagonal, 0.0F);
+			columns[3] = vec4(0.0F, 0.0F, 0.0F, diagonal);
+		}
+										mat4x4(const vec4& column0, const vec4& column1, const vec4& column2, const vec4& column3)
+		{
+			columns[0] = column0;
+			columns[1] = column1;
+			columns[2] = column2;
+			columns[3] = column3;
+		}
+
+		vec4&							operator[](int index)
+		{
+			return columns[index];
+		}
+
+		const vec4&						operator[](int index) const
+		{
+			return columns[index];
+		}
+	};
 
-		float x1;
-		float y1;
-		float z1;
-		float w1;
+	typedef mat4x4 mat4;
 
-		float x2;
-		float y2;
-		float z2;
-		float w2;
+	// Unit quaternion, components are stored x, y, z, w like in glm
+	struct quat
+	{
+		float x;
+		float y;
+		float z;
+		float w;
 
-		float x3;
-		float y3;
-		float z3;
-		float w3;
+										quat() = default;
+		// Same argument order as glm::quat
+										quat(float w, float x, float y, float z) : x(x), y(y), z(z), w(w)
+		{
+		}
 	};
 
+	static_assert(sizeof(vec4) == 16 && sizeof(mat4x4) == 64, "Vectors and matrices must be tightly packed");
+
+#if defined(YAS_MATH_SSE)
+	inline __m128						load(const vec4& vector)
+	{
+		return _mm_load_ps(&vector.x);
+	}
+
+	inline vec4							store(__m128 value)
+	{
+		vec4 vector;
+		_mm_store_ps(&vector.x, value);
+		return vector;
+	}
+
+	template<int INDEX>
+	inline __m128						splat(__m128 value)
+	{
+		return _mm_shuffle_ps(value, value, _MM_SHUFFLE(INDEX, INDEX, INDEX, INDEX));
+	}
+#endif
+
+	// vec3, scalar only
+
+	inline vec3							operator+(const vec3& left, const vec3& right)
+	{
+		return vec3(left.x + right.x, left.y + right.y, left.z + right.z);
+	}
+
+	inline vec3							operator-(const vec3& left, const vec3& right)
+	{
+		return vec3(left.x - right.x, left.y - right.y, left.z - right.z);
+	}
+
+	inline vec3							operator*(const vec3& left, const vec3& right)
+	{
+		return vec3(left.x * right.x, left.y * right.y, left.z * right.z);
+	}
+
+	inline vec3							operator*(const vec3& vector, float scalar)
+	{
+		return vec3(vector.x * scalar, vector.y * scalar, vector.z * scalar);
+	}
+
+	inline float						dot(const vec3& left, const vec3& right)
+	{
+		vec3 product = left * right;
+		return product.x + product.y + product.z;
+	}
+
+	inline vec3							cross(const vec3& left, const vec3& right)
+	{
+		return vec3(left.y * right.z - right.y * left.z, left.z * right.x - right.z * left.x, left.x * right.y - right.x * left.y);
+	}
+
+	inline vec3							normalize(const vec3& vector)
+	{
+		return vector * (1.0F / std::sqrt(dot(vector, vector)));
+	}
+
+	// vec4
+
+	inline vec4							operator+(const vec4& left, const vec4& right)
+	{
+#if defined(YAS_MATH_SSE)
+		return store(_mm_add_ps(load(left), load(right)));
+#else
+		return vec4(left.x + right.x, left.y + right.y, left.z + right.z, left.w + right.w);
+#endif
+	}
+
+	inline vec4							operator-(const vec4& left, const vec4& right)
+	{
+#if defined(YAS_MATH_SSE)
+		return store(_mm_sub_ps(load(left), load(right)));
+#else
+		return vec4(left.x - right.x, left.y - right.y, left.z - right.z, left.w - right.w);
+#endif
+	}
+
+	inline vec4							operator*(const vec4& left, const vec4& right)
+	{
+#if defined(YAS_MATH_SSE)
+		return store(_mm_mul_ps(load(left), load(right)));
+#else
+		return vec4(left.x * right.x, left.y * right.y, left.z * right.z, left.w * right.w);
+#endif
+	}
+
+	inline vec4							operator*(const vec4& vector, float scalar)
+	{
+#if defined(YAS_MATH_SSE)
+		return store(_mm_mul_ps(load(vector), _mm_set1_ps(scalar)));
+#else
+		return vec4(vector.x * scalar, vector.y * scalar, vector.z * scalar, vector.w * scalar);
+#endif
+	}
+
+	inline bool							operator==(const vec4& left, const vec4& right)
+	{
+		return left.x == right.x && left.y == right.y && left.z == right.z && left.w == right.w;
+	}
+
+	inline float						dot(const vec4& left, const vec4& right)
+	{
+#if defined(YAS_MATH_SSE)
+		// (x + y) + (z + w) like glm
+		__m128 product = _mm_mul_ps(load(left), load(right));
+		__m128 pairs = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2))));
+#else
+		vec4 product = left * right;
+		return (product.x + product.y) + (product.z + product.w);
+#endif
+	}
+
+	// Cross product of xyz parts, w of result is 0
+	inline vec4							cross(const vec4& left, const vec4& right)
+	{
+#if defined(YAS_MATH_SSE)
+		__m128 a = load(left);
+		__m128 b = load(right);
+		__m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 aZxy = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+		__m128 bZxy = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+		__m128 result = _mm_sub_ps(_mm_mul_ps(aYzx, bZxy), _mm_mul_ps(aZxy, bYzx));
+		// Clears w also when it was infinity or NaN
+		return store(_mm_and_ps(result, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0))));
+#else
+		return vec4(cross(vec3(left.x, left.y, left.z), vec3(right.x, right.y, right.z)), 0.0F);
+#endif
+	}
+
+	inline vec4							normalize(const vec4& vector)
+	{
+#if defined(YAS_MATH_SSE)
+		__m128 lengthSquared = _mm_set1_ps(dot(vector, vector));
+		return store(_mm_mul_ps(load(vector), _mm_div_ps(_mm_set1_ps(1.0F), _mm_sqrt_ps(lengthSquared))));
+#else
+		return vector * (1.0F / std::sqrt(dot(vector, vector)));
+#endif
+	}
+
+	// mat4x4
+
+	inline vec4							operator*(const mat4x4& matrix, const vec4& vector)
+	{
+#if defined(YAS_MATH_SSE)
+		__m128 v = load(vector);
+		__m128 sum01 = _mm_add_ps(_mm_mul_ps(load(matrix[0]), splat<0>(v)), _mm_mul_ps(load(matrix[1]), splat<1>(v)));
+		__m128 sum23 = _mm_add_ps(_mm_mul_ps(load(matrix[2]), splat<2>(v)), _mm_mul_ps(load(matrix[3]), splat<3>(v)));
+		return store(_mm_add_ps(sum01, sum23));
+#else
+		return (matrix[0] * vector.x + matrix[1] * vector.y) + (matrix[2] * vector.z + matrix[3] * vector.w);
+#endif
+	}
+
+	inline mat4x4						operator*(const mat4x4& left, const mat4x4& right)
+	{
+		mat4x4 result;
+#if defined(YAS_MATH_AVX)
+		// Two columns of result per iteration, each 128 bit lane works on own column. Matrix is only 16 byte aligned.
+		__m256 left0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&left[0]));
+		__m256 left1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&left[1]));
+		__m256 left2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&left[2]));
+		__m256 left3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&left[3]));
+
+		for(int i=0; i<4; i+=2)
+		{
+			// Two 128 bit loads, columns are often just written by scalar or 128 bit stores which can not forward to one 256 bit load
+			__m256 columns = _mm256_insertf128_ps(_mm256_castps128_ps256(load(right[i])), load(right[i + 1]), 1);
+			__m256 sum = _mm256_mul_ps(left0, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(0, 0, 0, 0)));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(left1, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(1, 1, 1, 1))));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(left2, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(2, 2, 2, 2))));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(left3, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm256_storeu_ps(&result[i].x, sum);
+		}
+#elif defined(YAS_MATH_SSE)
+		__m128 left0 = load(left[0]);
+		__m128 left1 = load(left[1]);
+		__m128 left2 = load(left[2]);
+		__m128 left3 = load(left[3]);
+
+		for(int i=0; i<4; i++)
+		{
+			__m128 column = load(right[i]);
+			__m128 sum = _mm_mul_ps(left0, splat<0>(column));
+			sum = _mm_add_ps(sum, _mm_mul_ps(left1, splat<1>(column)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(left2, splat<2>(column)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(left3, splat<3>(column)));
+			_mm_store_ps(&result[i].x, sum);
+		}
+#else
+		for(int i=0; i<4; i++)
+		{
+			result[i] = left[0] * right[i].x + left[1] * right[i].y + left[2] * right[i].z + left[3] * right[i].w;
+		}
+#endif
+		return result;
+	}
+
+	inline mat4x4						transpose(const mat4x4& matrix)
+	{
+#if defined(YAS_MATH_SSE)
+		__m128 column0 = load(matrix[0]);
+		__m128 column1 = load(matrix[1]);
+		__m128 column2 = load(matrix[2]);
+		__m128 column3 = load(matrix[3]);
+		_MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+		return mat4x4(store(column0), store(column1), store(column2), store(column3));
+#else
+		mat4x4 result;
+		for(int i=0; i<4; i++)
+		{
+			for(int j=0; j<4; j++)
+			{
+				result[i][j] = matrix[j][i];
+			}
+		}
+		return result;
+#endif
+	}
+
+#if defined(YAS_MATH_SSE)
+	// Cofactors of 2x2 minors from columns 1, 2 and 3 using rows A and B, in layout used by inverse
+	template<int A, int B>
+	inline __m128						inverseFactor(__m128 column1, __m128 column2, __m128 column3)
+	{
+		__m128 swapB = _mm_shuffle_ps(column3, column2, _MM_SHUFFLE(B, B, B, B));
+		__m128 swapA = _mm_shuffle_ps(column3, column2, _MM_SHUFFLE(A, A, A, A));
+		__m128 left0 = _mm_shuffle_ps(column2, column1, _MM_SHUFFLE(A, A, A, A));
+		__m128 right0 = _mm_shuffle_ps(swapB, swapB, _MM_SHUFFLE(2, 0, 0, 0));
+		__m128 left1 = _mm_shuffle_ps(swapA, swapA, _MM_SHUFFLE(2, 0, 0, 0));
+		__m128 right1 = _mm_shuffle_ps(column2, column1, _MM_SHUFFLE(B, B, B, B));
+		return _mm_sub_ps(_mm_mul_ps(left0, right0), _mm_mul_ps(left1, right1));
+	}
+
+	// (m[1][ROW], m[0][ROW], m[0][ROW], m[0][ROW])
+	template<int ROW>
+	inline __m128						inverseRow(__m128 column0, __m128 column1)
+	{
+		__m128 pair = _mm_shuffle_ps(column1, column0, _MM_SHUFFLE(ROW, ROW, ROW, ROW));
+		return _mm_shuffle_ps(pair, pair, _MM_SHUFFLE(2, 2, 2, 0));
+	}
+#endif
+
+	// Cofactor expansion of glm::inverse. Matrix must be invertible.
+	inline mat4x4						inverse(const mat4x4& matrix)
+	{
+#if defined(YAS_MATH_SSE)
+		__m128 column0 = load(matrix[0]);
+		__m128 column1 = load(matrix[1]);
+		__m128 column2 = load(matrix[2]);
+		__m128 column3 = load(matrix[3]);
+
+		__m128 factor0 = inverseFactor<2, 3>(column1, column2, column3);
+		__m128 factor1 = inverseFactor<1, 3>(column1, column2, column3);
+		__m128 factor2 = inverseFactor<1, 2>(column1, column2, column3);
+		__m128 factor3 = inverseFactor<0, 3>(column1, column2, column3);
+		__m128 factor4 = inverseFactor<0, 2>(column1, column2, column3);
+		__m128 factor5 = inverseFactor<0, 1>(column1, column2, column3);
+
+		__m128 row0 = inverseRow<0>(column0, column1);
+		__m128 row1 = inverseRow<1>(column0, column1);
+		__m128 row2 = inverseRow<2>(column0, column1);
+		__m128 row3 = inverseRow<3>(column0, column1);
+
+		const __m128 signA = _mm_setr_ps(1.0F, -1.0F, 1.0F, -1.0F);
+		const __m128 signB = _mm_setr_ps(-1.0F, 1.0F, -1.0F, 1.0F);
+		__m128 inverse0 = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(row1, factor0), _mm_mul_ps(row2, factor1)), _mm_mul_ps(row3, factor2)), signA);
+		__m128 inverse1 = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(row0, factor0), _mm_mul_ps(row2, factor3)), _mm_mul_ps(row3, factor4)), signB);
+		__m128 inverse2 = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(row0, factor1), _mm_mul_ps(row1, factor3)), _mm_mul_ps(row3, factor5)), signA);
+		__m128 inverse3 = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(row0, factor2), _mm_mul_ps(row1, factor4)), _mm_mul_ps(row2, factor5)), signB);
+
+		// Determinant is dot product of first column with first row of adjugate
+		__m128 firstRow = _mm_shuffle_ps(_mm_shuffle_ps(inverse0, inverse1, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(inverse2, inverse3, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 product = _mm_mul_ps(column0, firstRow);
+		__m128 pairs = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+		__m128 determinant = _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2)));
+		__m128 oneOverDeterminant = _mm_div_ps(_mm_set1_ps(1.0F), determinant);
+
+		return mat4x4(store(_mm_mul_ps(inverse0, oneOverDeterminant)), store(_mm_mul_ps(inverse1, oneOverDeterminant)), store(_mm_mul_ps(inverse2, oneOverDeterminant)), store(_mm_mul_ps(inverse3, oneOverDeterminant)));
+#else
+		const mat4x4& m = matrix;
+		float coefficient00 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+		float coefficient02 = m[1][2] * m[3][3] - m[3][2] * m[1][3];
+		float coefficient03 = m[1][2] * m[2][3] - m[2][2] * m[1][3];
+		float coefficient04 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+		float coefficient06 = m[1][1] * m[3][3] - m[3][1] * m[1][3];
+		float coefficient07 = m[1][1] * m[2][3] - m[2][1] * m[1][3];
+		float coefficient08 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+		float coefficient10 = m[1][1] * m[3][2] - m[3][1] * m[1][2];
+		float coefficient11 = m[1][1] * m[2][2] - m[2][1] * m[1][2];
+		float coefficient12 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+		float coefficient14 = m[1][0] * m[3][3] - m[3][0] * m[1][3];
+		float coefficient15 = m[1][0] * m[2][3] - m[2][0] * m[1][3];
+		float coefficient16 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+		float coefficient18 = m[1][0] * m[3][2] - m[3][0] * m[1][2];
+		float coefficient19 = m[1][0] * m[2][2] - m[2][0] * m[1][2];
+		float coefficient20 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+		float coefficient22 = m[1][0] * m[3][1] - m[3][0] * m[1][1];
+		float coefficient23 = m[1][0] * m[2][1] - m[2][0] * m[1][1];
+
+		vec4 factor0(coefficient00, coefficient00, coefficient02, coefficient03);
+		vec4 factor1(coefficient04, coefficient04, coefficient06, coefficient07);
+		vec4 factor2(coefficient08, coefficient08, coefficient10, coefficient11);
+		vec4 factor3(coefficient12, coefficient12, coefficient14, coefficient15);
+		vec4 factor4(coefficient16, coefficient16, coefficient18, coefficient19);
+		vec4 factor5(coefficient20, coefficient20, coefficient22, coefficient23);
+
+		vec4 row0(m[1][0], m[0][0], m[0][0], m[0][0]);
+		vec4 row1(m[1][1], m[0][1], m[0][1], m[0][1]);
+		vec4 row2(m[1][2], m[0][2], m[0][2], m[0][2]);
+		vec4 row3(m[1][3], m[0][3], m[0][3], m[0][3]);
+
+		const vec4 signA(1.0F, -1.0F, 1.0F, -1.0F);
+		const vec4 signB(-1.0F, 1.0F, -1.0F, 1.0F);
+		mat4x4 result((row1 * factor0 - row2 * factor1 + row3 * factor2) * signA, (row0 * factor0 - row2 * factor3 + row3 * factor4) * signB,
+			(row0 * factor1 - row1 * factor3 + row3 * factor5) * signA, (row0 * factor2 - row1 * factor4 + row2 * factor5) * signB);
+
+		vec4 firstRow(result[0][0], result[1][0], result[2][0], result[3][0]);
+		float oneOverDeterminant = 1.0F / dot(m[0], firstRow);
+
+		for(int i=0; i<4; i++)
+		{
+			result[i] = result[i] * oneOverDeterminant;
+		}
+		return result;
+#endif
+	}
+
+	// Transformations, same conventions as glm with GLM_FORCE_DEPTH_ZERO_TO_ONE: right handed, depth from 0 to 1
+
+	inline float						radians(float degrees)
+	{
+		return degrees * 0.01745329251994329576923690768489F;
+	}
+
+	inline mat4x4						translate(const mat4x4& matrix, const vec3& offset)
+	{
+		mat4x4 result = matrix;
+		result[3] = matrix[0] * offset.x + matrix[1] * offset.y + matrix[2] * offset.z + matrix[3];
+		return result;
+	}
+
+	inline mat4x4						scale(const mat4x4& matrix, const vec3& factors)
+	{
+		return mat4x4(matrix[0] * factors.x, matrix[1] * factors.y, matrix[2] * factors.z, matrix[3]);
+	}
+
+	inline mat4x4						rotate(const mat4x4& matrix, float angle, const vec3& axis)
+	{
+		const float cosine = std::cos(angle);
+		const float sine = std::sin(angle);
+		const vec3 unitAxis = normalize(axis);
+		const vec3 temp = unitAxis * (1.0F - cosine);
+
+		mat4x4 rotation;
+		rotation[0][0] = cosine + temp[0] * unitAxis[0];
+		rotation[0][1] = temp[0] * unitAxis[1] + sine * unitAxis[2];
+		rotation[0][2] = temp[0] * unitAxis[2] - sine * unitAxis[1];
+		rotation[1][0] = temp[1] * unitAxis[0] - sine * unitAxis[2];
+		rotation[1][1] = cosine + temp[1] * unitAxis[1];
+		rotation[1][2] = temp[1] * unitAxis[2] + sine * unitAxis[0];
+		rotation[2][0] = temp[2] * unitAxis[0] + sine * unitAxis[1];
+		rotation[2][1] = temp[2] * unitAxis[1] - sine * unitAxis[0];
+		rotation[2][2] = cosine + temp[2] * unitAxis[2];
+
+		mat4x4 result;
+		result[0] = matrix[0] * rotation[0][0] + matrix[1] * rotation[0][1] + matrix[2] * rotation[0][2];
+		result[1] = matrix[0] * rotation[1][0] + matrix[1] * rotation[1][1] + matrix[2] * rotation[1][2];
+		result[2] = matrix[0] * rotation[2][0] + matrix[1] * rotation[2][1] + matrix[2] * rotation[2][2];
+		result[3] = matrix[3];
+		return result;
+	}
+
+	inline mat4x4						lookAt(const vec3& eye, const vec3& center, const vec3& up)
+	{
+		const vec3 forward = normalize(center - eye);
+		const vec3 side = normalize(cross(forward, up));
+		const vec3 cameraUp = cross(side, forward);
+
+		mat4x4 result(1.0F);
+		result[0][0] = side.x;
+		result[1][0] = side.y;
+		result[2][0] = side.z;
+		result[0][1] = cameraUp.x;
+		result[1][1] = cameraUp.y;
+		result[2][1] = cameraUp.z;
+		result[0][2] = -forward.x;
+		result[1][2] = -forward.y;
+		result[2][2] = -forward.z;
+		result[3][0] = -dot(side, eye);
+		result[3][1] = -dot(cameraUp, eye);
+		result[3][2] = dot(forward, eye);
+		return result;
+	}
+
+	inline mat4x4						perspective(float fieldOfViewY, float aspectRatio, float zNear, float zFar)
+	{
+		const float tanHalfFieldOfView = std::tan(fieldOfViewY / 2.0F);
+
+		mat4x4 result(0.0F);
+		result[0][0] = 1.0F / (aspectRatio * tanHalfFieldOfView);
+		result[1][1] = 1.0F / tanHalfFieldOfView;
+		result[2][2] = zFar / (zNear - zFar);
+		result[2][3] = -1.0F;
+		result[3][2] = -(zFar * zNear) / (zFar - zNear);
+		return result;
+	}
+
+	inline quat							angleAxis(float angle, const vec3& unitAxis)
+	{
+		const float sine = std::sin(angle * 0.5F);
+		return quat(std::cos(angle * 0.5F), unitAxis.x * sine, unitAxis.y * sine, unitAxis.z * sine);
+	}
+
+	// Rotation matrix of unit quaternion, same as glm::mat4_cast
+	inline mat4x4						toMat4(const quat& rotation)
+	{
+		const float xx = rotation.x * rotation.x;
+		const float yy = rotation.y * rotation.y;
+		const float zz = rotation.z * rotation.z;
+		const float xz = rotation.x * rotation.z;
+		const float xy = rotation.x * rotation.y;
+		const float yz = rotation.y * rotation.z;
+		const float wx = rotation.w * rotation.x;
+		const float wy = rotation.w * rotation.y;
+		const float wz = rotation.w * rotation.z;
+
+		return mat4x4(vec4(1.0F - 2.0F * (yy + zz), 2.0F * (xy + wz), 2.0F * (xz - wy), 0.0F),
+			vec4(2.0F * (xy - wz), 1.0F - 2.0F * (xx + zz), 2.0F * (yz + wx), 0.0F),
+			vec4(2.0F * (xz + wy), 2.0F * (yz - wx), 1.0F - 2.0F * (xx + yy), 0.0F),
+			vec4(0.0F, 0.0F, 0.0F, 1.0F));
+	}
+
+	// Rest of engine still works with glm, both have the same memory layout
+	inline glm::mat4					toGlm(const mat4x4& matrix)
+	{
+		static_assert(sizeof(glm::mat4) == sizeof(mat4x4), "Layout of glm::mat4 differs");
+		glm::mat4 result;
+		std::memcpy(&result[0].x, &matrix[0].x, sizeof(result));
+		return result;
+	}
+
+	inline mat4x4						fromGlm(const glm::mat4& matrix)
+	{
+		mat4x4 result;
+		std::memcpy(&result[0].x, &matrix[0].x, sizeof(result));
+		return result;
+	}
 }
 
+// Per frame data. Written once per frame into persistently mapped uniform buffer.
 struct UniformBufferObject
+{
+	YasMathLib::mat4 viewProjection;
+};
+
+// Per draw data. Recorded into command buffer with vkCmdPushConstants so no descriptor writes are needed per object.
+struct PushConstantObject
 {
 	glm::mat4 model;
-	glm::mat4 view;
-	glm::mat4 proj;
 };
 
-#endif
\ No newline at end of file
+#endif
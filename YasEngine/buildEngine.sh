@@ -0,0 +1,22 @@
+#!/bin/sh
+# Builds engine on Linux. Without window it runs only headless, Vulkan loader and headers come from system.
+# Header only libraries are taken from directories given in GLM, STB and TINYOBJLOADER.
+CXX=${CXX:-g++}
+GLM=${GLM:-/usr/include}
+STB=${STB:-/usr/include/stb}
+TINYOBJLOADER=${TINYOBJLOADER:-/usr/include}
+cd "$(dirname "$0")" || exit 1
+
+./compileShaders.sh || exit 1
+
+$CXX -std=c++17 -O2 -DNDEBUG -mavx2 \
+	-I. -I"$GLM" -I"$STB" -I"$TINYOBJLOADER" \
+	AllocationCounter.cpp Animation.cpp Arena.cpp AssetArchive.cpp Clock.cpp CpuProfiler.cpp Descriptors.cpp DeviceSelection.cpp GeometryPool.cpp GpuProfiler.cpp \
+	InitGraph.cpp JobSystem.cpp Main.cpp MappedFile.cpp MeshCodec.cpp ModelLoader.cpp OcclusionCulling.cpp PipelineCache.cpp RenderQueue.cpp \
+	ResidencyCache.cpp ShaderVariants.cpp Simulation.cpp Skinning.cpp TransformBatch.cpp VulkanDevice.cpp VulkanInstance.cpp \
+	VulkanLayersAndExtensions.cpp VulkanSwapchain.cpp YasEngine.cpp YasLog.cpp \
+	-o YasEngine -lvulkan -lpthread || exit 1
+
+# Runs from this directory, Models/chalet.obj and Textures/chalet.jpg are loaded relative to it.
+# Without GPU Mesa software rasterizer lavapipe can be selected through its ICD file:
+# VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./YasEngine --headless --frames 300 --device llvmpipe --statistics lavapipe.txt
@@ -1,9 +1,23 @@
-C:\VulkanSDK\1.1.101.0\Bin32\glslangValidator.exe -V Shaders\vertShader.vert
-C:\VulkanSDK\1.1.101.0\Bin32\glslangValidator.exe -V Shaders\fragShader.frag
-REM cd Shaders
-
-REM files are created in folder where is this script
-REM copy /Y Shaders\vert.spv ..\
-REM copy /Y Shaders\frag.spv ..\
-copy /Y vert.spv Shaders\
-copy /Y frag.spv Shaders\
\ No newline at end of file
+SET GLSLANG=C:\VulkanSDK\1.1.101.0\Bin32\glslangValidator.exe
+
+REM Shader variants. Number in file name is variant key masked to features used by stage:
+REM 1 - VERTEX_COLOR, 2 - TEXTURING, 8 - INSTANCING (vertex shader only)
+REM Alpha test is specialization constant and does not need separate files.
+%GLSLANG% -V Shaders\vertShader.vert -o Shaders\vert_0.spv
+%GLSLANG% -V -DVERTEX_COLOR Shaders\vertShader.vert -o Shaders\vert_1.spv
+%GLSLANG% -V -DTEXTURING Shaders\vertShader.vert -o Shaders\vert_2.spv
+%GLSLANG% -V -DVERTEX_COLOR -DTEXTURING Shaders\vertShader.vert -o Shaders\vert_3.spv
+%GLSLANG% -V -DINSTANCING Shaders\vertShader.vert -o Shaders\vert_8.spv
+%GLSLANG% -V -DVERTEX_COLOR -DINSTANCING Shaders\vertShader.vert -o Shaders\vert_9.spv
+%GLSLANG% -V -DTEXTURING -DINSTANCING Shaders\vertShader.vert -o Shaders\vert_10.spv
+%GLSLANG% -V -DVERTEX_COLOR -DTEXTURING -DINSTANCING Shaders\vertShader.vert -o Shaders\vert_11.spv
+
+%GLSLANG% -V Shaders\fragShader.frag -o Shaders\frag_0.spv
+%GLSLANG% -V -DVERTEX_COLOR Shaders\fragShader.frag -o Shaders\frag_1.spv
+%GLSLANG% -V -DTEXTURING Shaders\fragShader.frag -o Shaders\frag_2.spv
+%GLSLANG% -V -DVERTEX_COLOR -DTEXTURING Shaders\fragShader.frag -o Shaders\frag_3.spv
+
+%GLSLANG% -V Shaders\skinning.comp -o Shaders\skinning_comp.spv
+
+REM Shader pack is rebuilt from new SPIR-V files on next start
+IF EXIST Shaders\shaders.pak DEL Shaders\shaders.pak
\ No newline at end of file
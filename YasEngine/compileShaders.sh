@@ -0,0 +1,26 @@
+#!/bin/sh
+# Linux counterpart of compileShaders.bat, glslangValidator is taken from PATH
+GLSLANG=${GLSLANG:-glslangValidator}
+cd "$(dirname "$0")" || exit 1
+
+# Shader variants. Number in file name is variant key masked to features used by stage:
+# 1 - VERTEX_COLOR, 2 - TEXTURING, 8 - INSTANCING (vertex shader only)
+# Alpha test is specialization constant and does not need separate files.
+$GLSLANG -V Shaders/vertShader.vert -o Shaders/vert_0.spv
+$GLSLANG -V -DVERTEX_COLOR Shaders/vertShader.vert -o Shaders/vert_1.spv
+$GLSLANG -V -DTEXTURING Shaders/vertShader.vert -o Shaders/vert_2.spv
+$GLSLANG -V -DVERTEX_COLOR -DTEXTURING Shaders/vertShader.vert -o Shaders/vert_3.spv
+$GLSLANG -V -DINSTANCING Shaders/vertShader.vert -o Shaders/vert_8.spv
+$GLSLANG -V -DVERTEX_COLOR -DINSTANCING Shaders/vertShader.vert -o Shaders/vert_9.spv
+$GLSLANG -V -DTEXTURING -DINSTANCING Shaders/vertShader.vert -o Shaders/vert_10.spv
+$GLSLANG -V -DVERTEX_COLOR -DTEXTURING -DINSTANCING Shaders/vertShader.vert -o Shaders/vert_11.spv
+
+$GLSLANG -V Shaders/fragShader.frag -o Shaders/frag_0.spv
+$GLSLANG -V -DVERTEX_COLOR Shaders/fragShader.frag -o Shaders/frag_1.spv
+$GLSLANG -V -DTEXTURING Shaders/fragShader.frag -o Shaders/frag_2.spv
+$GLSLANG -V -DVERTEX_COLOR -DTEXTURING Shaders/fragShader.frag -o Shaders/frag_3.spv
+
+$GLSLANG -V Shaders/skinning.comp -o Shaders/skinning_comp.spv
+
+# Shader pack is rebuilt from new SPIR-V files on next start
+rm -f Shaders/shaders.pak